@@ -99,7 +99,7 @@ public:
         QD_XYZ,  // XYZ
     };
 
-    // Most public members are similar to the ocl::KDTree<Triangle> class
+    // Most public members are similar to the ocl::KDTree class
 public:
     AABBTreeAdaptor() = default;
 
@@ -130,6 +130,12 @@ public:
 
         spdlog::info("AABBTree::build() size:={} time:={} s", list.size(), sw);
     }
+    /// build the AABB tree from any range of triangles, e.g. STLSurf::tris
+    template<class Range>
+    void build(const Range& range)
+    {
+        build(InputTypes(range.begin(), range.end()));
+    }
 
     /// search for overlap with input Bbox bb, return found objects
     [[nodiscard]] QueryResult search(const Bbox& bb) const
@@ -428,10 +428,10 @@ void UIComponents::DrawDataModelUI(vtkDearImGuiInjector* injector)
                     // and test memory usage
                     if (treeType == 0) {
                         auto memory_before = CGAL::Memory_sizer().virtual_size();
-                        ocl::KDTree<ocl::Triangle> kdtree;
+                        ocl::KDTree<ocl::IndexedMesh> kdtree;
                         kdtree.setBucketSize(1);
                         kdtree.setXYDimensions();
-                        kdtree.build(modelManager.surface->tris);
+                        kdtree.build(modelManager.surface->mesh);
                         spdlog::info("KDTree allocated {} MB",
                                      (CGAL::Memory_sizer().virtual_size() - memory_before) >> 20);
                         actorManager.treeActor->VisibilityOn();
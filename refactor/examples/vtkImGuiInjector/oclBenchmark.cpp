@@ -303,8 +303,8 @@ void run_AABBTree_VS_KDTree(const CAMModelManager& model, bool verbose)
 
     // Raw KDTree
     spdlog::stopwatch sw;
-    ocl::KDTree<ocl::Triangle> kd_tree;
-    kd_tree.build(model.surface->tris);
+    ocl::KDTree<ocl::IndexedMesh> kd_tree;
+    kd_tree.build(model.surface->mesh);
     double kd_tree_build_time = sw.elapsed().count();
     benchmark_logger->info("\tRaw KDTree build with {} triangles took {} s",
                            model.surface->tris.size(),
@@ -336,10 +336,10 @@ void run_AABBTree_VS_KDTree(const CAMModelManager& model, bool verbose)
     // Search
     sw.reset();
     std::array search_results {0, 0};
+    std::vector<std::uint32_t> kd_res;
     for (auto& box : boxes) {
-        auto res = kd_tree.search(box);
-        search_results[0] += res->size();
-        delete res;
+        kd_tree.search(box, kd_res);
+        search_results[0] += kd_res.size();
     }
     double kd_tree_search_time = sw.elapsed().count();
     benchmark_logger->info("\tKDTree search with {} boxes took {} s and find {} results",
@@ -368,9 +368,8 @@ void run_AABBTree_VS_KDTree(const CAMModelManager& model, bool verbose)
     generate_boxes(*model.surface, max_boxes, boxes);
     sw.reset();
     for (auto& box : boxes) {
-        auto res = kd_tree.search(box);
-        search_results[0] += res->size();
-        delete res;
+        kd_tree.search(box, kd_res);
+        search_results[0] += kd_res.size();
     }
     kd_tree_search_time = sw.elapsed().count();
     benchmark_logger->info("\tKDTree search with {} boxes took {} s and find {} results",
@@ -399,9 +398,8 @@ void run_AABBTree_VS_KDTree(const CAMModelManager& model, bool verbose)
     generate_boxes(*model.surface, max_boxes, boxes);
     sw.reset();
     for (auto& box : boxes) {
-        auto res = kd_tree.search(box);
-        search_results[0] += res->size();
-        delete res;
+        kd_tree.search(box, kd_res);
+        search_results[0] += kd_res.size();
     }
     kd_tree_search_time = sw.elapsed().count();
     benchmark_logger->info("\tKDTree search with {} boxes took {} s and find {} results",
@@ -430,9 +428,8 @@ void run_AABBTree_VS_KDTree(const CAMModelManager& model, bool verbose)
     generate_boxes(*model.surface, max_boxes, boxes);
     sw.reset();
     for (auto& box : boxes) {
-        auto res = kd_tree.search(box);
-        search_results[0] += res->size();
-        delete res;
+        kd_tree.search(box, kd_res);
+        search_results[0] += kd_res.size();
     }
     kd_tree_search_time = sw.elapsed().count();
     benchmark_logger->info("\tKDTree search with {} boxes took {} s and find {} results",
@@ -324,11 +324,11 @@ void UpdateLoopsActor(vtkSmartPointer<vtkActor>& actor,
 }
 
 void UpdateKDTreeActor(vtkSmartPointer<vtkActor>& actor,
-                       const ocl::KDTree<ocl::Triangle>* kdtree,
+                       const ocl::KDTree<ocl::IndexedMesh>* kdtree,
                        double opacity,
                        bool onlyLeafNodes)
 {
-    using node_type = ocl::KDNode<ocl::Triangle>;
+    using node_type = ocl::KDNode;
     if (!kdtree || !kdtree->getRoot()) {
         spdlog::error("KDTree is null or has no root node");
         return;
@@ -344,19 +344,13 @@ void UpdateKDTreeActor(vtkSmartPointer<vtkActor>& actor,
                 return;
 
             // 如果是叶子节点
-            if (node->isLeaf && node->tris && !node->tris->empty()) {
+            if (node->isLeaf && !node->faces.empty()) {
                 // 计算叶子节点的包围盒
                 ocl::Bbox bbox;
-                bool first = true;
-
-                for (const auto& obj : *(node->tris)) {
-                    if (first) {
-                        bbox = obj.bb;
-                        first = false;
-                    }
-                    else {
-                        bbox.addTriangle(obj);
-                    }
+                for (std::uint32_t f : node->faces) {
+                    const ocl::Bbox fb = kdtree->getMesh()->bounds(f);
+                    bbox.addPoint(fb.minpt);
+                    bbox.addPoint(fb.maxpt);
                 }
 
                 // 创建一个vtkVoxel来表示此叶子节点的包围盒
@@ -408,16 +402,11 @@ void UpdateKDTreeActor(vtkSmartPointer<vtkActor>& actor,
             ocl::Bbox bbox;
 
             // 如果是叶子节点，从三角形构建包围盒
-            if (node->isLeaf && node->tris) {
-                bool first = true;
-                for (const auto& obj : *(node->tris)) {
-                    if (first) {
-                        bbox = obj.bb;
-                        first = false;
-                    }
-                    else {
-                        bbox.addTriangle(obj);
-                    }
+            if (node->isLeaf) {
+                for (std::uint32_t f : node->faces) {
+                    const ocl::Bbox fb = kdtree->getMesh()->bounds(f);
+                    bbox.addPoint(fb.minpt);
+                    bbox.addPoint(fb.maxpt);
                 }
             }
             // 否则基于子节点构建包围盒
@@ -385,7 +385,7 @@ void UpdateLoopsActor(vtkSmartPointer<vtkActor>& actor,
 
 // 创建一个KDTree的可视化
 void UpdateKDTreeActor(vtkSmartPointer<vtkActor>& actor,
-                       const ocl::KDTree<ocl::Triangle>* kdtree,
+                       const ocl::KDTree<ocl::IndexedMesh>* kdtree,
                        double opacity = 0.3,
                        bool onlyLeafNodes = false);
 
@@ -20,14 +20,12 @@
 */
 
 #include <algorithm>
+#include <iterator>
 #include <vector>
 
 
 #include <boost/foreach.hpp> 
 
-#ifdef _OPENMP
-    #include <omp.h>
-#endif
 
 #include "cutters/millingcutter.hpp"
 #include "geo/point.hpp"
@@ -51,13 +49,10 @@ AdaptiveWaterline::AdaptiveWaterline() {
     subOp.push_back( new FiberPushCutter() );
     subOp[0]->setXDirection();
     subOp[1]->setYDirection();
-    nthreads = 1;
-#ifdef _OPENMP
-    nthreads = omp_get_num_procs();
-#endif
     sampling = 1.0;
     min_sampling = 0.1;
     cosLimit = 0.999;
+    task_depth = 10;
 }
 
 AdaptiveWaterline::~AdaptiveWaterline() {}
@@ -79,67 +74,44 @@ void AdaptiveWaterline::adaptive_sampling_run() {
     maxy = surf->bb.maxpt.y + 2*cutter->getRadius();
     Line* line = new Line( Point(minx,miny,zh) , Point(maxx,maxy,zh) );
     Span* linespan = new LineSpan(*line);
-#ifdef _WIN32 // OpenMP task not supported with the version 2 of VS2013 OpenMP
-	#pragma omp parallel sections
-	{
-		#pragma omp section // Replace OMP Task by Parallel sections
-		{ // first child
-#else
-#pragma omp parallel
-	{
-#pragma omp single nowait
-		{ // initial root task
-#pragma omp task
-			{ // first child task
-#endif // _WIN32
-				xfibers.clear();
-				Point xstart_p1 = Point(minx, linespan->getPoint(0.0).y, zh);
-				Point xstart_p2 = Point(maxx, linespan->getPoint(0.0).y, zh);
-				Point xstop_p1 = Point(minx, linespan->getPoint(1.0).y, zh);
-				Point xstop_p2 = Point(maxx, linespan->getPoint(1.0).y, zh);
-				Fiber xstart_f = Fiber(xstart_p1, xstart_p2);
-				Fiber xstop_f = Fiber(xstop_p1, xstop_p2);
-				subOp[0]->run(xstart_f);
-				subOp[0]->run(xstop_f);
-				xfibers.push_back(xstart_f);
-				// std::cout << " XFiber adaptive sample \n";
-				xfiber_adaptive_sample(linespan, 0.0, 1.0, xstart_f, xstop_f);
-#ifdef _WIN32 // OpenMP task not supported with the version 2 of VS2013 OpenMP
-		}
-		#pragma omp section
-		{ // second child
-#else
-		}
-# pragma omp task
-			{ // second child task
-#endif // _WIN32
-				yfibers.clear();
-				Point ystart_p1 = Point(linespan->getPoint(0.0).x, miny, zh);
-				Point ystart_p2 = Point(linespan->getPoint(0.0).x, maxy, zh);
-				Point ystop_p1 = Point(linespan->getPoint(1.0).x, miny, zh);
-				Point ystop_p2 = Point(linespan->getPoint(1.0).x, maxy, zh);
-				Fiber ystart_f = Fiber(ystart_p1, ystart_p2);
-				Fiber ystop_f = Fiber(ystop_p1, ystop_p2);
-				subOp[1]->run(ystart_f);
-				subOp[1]->run(ystop_f);
-				yfibers.push_back(ystart_f);
-				// std::cout << " YFiber adaptive sample \n";
-				yfiber_adaptive_sample(linespan, 0.0, 1.0, ystart_f, ystop_f);
-#ifdef _WIN32 // OpenMP task not supported with the version 2 of VS2013 OpenMP
-		}
-	} // end omp parallel
-#else
-            }
-        }
-    } // end omp parallel
-#endif // _WIN32
+    xfibers.clear();
+    yfibers.clear();
+    // the x- and y-directions are two root tasks. Each subdivision above task_depth
+    // spawns its halves as tasks, with one output buffer per half, so the fibers
+    // come out in the same (coordinate) order as a serial run.
+    executor.execute( [&] {
+        executor.invoke( [&] {
+            Point xstart_p1 = Point(minx, linespan->getPoint(0.0).y, zh);
+            Point xstart_p2 = Point(maxx, linespan->getPoint(0.0).y, zh);
+            Point xstop_p1 = Point(minx, linespan->getPoint(1.0).y, zh);
+            Point xstop_p2 = Point(maxx, linespan->getPoint(1.0).y, zh);
+            Fiber xstart_f = Fiber(xstart_p1, xstart_p2);
+            Fiber xstop_f = Fiber(xstop_p1, xstop_p2);
+            subOp[0]->run(xstart_f);
+            subOp[0]->run(xstop_f);
+            xfibers.push_back(xstart_f);
+            xfiber_adaptive_sample(linespan, 0.0, 1.0, xstart_f, xstop_f, xfibers, 0);
+        }, [&] {
+            Point ystart_p1 = Point(linespan->getPoint(0.0).x, miny, zh);
+            Point ystart_p2 = Point(linespan->getPoint(0.0).x, maxy, zh);
+            Point ystop_p1 = Point(linespan->getPoint(1.0).x, miny, zh);
+            Point ystop_p2 = Point(linespan->getPoint(1.0).x, maxy, zh);
+            Fiber ystart_f = Fiber(ystart_p1, ystart_p2);
+            Fiber ystop_f = Fiber(ystop_p1, ystop_p2);
+            subOp[1]->run(ystart_f);
+            subOp[1]->run(ystop_f);
+            yfibers.push_back(ystart_f);
+            yfiber_adaptive_sample(linespan, 0.0, 1.0, ystart_f, ystop_f, yfibers, 0);
+        } );
+    } );
 
     delete line;
     delete linespan;
 }
 
-
-void AdaptiveWaterline::xfiber_adaptive_sample(const Span* span, double start_t, double stop_t, Fiber start_f, Fiber stop_f) {
+void AdaptiveWaterline::xfiber_adaptive_sample(const Span* span, double start_t, double stop_t,
+                                               const Fiber& start_f, const Fiber& stop_f,
+                                               std::vector<Fiber>& out, int depth) {
     const double mid_t = start_t + (stop_t-start_t)/2.0; // mid point sample
     assert( mid_t > start_t );  assert( mid_t < stop_t );
     //std::cout << "xfiber sample= ( " << start_t << " , " << stop_t << " ) \n";
@@ -149,20 +121,31 @@ void AdaptiveWaterline::xfiber_adaptive_sample(const Span* span, double start_t,
     Fiber mid_f = Fiber( mid_p1, mid_p2 );
     subOp[0]->run( mid_f );
     double fw_step = fabs( start_f.p1.y - stop_f.p1.y ) ;
+    bool subdivide = false;
     if ( fw_step > sampling ) { // above minimum step-forward, need to sample more
-        xfiber_adaptive_sample( span, start_t, mid_t , start_f, mid_f  );
-        xfiber_adaptive_sample( span, mid_t  , stop_t, mid_f  , stop_f );
+        subdivide = true;
     } else if ( !flat(start_f,mid_f,stop_f)   ) {
-        if (fw_step > min_sampling) { // not a flat segment, and we have not reached maximum sampling
-            xfiber_adaptive_sample( span, start_t, mid_t , start_f, mid_f  );
-            xfiber_adaptive_sample( span, mid_t  , stop_t, mid_f  , stop_f );
-        }
+        // not a flat segment, and we have not reached maximum sampling
+        subdivide = (fw_step > min_sampling);
+    } else {
+        out.push_back(stop_f);
+    }
+    if ( !subdivide )
+        return;
+    if ( depth < task_depth ) {
+        std::vector<Fiber> upper; // fibers of the upper half, appended after the lower half
+        executor.invoke( [&] { xfiber_adaptive_sample( span, mid_t, stop_t, mid_f, stop_f, upper, depth+1 ); },
+                         [&] { xfiber_adaptive_sample( span, start_t, mid_t , start_f, mid_f, out, depth+1 ); } );
+        out.insert( out.end(), std::make_move_iterator(upper.begin()), std::make_move_iterator(upper.end()) );
     } else {
-        xfibers.push_back(stop_f);
+        xfiber_adaptive_sample( span, start_t, mid_t , start_f, mid_f , out, depth+1 );
+        xfiber_adaptive_sample( span, mid_t  , stop_t, mid_f  , stop_f, out, depth+1 );
     }
 }
 
-void AdaptiveWaterline::yfiber_adaptive_sample(const Span* span, double start_t, double stop_t, Fiber start_f, Fiber stop_f) {
+void AdaptiveWaterline::yfiber_adaptive_sample(const Span* span, double start_t, double stop_t,
+                                               const Fiber& start_f, const Fiber& stop_f,
+                                               std::vector<Fiber>& out, int depth) {
     const double mid_t = start_t + (stop_t-start_t)/2.0; // mid point sample
     assert( mid_t > start_t );  assert( mid_t < stop_t );
     //std::cout << "yfiber sample= ( " << start_t << " , " << stop_t << " ) \n";
@@ -172,21 +155,29 @@ void AdaptiveWaterline::yfiber_adaptive_sample(const Span* span, double start_t,
     Fiber mid_f = Fiber( mid_p1, mid_p2 );
     subOp[1]->run( mid_f );
     double fw_step = fabs( start_f.p1.x - stop_f.p1.x ) ;
-    if ( fw_step > sampling ) { // above minimum step-forward, need to sample more
-        yfiber_adaptive_sample( span, start_t, mid_t , start_f, mid_f  );
-        yfiber_adaptive_sample( span, mid_t  , stop_t, mid_f  , stop_f );
+    bool subdivide = false;
+    if ( fw_step > sampling ) {
+        subdivide = true;
     } else if ( !flat(start_f,mid_f,stop_f)   ) {
-        if (fw_step > min_sampling) { // not a flat segment, and we have not reached maximum sampling
-            yfiber_adaptive_sample( span, start_t, mid_t , start_f, mid_f  );
-            yfiber_adaptive_sample( span, mid_t  , stop_t, mid_f  , stop_f );
-        }
+        subdivide = (fw_step > min_sampling);
+    } else {
+        out.push_back(stop_f);
+    }
+    if ( !subdivide )
+        return;
+    if ( depth < task_depth ) {
+        std::vector<Fiber> upper;
+        executor.invoke( [&] { yfiber_adaptive_sample( span, mid_t, stop_t, mid_f, stop_f, upper, depth+1 ); },
+                         [&] { yfiber_adaptive_sample( span, start_t, mid_t , start_f, mid_f, out, depth+1 ); } );
+        out.insert( out.end(), std::make_move_iterator(upper.begin()), std::make_move_iterator(upper.end()) );
     } else {
-        yfibers.push_back(stop_f);
+        yfiber_adaptive_sample( span, start_t, mid_t , start_f, mid_f , out, depth+1 );
+        yfiber_adaptive_sample( span, mid_t  , stop_t, mid_f  , stop_f, out, depth+1 );
     }
 }
 
 // flat predicate to determine when we subdivide
-bool AdaptiveWaterline::flat( Fiber& start, Fiber& mid, Fiber& stop ) const {
+bool AdaptiveWaterline::flat( const Fiber& start, const Fiber& mid, const Fiber& stop ) const {
     if ( start.size() != stop.size() ) // start, mid, and stop need to have same size()
         return false;
     else if ( start.size() != mid.size() )
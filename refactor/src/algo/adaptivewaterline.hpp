@@ -48,6 +48,9 @@ public:
   void setMinSampling(double s) { min_sampling = s; }
   /// set the cosine limit for the flat() predicate
   void setCosLimit(double lim) { cosLimit = lim; }
+  /// set the recursion depth below which subdivisions run serially, within
+  /// the task that reached it. 0 samples each direction in a single task.
+  void setTaskDepth(int depth) { task_depth = depth; }
 
   /// run the Waterline algorithm. setSTL, setCutter, setSampling, and setZ must
   /// be called before a call to run()
@@ -63,15 +66,18 @@ public:
 protected:
   /// adaptive waterline algorithm
   void adaptive_sampling_run();
-  /// x-direction adaptive sampling
+  /// x-direction adaptive sampling. The fibers accepted in (start_t, stop_t]
+  /// are appended to out in order of increasing t.
   void xfiber_adaptive_sample(const Span *span, double start_t, double stop_t,
-                              Fiber start_f, Fiber stop_f);
+                              const Fiber &start_f, const Fiber &stop_f,
+                              std::vector<Fiber> &out, int depth);
   /// y-direction adaptive sampling
   void yfiber_adaptive_sample(const Span *span, double start_t, double stop_t,
-                              Fiber start_f, Fiber stop_f);
+                              const Fiber &start_f, const Fiber &stop_f,
+                              std::vector<Fiber> &out, int depth);
   /// flatness predicate for fibers. Checks Fiber.size() and then calls flat()
   /// on cl-points
-  bool flat(Fiber &start, Fiber &mid, Fiber &stop) const;
+  bool flat(const Fiber &start, const Fiber &mid, const Fiber &stop) const;
   /// flatness predicate for cl-points. checks for angle metween start-mid-stop
   bool flat(Point start_cl, Point mid_cl, Point stop_cl) const;
 
@@ -90,6 +96,9 @@ protected:
   /// the cosine limit value for cl-point flat(). In the constructor, cosLimit =
   /// 0.999 by default.
   double cosLimit;
+  /// subdivisions at a recursion depth below task_depth run the two halves as
+  /// parallel tasks
+  int task_depth;
 };
 
 } // namespace ocl
@@ -19,14 +19,13 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <boost/foreach.hpp>
+#include <atomic>
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
+#include <boost/foreach.hpp>
 
 #include "batchpushcutter.hpp"
 #include "cutters/millingcutter.hpp"
+#include "geo/meshindex.hpp"
 #include "geo/point.hpp"
 #include "geo/triangle.hpp"
 
@@ -38,13 +37,9 @@ namespace ocl {
 BatchPushCutter::BatchPushCutter() {
   fibers = new std::vector<Fiber>();
   nCalls = 0;
-  nthreads = 1;
-#ifdef _OPENMP
-  nthreads = omp_get_num_procs(); // figure out how many cores we have
-#endif
   cutter = NULL;
   bucketSize = 1;
-  root = new KDTree<Triangle>();
+  root = new KDTree<IndexedMesh>();
 }
 
 BatchPushCutter::~BatchPushCutter() {
@@ -53,7 +48,7 @@ BatchPushCutter::~BatchPushCutter() {
 }
 
 void BatchPushCutter::setSTL(const STLSurf &s) {
-  surf = &s;
+  surf = &cullROI(s);
   // std::cout << "BPC::setSTL() Building kd-tree... bucketSize=" << bucketSize
   // << "..";
   root->setBucketSize(bucketSize);
@@ -68,7 +63,7 @@ void BatchPushCutter::setSTL(const STLSurf &s) {
     assert(0);
   }
   // std::cout << "BPC::setSTL() root->build()...";
-  root->build(s.tris);
+  MeshIndex::buildTree(*root, *surf);
   // std::cout << "done.\n";
 }
 
@@ -103,7 +98,9 @@ void BatchPushCutter::pushCutter2() {
   //           " fibers and " << surf->tris.size() << " triangles..." <<
   //           std::endl;
   nCalls = 0;
-  std::list<Triangle> *overlap_triangles;
+  nSkipped = 0;
+  std::vector<std::uint32_t> overlap_faces;
+  Triangle t;
   BOOST_FOREACH (Fiber &f, *fibers) {
     CLPoint cl;
     if (x_direction) {
@@ -117,83 +114,68 @@ void BatchPushCutter::pushCutter2() {
     } else {
       assert(0);
     }
-    overlap_triangles = root->search_cutter_overlap(cutter, &cl);
+    root->search_cutter_overlap(cutter, &cl, overlap_faces);
     assert(
-        overlap_triangles->size() <=
+        overlap_faces.size() <=
         surf->size()); // can't possibly find more triangles than in the STLSurf
-    BOOST_FOREACH (const Triangle &t, *overlap_triangles) {
-      // if ( bb->overlaps( t.bb ) ) {
+    BOOST_FOREACH (std::uint32_t face, overlap_faces) {
+      surf->mesh.triangle(face, t);
+      if (!cutter->overlapsFiber(f, t)) {
+        ++nSkipped;
+        continue;
+      }
       Interval i;
       cutter->pushCutter(f, i, t);
       f.addInterval(i);
       ++nCalls;
-      //}
     }
-    delete (overlap_triangles);
   }
   // std::cout << "BatchPushCutter2 done." << std::endl;
   return;
 }
 
 /// use kd-tree search to find overlapping triangles
-/// use OpenMP for multi-threading
+/// share the fibers between threads with the Executor
 void BatchPushCutter::pushCutter3() {
-  // std::cout << "BatchPushCutter3 with " << fibers->size() <<
-  //           " fibers and " << surf->tris.size() << " triangles." <<
-  //           std::endl;
-  // std::cout << " cutter = " << cutter->str() << "\n";
-  nCalls = 0;
-#ifdef _OPENMP
-  omp_set_num_threads(nthreads);
-#endif
-  std::list<Triangle>::iterator it, it_end; // for looping over found triabgles
-  Interval *i;
-  std::list<Triangle> *tris;
   std::vector<Fiber> &fiberr = *fibers;
-#ifdef _WIN32 // OpenMP version 2 of VS2013 OpenMP need signed loop variable
-  int n; // loop variable
-  int Nmax =
-      static_cast<int>(fibers->size()); // the number of fibers to process
-#else
-  unsigned int n;                     // loop variable
-  unsigned int Nmax = fibers->size(); // the number of fibers to process
-#endif
-  unsigned int calls = 0;
-
-#pragma omp parallel for schedule(dynamic)                                     \
-    shared(calls, fiberr) private(n, i, tris, it, it_end)
-  //#pragma omp parallel for shared( calls, fiberr) private(n,i,tris,it,it_end)
-  for (n = 0; n < Nmax; ++n) { // loop through all fibers
-    CLPoint cl;                // cl-point on the fiber
-    if (x_direction) {
-      cl.x = 0;
-      cl.y = fiberr[n].p1.y;
-      cl.z = fiberr[n].p1.z;
-    } else if (y_direction) {
-      cl.x = fiberr[n].p1.x;
-      cl.y = 0;
-      cl.z = fiberr[n].p1.z;
-    }
-    tris = root->search_cutter_overlap(cutter, &cl);
-    it_end = tris->end();
-    for (it = tris->begin(); it != it_end;
-         ++it) { // loop through the found overlapping triangles
-                 // if ( bb->overlaps( it->bb ) ) {
+  std::atomic<int> calls(0);
+  std::atomic<int> skipped(0);
+  executor.parallel_for(fiberr.size(), [&](size_t begin, size_t end) {
+    int local_calls = 0;
+    int local_skipped = 0;
+    std::vector<std::uint32_t> faces;
+    Triangle t;
+    for (size_t n = begin; n != end; ++n) { // loop through the fibers
+      CLPoint cl;                           // cl-point on the fiber
+      if (x_direction) {
+        cl.x = 0;
+        cl.y = fiberr[n].p1.y;
+        cl.z = fiberr[n].p1.z;
+      } else if (y_direction) {
+        cl.x = fiberr[n].p1.x;
+        cl.y = 0;
+        cl.z = fiberr[n].p1.z;
+      }
+      root->search_cutter_overlap(cutter, &cl, faces);
       // todo: optimization where method-calls are skipped if triangle bbox
       // already in the fiber
-      i = new Interval();
-      cutter->pushCutter(fiberr[n], *i, *it);
-      fiberr[n].addInterval(*i);
-      ++calls;
-      delete i;
-      //}
+      BOOST_FOREACH (std::uint32_t face, faces) {
+        surf->mesh.triangle(face, t);
+        if (!cutter->overlapsFiber(fiberr[n], t)) {
+          ++local_skipped;
+          continue;
+        }
+        Interval i;
+        cutter->pushCutter(fiberr[n], i, t);
+        fiberr[n].addInterval(i);
+        ++local_calls;
+      }
     }
-    delete (tris);
-  } // OpenMP parallel region ends here
-
+    calls += local_calls;
+    skipped += local_skipped;
+  });
   this->nCalls = calls;
-  // std::cout << "\nBatchPushCutter3 done." << std::endl;
-  return;
+  this->nSkipped = skipped;
 }
 
 } // namespace ocl
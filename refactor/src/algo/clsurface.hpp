@@ -28,6 +28,7 @@
 
 #include "point.hpp"
 #include "halfedgediagram.hpp"
+#include "operation.hpp"
 
 
 namespace ocl
@@ -40,16 +41,8 @@ namespace clsurf
 
 
 
-typedef boost::adjacency_list_traits<boost::listS, 
-                                     boost::listS, 
-                                     boost::bidirectionalS, 
-                                     boost::listS >::edge_descriptor CLSEdge;
-
-
-typedef boost::adjacency_list_traits<boost::listS, 
-                                     boost::listS, 
-                                     boost::bidirectionalS, 
-                                     boost::listS >::vertex_descriptor CLSVertex;
+typedef hedi::EdgeHandle CLSEdge;
+typedef hedi::VertexHandle CLSVertex;
 //typedef CLSGraph::Edge CLSEdge;
 //typedef CLSGraph::Vertex CLSVertex;
 typedef unsigned int CLSFace;
@@ -109,14 +102,9 @@ struct CLSFaceProps {
 
 
 // the cutter location surface graph
-typedef hedi::HEDIGraph<  boost::listS,             // out-edge storage
-                          boost::listS,             // vertex set storage
-                          boost::bidirectionalS,    // bidirectional graph.
-                          CLSVertexProps,           // vertex properties
+typedef hedi::HEDIGraph<  CLSVertexProps,           // vertex properties
                           CLSEdgeProps,             // edge properties
-                          CLSFaceProps,             // face properties
-                          boost::no_property,       // graph properties
-                          boost::listS              // edge storage
+                          CLSFaceProps              // face properties
                           > CLSGraph;
 
 
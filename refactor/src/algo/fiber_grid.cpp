@@ -0,0 +1,102 @@
+/*  $Id$
+ * 
+ *  Copyright (c) 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *  
+ *  This file is part of OpenCAMlib 
+ *  (see https://github.com/aewallin/opencamlib).
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <numeric>
+
+#include "fiber_grid.hpp"
+
+namespace ocl
+{
+
+namespace weave
+{
+
+// sort the intervals of every fiber and the fibers themselves by coordinate
+void FiberGrid::build(const std::vector<Fiber>& xfibers, const std::vector<Fiber>& yfibers) {
+    row_fiber_.resize( xfibers.size() );
+    std::iota( row_fiber_.begin(), row_fiber_.end(), 0 );
+    std::stable_sort( row_fiber_.begin(), row_fiber_.end(),
+                      [&xfibers](int a, int b) { return xfibers[a].p1.y < xfibers[b].p1.y; } );
+    col_fiber_.resize( yfibers.size() );
+    std::iota( col_fiber_.begin(), col_fiber_.end(), 0 );
+    std::stable_sort( col_fiber_.begin(), col_fiber_.end(),
+                      [&yfibers](int a, int b) { return yfibers[a].p1.x < yfibers[b].p1.x; } );
+
+    const auto by_lo = [](const Span& a, const Span& b) { return a.lo < b.lo; };
+    row_rank_.resize( row_fiber_.size() );
+    row_y_.resize( row_fiber_.size() );
+    row_spans_.assign( row_fiber_.size(), SpanList() );
+    for (int r=0; r<rows(); ++r) {
+        const Fiber& xf = xfibers[ row_fiber_[r] ];
+        row_rank_[ row_fiber_[r] ] = r;
+        row_y_[r] = xf.p1.y;
+        for (unsigned int k=0; k<xf.ints.size(); ++k) {
+            Span s;
+            s.lo = xf.point(xf.ints[k].lower).x;
+            s.hi = xf.point(xf.ints[k].upper).x;
+            s.ival = k;
+            if ( (s.hi-s.lo) > 0 )
+                row_spans_[r].push_back(s);
+        }
+        std::sort( row_spans_[r].begin(), row_spans_[r].end(), by_lo );
+    }
+    col_rank_.resize( col_fiber_.size() );
+    col_x_.resize( col_fiber_.size() );
+    col_spans_.assign( col_fiber_.size(), SpanList() );
+    for (int c=0; c<cols(); ++c) {
+        const Fiber& yf = yfibers[ col_fiber_[c] ];
+        col_rank_[ col_fiber_[c] ] = c;
+        col_x_[c] = yf.p1.x;
+        for (unsigned int k=0; k<yf.ints.size(); ++k) {
+            Span s;
+            s.lo = yf.point(yf.ints[k].lower).y;
+            s.hi = yf.point(yf.ints[k].upper).y;
+            s.ival = k;
+            if ( (s.hi-s.lo) > 0 )
+                col_spans_[c].push_back(s);
+        }
+        std::sort( col_spans_[c].begin(), col_spans_[c].end(), by_lo );
+    }
+}
+
+int FiberGrid::cover(const SpanList& spans, double c) {
+    // last span with lo < c
+    SpanList::const_iterator itr = std::upper_bound( spans.begin(), spans.end(), c,
+                                        [](double v, const Span& s) { return v <= s.lo; } );
+    if ( itr == spans.begin() )
+        return -1;
+    --itr;
+    return ( c < itr->hi ) ? static_cast<int>( itr - spans.begin() ) : -1;
+}
+
+int FiberGrid::first_col_above(double x) const {
+    return std::upper_bound( col_x_.begin(), col_x_.end(), x ) - col_x_.begin();
+}
+
+int FiberGrid::first_row_above(double y) const {
+    return std::upper_bound( row_y_.begin(), row_y_.end(), y ) - row_y_.begin();
+}
+
+} // end weave namespace
+
+} // end ocl namespace
+// end file fiber_grid.cpp
@@ -0,0 +1,105 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef FIBER_GRID_HPP
+#define FIBER_GRID_HPP
+
+#include <vector>
+
+#include "fiber.hpp"
+
+namespace ocl {
+
+namespace weave {
+
+/// X- and Y-fibers arranged as a grid of rows (x-fibers, sorted by y) and
+/// columns (y-fibers, sorted by x). The intervals of every fiber are stored
+/// in world coordinates and sorted, so whether a row and a column cross (the
+/// condition used by SimpleWeave::build()) is answered by a binary search
+/// instead of a walk over the intervals.
+class OCL_API FiberGrid {
+public:
+  /// an interval in world coordinates
+  struct Span {
+    double lo; ///< lower world coordinate
+    double hi; ///< upper world coordinate
+    int ival;  ///< index of the interval in Fiber::ints
+  };
+  /// the intervals of one fiber, sorted by lower coordinate
+  typedef std::vector<Span> SpanList;
+
+  FiberGrid() {}
+  /// build the grid. zero-length intervals are left out.
+  void build(const std::vector<Fiber> &xfibers,
+             const std::vector<Fiber> &yfibers);
+
+  /// number of rows (x-fibers)
+  int rows() const { return static_cast<int>(row_fiber_.size()); }
+  /// number of columns (y-fibers)
+  int cols() const { return static_cast<int>(col_fiber_.size()); }
+  /// index into xfibers of row r
+  int row_fiber(int r) const { return row_fiber_[r]; }
+  /// index into yfibers of column c
+  int col_fiber(int c) const { return col_fiber_[c]; }
+  /// row of x-fiber i
+  int row_of(int i) const { return row_rank_[i]; }
+  /// column of y-fiber j
+  int col_of(int j) const { return col_rank_[j]; }
+  /// y-coordinate of row r
+  double row_y(int r) const { return row_y_[r]; }
+  /// x-coordinate of column c
+  double col_x(int c) const { return col_x_[c]; }
+  /// the intervals of row r
+  const SpanList &row_spans(int r) const { return row_spans_[r]; }
+  /// the intervals of column c
+  const SpanList &col_spans(int c) const { return col_spans_[c]; }
+
+  /// index into row_spans(r) of the interval strictly containing x, or -1
+  int row_cover(int r, double x) const { return cover(row_spans_[r], x); }
+  /// index into col_spans(c) of the interval strictly containing y, or -1
+  int col_cover(int c, double y) const { return cover(col_spans_[c], y); }
+  /// true if an x-interval of row r and a y-interval of column c cross
+  bool crossing(int r, int c) const {
+    return row_cover(r, col_x_[c]) >= 0 && col_cover(c, row_y_[r]) >= 0;
+  }
+  /// first column with x-coordinate > x
+  int first_col_above(double x) const;
+  /// first row with y-coordinate > y
+  int first_row_above(double y) const;
+
+  /// index of the span strictly containing c, or -1
+  static int cover(const SpanList &spans, double c);
+
+protected:
+  std::vector<SpanList> row_spans_; ///< x-intervals per row
+  std::vector<SpanList> col_spans_; ///< y-intervals per column
+  std::vector<int> row_fiber_;      ///< row -> x-fiber index
+  std::vector<int> col_fiber_;      ///< column -> y-fiber index
+  std::vector<int> row_rank_;       ///< x-fiber index -> row
+  std::vector<int> col_rank_;       ///< y-fiber index -> column
+  std::vector<double> row_y_;       ///< y-coordinate of each row
+  std::vector<double> col_x_;       ///< x-coordinate of each column
+};
+
+} // namespace weave
+
+} // namespace ocl
+#endif
+// end file fiber_grid.hpp
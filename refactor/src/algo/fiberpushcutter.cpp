@@ -27,6 +27,7 @@
 
 #include "cutters/millingcutter.hpp"
 #include "fiberpushcutter.hpp"
+#include "geo/meshindex.hpp"
 #include "geo/point.hpp"
 #include "geo/triangle.hpp"
 
@@ -37,16 +38,18 @@ namespace ocl {
 
 FiberPushCutter::FiberPushCutter() {
   nCalls = 0;
+  calls = 0;
+  skipped = 0;
   cutter = NULL;
   bucketSize = 1;
-  root = new KDTree<Triangle>();
+  root = new KDTree<IndexedMesh>();
 }
 
 FiberPushCutter::~FiberPushCutter() { delete root; }
 
 void FiberPushCutter::setSTL(const STLSurf& s)
 {
-    surf = &s;
+    surf = &cullROI(s);
     // std::cout << "BPC::setSTL() Building kd-tree... bucketSize=" << bucketSize
     // << "..";
     root->setBucketSize(bucketSize);
@@ -60,7 +63,7 @@ void FiberPushCutter::setSTL(const STLSurf& s)
         assert(0);
     }
     // std::cout << "BPC::setSTL() root->build()";
-    root->build(s.tris);
+    MeshIndex::buildTree(*root, *surf);
     // std::cout << " done.\n";
 }
 
@@ -72,20 +75,19 @@ void FiberPushCutter::run(Fiber& f)
 }
 
 void FiberPushCutter::pushCutter1(Fiber &f) {
-  nCalls = 0;
+  int n = 0;
   BOOST_FOREACH (const Triangle &t,
                  surf->tris) { // test against all triangles in s
     Interval i;
     cutter->pushCutter(f, i, t);
     f.addInterval(i);
-    ++nCalls;
+    ++n;
   }
+  calls += n;
 }
 
 void FiberPushCutter::pushCutter2(Fiber &f) {
-  std::list<Triangle>::iterator it, it_end; // for looping over found triangles
-  Interval *i;
-  std::list<Triangle> *tris;
+  std::vector<std::uint32_t> faces;
   CLPoint cl;
   if (x_direction) {
     cl.x = 0;
@@ -96,16 +98,23 @@ void FiberPushCutter::pushCutter2(Fiber &f) {
     cl.y = 0;
     cl.z = f.p1.z;
   }
-  tris = root->search_cutter_overlap(cutter, &cl);
-  it_end = tris->end();
-  for (it = tris->begin(); it != it_end; ++it) {
-    i = new Interval();
-    cutter->pushCutter(f, *i, *it);
-    f.addInterval(*i);
-    ++nCalls;
-    delete i;
+  root->search_cutter_overlap(cutter, &cl, faces);
+  int n = 0;
+  int s = 0;
+  Triangle t;
+  for (std::uint32_t face : faces) { // loop over found triangles
+    surf->mesh.triangle(face, t);
+    if (!cutter->overlapsFiber(f, t)) {
+      ++s;
+      continue;
+    }
+    Interval i;
+    cutter->pushCutter(f, i, t);
+    f.addInterval(i);
+    ++n;
   }
-  delete (tris);
+  calls += n;
+  skipped += s;
 }
 
 } // namespace ocl
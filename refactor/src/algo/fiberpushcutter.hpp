@@ -22,6 +22,7 @@
 #ifndef FIBERPUSHCUTTER_H
 #define FIBERPUSHCUTTER_H
 
+#include <atomic>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -56,7 +57,14 @@ public:
   }
   /// run() is an error.
   void run() { assert(0); }
+  /// push the cutter along f. Safe to call concurrently on different fibers,
+  /// the kd-tree and cutter are only read.
   void run(Fiber& f) override;
+  /// number of pushCutter() calls, summed over all run() calls
+  int getCalls() const override { return calls.load(); }
+  /// number of pushCutter() calls saved by overlapsFiber(), summed over all
+  /// run() calls
+  int getSkippedCalls() const override { return skipped.load(); }
 
   protected:
   /// input fiber is tested against all triangles of surface
@@ -69,6 +77,10 @@ public:
   bool x_direction;
   /// true if we have y-direction fibers
   bool y_direction;
+  /// pushCutter() call count, updated once per fiber by concurrent run() calls
+  std::atomic<int> calls;
+  /// overlapsFiber() rejection count, updated like calls
+  std::atomic<int> skipped;
 };
 
 } // namespace ocl
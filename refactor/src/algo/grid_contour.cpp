@@ -0,0 +1,208 @@
+/*  $Id$
+ * 
+ *  Copyright (c) 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *  
+ *  This file is part of OpenCAMlib 
+ *  (see https://github.com/aewallin/opencamlib).
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cassert>
+
+#include "grid_contour.hpp"
+
+namespace ocl
+{
+
+namespace weave
+{
+
+void GridContour::addFiber(Fiber& f) {
+    if ( f.dir.xParallel() && !f.empty() ) {
+        xfibers.push_back(f);
+    } else if ( f.dir.yParallel() && !f.empty() ) {
+        yfibers.push_back(f);
+    } else if (!f.empty()) {
+        assert(0); // fiber must be either x or y
+    }
+}
+
+void GridContour::build() {
+    grid.build( xfibers, yfibers );
+    row_done.resize( grid.rows() );
+    for (int r=0; r<grid.rows(); ++r)
+        row_done[r].assign( 2*grid.row_spans(r).size(), 0 );
+    col_done.resize( grid.cols() );
+    for (int c=0; c<grid.cols(); ++c)
+        col_done[c].assign( 2*grid.col_spans(c).size(), 0 );
+}
+
+bool GridContour::row_span_crossed(int r, int span) const {
+    const FiberGrid::Span& s = grid.row_spans(r)[span];
+    for (int c = grid.first_col_above(s.lo); c < grid.cols() && grid.col_x(c) < s.hi; ++c) {
+        if ( grid.col_cover( c, grid.row_y(r) ) >= 0 )
+            return true;
+    }
+    return false;
+}
+
+bool GridContour::col_span_crossed(int c, int span) const {
+    const FiberGrid::Span& s = grid.col_spans(c)[span];
+    for (int r = grid.first_row_above(s.lo); r < grid.rows() && grid.row_y(r) < s.hi; ++r) {
+        if ( grid.row_cover( r, grid.col_x(c) ) >= 0 )
+            return true;
+    }
+    return false;
+}
+
+Point GridContour::end_point(const Walker& w) const {
+    if ( w.on_row ) {
+        const Fiber& xf = xfibers[ grid.row_fiber(w.line) ];
+        const Interval& xi = xf.ints[ grid.row_spans(w.line)[w.span].ival ];
+        return xf.point( w.dir > 0 ? xi.upper : xi.lower );
+    } else {
+        const Fiber& yf = yfibers[ grid.col_fiber(w.line) ];
+        const Interval& yi = yf.ints[ grid.col_spans(w.line)[w.span].ival ];
+        return yf.point( w.dir > 0 ? yi.upper : yi.lower );
+    }
+}
+
+char& GridContour::end_flag(const Walker& w) {
+    std::vector<char>& done = w.on_row ? row_done[w.line] : col_done[w.line];
+    return done[ 2*w.span + (w.dir > 0 ? 1 : 0) ];
+}
+
+// start at every unvisited interval end-point that is on a loop:
+// x-intervals (lower, upper) in fiber order, then y-intervals.
+// an interval that no other interval crosses has no vertices in the weave.
+void GridContour::face_traverse() {
+    for (unsigned int i=0; i<xfibers.size(); ++i) {
+        const int r = grid.row_of(i);
+        for (int k=0; k<(int)grid.row_spans(r).size(); ++k) {
+            if ( (row_done[r][2*k] && row_done[r][2*k+1]) || !row_span_crossed(r, k) )
+                continue;
+            const FiberGrid::Span& s = grid.row_spans(r)[k];
+            if ( !row_done[r][2*k] ) { // from the lower end-point, heading +x
+                Walker w = { true, r, k, s.lo, +1 };
+                trace(w);
+            }
+            if ( !row_done[r][2*k+1] ) { // from the upper end-point, heading -x
+                Walker w = { true, r, k, s.hi, -1 };
+                trace(w);
+            }
+        }
+    }
+    for (unsigned int j=0; j<yfibers.size(); ++j) {
+        const int c = grid.col_of(j);
+        for (int k=0; k<(int)grid.col_spans(c).size(); ++k) {
+            if ( (col_done[c][2*k] && col_done[c][2*k+1]) || !col_span_crossed(c, k) )
+                continue;
+            const FiberGrid::Span& s = grid.col_spans(c)[k];
+            if ( !col_done[c][2*k] ) {
+                Walker w = { false, c, k, s.lo, +1 };
+                trace(w);
+            }
+            if ( !col_done[c][2*k+1] ) {
+                Walker w = { false, c, k, s.hi, -1 };
+                trace(w);
+            }
+        }
+    }
+}
+
+// walk the face as Weave::face_traverse() does: along the interval to the next
+// crossing, turn right (+x -> -y -> -x -> +y -> +x), and at an end-point record the
+// CL-point and turn back.
+void GridContour::trace(Walker w) {
+    std::vector<Point> loop;
+    // the start point is the end-point behind the walker
+    Walker back = w;
+    back.dir = -w.dir;
+    end_flag(back) = 1;
+    loop.push_back( end_point(back) );
+    const Walker start = back;
+
+    for (;;) {
+        bool turned = false;
+        if ( w.on_row ) {
+            const FiberGrid::Span& s = grid.row_spans(w.line)[w.span];
+            const double y = grid.row_y(w.line);
+            if ( w.dir > 0 ) {
+                for (int c = grid.first_col_above(w.pos); c < grid.cols() && grid.col_x(c) < s.hi; ++c) {
+                    int k = grid.col_cover(c, y);
+                    if ( k >= 0 ) { // +x turns to -y
+                        w.on_row = false; w.line = c; w.span = k; w.pos = y; w.dir = -1;
+                        turned = true;
+                        break;
+                    }
+                }
+            } else {
+                for (int c = grid.first_col_above(w.pos) - 1; c >= 0 && grid.col_x(c) > s.lo; --c) {
+                    if ( !(grid.col_x(c) < w.pos) )
+                        continue;
+                    int k = grid.col_cover(c, y);
+                    if ( k >= 0 ) { // -x turns to +y
+                        w.on_row = false; w.line = c; w.span = k; w.pos = y; w.dir = +1;
+                        turned = true;
+                        break;
+                    }
+                }
+            }
+        } else {
+            const FiberGrid::Span& s = grid.col_spans(w.line)[w.span];
+            const double x = grid.col_x(w.line);
+            if ( w.dir > 0 ) {
+                for (int r = grid.first_row_above(w.pos); r < grid.rows() && grid.row_y(r) < s.hi; ++r) {
+                    int k = grid.row_cover(r, x);
+                    if ( k >= 0 ) { // +y turns to +x
+                        w.on_row = true; w.line = r; w.span = k; w.pos = x; w.dir = +1;
+                        turned = true;
+                        break;
+                    }
+                }
+            } else {
+                for (int r = grid.first_row_above(w.pos) - 1; r >= 0 && grid.row_y(r) > s.lo; --r) {
+                    if ( !(grid.row_y(r) < w.pos) )
+                        continue;
+                    int k = grid.row_cover(r, x);
+                    if ( k >= 0 ) { // -y turns to -x
+                        w.on_row = true; w.line = r; w.span = k; w.pos = x; w.dir = -1;
+                        turned = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if ( turned )
+            continue;
+        // no crossing before the end of the interval: arrive at a CL-point
+        if ( w.on_row == start.on_row && w.line == start.line && w.span == start.span && w.dir == start.dir )
+            break; // back at the start
+        char& flag = end_flag(w);
+        assert( !flag ); // every CL-point is on exactly one loop
+        flag = 1;
+        loop.push_back( end_point(w) );
+        // turn back along the same interval
+        const FiberGrid::SpanList& spans = w.on_row ? grid.row_spans(w.line) : grid.col_spans(w.line);
+        w.pos = w.dir > 0 ? spans[w.span].hi : spans[w.span].lo;
+        w.dir = -w.dir;
+    }
+    loops.push_back(loop);
+}
+
+} // end weave namespace
+
+} // end ocl namespace
+// end file grid_contour.cpp
@@ -0,0 +1,94 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GRID_CONTOUR_HPP
+#define GRID_CONTOUR_HPP
+
+#include <vector>
+
+#include "fiber.hpp"
+#include "fiber_grid.hpp"
+
+namespace ocl {
+
+namespace weave {
+
+/// Waterline loops traced directly from the fiber intervals, without a
+/// WeaveGraph.
+///
+/// The loops of a weave are found by walking along an interval to the next
+/// crossing, turning right there, and turning back at interval end-points
+/// (the CL-points). GridContour does the same walk on the FiberGrid: the next
+/// crossing along a row or column is found from the sorted intervals, so no
+/// vertices or edges are ever stored. The result is the same set of loops, with
+/// the same CL-points in the same cyclic order, as
+/// SimpleWeave/SparseWeave + face_traverse() + getLoops(). Loops are listed in
+/// the order of their first CL-point along the x-fibers (then y-fibers), and
+/// each loop starts at that point.
+///
+/// Memory is proportional to the number of intervals (the perimeter); time is
+/// proportional to the grid size plus the length of the loops.
+class OCL_API GridContour {
+public:
+  GridContour() {}
+  virtual ~GridContour() {}
+  /// add Fiber f. each fiber should be either in the X or Y-direction
+  void addFiber(Fiber &f);
+  /// sort the fibers and intervals into a FiberGrid
+  void build();
+  /// trace the loops
+  void face_traverse();
+  /// return list of loops
+  std::vector<std::vector<Point>> getLoops() const { return loops; }
+
+protected:
+  /// a position while walking: on a row (x-interval) or a column (y-interval)
+  struct Walker {
+    bool on_row; ///< true when walking along an x-interval
+    int line;    ///< row or column
+    int span;    ///< index into row_spans()/col_spans() of the line
+    double pos;  ///< current coordinate along the line
+    int dir;     ///< +1 or -1 along the line
+  };
+  /// trace the loop that starts at the given interval end-point
+  void trace(Walker w);
+  /// CL-point at the end of the current interval that w is heading towards
+  Point end_point(const Walker &w) const;
+  /// visited-flag of the end-point that w is heading towards
+  char &end_flag(const Walker &w);
+  /// true if any y-interval crosses the x-interval span of row r
+  bool row_span_crossed(int r, int span) const;
+  /// true if any x-interval crosses the y-interval span of column c
+  bool col_span_crossed(int c, int span) const;
+
+  std::vector<Fiber> xfibers; ///< the X-fibers
+  std::vector<Fiber> yfibers; ///< the Y-fibers
+  FiberGrid grid;             ///< rows, columns and sorted intervals
+  /// visited flags, two per interval (lower, upper end-point)
+  std::vector<std::vector<char>> row_done;
+  std::vector<std::vector<char>> col_done;
+  std::vector<std::vector<Point>> loops; ///< output
+};
+
+} // namespace weave
+
+} // namespace ocl
+#endif
+// end file grid_contour.hpp
@@ -0,0 +1,59 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "operation.hpp"
+#include "cutters/millingcutter.hpp"
+#include "geo/stlsurf.hpp"
+
+namespace ocl
+{
+
+Operation::~Operation()
+{
+    // std::cout << "~Operation()\n";
+}
+
+std::size_t Operation::getROIFaces() const
+{
+    return surf ? surf->size() : 0;
+}
+
+const STLSurf& Operation::cullROI(const STLSurf& s)
+{
+    input = &s;
+    if (roi.empty()) {
+        roiSurf.reset();
+        return s;
+    }
+    roiRadius = cutterRadius();
+    // the sub-operations still point at the old surface until setSTL()
+    // passes them the new one
+    roiSurf.reset(new STLSurf(roi.cull(s, roiRadius)));
+    return *roiSurf;
+}
+
+double Operation::cutterRadius() const
+{
+    return cutter ? cutter->getRadius() : 0.0;
+}
+
+}  // namespace ocl
+// end file operation.cpp
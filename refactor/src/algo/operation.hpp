@@ -23,12 +23,16 @@
 #define OP_H
 
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "common/executor.hpp"
 #include "common/kdtree.hpp"
 #include "fiber.hpp"
+#include "geo/indexedmesh.hpp"
 #include "geo/point.hpp"
+#include "geo/regionofinterest.hpp"
 
 namespace ocl
 {
@@ -45,38 +49,79 @@ class OCL_API Operation
 public:
     Operation()
     {}
-    virtual ~Operation()
-    {
-        // std::cout << "~Operation()\n";
-    }
-    /// set the STL-surface and build kd-tree
+    virtual ~Operation();
+    /// set the STL-surface and build kd-tree. A kd-tree index attached to
+    /// the surface (STLSurf::addIndex(), MeshSnapshot::load()) with the
+    /// plane and bucket-size of the operation is restored instead of built.
+    /// With a region of interest (setROI()) only the part of s near the
+    /// region is indexed, and passed on to the sub-operations.
     virtual void setSTL(const STLSurf& s)
     {
-        surf = &s;
+        surf = &cullROI(s);
         BOOST_FOREACH (Operation* op, subOp) {
-            op->setSTL(s);
+            op->setSTL(*surf);
         }
     }
-    /// set the MillingCutter to use
+    /// set the MillingCutter to use. With a region of interest the surface is
+    /// culled again if the cutter radius changed, so set the cutter before
+    /// the surface to build the kd-tree once.
     virtual void setCutter(const MillingCutter* c)
     {
         cutter = c;
         BOOST_FOREACH (Operation* op, subOp) {
             op->setCutter(cutter);
         }
+        if (!roi.empty() && input && roiRadius != cutterRadius())
+            setSTL(*input);
+    }
+    /// \brief restrict the operation to the region of interest r, see
+    /// RegionOfInterest. The surface already set is culled again. An empty
+    /// region restores the whole surface.
+    void setROI(const RegionOfInterest& r)
+    {
+        roi = r;
+        if (input)
+            setSTL(*input);
+    }
+    /// remove the region of interest
+    void clearROI()
+    {
+        setROI(RegionOfInterest());
+    }
+    /// return the region of interest
+    const RegionOfInterest& getROI() const
+    {
+        return roi;
+    }
+    /// \brief number of triangles the operation works on: those kept by the
+    /// region of interest, or all of the surface
+    std::size_t getROIFaces() const;
+    /// set the Executor that runs the parallel parts of this Operation and
+    /// all sub-operations
+    void setExecutor(const Executor& e)
+    {
+        executor = e;
+        BOOST_FOREACH (Operation* op, subOp) {
+            op->setExecutor(executor);
+        }
+    }
+    /// return the Executor of this Operation
+    const Executor& getExecutor() const
+    {
+        return executor;
     }
-    /// set number of OpenMP threads. Defaults to OpenMP::omp_get_num_procs()
+    /// set number of threads, for every backend. Defaults to all hardware threads
     void setThreads(unsigned int n)
     {
-        nthreads = n;
+        executor.setThreads(n);
         BOOST_FOREACH (Operation* op, subOp) {
-            op->setThreads(nthreads);
+            op->setThreads(n);
         }
     }
-    /// return number of OpenMP threads
+    /// return number of threads
     int getThreads() const
     {
-        return nthreads;
+        return executor.getThreads();
     }
     /// return the kd-tree bucket-size
     int getBucketSize() const
@@ -91,11 +136,27 @@ public:
             op->setBucketSize(bucketSize);
         }
     }
+    /// \brief test drop-cutter candidates in order of descending triangle
+    /// max-z. Operations with a drop-cutter kd-tree override this, the
+    /// default only forwards to sub-operations.
+    virtual void setSortByMaxZ(bool s)
+    {
+        BOOST_FOREACH (Operation* op, subOp) {
+            op->setSortByMaxZ(s);
+        }
+    }
     /// return number of low-level calls
-    int getCalls() const
+    virtual int getCalls() const
     {
         return nCalls;
     }
+    /// return number of low-level calls saved by the exact cutter-footprint
+    /// test, i.e. triangles found by the kd-tree search but rejected by
+    /// MillingCutter::overlapsDisc() or MillingCutter::overlapsFiber()
+    virtual int getSkippedCalls() const
+    {
+        return nSkipped;
+    }
 
     /// set the sampling interval for this Operation and all sub-operations
     virtual void setSampling(double s)
@@ -154,30 +215,47 @@ public:
         return 0;
     }
 
+    /// shorthand for selecting the TBB (or the default) Executor backend
     void setForceUseTBB(bool force_use_tbb)
     {
-        this->force_use_tbb = force_use_tbb;
+        Executor e = executor;
+        e.setBackend(force_use_tbb ? Executor::TBB : Executor::defaultBackend());
+        setExecutor(e);
     }
 
 protected:
+    /// \brief return s, or with a region of interest the part of s within the
+    /// cutter radius of it, owned by this operation. Called by setSTL().
+    const STLSurf& cullROI(const STLSurf& s);
+    /// radius of cutter, zero without a cutter
+    double cutterRadius() const;
+
     /// sampling interval
     double sampling;
     /// how many low-level calls were made
     int nCalls;
+    /// how many low-level calls the exact footprint test saved
+    int nSkipped {0};
     /// size of bucket-node in KD-tree
     unsigned int bucketSize;
     /// the MillingCutter used
-    const MillingCutter* cutter;
+    const MillingCutter* cutter {nullptr};
     /// the STLSurf which we test against.
-    const STLSurf* surf;
+    const STLSurf* surf {nullptr};
     /// root of a kd-tree
-    KDTree<Triangle>* root;
-    /// number of threads to use
-    unsigned int nthreads;
+    KDTree<IndexedMesh>* root;
+    /// runs the parallel parts of this operation
+    Executor executor;
     /// sub-operations, if any, of this operation
     std::vector<Operation*> subOp;
-
-    bool force_use_tbb {false};
+    /// the region of interest, empty for the whole surface
+    RegionOfInterest roi;
+    /// the surface given to setSTL(), before culling
+    const STLSurf* input {nullptr};
+    /// the culled surface, when there is a region of interest
+    std::unique_ptr<STLSurf> roiSurf;
+    /// cutter radius roiSurf was culled with
+    double roiRadius {0.0};
 };
 
 }  // namespace ocl
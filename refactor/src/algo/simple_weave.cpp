@@ -22,6 +22,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <tuple>
 
 #include "simple_weave.hpp"
 
@@ -52,6 +53,7 @@ std::pair<Vertex,Vertex> SimpleWeave::find_neighbor_vertices( VertexPair v_pair,
 // vertices/edges belonging to non-toolpath-producing faces could then be deleted
 // and the RAM consumption should be limited to N+N (i.e. the length/perimeter of the part/toolpath
 // in contrast to the area for the naive implementation)
+// SparseWeave::build() does this by not creating the interior vertices at all.
 void SimpleWeave::build() {
     // 1) add CL-points of X-fiber (if not already in graph)
     // 2) add CL-points of Y-fiber (if not already in graph)
@@ -112,10 +114,10 @@ void SimpleWeave::build() {
                             Vertex x_u, x_l;
                             
                             //std::cout << " fins neighbor to x= " << v_position.x << "\n";
-                            boost::tie( x_u, x_l ) = find_neighbor_vertices( VertexPair(v, v_position.x), xi );
+                            std::tie( x_u, x_l ) = find_neighbor_vertices( VertexPair(v, v_position.x), xi );
                             //std::cout << "found: x_u , x_l : " << x_u << " , " << x_l << "\n";
                             Vertex y_u, y_l;
-                            boost::tie( y_u, y_l ) = find_neighbor_vertices( VertexPair(v, v_position.y), yi );
+                            std::tie( y_u, y_l ) = find_neighbor_vertices( VertexPair(v, v_position.y), yi );
                             
                             //std::cout << "found: y_u , y_l : " << y_u << " , " << y_l << "\n";
                             
@@ -19,10 +19,14 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <climits>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <tuple>
 
+#include "common/threadbudget.hpp"
 #include "smart_weave.hpp"
 
 namespace ocl
@@ -31,390 +35,525 @@ namespace ocl
 namespace weave
 {
 
-// given a VertexPair and an Interval, in the Interval find the Vertex above and below the given vertex
-std::pair<Vertex,Vertex> SmartWeave::find_neighbor_vertices( VertexPair v_pair, Interval& ival, bool above_equality ) { 
-    Interval::VertexPairIterator itr = ival.intersections2.lower_bound( v_pair ); // returns first that is not less than argument (equal or greater)
-    assert( itr != ival.intersections2.end() ); // we must find a lower_bound
-    Interval::VertexPairIterator v_above; 
-    if ( above_equality ) 
-        v_above = itr; // lower_bound returns one beyond the give key, i.e. what we want
-    else {
-        v_above = ++itr;
-        --itr;
-    }
-    Interval::VertexPairIterator v_below = --itr; // this is the vertex below the given vertex
-    std::pair<Vertex,Vertex> out;
-    out.first = v_above->first; // vertex above v (xu)
-    out.second = v_below->first; // vertex below v (xl)
-    return out;
+namespace {
+
+template <class T>
+void append_all( const std::vector< std::vector<T> >& parts, std::vector<T>& out ) {
+    for ( const std::vector<T>& p : parts )
+        out.insert( out.end(), p.begin(), p.end() );
 }
 
+} // end anonymous namespace
 
-// this is the new smarter build() which uses less RAM
-void SmartWeave::build() {
-    // std::cout << " SmartWeave::build()... \n";
-    
-    // this adds all CL-vertices from x-intervals
-    // it also populates the xi.intersections_fibers set of intersecting y-fibers
-    // also add the first-crossing vertex and the last-crossing vertex
-    
-    //std::cout << " build2() add_vertices_x() ... " << std::flush ;
-    add_vertices_x();
-    //std::cout << " done.\n" << std::flush ;
-    // the same for y-intervals, add all CL-points, and intersections to the set.
-    //std::cout << " build2() add_vertices_y() ... " << std::flush ;
-    add_vertices_y();
-    //std::cout << " done.\n" << std::flush ;
-    
-    //std::cout << " build2() looping over xfibers ... " << std::flush ;
-    BOOST_FOREACH( Fiber& xf, xfibers ) {
-        std::vector<Interval>::iterator xi;
-        for( xi = xf.ints.begin(); xi < xf.ints.end(); xi++ ) {
-            std::set<std::vector<Fiber>::iterator>::const_iterator current, prev;
-            if( xi->intersections_fibers.size() > 1 ) {
-                current = xi->intersections_fibers.begin();
-                prev = current++;
-                for( ; current != xi->intersections_fibers.end(); current++ ) {
-                    // for each x-interval, loop through the intersecting y-fibers
-                    if( (*current - *prev) > 1 ) {
-                        std::vector<Interval>::iterator yi = find_interval_crossing_x( xf, *(*prev + 1) );
-                        add_vertex( xf, *(*prev + 1), xi , yi, FULLINT );
-                        if( (*current - *prev) > 2 ) {
-                            yi = find_interval_crossing_x( xf, *(*current - 1) );
-                            add_vertex( xf, *(*current - 1), xi, yi, FULLINT );
-                        }
-                    }
-                    prev = current;
-                }
-            }
-        }
-    }
-    //std::cout << " done.\n" << std::flush ;
-    
-    //std::cout << " build2() looping over yfibers ... " << std::flush ;
-    //std::cout << yfibers.size() << " fibers to loop over \n"<< std::flush ; 
-    //int ny = 0;
-    BOOST_FOREACH( Fiber& yf, yfibers ) {
-        //std::cout << " fiber nr: " << ny++ << " has " << yf.ints.size() << " intervals\n" << std::flush ;
-        std::vector<Interval>::iterator yi;
-        //int ny_int=0;
-        for( yi = yf.ints.begin(); yi < yf.ints.end(); yi++ ) {
-            //std::cout << "  interval nr: " << ny_int++ << " has yi->intersections_fibers.size()= " << yi->intersections_fibers.size() << "\n" << std::flush;
-            std::set<std::vector<Fiber>::iterator>::iterator current, prev;
-            if( yi->intersections_fibers.size() > 1 ) {
-                current = yi->intersections_fibers.begin();
-                prev = current++;
-                for( ; current != yi->intersections_fibers.end(); current++ ) {
-                    if( (*current - *prev) > 1 ) {
-                        std::vector<Interval>::iterator xi = find_interval_crossing_y( *(*prev + 1), yf );
-                        add_vertex( *(*prev + 1), yf, xi , yi, FULLINT );
-                        if( (*current - *prev) > 2 ) {
-                            xi = find_interval_crossing_y( *(*current - 1), yf );
-                            add_vertex( *(*current - 1), yf, xi, yi, FULLINT );
-                        }
-                    }
-                    prev = current;
-                }
-            }
-        }
-    }
-    //std::cout << " done.\n" << std::flush ;
-    
-    // std::cout << " SmartWeave::build() add_all_edges()... " << std::flush ;
-    add_all_edges();
-    // std::cout << " done.\n" << std::flush ;
+// crossings are sorted by (xf, yf), INT before FULLINT at the same place
+bool SmartWeave::by_x_fiber( const Crossing& a, const Crossing& b ) {
+    return std::tie( a.xf, a.yf, a.type ) < std::tie( b.xf, b.yf, b.type );
 }
 
-// add a new CL-vertex to Weave, also adding it to the interval intersection-set, and to clVertices
-Vertex SmartWeave::add_cl_vertex( const Point& position, Interval& ival, double ipos) {
-    Vertex  v = g.add_vertex(); 
-    g[v].position = position;
-    g[v].type = CL;
-    ival.intersections2.insert( VertexPair( v, ipos) ); // ?? this makes Interval depend on the WeaveGraph type
-    clVertexSet.insert(v);
-    return v;
+bool SmartWeave::by_y_fiber( const Crossing& a, const Crossing& b ) {
+    return std::tie( a.yf, a.xf ) < std::tie( b.yf, b.xf );
 }
 
-void SmartWeave::add_vertices_x() {
-    std::vector<Fiber>::iterator xf;
-    for( xf = xfibers.begin(); xf < xfibers.end(); xf++ ) {
-        std::vector<Interval>::iterator xi;
-        for( xi = xf->ints.begin(); xi < xf->ints.end(); xi++ ) {
-            // find first and last fiber crossing this interval
-            std::vector<Fiber>::iterator yf = yfibers.begin();
-            std::vector<Interval>::iterator yi;
-
-            bool is_crossing = crossing_x( *yf, yi, *xi, *xf );
-            while( (yf<yfibers.end()) && !is_crossing ) {// first crossing 
-                yf++;
-                if( yf<yfibers.end() ) is_crossing = crossing_x( *yf, yi, *xi, *xf );
-            }
+bool SmartWeave::same_place( const Crossing& a, const Crossing& b ) {
+    return a.xf == b.xf && a.yf == b.yf;
+}
 
-            if( yf < yfibers.end() ) {
-                Point lower( xf->point( xi->lower ) );
-                add_cl_vertex( lower, *xi, lower.x );
-                Point upper( xf->point( xi->upper ) );
-                add_cl_vertex( upper, *xi, upper.x );
+void SmartWeave::set_side( VertexStar& star, int k, Vertex adj, Edge in, Edge out ) {
+    star.adj[k] = adj;
+    star.in[k] = in;
+    star.out[k] = out;
+}
 
-                add_vertex( *xf, *yf, xi, yi, INT ); // the first crossing vertex
-                xi->intersections_fibers.insert( yf );
-                yi->intersections_fibers.insert( xf );
+// fibers per chunk when the fiber or vertex lists are split up for the parallel loops
+int SmartWeave::tile_size(int n) const {
+    return std::max(1, n / (8 * std::max(1, nthreads)));
+}
 
-                is_crossing = crossing_x( *yf, yi, *xi, *xf );
-                while( (yf<yfibers.end()) && is_crossing ) {// last crossing 
-                    yf++;
-                    if( yf<yfibers.end() ) is_crossing = crossing_x( *yf, yi, *xi, *xf );
-                }
-                add_vertex( *xf, *(--yf), xi, yi, INT ); // the last crossing vertex
-                xi->intersections_fibers.insert( yf );
-                yi->intersections_fibers.insert( xf );
-            }
-        }// end foreach x-interval
-    }// end foreach x-fiber
+// at most 64 x 64 tiles, but not smaller than 32 fibers
+int SmartWeave::tile_fibers(int n) {
+    return std::max( 32, (n + 63) / 64 );
 }
 
-void SmartWeave::add_vertices_y() {
-    std::vector<Fiber>::iterator yf;
-    for( yf = yfibers.begin(); yf < yfibers.end(); yf++ ) {
-        std::vector<Interval>::iterator yi;
-        for( yi = yf->ints.begin(); yi < yf->ints.end(); yi++ ) {
-            std::vector<Fiber>::iterator xf = xfibers.begin();
-            std::vector<Interval>::iterator xi;
-            
-            // find first and last fiber crossing this interval
-            bool is_crossing = crossing_y( *xf, xi, *yi, *yf );
-            while ( (xf<xfibers.end()) && !is_crossing ) {
-                xf++;
-                if( xf<xfibers.end() ) is_crossing = crossing_y( *xf, xi, *yi, *yf );
-            }
+// this is the new smarter build() which uses less RAM
+// 1) in parallel over fibers, find the INT vertices (the first and last crossing of
+//    every interval) and the FULLINT vertices next to the gaps between them
+// 2) in parallel over XY tiles of fibers, build a sub-weave of the vertices in the tile
+//    and the edges between them
+// 3) append the sub-weaves to g and stitch them with the edges across the tile borders
+// 4) in parallel, set next/prev around every INT/FULLINT vertex
+// the tiles do not depend on the number of threads, so the weave is the same for any
+// number of threads.
+void SmartWeave::build() {
+    // the team is leased from the process-wide budget, see ThreadBudget
+    ThreadLease lease( ThreadBudget::isOpenMPEnabled() ? nthreads : 1 );
+    team = static_cast<int>( lease.threads() );
+    // sort the fibers and precompute the interval end-points, so that the
+    // crossing searches below are binary searches instead of full scans
+    build_index();
+    std::vector<Tile> tiles = make_tiles( find_crossings() );
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(team)
+    for (int n = 0; n < static_cast<int>( tiles.size() ); ++n)
+        build_tile( tiles[n] );
+    stitch_tiles( tiles );
+    link_edges( tiles );
+}
 
-            if( xf < xfibers.end() ) {
-                Point lower( yf->point( yi->lower ) );
-                add_cl_vertex( lower, *yi, lower.y );
-                Point upper( yf->point( yi->upper ) );
-                add_cl_vertex( upper, *yi, upper.y );
+// all INT and FULLINT vertices, sorted by (xf, yf)
+std::vector<SmartWeave::Crossing> SmartWeave::find_crossings() const {
+    const int nx = static_cast<int>( xfibers.size() );
+    const int ny = static_cast<int>( yfibers.size() );
+    std::vector< std::vector<Crossing> > xseeds( nx );
+    std::vector< std::vector<Crossing> > yseeds( ny );
+    #pragma omp parallel for schedule(dynamic, tile_size(nx)) num_threads(team)
+    for (int n = 0; n < nx; ++n)
+        seeds_x( n, xseeds[n] );
+    #pragma omp parallel for schedule(dynamic, tile_size(ny)) num_threads(team)
+    for (int n = 0; n < ny; ++n)
+        seeds_y( n, yseeds[n] );
+    // a crossing found from both of its intervals is one vertex
+    std::vector<Crossing> ints;
+    append_all( xseeds, ints );
+    append_all( yseeds, ints );
+    std::sort( ints.begin(), ints.end(), by_x_fiber );
+    ints.erase( std::unique( ints.begin(), ints.end(), same_place ), ints.end() );
+
+    // the gaps are looked up per fiber, in the crossings of that fiber
+    std::vector<Crossing> ints_y( ints );
+    std::sort( ints_y.begin(), ints_y.end(), by_y_fiber );
+    std::vector< std::vector<Crossing> > xgaps( nx );
+    std::vector< std::vector<Crossing> > ygaps( ny );
+    #pragma omp parallel for schedule(dynamic, tile_size(nx)) num_threads(team)
+    for (int n = 0; n < nx; ++n) {
+        Crossing key = { n, 0, 0, 0, INT };
+        const Crossing* first = ints.data() + ( std::lower_bound( ints.begin(), ints.end(), key,
+                            [](const Crossing& a, const Crossing& b) { return a.xf < b.xf; } ) - ints.begin() );
+        const Crossing* last = first;
+        while ( last < ints.data() + ints.size() && last->xf == n )
+            ++last;
+        gaps_x( n, first, last, xgaps[n] );
+    }
+    #pragma omp parallel for schedule(dynamic, tile_size(ny)) num_threads(team)
+    for (int n = 0; n < ny; ++n) {
+        Crossing key = { 0, 0, n, 0, INT };
+        const Crossing* first = ints_y.data() + ( std::lower_bound( ints_y.begin(), ints_y.end(), key,
+                            [](const Crossing& a, const Crossing& b) { return a.yf < b.yf; } ) - ints_y.begin() );
+        const Crossing* last = first;
+        while ( last < ints_y.data() + ints_y.size() && last->yf == n )
+            ++last;
+        gaps_y( n, first, last, ygaps[n] );
+    }
+    append_all( xgaps, ints );
+    append_all( ygaps, ints );
+    std::sort( ints.begin(), ints.end(), by_x_fiber );
+    ints.erase( std::unique( ints.begin(), ints.end(), same_place ), ints.end() );
+    return ints;
+}
 
-                if( add_vertex( *xf, *yf, xi, yi, INT ) ) { // add_vertex returns false if vertex already exists
-                    xi->intersections_fibers.insert( yf );
-                    yi->intersections_fibers.insert( xf );
-                }
+// the first crossing, and the last crossing of the first run of crossing y-fibers,
+// of every interval of x-fiber xf
+void SmartWeave::seeds_x( int xf, std::vector<Crossing>& out ) const {
+    for (int k = 0; k < static_cast<int>( xfibers[xf].ints.size() ); ++k) {
+        const double xmin = xindex[xf].lo[k];
+        const double xmax = xindex[xf].hi[k];
+        // y-fibers with x in [xmin, xmax], the only ones that can cross
+        int yf = std::lower_bound( yfiber_x.begin(), yfiber_x.end(), xmin ) - yfiber_x.begin();
+        const int yend = std::upper_bound( yfiber_x.begin(), yfiber_x.end(), xmax ) - yfiber_x.begin();
+        int yi = -1;
+        for( ; yf < yend; ++yf ) { // first crossing
+            yi = crossing_x( yf, xmin, xmax, xfiber_y[xf] );
+            if( yi >= 0 )
+                break;
+        }
+        if( yf == yend )
+            continue;
+        Crossing c = { xf, k, yf, yi, INT };
+        out.push_back( c );
+        while( yi >= 0 ) { // last crossing of the first run
+            c.yf = yf;
+            c.yi = yi;
+            ++yf;
+            yi = ( yf < yend ) ? crossing_x( yf, xmin, xmax, xfiber_y[xf] ) : -1;
+        }
+        out.push_back( c );
+    }
+}
 
-                bool is_crossing = crossing_y( *xf, xi, *yi, *yf );
-                while ( (xf<xfibers.end()) && is_crossing ) { 
-                    xf++;
-                    if( xf<xfibers.end() ) is_crossing = crossing_y( *xf, xi, *yi, *yf );
-                }
-                if( add_vertex( *(--xf), *yf, xi, yi, INT ) ) {
-                    xi->intersections_fibers.insert( yf );
-                    yi->intersections_fibers.insert( xf );
-                }
-            }
-        }// end foreach x-interval
-    }// end foreach x-fiber
+// the same for the intervals of y-fiber yf
+void SmartWeave::seeds_y( int yf, std::vector<Crossing>& out ) const {
+    for (int k = 0; k < static_cast<int>( yfibers[yf].ints.size() ); ++k) {
+        const double ymin = yindex[yf].lo[k];
+        const double ymax = yindex[yf].hi[k];
+        int xf = std::lower_bound( xfiber_y.begin(), xfiber_y.end(), ymin ) - xfiber_y.begin();
+        const int xend = std::upper_bound( xfiber_y.begin(), xfiber_y.end(), ymax ) - xfiber_y.begin();
+        int xi = -1;
+        for( ; xf < xend; ++xf ) {
+            xi = crossing_y( xf, ymin, ymax, yfiber_x[yf] );
+            if( xi >= 0 )
+                break;
+        }
+        if( xf == xend )
+            continue;
+        Crossing c = { xf, xi, yf, k, INT };
+        out.push_back( c );
+        while( xi >= 0 ) {
+            c.xf = xf;
+            c.xi = xi;
+            ++xf;
+            xi = ( xf < xend ) ? crossing_y( xf, ymin, ymax, yfiber_x[yf] ) : -1;
+        }
+        out.push_back( c );
+    }
 }
 
-//crossing_x fiber
-bool SmartWeave::crossing_x( Fiber& yf, std::vector<Interval>::iterator& yi, Interval& xi, Fiber& xf ) {
-    //if the FIBER crosses the xi interval
-    if( (yf.p1.x >= xf.point( xi.lower ).x) && (yf.p1.x <= xf.point( xi.upper ).x) ) {
-        //for all the intervals of this y-fiber...
-        std::vector<Interval>::iterator it;
-        for( it = yf.ints.begin(); it < yf.ints.end(); it++ ) {
-            //find the first INTERVAL which crosses our xi interval
-            if( (yf.point( it->lower ).y <= xf.p1.y) && (yf.point( it->upper ).y >= xf.p1.y) ) {
-                //save the y-interval iterator
-                //and return true because we found an interval
-                yi = it;
-                return true;
+// FULLINT vertices on both sides of every gap between the crossing y-fibers of an
+// interval of x-fiber xf. [begin, end) are the INT vertices on xf, sorted by yf.
+void SmartWeave::gaps_x( int xf, const Crossing* begin, const Crossing* end, std::vector<Crossing>& out ) const {
+    auto add = [&]( int k, int yf ) {
+        const int yi = find_interval_crossing_x( xf, yf );
+        if( yi >= 0 ) {
+            Crossing c = { xf, k, yf, yi, FULLINT };
+            out.push_back( c );
+        }
+    };
+    for (int k = 0; k < static_cast<int>( xfibers[xf].ints.size() ); ++k) {
+        int prev = -1;
+        for ( const Crossing* c = begin; c < end; ++c ) {
+            if( c->xi != k )
+                continue;
+            if( prev >= 0 && (c->yf - prev) > 1 ) {
+                add( k, prev + 1 );
+                if( (c->yf - prev) > 2 )
+                    add( k, c->yf - 1 );
             }
+            prev = c->yf;
         }
-        //return false, there is no y-interval on this y-fiber crossing our xi interval 
-        return false;
     }
-    //this y-fiber doesn't cross our xi interval
-    else 
-        return false;
 }
 
-//crossing_y fiber
-bool SmartWeave::crossing_y( Fiber& xf, std::vector<Interval>::iterator& xi, Interval& yi, Fiber& yf ) {
-    if( (xf.p1.y >= yf.point( yi.lower ).y) && (xf.p1.y <= yf.point( yi.upper ).y) ) {
-        std::vector<Interval>::iterator it;
-        for( it = xf.ints.begin(); it < xf.ints.end(); it++ ) {
-            if( (xf.point( it->lower ).x <= yf.p1.x) && (xf.point( it->upper ).x >= yf.p1.x) ) {
-                xi = it;
-                return true;
+// the same for the intervals of y-fiber yf, [begin, end) sorted by xf
+void SmartWeave::gaps_y( int yf, const Crossing* begin, const Crossing* end, std::vector<Crossing>& out ) const {
+    auto add = [&]( int k, int xf ) {
+        const int xi = find_interval_crossing_y( xf, yf );
+        if( xi >= 0 ) {
+            Crossing c = { xf, xi, yf, k, FULLINT };
+            out.push_back( c );
+        }
+    };
+    for (int k = 0; k < static_cast<int>( yfibers[yf].ints.size() ); ++k) {
+        int prev = -1;
+        for ( const Crossing* c = begin; c < end; ++c ) {
+            if( c->yi != k )
+                continue;
+            if( prev >= 0 && (c->xf - prev) > 1 ) {
+                add( k, prev + 1 );
+                if( (c->xf - prev) > 2 )
+                    add( k, c->xf - 1 );
             }
+            prev = c->xf;
         }
-        return false;
     }
-    else 
-        return false;
 }
 
-//find_interval_crossing_x
-std::vector<Interval>::iterator SmartWeave::find_interval_crossing_x( Fiber& xf, Fiber& yf ) {
-    std::vector<Interval>::iterator yi, xi;
-    yi = yf.ints.begin();
-    while( (yi<yf.ints.end()) && !crossing_y( xf, xi, *yi, yf ) ) 
-        yi++;
-    return yi;
+// distribute the crossings over the tiles. The end-points of an interval go to the
+// tile of the nearest crossing on it, so the edge to an end-point never crosses a border.
+std::vector<SmartWeave::Tile> SmartWeave::make_tiles( const std::vector<Crossing>& crossings ) const {
+    const int nx = static_cast<int>( xfibers.size() );
+    const int ny = static_cast<int>( yfibers.size() );
+    const int T = tile_fibers( std::max( nx, ny ) );
+    const int rows = (nx + T - 1) / T;
+    const int cols = (ny + T - 1) / T;
+    std::vector<Tile> tiles( rows * cols );
+    for (int n = 0; n < rows * cols; ++n) {
+        tiles[n].row = n / cols;
+        tiles[n].col = n % cols;
+    }
+    // the first and last crossing fiber of every interval
+    std::vector< std::vector< std::pair<int,int> > > xrange( nx );
+    std::vector< std::vector< std::pair<int,int> > > yrange( ny );
+    for (int n = 0; n < nx; ++n)
+        xrange[n].assign( xfibers[n].ints.size(), std::make_pair( INT_MAX, -1 ) );
+    for (int n = 0; n < ny; ++n)
+        yrange[n].assign( yfibers[n].ints.size(), std::make_pair( INT_MAX, -1 ) );
+    for ( const Crossing& c : crossings ) {
+        tiles[ (c.xf / T) * cols + c.yf / T ].crossings.push_back( c );
+        std::pair<int,int>& xr = xrange[c.xf][c.xi];
+        xr.first = std::min( xr.first, c.yf );
+        xr.second = std::max( xr.second, c.yf );
+        std::pair<int,int>& yr = yrange[c.yf][c.yi];
+        yr.first = std::min( yr.first, c.xf );
+        yr.second = std::max( yr.second, c.xf );
+    }
+    for (int n = 0; n < nx; ++n) {
+        for (int k = 0; k < static_cast<int>( xrange[n].size() ); ++k) {
+            if( xrange[n][k].second < 0 )
+                continue; // no crossings, the interval is not in the weave
+            EndPoint lower = { true, n, k, false };
+            EndPoint upper = { true, n, k, true };
+            tiles[ (n / T) * cols + xrange[n][k].first / T ].ends.push_back( lower );
+            tiles[ (n / T) * cols + xrange[n][k].second / T ].ends.push_back( upper );
+        }
+    }
+    for (int n = 0; n < ny; ++n) {
+        for (int k = 0; k < static_cast<int>( yrange[n].size() ); ++k) {
+            if( yrange[n][k].second < 0 )
+                continue;
+            EndPoint lower = { false, n, k, false };
+            EndPoint upper = { false, n, k, true };
+            tiles[ (yrange[n][k].first / T) * cols + n / T ].ends.push_back( lower );
+            tiles[ (yrange[n][k].second / T) * cols + n / T ].ends.push_back( upper );
+        }
+    }
+    return tiles;
 }
 
-//crossing_y interval
-std::vector<Interval>::iterator SmartWeave::find_interval_crossing_y( Fiber& xf, Fiber& yf ) {
-    std::vector<Interval>::iterator xi, yi;
-    xi = xf.ints.begin();
-    while( (xi<xf.ints.end()) && !crossing_x( yf, yi, *xi, xf ) ) 
-        xi++;
-    return xi;
+// the sub-weave of one tile: its vertices, and the edges between neighboring
+// vertices on the same interval
+void SmartWeave::build_tile( Tile& t ) {
+    const int ncross = static_cast<int>( t.crossings.size() );
+    t.sub.reserve( ncross + t.ends.size(), 4 * ncross + 2 * t.ends.size() );
+    std::vector<OnInterval> xon;
+    std::vector<OnInterval> yon;
+    for ( const Crossing& c : t.crossings ) {
+        const Fiber& xf = xfibers[c.xf];
+        const Fiber& yf = yfibers[c.yf];
+        Vertex v = t.sub.add_vertex();
+        t.sub[v].position = Point( yf.p1.x, xf.p1.y, xf.p1.z );
+        t.sub[v].type = c.type;
+        // the vertex keeps iterators to its intervals, as in the other weaves
+        t.sub[v].xi = xfibers[c.xf].ints.begin() + c.xi;
+        t.sub[v].yi = yfibers[c.yf].ints.begin() + c.yi;
+        OnInterval xo = { c.xf, c.xi, yf.p1.x, v };
+        OnInterval yo = { c.yf, c.yi, xf.p1.y, v };
+        xon.push_back( xo );
+        yon.push_back( yo );
+    }
+    for ( const EndPoint& e : t.ends ) {
+        const Fiber& f = e.along_x ? xfibers[e.fiber] : yfibers[e.fiber];
+        const Interval& ival = f.ints[e.ival];
+        Vertex v = t.sub.add_vertex();
+        t.sub[v].position = f.point( e.upper ? ival.upper : ival.lower );
+        t.sub[v].type = CL;
+        OnInterval o = { e.fiber, e.ival, e.along_x ? t.sub[v].position.x : t.sub[v].position.y, v };
+        ( e.along_x ? xon : yon ).push_back( o );
+    }
+    t.stars.resize( ncross );
+    link_along( t, xon, true );
+    link_along( t, yon, false );
 }
 
-//add_vertex
-bool SmartWeave::add_vertex( Fiber& xf, Fiber& yf,
-                        std::vector<Interval>::iterator xi, 
-                        std::vector<Interval>::iterator yi,
-                        enum VertexType type ) {
-    //test if vertex exists
-    BOOST_FOREACH( std::vector<Fiber>::iterator it_xf, yi->intersections_fibers ) {
-        if( *it_xf == xf )
-            return false;
+// connect the neighboring vertices on each interval in the tile, and record the
+// first and last vertex of each interval for the stitching
+void SmartWeave::link_along( Tile& t, std::vector<OnInterval>& on, bool along_x ) {
+    std::sort( on.begin(), on.end(), [](const OnInterval& a, const OnInterval& b) {
+        return std::tie( a.fiber, a.ival, a.pos ) < std::tie( b.fiber, b.ival, b.pos );
+    } );
+    const int below = along_x ? 0 : 3; // x_l or y_l
+    const int above = along_x ? 2 : 1; // x_u or y_u
+    const uint32_t ncross = static_cast<uint32_t>( t.crossings.size() );
+    std::vector<Segment>& segments = along_x ? t.xsegments : t.ysegments;
+    size_t m = 0;
+    while ( m < on.size() ) {
+        size_t end = m + 1;
+        for ( ; end < on.size() && on[end].fiber == on[m].fiber && on[end].ival == on[m].ival; ++end ) {
+            Vertex a = on[end-1].v;
+            Vertex b = on[end].v;
+            Edge ab = t.sub.add_edge( a, b );
+            Edge ba = t.sub.add_edge( b, a );
+            if( a.idx < ncross )
+                set_side( t.stars[a.idx], above, b, ba, ab );
+            if( b.idx < ncross )
+                set_side( t.stars[b.idx], below, a, ab, ba );
+        }
+        Segment s = { on[m].fiber, on[m].ival, along_x ? t.col : t.row, 0, on[m].v, on[end-1].v };
+        segments.push_back( s );
+        m = end;
     }
-    Point v_position( yf.p1.x, xf.p1.y, xf.p1.z );
-    Vertex v =g.add_vertex(); 
-    g[v].position = v_position;
-    g[v].type = type;
-    g[v].xi= xi;
-    g[v].yi= yi;
-    xi->intersections2.insert( VertexPair( v, v_position.x ) );
-    yi->intersections2.insert( VertexPair( v, v_position.y ) );
-    return true;
 }
 
-//add_all_edges
-void SmartWeave::add_all_edges()
-{
-    std::vector<Vertex> vertices = g.vertices(); 
-
-    // std::cout << "There are " << vertices.size() << " vertices.\n";
-    BOOST_FOREACH( Vertex& vertex, vertices ) {
-        if( (g[vertex].type == INT) || (g[vertex].type == FULLINT) ) {
-            std::vector<Vertex>                adjacent_vertices;
-            std::vector<Vertex>::iterator    adj_itr;
-            std::vector<Edge>                in_edges, out_edges;
-            std::vector<Edge>::iterator        in_edge_itr, out_edge_itr;
-
-            Vertex x_u, x_l, y_u, y_l;
-            boost::tie( x_u, x_l ) = find_neighbor_vertices( VertexPair(vertex, g[vertex].position.x), *(g[vertex].xi), false );
-            boost::tie( y_u, y_l ) = find_neighbor_vertices( VertexPair(vertex, g[vertex].position.y), *(g[vertex].yi), false );
-            
-            adjacent_vertices.push_back( x_l );
-            adjacent_vertices.push_back( y_u );
-            adjacent_vertices.push_back( x_u );
-            adjacent_vertices.push_back( y_l );
-
-            for( adj_itr=adjacent_vertices.begin(); adj_itr<adjacent_vertices.end(); adj_itr++ ) {
-                Edge in, out;
-                if( g.has_edge( *adj_itr, vertex ) ) { 
-                    in =  g.edge( *adj_itr, vertex );
-                    out = g.edge( vertex, *adj_itr );
-                    in_edges.push_back( in );
-                    out_edges.push_back( out );
-                }
-                else {
-                    in = g.add_edge( *adj_itr, vertex );
-                    out = g.add_edge( vertex, *adj_itr );
-                    in_edges.push_back( in );
-                    out_edges.push_back( out );
-                }
-
-                if( g[*adj_itr].type == CL ) {
-                    g[in].prev = out;
-                    g[out].next = in;
-                }
+// append the sub-weaves to g, then add the edge pairs between the last vertex of an
+// interval in one tile and the first vertex of the same interval in the next tile
+void SmartWeave::stitch_tiles( std::vector<Tile>& tiles ) {
+    unsigned int nv = 0;
+    unsigned int ne = 0;
+    for ( const Tile& t : tiles ) {
+        nv += t.sub.num_vertices();
+        ne += t.sub.num_edges();
+    }
+    g.reserve( nv, ne + 2 * nv ); // the border edges are fewer than the vertices
+    for ( Tile& t : tiles ) {
+        std::tie( t.voffset, t.eoffset ) = g.append( t.sub );
+        t.sub = WeaveGraph();
+        for ( uint32_t n = t.crossings.size(); n < t.crossings.size() + t.ends.size(); ++n )
+            clVertexSet.insert( clVertexSet.end(), Vertex( t.voffset + n ) );
+    }
+    // the handles in the stars now refer to g
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(team)
+    for (int n = 0; n < static_cast<int>( tiles.size() ); ++n) {
+        Tile& t = tiles[n];
+        for ( VertexStar& star : t.stars ) {
+            for( int k = 0; k < 4; ++k ) {
+                if( star.adj[k] == Vertex() )
+                    continue; // across a tile border
+                star.adj[k].idx += t.voffset;
+                star.in[k].idx += t.eoffset;
+                star.out[k].idx += t.eoffset;
             }
+        }
+        for ( Segment& s : t.xsegments ) {
+            s.tile = n;
+            s.first.idx += t.voffset;
+            s.last.idx += t.voffset;
+        }
+        for ( Segment& s : t.ysegments ) {
+            s.tile = n;
+            s.first.idx += t.voffset;
+            s.last.idx += t.voffset;
+        }
+    }
+    for( int along_x = 1; along_x >= 0; --along_x ) {
+        std::vector<Segment> segments;
+        for ( const Tile& t : tiles ) {
+            const std::vector<Segment>& s = along_x ? t.xsegments : t.ysegments;
+            segments.insert( segments.end(), s.begin(), s.end() );
+        }
+        std::sort( segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+            return std::tie( a.fiber, a.ival, a.pos ) < std::tie( b.fiber, b.ival, b.pos );
+        } );
+        const int below = along_x ? 0 : 3;
+        const int above = along_x ? 2 : 1;
+        for ( size_t n = 1; n < segments.size(); ++n ) {
+            const Segment& lo = segments[n-1];
+            const Segment& hi = segments[n];
+            if( lo.fiber != hi.fiber || lo.ival != hi.ival )
+                continue;
+            // the end-points are never at a border, so both are crossings
+            Tile& tlo = tiles[lo.tile];
+            Tile& thi = tiles[hi.tile];
+            assert( lo.last.idx - tlo.voffset < tlo.crossings.size() );
+            assert( hi.first.idx - thi.voffset < thi.crossings.size() );
+            Edge ab = g.add_edge( lo.last, hi.first );
+            Edge ba = g.add_edge( hi.first, lo.last );
+            set_side( tlo.stars[ lo.last.idx - tlo.voffset ], above, hi.first, ba, ab );
+            set_side( thi.stars[ hi.first.idx - thi.voffset ], below, lo.last, ab, ba );
+        }
+    }
+}
 
-            for(    in_edge_itr = in_edges.begin(),    out_edge_itr = out_edges.begin();
-                    in_edge_itr < in_edges.end() &&    out_edge_itr < out_edges.end();
-                    in_edge_itr++,                    out_edge_itr++ )
-            {
-                if( in_edge_itr == in_edges.begin() ) {
-                    g[*in_edge_itr].next = *(out_edge_itr+1);
-                    g[*out_edge_itr].prev = *(in_edges.end()-1);
-                }
-                else if( in_edge_itr == (in_edges.end() - 1) ) {
-                    g[*in_edge_itr].next = *(out_edges.begin());
-                    g[*out_edge_itr].prev = *(in_edge_itr-1);
-                }
-                else {
-                    g[*in_edge_itr].next = *(out_edge_itr+1);
-                    g[*out_edge_itr].prev = *(in_edge_itr-1);
+// set next/prev around every INT/FULLINT vertex. Vertex v only writes next of its
+// in-edges, prev of its out-edges, and prev/next of the edges to/from a CL-neighbor,
+// so no two vertices write the same field.
+void SmartWeave::link_edges( std::vector<Tile>& tiles ) {
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(team)
+    for (int n = 0; n < static_cast<int>( tiles.size() ); ++n) {
+        for ( const VertexStar& star : tiles[n].stars ) {
+            for( int k = 0; k < 4; ++k ) {
+                assert( star.adj[k] != Vertex() );
+                if( g[star.adj[k]].type == CL ) {
+                    g[star.in[k]].prev = star.out[k];
+                    g[star.out[k]].next = star.in[k];
                 }
             }
-        }
-        /*else if( g[vertex].type == FULLINT ) {
-            std::vector<Vertex> adjacent_vertices;
-            Vertex x_u, x_l, y_u, y_l;
-            boost::tie( x_u, x_l ) = find_neighbor_vertices( VertexPair(vertex, g[vertex].position.x), *(g[vertex].xi), false );
-            boost::tie( y_u, y_l ) = find_neighbor_vertices( VertexPair(vertex, g[vertex].position.y), *(g[vertex].yi), false );
-
-            if( g[x_l].type == INT ) adjacent_vertices.push_back( x_l );
-            if( g[y_u].type == INT ) adjacent_vertices.push_back( y_u );
-            if( g[x_u].type == INT ) adjacent_vertices.push_back( x_u );
-            if( g[y_l].type == INT ) adjacent_vertices.push_back( y_l );
-            
-            if( adjacent_vertices.size() == 1 ) {
-                Edge in, out;
-                std::vector<Vertex>::iterator adj_itr = adjacent_vertices.begin();
-
-                if( hedi::has_edge( *adj_itr, vertex, g ) ) {
-                    in  = hedi::edge( *adj_itr, vertex, g );
-                    out = hedi::edge( vertex, *adj_itr, g );
-                }
-                else {
-                    in  = hedi::add_edge( *adj_itr, vertex, g );
-                    out = hedi::add_edge( vertex, *adj_itr, g );
-                }
-                g[in].next = out;
-                g[out].prev = in;
+            for( int k = 0; k < 4; ++k ) {
+                g[star.in[k]].next = star.out[ (k+1) % 4 ];
+                g[star.out[k]].prev = star.in[ (k+3) % 4 ];
             }
-            else {
-                std::vector<Vertex>::iterator adj_itr;
-                std::vector<Edge> out_edges, in_edges;
-                std::vector<Edge>::iterator edge_itr;
-
-                for( adj_itr=adjacent_vertices.begin(); adj_itr<adjacent_vertices.end(); adj_itr++ ) {
-                    if( !hedi::has_edge( *adj_itr, vertex, g ) ) {    
-                        in_edges.push_back( hedi::add_edge( *adj_itr, vertex, g ) );
-                        out_edges.push_back( hedi::add_edge( vertex, *adj_itr, g ) );
-                    }
-                    else {
-                        in_edges.push_back( hedi::edge( *adj_itr, vertex, g ) );
-                        out_edges.push_back( hedi::edge( vertex, *adj_itr, g ) );
-                    }
-                }
+        }
+    }
+}
 
-                for( unsigned int i=0; i<in_edges.size(); i++ ) {
-                    if( i == (in_edges.size() - 1) ) {
-                        g[in_edges[i] ].next = out_edges[ 0 ];
-                        g[out_edges[i]].prev =  in_edges[i-1];
-                    }
-                    else if( i == 0 ) {
-                        g[in_edges[i] ].next = out_edges[i+1];
-                        g[out_edges[i]].prev =  in_edges[in_edges.size()-1];
-                    }
-                    else {
-                        g[in_edges[i] ].next = out_edges[i+1];
-                        g[out_edges[i]].prev =  in_edges[i-1];
-                    }
-                }
-            }
+// stable-sort the fibers by coordinate and precompute the world-coordinate end-points
+// of every interval. Fibers from Waterline are already sorted, for them this only
+// builds the index. The searches rely on the sorted order: the "first" and "last"
+// crossing fibers are defined in vector order, which is now coordinate order.
+void SmartWeave::build_index() {
+    std::stable_sort( xfibers.begin(), xfibers.end(),
+                      [](const Fiber& a, const Fiber& b) { return a.p1.y < b.p1.y; } );
+    std::stable_sort( yfibers.begin(), yfibers.end(),
+                      [](const Fiber& a, const Fiber& b) { return a.p1.x < b.p1.x; } );
+    const int nx = static_cast<int>( xfibers.size() );
+    const int ny = static_cast<int>( yfibers.size() );
+    xindex.assign( nx, FiberIndex() );
+    yindex.assign( ny, FiberIndex() );
+    xfiber_y.resize( nx );
+    yfiber_x.resize( ny );
+    #pragma omp parallel for schedule(dynamic, tile_size(nx)) num_threads(team)
+    for (int n = 0; n < nx; ++n) {
+        xfiber_y[n] = xfibers[n].p1.y;
+        index_fiber( xfibers[n], true, xindex[n] );
+    }
+    #pragma omp parallel for schedule(dynamic, tile_size(ny)) num_threads(team)
+    for (int n = 0; n < ny; ++n) {
+        yfiber_x[n] = yfibers[n].p1.x;
+        index_fiber( yfibers[n], false, yindex[n] );
+    }
+}
 
-        }*/
+void SmartWeave::index_fiber( const Fiber& f, bool along_x, FiberIndex& idx ) {
+    const int n = static_cast<int>( f.ints.size() );
+    idx.lo.resize( n );
+    idx.hi.resize( n );
+    idx.order.resize( n );
+    idx.max_hi.resize( n );
+    for (int k = 0; k < n; ++k) {
+        Point lower = f.point( f.ints[k].lower );
+        Point upper = f.point( f.ints[k].upper );
+        idx.lo[k] = along_x ? lower.x : lower.y;
+        idx.hi[k] = along_x ? upper.x : upper.y;
+        idx.order[k] = k;
     }
+    std::stable_sort( idx.order.begin(), idx.order.end(),
+                      [&idx](int a, int b) { return idx.lo[a] < idx.lo[b]; } );
+    for (int k = 0; k < n; ++k) {
+        const double h = idx.hi[ idx.order[k] ];
+        idx.max_hi[k] = ( k == 0 ) ? h : std::max( idx.max_hi[k-1], h );
+    }
+}
+
+// the first interval, in Fiber::ints order, with lo <= c <= hi. -1 if there is none.
+// Intervals are disjoint, so normally only the last interval starting at or below c
+// needs to be checked; max_hi bounds the walk back for overlapping ones.
+int SmartWeave::first_interval_containing( const FiberIndex& idx, double c ) {
+    std::vector<int>::const_iterator it = std::upper_bound( idx.order.begin(), idx.order.end(), c,
+                                        [&idx](double v, int a) { return v < idx.lo[a]; } );
+    int m = static_cast<int>( it - idx.order.begin() ) - 1;
+    int found = -1;
+    for ( ; m >= 0 && idx.max_hi[m] >= c; --m ) {
+        const int k = idx.order[m];
+        if( idx.hi[k] >= c && ( found < 0 || k < found ) )
+            found = k;
+    }
+    return found;
+}
+
+// the interval of y-fiber yf that crosses the x-interval [xmin, xmax] at height y, or -1.
+// The y-fiber itself must lie within [xmin, xmax].
+int SmartWeave::crossing_x( int yf, double xmin, double xmax, double y ) const {
+    if( (yfiber_x[yf] >= xmin) && (yfiber_x[yf] <= xmax) )
+        return first_interval_containing( yindex[yf], y );
+    return -1;
 }
 
+// the interval of x-fiber xf that crosses the y-interval [ymin, ymax] at x, or -1.
+int SmartWeave::crossing_y( int xf, double ymin, double ymax, double x ) const {
+    if( (xfiber_y[xf] >= ymin) && (xfiber_y[xf] <= ymax) )
+        return first_interval_containing( xindex[xf], x );
+    return -1;
+}
 
+// the interval of y-fiber yf that crosses x-fiber xf, -1 if none does.
+// As before, the x-fiber only needs some interval over the y-fiber, not a particular one.
+int SmartWeave::find_interval_crossing_x( int xf, int yf ) const {
+    if( first_interval_containing( xindex[xf], yfiber_x[yf] ) < 0 )
+        return -1;
+    return first_interval_containing( yindex[yf], xfiber_y[xf] );
+}
+
+// the interval of x-fiber xf that crosses y-fiber yf, -1 if none does.
+int SmartWeave::find_interval_crossing_y( int xf, int yf ) const {
+    if( first_interval_containing( yindex[yf], xfiber_y[xf] ) < 0 )
+        return -1;
+    return first_interval_containing( xindex[xf], yfiber_x[yf] );
+}
 
 } // end weave namespace
 
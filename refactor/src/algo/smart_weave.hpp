@@ -29,26 +29,107 @@ namespace ocl {
 
 namespace weave {
 
+/// builds the weave in XY tiles of fibers. Each tile builds a sub-weave of the
+/// vertices inside it in parallel, the sub-weaves are then appended to the graph
+/// and stitched together with the edges that cross the tile borders.
 class SmartWeave : public Weave {
     public:
         SmartWeave() {}
         virtual ~SmartWeave() {}
         void build();
     protected:       
-        void add_vertices_x();
-        void add_vertices_y();
-        bool crossing_x( Fiber& yf, std::vector<Interval>::iterator& yi, Interval& xi, Fiber& xf );
-        bool crossing_y( Fiber& xf, std::vector<Interval>::iterator& xi, Interval& yi, Fiber& yf );
-        std::vector<Interval>::iterator find_interval_crossing_x( Fiber& xf, Fiber& yf );
-        std::vector<Interval>::iterator find_interval_crossing_y( Fiber& xf, Fiber& yf );
-        Vertex add_cl_vertex( const Point& position, Interval& ival, double ipos);
-        bool add_vertex(    Fiber& xf, 
-                            Fiber& yf,
-                            std::vector<Interval>::iterator xi, 
-                            std::vector<Interval>::iterator yi,
-                            enum VertexType type );
-        void add_all_edges();
-        std::pair<Vertex,Vertex> find_neighbor_vertices( VertexPair v_pair, Interval& ival, bool above_equality );
+        /// an INT/FULLINT vertex, where interval xi of x-fiber xf crosses interval yi of y-fiber yf.
+        /// all four are indices, into xfibers/yfibers and into Fiber::ints
+        struct Crossing {
+            int xf;
+            int xi;
+            int yf;
+            int yi;
+            VertexType type;
+        };
+        /// the lower or upper end-point of an interval, a CL-vertex
+        struct EndPoint {
+            bool along_x; ///< interval of an x-fiber, or of a y-fiber
+            int fiber;
+            int ival;
+            bool upper;
+        };
+        /// a vertex on an interval, at coordinate pos along the fiber
+        struct OnInterval {
+            int fiber;
+            int ival;
+            double pos;
+            Vertex v;
+        };
+        /// the vertices of one interval that lie in one tile, first and last along the fiber
+        struct Segment {
+            int fiber;
+            int ival;
+            int pos;    ///< position of the tile along the fiber
+            int tile;   ///< index of the tile
+            Vertex first;
+            Vertex last;
+        };
+        /// neighbors of an INT-vertex in the order x_l, y_u, x_u, y_l, with the edges to/from them
+        struct VertexStar {
+            Vertex adj[4];
+            Edge in[4];  ///< adj[k] -> vertex
+            Edge out[4]; ///< vertex -> adj[k]
+        };
+        /// a tile of the fiber grid and its sub-weave.
+        /// the sub-weave holds the crossings first, sub-vertex n is crossings[n], then the end-points.
+        struct Tile {
+            int row;                          ///< x-fibers row*T .. row*T+T-1
+            int col;                          ///< y-fibers col*T .. col*T+T-1
+            std::vector<Crossing> crossings;
+            std::vector<EndPoint> ends;
+            WeaveGraph sub;
+            std::vector<VertexStar> stars;    ///< one per crossing
+            std::vector<Segment> xsegments;
+            std::vector<Segment> ysegments;
+            uint32_t voffset = 0;             ///< first vertex of sub in g
+            uint32_t eoffset = 0;             ///< first edge of sub in g
+        };
+        /// interval end-points of one fiber in world coordinates, for the crossing look-ups.
+        /// lo/hi are the point(lower)/point(upper) coordinates along the fiber, in Fiber::ints order.
+        struct FiberIndex {
+            std::vector<double> lo;
+            std::vector<double> hi;
+            std::vector<int> order;     ///< interval indices sorted by lo
+            std::vector<double> max_hi; ///< running maximum of hi along order
+        };
+        /// number of fibers (or vertices) per chunk for the parallel loops
+        int tile_size(int n) const;
+        /// number of fibers along each side of a tile. It does not depend on the
+        /// number of threads, so neither does the weave.
+        static int tile_fibers(int n);
+        void build_index();
+        static void index_fiber( const Fiber& f, bool along_x, FiberIndex& idx );
+        static int first_interval_containing( const FiberIndex& idx, double c );
+        static bool by_x_fiber( const Crossing& a, const Crossing& b );
+        static bool by_y_fiber( const Crossing& a, const Crossing& b );
+        static bool same_place( const Crossing& a, const Crossing& b );
+        static void set_side( VertexStar& star, int k, Vertex adj, Edge in, Edge out );
+        std::vector<Crossing> find_crossings() const;
+        void seeds_x( int xf, std::vector<Crossing>& out ) const;
+        void seeds_y( int yf, std::vector<Crossing>& out ) const;
+        void gaps_x( int xf, const Crossing* begin, const Crossing* end, std::vector<Crossing>& out ) const;
+        void gaps_y( int yf, const Crossing* begin, const Crossing* end, std::vector<Crossing>& out ) const;
+        int crossing_x( int yf, double xmin, double xmax, double y ) const;
+        int crossing_y( int xf, double ymin, double ymax, double x ) const;
+        int find_interval_crossing_x( int xf, int yf ) const;
+        int find_interval_crossing_y( int xf, int yf ) const;
+        std::vector<Tile> make_tiles( const std::vector<Crossing>& crossings ) const;
+        void build_tile( Tile& t );
+        static void link_along( Tile& t, std::vector<OnInterval>& on, bool along_x );
+        void stitch_tiles( std::vector<Tile>& tiles );
+        void link_edges( std::vector<Tile>& tiles );
+
+        std::vector<FiberIndex> xindex; ///< one per x-fiber
+        std::vector<FiberIndex> yindex; ///< one per y-fiber
+        std::vector<double> xfiber_y;   ///< y-coordinate of each x-fiber, ascending
+        std::vector<double> yfiber_x;   ///< x-coordinate of each y-fiber, ascending
+        int team = 1;                   ///< OpenMP threads leased by build()
 };
 
 } // end weave namespace
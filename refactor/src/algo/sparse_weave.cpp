@@ -0,0 +1,132 @@
+/*  $Id$
+ * 
+ *  Copyright (c) 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *  
+ *  This file is part of OpenCAMlib 
+ *  (see https://github.com/aewallin/opencamlib).
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <tuple>
+
+#include "sparse_weave.hpp"
+
+namespace ocl
+{
+
+namespace weave
+{
+
+// the cell between rows r, r+1 and columns c, c+1 is closed when the four
+// intersections at its corners exist and are connected pairwise by the same
+// x-interval (bottom, top) and the same y-interval (left, right).
+// the face of such a cell is a quad of INT-vertices that never produces a loop.
+bool SparseWeave::cell_closed(int r, int c) const {
+    if ( r < 0 || c < 0 || r+1 >= grid.rows() || c+1 >= grid.cols() )
+        return false;
+    const double y0 = grid.row_y(r);
+    const double y1 = grid.row_y(r+1);
+    const double x0 = grid.col_x(c);
+    const double x1 = grid.col_x(c+1);
+    if ( !(y0 < y1) || !(x0 < x1) ) // coincident fibers, be conservative
+        return false;
+    for (int dr=0; dr<2; ++dr) { // bottom and top x-intervals
+        int k = grid.row_cover( r+dr, x0 );
+        if ( k < 0 || k != grid.row_cover( r+dr, x1 ) )
+            return false;
+    }
+    for (int dc=0; dc<2; ++dc) { // left and right y-intervals
+        int k = grid.col_cover( c+dc, y0 );
+        if ( k < 0 || k != grid.col_cover( c+dc, y1 ) )
+            return false;
+    }
+    return true;
+}
+
+bool SparseWeave::vertex_needed(int r, int c) const {
+    return !( cell_closed(r-1, c-1) && cell_closed(r-1, c) &&
+              cell_closed(r  , c-1) && cell_closed(r  , c) );
+}
+
+// same as SimpleWeave::build(), but intersections that only touch closed cells
+// are skipped. An edge of the weave may then cross an edge of the other direction
+// without a vertex, but only in the interior of a closed region that face_traverse()
+// never enters. Every vertex and edge on a loop-producing face is created exactly
+// as SimpleWeave would create it, so the loops are unchanged.
+void SparseWeave::build() {
+    grid.build( xfibers, yfibers );
+    for (unsigned int i=0; i<xfibers.size(); ++i) {
+        Fiber& xf = xfibers[i];
+        assert( !xf.empty() ); // no empty fibers please
+        const int r = grid.row_of(i);
+        BOOST_FOREACH( Interval& xi, xf.ints ) {
+            double xmin = xf.point(xi.lower).x;
+            double xmax = xf.point(xi.upper).x;
+            if ( !((xmax-xmin) > 0) )
+                continue;
+            assert( !xi.in_weave );
+            xi.in_weave = true;
+            Point p1( xf.point(xi.lower) );
+            Vertex xv1 = add_cl_vertex( p1, xi, p1.x );
+            Point p2( xf.point(xi.upper) );
+            Vertex xv2 = add_cl_vertex( p2, xi, p2.x );
+            Edge e1 = g.add_edge(xv1,xv2);
+            Edge e2 = g.add_edge(xv2,xv1);
+            g[e1].next = e2;
+            g[e2].next = e1;
+            g[e1].prev = e2;
+            g[e2].prev = e1;
+            // only the y-fibers strictly inside (xmin, xmax) can intersect
+            for (int c = grid.first_col_above(xmin); c < grid.cols() && grid.col_x(c) < xmax; ++c) {
+                Fiber& yf = yfibers[ grid.col_fiber(c) ];
+                int k = grid.col_cover( c, xf.p1.y );
+                if ( k < 0 )
+                    continue;
+                Interval& yi = yf.ints[ grid.col_spans(c)[k].ival ];
+                if (!yi.in_weave) { // add y-interval endpoints to weave
+                    Point yp1( yf.point(yi.lower) );
+                    add_cl_vertex( yp1, yi, yp1.y );
+                    Point yp2( yf.point(yi.upper) );
+                    add_cl_vertex( yp2, yi, yp2.y );
+                    yi.in_weave = true;
+                }
+                if ( !vertex_needed(r, c) )
+                    continue;
+                Vertex v = g.null_vertex();
+                Point v_position( yf.p1.x, xf.p1.y , xf.p1.z );
+                Vertex x_u, x_l;
+                std::tie( x_u, x_l ) = find_neighbor_vertices( VertexPair(v, v_position.x), xi );
+                Vertex y_u, y_l;
+                std::tie( y_u, y_l ) = find_neighbor_vertices( VertexPair(v, v_position.y), yi );
+                add_int_vertex(v_position,x_l,x_u,y_l,y_u,xi,yi);
+            }
+            // an x-interval without intersections does not contribute to any loop
+            assert( xi.intersections2.size() >= 2  );
+            if ( xi.intersections2.size() == 2 ) {
+                clVertexSet.erase(xv1);
+                clVertexSet.erase(xv2);
+                g.clear_vertex(xv1);
+                g.clear_vertex(xv2);
+                g.remove_vertex(xv1);
+                g.remove_vertex(xv2);
+            }
+        }
+    }
+}
+
+} // end weave namespace
+
+} // end ocl namespace
+// end file sparse_weave.cpp
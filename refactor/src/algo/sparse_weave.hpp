@@ -0,0 +1,64 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SPARSE_WEAVE_HPP
+#define SPARSE_WEAVE_HPP
+
+#include <vector>
+
+#include "fiber_grid.hpp"
+#include "simple_weave.hpp"
+
+namespace ocl {
+
+namespace weave {
+
+/// SimpleWeave variant that only creates the vertices that can end up on a
+/// waterline loop.
+///
+/// A loop is a face of the weave that has CL-vertices on its boundary. An
+/// INT-vertex whose four surrounding grid cells are all closed (the x- and
+/// y-intervals run uninterrupted across each cell) only bounds faces made of
+/// INT-vertices, so it can never be visited by face_traverse(). Such vertices
+/// are never created here, which makes the size of the graph proportional to
+/// the perimeter of the part rather than to its area. The loops produced by
+/// face_traverse() are the same as with SimpleWeave.
+class OCL_API SparseWeave : public SimpleWeave {
+public:
+  SparseWeave() {}
+  virtual ~SparseWeave() {}
+  void build();
+
+protected:
+  /// true if the grid cell with lower-left corner (row r, column c) is closed,
+  /// i.e. surrounded on all four sides by weave edges
+  bool cell_closed(int r, int c) const;
+  /// true if the intersection at (row r, column c) touches an open cell and
+  /// may therefore lie on a loop
+  bool vertex_needed(int r, int c) const;
+
+  FiberGrid grid; ///< sorted rows/columns and intervals, for the look-ups
+};
+
+} // namespace weave
+
+} // namespace ocl
+#endif
+// end file sparse_weave.hpp
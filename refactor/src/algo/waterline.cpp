@@ -21,10 +21,6 @@
 
 #include <boost/foreach.hpp> 
 
-#ifdef _OPENMP
-    #include <omp.h>
-#endif
-
 #include "cutters/millingcutter.hpp"
 #include "geo/point.hpp"
 #include "geo/triangle.hpp"
@@ -33,6 +29,8 @@
 // #include "weave.hpp"
 #include "simple_weave.hpp"
 #include "smart_weave.hpp"
+#include "sparse_weave.hpp"
+#include "grid_contour.hpp"
 
 namespace ocl
 {
@@ -45,13 +43,6 @@ Waterline::Waterline() {
     subOp.push_back( new BatchPushCutter() );
     subOp[0]->setXDirection();
     subOp[1]->setYDirection();
-    nthreads=1;
-#ifdef _OPENMP
-    nthreads = omp_get_num_procs();
-    //omp_set_dynamic(0);
-    //omp_set_nested(1);
-#endif
-
 }
 
 Waterline::~Waterline() {
@@ -87,6 +78,17 @@ void Waterline::run() {
 }
 
 
+void Waterline::run3() {
+    init_fibers();
+    subOp[0]->run();
+    subOp[1]->run();
+    
+    xfibers = *( subOp[0]->getFibers() );
+    yfibers = *( subOp[1]->getFibers() );
+    
+    weave_process3();
+}
+
 void Waterline::reset() {
     xfibers.clear();
     yfibers.clear();
@@ -96,7 +98,8 @@ void Waterline::reset() {
 
 void Waterline::weave_process() {
     // std::cout << "Weave...\n" << std::flush;
-    weave::SimpleWeave weave;
+    weave::SparseWeave weave; // same loops as SimpleWeave, without the interior vertices
+    weave.setThreads(executor.getThreads());
     BOOST_FOREACH( Fiber f, xfibers ) {
         weave.addFiber(f);
     }
@@ -120,6 +123,7 @@ void Waterline::weave_process() {
 void Waterline::weave_process2() {
     // std::cout << "Weave...\n" << std::flush;
     weave::SmartWeave weave;
+    weave.setThreads(executor.getThreads());
     BOOST_FOREACH( Fiber f, xfibers ) {
         weave.addFiber(f);
     }
@@ -140,6 +144,19 @@ void Waterline::weave_process2() {
     // std::cout << "done.\n";   
 }
 
+void Waterline::weave_process3() {
+    weave::GridContour contour;
+    BOOST_FOREACH( Fiber f, xfibers ) {
+        contour.addFiber(f);
+    }
+    BOOST_FOREACH( Fiber f, yfibers ) {
+        contour.addFiber(f);
+    }
+    contour.build();
+    contour.face_traverse();
+    loops = contour.getLoops();
+}
+
 void Waterline::init_fibers() {
     // std::cout << " Waterline::init_fibers()\n";
     double minx = surf->bb.minpt.x - 2*cutter->getRadius();
@@ -40,6 +40,11 @@ namespace ocl {
 /// from an STL-model. Waterline uses two BatchPushCutter sub-operations to find
 /// out where the CL-points are located and a Weave to split and order the
 /// CL-points correctly into loops.
+///
+/// The fibers span the bounding-box of the surface grown by the cutter
+/// diameter. With a region of interest (setROI()) that is the culled surface,
+/// so the fibers cover only the region and the loops inside it are the same
+/// as on the whole surface.
 class OCL_API Waterline : public Operation {
 public:
   /// create an empty Waterline object
@@ -52,6 +57,9 @@ public:
   /// be called before a call to run()
   virtual void run();
   virtual void run2();
+  /// as run(), but the loops are traced with weave::GridContour directly from
+  /// the fibers, without building a weave graph
+  virtual void run3();
 
   /// returns a vector< vector< Point > > with the resulting waterline loops
   std::vector<std::vector<Point>> getLoops() const { return loops; }
@@ -62,6 +70,7 @@ protected:
   /// toolpaths to loops
   void weave_process();
   void weave_process2();
+  void weave_process3();
 
   /// initialization of fibers
   void init_fibers();
@@ -19,10 +19,14 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <utility>
 
+#include "common/threadbudget.hpp"
 #include "weave.hpp"
 
 
@@ -32,7 +36,7 @@ namespace ocl
 namespace weave
 {
 
-int VertexProps::count = 0;
+std::atomic<int> VertexProps::count(0);
 
 void Weave::addFiber(Fiber& f) {
     if ( f.dir.xParallel() && !f.empty() ) {
@@ -44,32 +48,102 @@ void Weave::addFiber(Fiber& f) {
     }
 }
 
+Weave::Weave() {
+    nthreads = static_cast<int>( ThreadBudget::getMaxThreads() );
+}
+
+// from CL-vertex v, follow the out-edge and then next-pointers until we arrive at a CL-vertex
+Vertex Weave::next_cl_vertex(Vertex v) const {
+    assert( g[v].type == CL ); // we only want cl-points in the loop
+    assert( g.out_degree(v) == 1 ); // cl-points are always at ends of intervals, so they have only one out-edge
+    Edge currentEdge = g.out_edge(v); // the edge to follow
+    Vertex current;
+    do { // following next, find a CL point 
+        current = g.target(currentEdge); 
+        currentEdge = g[currentEdge].next;
+    } while ( g[current].type != CL );
+    return current;
+}
+
+namespace {
+
+// root of CL-vertex n in the union-find over the successor links, halving the path on the way
+int find_root( std::vector< std::atomic<int> >& parent, int n ) {
+    int p = parent[n].load();
+    while ( p != n ) {
+        int gp = parent[p].load();
+        if ( gp != p )
+            parent[n].compare_exchange_weak( p, gp ); // another thread may have moved it, that is fine
+        n = gp;
+        p = parent[n].load();
+    }
+    return n;
+}
+
+// join the components of a and b. The larger root is always linked under the smaller
+// one, so the root of a component is its smallest CL-vertex.
+void unite( std::vector< std::atomic<int> >& parent, int a, int b ) {
+    for (;;) {
+        a = find_root( parent, a );
+        b = find_root( parent, b );
+        if ( a == b )
+            return;
+        if ( a < b )
+            std::swap( a, b );
+        int expected = a;
+        if ( parent[a].compare_exchange_strong( expected, b ) )
+            return;
+    }
+}
+
+} // end anonymous namespace
+
 // traverse the graph putting loops of vertices into the loops variable
 // this figure illustrates next-pointers: http://www.anderswallin.net/wp-content/uploads/2011/05/weave2_zoom.png
+// every CL-vertex is on exactly one loop:
+// 1) the successor of each CL-vertex is found independently (in parallel)
+// 2) a lock-free union-find over the successor links splits the CL-vertices into
+//    connected components, each of them one loop, with its smallest CL-vertex as root
+// 3) the components are walked in parallel, starting from the root
+// the loops come out ordered by their smallest CL-vertex, as in the serial traversal.
 void Weave::face_traverse() { 
-    // std::cout << " traversing graph with " << clVertexSet.size() << " cl-points\n";
-    while ( !clVertexSet.empty() ) { // while unprocessed cl-vertices remain
-        std::vector<Vertex> loop; // start on a new loop
-        Vertex current = *(clVertexSet.begin());
-        Vertex first = current;
-        
+    const std::vector<Vertex> cl( clVertexSet.begin(), clVertexSet.end() ); // sorted
+    const int ncl = static_cast<int>( cl.size() );
+    std::vector<int> succ( ncl );
+    // the team is leased from the process-wide budget, see ThreadBudget
+    ThreadLease lease( ThreadBudget::isOpenMPEnabled() ? nthreads : 1 );
+    [[maybe_unused]] const int team = static_cast<int>( lease.threads() );
+    #pragma omp parallel for schedule(dynamic, 64) num_threads(team)
+    for (int n = 0; n < ncl; ++n) {
+        Vertex next = next_cl_vertex( cl[n] );
+        succ[n] = std::lower_bound( cl.begin(), cl.end(), next ) - cl.begin();
+        assert( succ[n] < ncl && cl[ succ[n] ] == next );
+    }
+
+    std::vector< std::atomic<int> > parent( ncl );
+    for (int n = 0; n < ncl; ++n)
+        parent[n].store( n, std::memory_order_relaxed );
+    #pragma omp parallel for schedule(dynamic, 64) num_threads(team)
+    for (int n = 0; n < ncl; ++n)
+        unite( parent, n, succ[n] );
+    std::vector<int> roots;
+    for (int n = 0; n < ncl; ++n) {
+        if ( parent[n].load( std::memory_order_relaxed ) == n )
+            roots.push_back( n );
+    }
+
+    const size_t first_loop = loops.size();
+    loops.resize( first_loop + roots.size() );
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(team)
+    for (int r = 0; r < static_cast<int>( roots.size() ); ++r) {
+        std::vector<Vertex>& loop = loops[ first_loop + r ];
+        int current = roots[r];
         do { // traverse around the loop
-            assert( g[current].type == CL ); // we only want cl-points in the loop
-            loop.push_back(current);
-            clVertexSet.erase(current); // remove from set of unprocesser cl-verts
-            std::vector<Edge> outEdges = g.out_edges(current);  // find the edge to follow
-            //if (outEdges.size() != 1 )
-            //    std::cout << " outEdges.size() = " << outEdges.size() << "\n";
-            assert( outEdges.size() == 1 ); // cl-points are always at ends of intervals, so they have only one out-edge
-            Edge currentEdge = outEdges[0]; 
-            do { // following next, find a CL point 
-                current = g.target(currentEdge); 
-                currentEdge = g[currentEdge].next;
-            } while ( g[current].type != CL );
-        } while (current!=first); // end the loop when we arrive at the start
-        
-        loops.push_back(loop); // add the processed loop to the master list of all loops
+            loop.push_back( cl[current] );
+            current = succ[current];
+        } while (current != roots[r]); // end the loop when we arrive at the start
     }
+    clVertexSet.clear();
 }
 
 
@@ -86,9 +160,8 @@ std::vector< std::vector<Point> > Weave::getLoops() const {
 }
 
 
-// this can cause a build error when both face and vertex descriptors have the same type
-// i.e. unsigned int (?)
-// operator[] below "g[*itr].type" then looks for FaceProps.type which does not exist...
+// vertex and edge handles are distinct types, so g[v] below cannot resolve to
+// the operator[] for faces (which are plain unsigned int)
 void Weave::printGraph()  {
     std::cout << " number of vertices: " <<  g.num_vertices() << "\n"; 
     std::cout << " number of edges: " << g.num_edges()  << "\n"; 
@@ -35,8 +35,10 @@ namespace weave {
 // sub-class!
 class OCL_API Weave {
 public:
-  Weave() {}
+  Weave();
   virtual ~Weave() {}
+  /// set the number of OpenMP threads used by build() and face_traverse()
+  void setThreads(int n) { nthreads = n; }
   /// add Fiber f to the graph
   /// each fiber should be either in the X or Y-direction
   /// FIXME: separate addXFiber and addYFiber methods?
@@ -44,6 +46,9 @@ public:
   /// from the list of fibers, build a graph
   virtual void build() = 0;
   /// run planar_face_traversal to get the waterline loops
+  /// the walks from each CL-vertex to the next one along the face run in
+  /// parallel, then each connected component (loop) is assembled in parallel.
+  /// The loops are ordered by their smallest CL-vertex.
   void face_traverse();
   /// return list of loops
   std::vector<std::vector<Point>> getLoops() const;
@@ -58,6 +63,10 @@ protected:
   std::vector<Fiber> xfibers;   ///< the X-fibers
   std::vector<Fiber> yfibers;   ///< the Y-fibers
   std::set<Vertex> clVertexSet; ///< set of CL-points
+  int nthreads;                 ///< number of OpenMP threads
+
+  /// follow the face from CL-vertex v to the next CL-vertex
+  Vertex next_cl_vertex(Vertex v) const;
 };
 
 } // namespace weave
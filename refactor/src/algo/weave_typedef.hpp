@@ -21,6 +21,8 @@
 #ifndef WEAVE_TYPEDEF_H
 #define WEAVE_TYPEDEF_H
 
+#include <atomic>
+
 #include "common/halfedgediagram.hpp"
 #include "interval.hpp"
 
@@ -28,10 +30,8 @@ namespace ocl {
 
 namespace weave {
 
-// we use the traits-class here so that EdgeProps can have Edge as a member
-typedef boost::adjacency_list_traits<boost::listS, boost::listS,
-                                     boost::bidirectionalS,
-                                     boost::listS>::edge_descriptor Edge;
+// edges are index handles, so EdgeProps can have Edge as a member
+typedef hedi::EdgeHandle Edge;
 
 /// vertex type: CL-point, internal point, adjacent point
 enum VertexType { CL, CL_DONE, ADJ, TWOADJ, INT, FULLINT };
@@ -55,8 +55,7 @@ struct VertexProps {
   }
 
   void init() {
-    index = count;
-    count++;
+    index = count++;
   }
   VertexType type;
   // HE data
@@ -64,8 +63,8 @@ struct VertexProps {
   Point position;
   /// index of vertex
   int index;
-  /// global vertex count
-  static int count;
+  /// global vertex count, atomic since sub-weaves are built in parallel
+  static std::atomic<int> count;
 
   // x interval
   std::vector<Interval>::iterator xi;
@@ -98,28 +97,15 @@ struct FaceProps {
 };
 
 // the graph type for the weave
-typedef ocl::hedi::HEDIGraph<boost::listS,          // out-edges stored here
-                             boost::listS,          // vertex set stored here
-                             boost::bidirectionalS, // undirecgted or
-                                                    // bidirectional graph?
-                             VertexProps,           // vertex properties
-                             EdgeProps,             // edge properties
-                             FaceProps,             // face properties
-                             boost::no_property,    // graph properties
-                             boost::listS           // edge storage
+typedef ocl::hedi::HEDIGraph<VertexProps, // vertex properties
+                             EdgeProps,   // edge properties
+                             FaceProps    // face properties
                              >
     WeaveGraph;
 
 typedef WeaveGraph::Vertex Vertex;
 typedef WeaveGraph::VertexItr VertexItr;
 
-// typedef boost::graph_traits< WeaveGraph >::vertex_descriptor  Vertex;
-//
-// typedef boost::graph_traits< WeaveGraph >::edge_descriptor    Edge;
-// typedef boost::graph_traits< WeaveGraph >::edge_iterator      EdgeItr;
-// typedef boost::graph_traits< WeaveGraph >::out_edge_iterator  OutEdgeItr;
-// typedef boost::graph_traits< WeaveGraph >::adjacency_iterator AdjacencyItr;
-
 /// intersections between intervals are stored as a VertexPair
 /// pair.first is a vertex descriptor of the weave graph
 /// pair.second is the coordinate along the fiber of the intersection
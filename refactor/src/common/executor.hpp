@@ -0,0 +1,250 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EXECUTOR_HPP
+#define EXECUTOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_invoke.h>
+#include <tbb/partitioner.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_scheduler_observer.h>
+
+#include "threadbudget.hpp"
+
+namespace ocl {
+
+/// \brief counts the threads that run in a TBB arena of an Executor in and
+/// out of it, see ThreadBudget::inArena()
+class ArenaObserver : public tbb::task_scheduler_observer {
+public:
+  explicit ArenaObserver(tbb::task_arena &a) : tbb::task_scheduler_observer(a) {
+    observe(true);
+  }
+  ~ArenaObserver() { observe(false); }
+  void on_scheduler_entry(bool) override { ThreadBudget::enterArena(); }
+  void on_scheduler_exit(bool) override { ThreadBudget::leaveArena(); }
+  /// counts in the thread that calls task_arena::execute(), for its lifetime
+  struct Scope {
+    Scope() { ThreadBudget::enterArena(); }
+    ~Scope() { ThreadBudget::leaveArena(); }
+  };
+};
+
+/// \brief runtime-selectable parallel backend shared by all Operations
+///
+/// An Executor runs loops and fork-join tasks either serially, with OpenMP,
+/// or with TBB. The algorithms are written once against parallel_for(),
+/// execute() and invoke(); the backend, thread count, grain size and
+/// partitioner are chosen at runtime with the setters. A thread count or
+/// grain size of zero means "choose automatically".
+///
+/// All Executors share the process-wide ThreadBudget: the thread count is
+/// capped by ThreadBudget::getMaxThreads(), OpenMP teams and TBB arenas both
+/// lease their workers from the one pool of the budget, and an OPENMP
+/// Executor runs on TBB while OpenMP is disabled with
+/// ThreadBudget::setOpenMPEnabled().
+class Executor {
+public:
+  /// the threading library that runs the work
+  enum Backend { SERIAL, OPENMP, TBB };
+  /// how parallel_for() splits [0, n) into chunks
+  enum Partitioner {
+    AUTO,   ///< TBB auto_partitioner, OpenMP dynamic schedule
+    SIMPLE, ///< chunks of exactly the grain size, dynamically scheduled
+    STATIC  ///< one contiguous range per thread
+  };
+
+  /// the default backend; all threads of the budget
+  Executor()
+      : backend(defaultBackend()), threads(0), grain(0), partitioner(AUTO) {}
+  /// executor with the given backend and thread count
+  explicit Executor(Backend b, unsigned int n = 0)
+      : backend(b), threads(n), grain(0), partitioner(AUTO) {}
+
+  /// the default backend: OpenMP when compiled in and enabled, otherwise TBB
+  static Backend defaultBackend() {
+    return ThreadBudget::isOpenMPEnabled() ? OPENMP : TBB;
+  }
+
+  void setBackend(Backend b) { backend = b; }
+  Backend getBackend() const { return backend; }
+  /// set the number of threads, 0 for all threads of the budget
+  void setThreads(unsigned int n) { threads = n; }
+  /// the number of threads parallel work may use (1 for SERIAL), never more
+  /// than the ThreadBudget. Under concurrent load an OpenMP team may get
+  /// fewer.
+  unsigned int getThreads() const {
+    if (backend == SERIAL)
+      return 1;
+    const unsigned int budget = ThreadBudget::getMaxThreads();
+    return threads ? std::min(threads, budget) : budget;
+  }
+  /// set the grain size of parallel_for(), 0 to choose from the loop size
+  void setGrainSize(std::size_t g) { grain = g; }
+  std::size_t getGrainSize() const { return grain; }
+  void setPartitioner(Partitioner p) { partitioner = p; }
+  Partitioner getPartitioner() const { return partitioner; }
+
+  /// \brief call body(begin, end) on chunks that cover [0, n).
+  /// Chunks may run concurrently, body must only touch data of its own range
+  /// or combine results atomically.
+  template <class Body>
+  void parallel_for(std::size_t n, const Body &body) const {
+    if (n == 0)
+      return;
+    const unsigned int nt = getThreads();
+    if (backend == SERIAL || nt == 1) {
+      body(std::size_t(0), n);
+      return;
+    }
+    const std::size_t g = chunkSize(n, nt);
+#ifdef _OPENMP
+    if (useOpenMP()) {
+      ThreadLease lease(nt);
+      const int team = static_cast<int>(lease.threads());
+      if (team == 1) {
+        body(std::size_t(0), n);
+        return;
+      }
+      const long chunks = static_cast<long>((n + g - 1) / g);
+      if (partitioner == STATIC) {
+#pragma omp parallel for schedule(static) num_threads(team)
+        for (long c = 0; c < chunks; ++c)
+          body(std::size_t(c) * g, std::min(n, std::size_t(c + 1) * g));
+      } else {
+#pragma omp parallel for schedule(dynamic) num_threads(team)
+        for (long c = 0; c < chunks; ++c)
+          body(std::size_t(c) * g, std::min(n, std::size_t(c + 1) * g));
+      }
+      return;
+    }
+#endif
+    inArena(nt, [&] {
+      tbb::blocked_range<std::size_t> range(0, n, g);
+      auto run = [&](const tbb::blocked_range<std::size_t> &r) {
+        body(r.begin(), r.end());
+      };
+      if (partitioner == SIMPLE)
+        tbb::parallel_for(range, run, tbb::simple_partitioner());
+      else if (partitioner == STATIC)
+        tbb::parallel_for(range, run, tbb::static_partitioner());
+      else
+        tbb::parallel_for(range, run, tbb::auto_partitioner());
+    });
+  }
+
+  /// \brief run f as the root of fork-join work, using getThreads() threads.
+  /// invoke() calls made from within f share those threads.
+  template <class F> void execute(const F &f) const {
+    const unsigned int nt = getThreads();
+    if (backend == SERIAL || nt == 1) {
+      f();
+      return;
+    }
+#ifdef _OPENMP
+    if (useOpenMP()) {
+      ThreadLease lease(nt);
+      const int team = static_cast<int>(lease.threads());
+      if (team == 1) {
+        f();
+        return;
+      }
+#pragma omp parallel num_threads(team)
+#pragma omp single
+      f();
+      return;
+    }
+#endif
+    inArena(nt, f);
+  }
+
+  /// run f and g, concurrently if the backend allows it, and wait for both.
+  /// Call this from within execute().
+  template <class F, class G> void invoke(const F &f, const G &g) const {
+    if (backend == SERIAL || getThreads() == 1) {
+      f();
+      g();
+      return;
+    }
+#ifdef _OPENMP
+    if (useOpenMP()) {
+#pragma omp task default(shared)
+      f();
+      g();
+#pragma omp taskwait
+      return;
+    }
+#endif
+    tbb::parallel_invoke(f, g);
+  }
+
+private:
+  /// true if work runs on OpenMP: the backend asks for it and it is enabled
+  bool useOpenMP() const {
+    return backend == OPENMP && ThreadBudget::isOpenMPEnabled();
+  }
+  /// the grain size for a loop of n items on nt threads
+  std::size_t chunkSize(std::size_t n, unsigned int nt) const {
+    if (grain)
+      return grain;
+    if (partitioner == STATIC)
+      return std::max<std::size_t>(1, (n + nt - 1) / nt);
+    // about eight chunks per thread leaves room for load balancing
+    return std::max<std::size_t>(1, n / (8 * nt));
+  }
+  /// \brief run f in a TBB arena of up to nt threads, leased from the
+  /// ThreadBudget like an OpenMP team. Work started from a thread already in
+  /// such an arena runs there, on the threads leased for it.
+  template <class F> void inArena(unsigned int nt, const F &f) const {
+    if (ThreadBudget::inArena()) {
+      f();
+      return;
+    }
+    ThreadLease lease(nt);
+    if (lease.threads() == 1) {
+      f();
+      return;
+    }
+    tbb::task_arena arena(static_cast<int>(lease.threads()));
+    arena.initialize();
+    ArenaObserver observer(arena);
+    arena.execute([&] {
+      ArenaObserver::Scope scope;
+      f();
+    });
+  }
+
+  Backend backend;
+  unsigned int threads;
+  std::size_t grain;
+  Partitioner partitioner;
+};
+
+} // namespace ocl
+
+#endif
@@ -21,22 +21,22 @@
 #ifndef HALFEDGEDIAGRAM_HPP
 #define HALFEDGEDIAGRAM_HPP
 
+#include <cassert>
+#include <cstdint>
+#include <set>
+#include <utility>
 #include <vector>
-#include <list>
 
-#include <boost/graph/adjacency_list.hpp>
 #include <boost/foreach.hpp> 
 
-// bundled BGL properties, see: http://www.boost.org/doc/libs/1_44_0/libs/graph/doc/bundles.html
-
 // dcel notes from http://www.holmes3d.net/graphics/dcel/
 
-// vertex (boost::out_edges)
+// vertex (out_edges)
 //  -leaving pointer to HalfEdge that has this vertex as origin
 //   if many HalfEdges have this vertex as origin, choose one arbitrarily
 
 // HalfEdge
-//  - origin pointer to vertex (boost::source)
+//  - origin pointer to vertex (source)
 //  - face to the left of halfedge
 //  - twin pointer to HalfEdge (on the right of this edge)
 //  - next pointer to HalfEdge
@@ -57,8 +57,12 @@
 /// attaching information to vertices/edges/faces that is 
 /// required for a particular algorithm.
 /// 
-/// Inherits from boost::adjacency_list
-/// minor additions allow storing face-properties.
+/// Vertices, edges and faces live in contiguous arrays and are referred to by
+/// 32-bit index handles, so the next/prev/twin links stored in the edge
+/// properties are plain indices. Each vertex keeps intrusive lists of its
+/// out- and in-edges threaded through the edge array. Removed vertices and
+/// edges go on a free-list and their slots are reused by the next add, so
+/// the arrays act as an arena and handles of live elements stay valid.
 ///
 /// the hedi namespace contains functions for manipulating HEDIGraphs
 ///
@@ -70,96 +74,194 @@ namespace ocl {
 
 namespace hedi  { 
 
-template <class TOutEdgeList, 
-          class TVertexList,
-          class TDirected, 
-          class TVertexProperties,
+/// index value used for "no vertex" / "no edge"
+const uint32_t NULL_INDEX = 0xffffffffu;
+
+/// handle to a vertex in a HEDIGraph
+struct VertexHandle {
+    VertexHandle() : idx(NULL_INDEX) {}
+    explicit VertexHandle(uint32_t i) : idx(i) {}
+    bool operator==(const VertexHandle& o) const { return idx == o.idx; }
+    bool operator!=(const VertexHandle& o) const { return idx != o.idx; }
+    bool operator<(const VertexHandle& o) const { return idx < o.idx; }
+    uint32_t idx; ///< index into the vertex array
+};
+
+/// handle to a half-edge in a HEDIGraph
+struct EdgeHandle {
+    EdgeHandle() : idx(NULL_INDEX) {}
+    explicit EdgeHandle(uint32_t i) : idx(i) {}
+    bool operator==(const EdgeHandle& o) const { return idx == o.idx; }
+    bool operator!=(const EdgeHandle& o) const { return idx != o.idx; }
+    bool operator<(const EdgeHandle& o) const { return idx < o.idx; }
+    uint32_t idx; ///< index into the edge array
+};
+
+template <class TVertexProperties,
           class TEdgeProperties,
-          class TFaceProperties,
-          class TGraphProperties,
-          class TEdgeList 
+          class TFaceProperties
           >
 class HEDIGraph {
     public:
-        
-        typedef typename boost::adjacency_list< TOutEdgeList,            
-                                                TVertexList,            
-                                                TDirected,   
-                                                TVertexProperties,             
-                                                TEdgeProperties,                
-                                                TGraphProperties,
-                                                TEdgeList
-                                                > BGLGraph;
         typedef unsigned int Face; 
-        typedef typename boost::graph_traits< BGLGraph >::edge_descriptor Edge;
-        typedef typename boost::graph_traits< BGLGraph >::vertex_descriptor Vertex;
-        typedef typename boost::graph_traits< BGLGraph >::vertex_iterator    VertexItr;
-        typedef typename boost::graph_traits< BGLGraph >::edge_iterator      EdgeItr;
-        typedef typename boost::graph_traits< BGLGraph >::out_edge_iterator  OutEdgeItr;
-        typedef typename boost::graph_traits< BGLGraph >::adjacency_iterator AdjacencyItr;
-                
+        typedef EdgeHandle Edge;
+        typedef VertexHandle Vertex;
         typedef std::vector<Vertex> VertexVector;
         typedef std::vector<Face> FaceVector;
         typedef std::vector<Edge> EdgeVector;  
+        typedef typename VertexVector::iterator VertexItr;
+        typedef typename EdgeVector::iterator EdgeItr;
+
+        HEDIGraph() : free_vertex(NULL_INDEX), free_edge(NULL_INDEX), nv(0), ne(0) {}
 
         inline TFaceProperties& operator[](Face f)  { return faces[f];  }
         inline const TFaceProperties& operator[](Face f) const  { return faces[f]; } 
         
-        inline TEdgeProperties& operator[](Edge e)  { return g[e];  }
-        inline const TEdgeProperties& operator[](Edge e) const  { return g[e];  }
+        inline TEdgeProperties& operator[](Edge e)  { return edge_array[e.idx].props;  }
+        inline const TEdgeProperties& operator[](Edge e) const  { return edge_array[e.idx].props;  }
         
-        inline TVertexProperties& operator[](Vertex v)  { return g[v];  }
-        inline const TVertexProperties& operator[](Vertex v) const  { return g[v];  }
+        inline TVertexProperties& operator[](Vertex v)  { return vertex_array[v.idx].props;  }
+        inline const TVertexProperties& operator[](Vertex v) const  { return vertex_array[v.idx].props;  }
         
 //DATA
         std::vector< TFaceProperties > faces;
-        BGLGraph g;
 
-Vertex null_vertex() {
-    return boost::graph_traits<BGLGraph>::null_vertex();
+    protected:
+        /// a vertex with the heads of its out- and in-edge lists
+        struct VertexRecord {
+            TVertexProperties props;
+            uint32_t out; ///< first out-edge, or next free slot if dead
+            uint32_t in;  ///< first in-edge
+            bool alive;
+        };
+        /// a half-edge, linked into the out-list of source and the in-list of target
+        struct EdgeRecord {
+            TEdgeProperties props;
+            uint32_t source; ///< NULL_INDEX if the slot is free
+            uint32_t target;
+            uint32_t next_out; ///< next out-edge of source, or next free slot if dead
+            uint32_t prev_out;
+            uint32_t next_in;  ///< next in-edge of target
+            uint32_t prev_in;
+        };
+        std::vector<VertexRecord> vertex_array;
+        std::vector<EdgeRecord> edge_array;
+        uint32_t free_vertex; ///< head of the vertex free-list
+        uint32_t free_edge;   ///< head of the edge free-list
+        unsigned int nv;      ///< number of live vertices
+        unsigned int ne;      ///< number of live edges
+
+    public:
+
+/// reserve storage for n_vertices and n_edges
+void reserve(unsigned int n_vertices, unsigned int n_edges) {
+    vertex_array.reserve(n_vertices);
+    edge_array.reserve(n_edges);
+}
+
+/// append the vertices and edges of other, which must not have removed elements.
+/// Vertex i and edge j of other become Vertex(i + first) and Edge(j + second) of
+/// this graph, where (first, second) is the returned pair of offsets.
+/// The properties are copied as they are: handles stored in them are not shifted.
+/// Call reserve() first when appending many graphs.
+std::pair<uint32_t, uint32_t> append( const HEDIGraph& other ) {
+    assert( other.free_vertex == NULL_INDEX && other.free_edge == NULL_INDEX );
+    const uint32_t voff = static_cast<uint32_t>( vertex_array.size() );
+    const uint32_t eoff = static_cast<uint32_t>( edge_array.size() );
+    auto shift = [](uint32_t i, uint32_t off) { return ( i == NULL_INDEX ) ? i : i + off; };
+    for ( VertexRecord r : other.vertex_array ) {
+        r.out = shift( r.out, eoff );
+        r.in = shift( r.in, eoff );
+        vertex_array.push_back( r );
+    }
+    for ( EdgeRecord r : other.edge_array ) {
+        r.source += voff;
+        r.target += voff;
+        r.next_out = shift( r.next_out, eoff );
+        r.prev_out = shift( r.prev_out, eoff );
+        r.next_in = shift( r.next_in, eoff );
+        r.prev_in = shift( r.prev_in, eoff );
+        edge_array.push_back( r );
+    }
+    nv += other.nv;
+    ne += other.ne;
+    return std::make_pair( voff, eoff );
+}
+
+/// remove all vertices, edges and faces
+void clear() {
+    vertex_array.clear();
+    edge_array.clear();
+    faces.clear();
+    free_vertex = NULL_INDEX;
+    free_edge = NULL_INDEX;
+    nv = 0;
+    ne = 0;
+}
+
+Vertex null_vertex() const {
+    return Vertex();
+}
+
+Edge null_edge() const {
+    return Edge();
 }
 
 /// add a blank vertex and return its descriptor
 Vertex add_vertex() { 
-    return boost::add_vertex( g );
+    uint32_t i;
+    if ( free_vertex != NULL_INDEX ) {
+        i = free_vertex;
+        free_vertex = vertex_array[i].out;
+        vertex_array[i].props = TVertexProperties();
+    } else {
+        i = static_cast<uint32_t>( vertex_array.size() );
+        vertex_array.push_back( VertexRecord() );
+    }
+    VertexRecord& r = vertex_array[i];
+    r.out = NULL_INDEX;
+    r.in = NULL_INDEX;
+    r.alive = true;
+    ++nv;
+    return Vertex(i);
 }
 
-/*
-/// add a vertex with given properties, return vertex descriptor
-template < class FVertexProperty>
-typename boost::graph_traits< BGLGraph >::vertex_descriptor add_vertex(typedef const FVertexProperty& prop) {
-    return boost::add_vertex( prop, g );
-}*/
-
 /// add an edge between vertices v1-v2
 Edge add_edge(Vertex v1, Vertex v2) {
-    Edge e;
-    bool b;
-    boost::tie( e , b ) = boost::add_edge( v1, v2, g);
-    return e;
-}
-
-/// add an edge with given properties between vertices v1-v2
-//template < class EdgeProperty>
-/*
-typename boost::graph_traits< BGLGraph >::edge_descriptor add_edge( 
-                                                       typename boost::graph_traits< BGLGraph >::vertex_descriptor v1, 
-                                                       typename boost::graph_traits< BGLGraph >::vertex_descriptor v2, 
-                                                       typename  TEdgeProperties prop
-                                                       ) {
-    typename boost::graph_traits< BGLGraph >::edge_descriptor e;
-    bool b;
-    boost::tie( e , b ) = boost::add_edge( v1, v2, prop, g);
-    return e;
-}*/
+    assert( is_valid(v1) && is_valid(v2) );
+    uint32_t i;
+    if ( free_edge != NULL_INDEX ) {
+        i = free_edge;
+        free_edge = edge_array[i].next_out;
+        edge_array[i].props = TEdgeProperties();
+    } else {
+        i = static_cast<uint32_t>( edge_array.size() );
+        edge_array.push_back( EdgeRecord() );
+    }
+    EdgeRecord& r = edge_array[i];
+    r.source = v1.idx;
+    r.target = v2.idx;
+    // push front on the out-list of v1 and the in-list of v2
+    r.prev_out = NULL_INDEX;
+    r.next_out = vertex_array[v1.idx].out;
+    if ( r.next_out != NULL_INDEX )
+        edge_array[r.next_out].prev_out = i;
+    vertex_array[v1.idx].out = i;
+    r.prev_in = NULL_INDEX;
+    r.next_in = vertex_array[v2.idx].in;
+    if ( r.next_in != NULL_INDEX )
+        edge_array[r.next_in].prev_in = i;
+    vertex_array[v2.idx].in = i;
+    ++ne;
+    return Edge(i);
+}
 
 /// make e1 the twin of e2 (and vice versa)
 void twin_edges( Edge e1, Edge e2 ) {
-    g[e1].twin = e2;
-    g[e2].twin = e1;
+    (*this)[e1].twin = e2;
+    (*this)[e2].twin = e1;
 }
 
-
 /// add a face 
 Face add_face() {
     TFaceProperties f_prop;
@@ -168,143 +270,149 @@ Face add_face() {
     faces[index].idx = index;
     return index;    
 }
-        
+
+/// true if v refers to a live vertex
+bool is_valid( Vertex v ) const {
+    return v.idx < vertex_array.size() && vertex_array[v.idx].alive;
+}
+
+/// true if e refers to a live edge
+bool is_valid( Edge e ) const {
+    return e.idx < edge_array.size() && edge_array[e.idx].source != NULL_INDEX;
+}
 
 /// return the target vertex of the given edge
-Vertex target( Edge e ) { 
-    return boost::target( e, g);
+Vertex target( Edge e ) const { 
+    return Vertex( edge_array[e.idx].target );
 }
 
 /// return the source vertex of the given edge
-Vertex source( Edge e )  { 
-    return boost::source( e, g); 
+Vertex source( Edge e ) const { 
+    return Vertex( edge_array[e.idx].source );
 }
 
 /// return all vertices in a vector of vertex descriptors
-VertexVector vertices()  {
-    typedef typename boost::graph_traits< BGLGraph >::vertex_descriptor  HEVertex;
-    typedef std::vector<HEVertex> VertexVector;
-    typedef typename boost::graph_traits< BGLGraph >::vertex_iterator    HEVertexItr;
+VertexVector vertices() const {
     VertexVector vv;
-    HEVertexItr it_begin, it_end, itr;
-    boost::tie( it_begin, it_end ) = boost::vertices( g );
-    for ( itr=it_begin ; itr != it_end ; ++itr ) {
-        vv.push_back( *itr );
+    vv.reserve( nv );
+    for ( uint32_t i=0; i<vertex_array.size(); ++i ) {
+        if ( vertex_array[i].alive )
+            vv.push_back( Vertex(i) );
     }
     return vv;
 }
 
 /// return all vertices adjacent to given vertex
-VertexVector adjacent_vertices(  Vertex v) {
+VertexVector adjacent_vertices( Vertex v) const {
     VertexVector vv;
-    BOOST_FOREACH( Edge edge, out_edges( v ) ) {
-        vv.push_back( target( edge ) );
-    }
+    for ( uint32_t e = vertex_array[v.idx].out; e != NULL_INDEX; e = edge_array[e].next_out )
+        vv.push_back( Vertex( edge_array[e].target ) );
     return vv;
 }
 
 /// return all vertices of given face
-
-VertexVector face_vertices(Face face_idx) {
+VertexVector face_vertices(Face face_idx) const {
     VertexVector verts;
     Edge startedge = faces[face_idx].edge; // the edge where we start
-    Vertex start_target = boost::target( startedge, g); 
-    verts.push_back(start_target);
-    Edge current = g[startedge].next;
+    Edge current = startedge;
     do {
-        Vertex current_target = boost::target( current, g); 
-        verts.push_back(current_target);
-        current = g[current].next;
+        verts.push_back( target(current) );
+        current = (*this)[current].next;
     } while ( current != startedge );
     return verts;
 }
 
 /// return edges of face f
-EdgeVector face_edges( Face f ) {
-    //Edge start_edge = g[ f ].edge; // was cast: (Face)f
+EdgeVector face_edges( Face f ) const {
     Edge start_edge = faces[f].edge;
     Edge current_edge = start_edge;
     EdgeVector out;
     do {
         out.push_back(current_edge);
-        current_edge = g[current_edge].next;
+        current_edge = (*this)[current_edge].next;
     } while( current_edge != start_edge );
     return out;
 }
 
+/// return number of out-edges of given vertex
+unsigned int out_degree( Vertex v ) const {
+    unsigned int n = 0;
+    for ( uint32_t e = vertex_array[v.idx].out; e != NULL_INDEX; e = edge_array[e].next_out )
+        ++n;
+    return n;
+}
+
+/// return number of in-edges of given vertex
+unsigned int in_degree( Vertex v ) const {
+    unsigned int n = 0;
+    for ( uint32_t e = vertex_array[v.idx].in; e != NULL_INDEX; e = edge_array[e].next_in )
+        ++n;
+    return n;
+}
 
-/// return degree of given vertex
-unsigned int degree( Vertex v)  { 
-    return boost::degree( v, g); 
+/// return degree (in + out) of given vertex
+unsigned int degree( Vertex v) const { 
+    return out_degree(v) + in_degree(v);
 }
 
 /// return number of vertices in graph
 unsigned int num_vertices() const { 
-    return static_cast<unsigned int>(boost::num_vertices( g ));
+    return nv;
+}
+
+/// return one out-edge of v (null_edge() if there is none), without allocating
+Edge out_edge( Vertex v ) const {
+    return Edge( vertex_array[v.idx].out );
 }
 
 /// return out_edges of given vertex
-EdgeVector out_edges( Vertex v) { 
-    typedef typename boost::graph_traits< BGLGraph >::out_edge_iterator  HEOutEdgeItr;
+EdgeVector out_edges( Vertex v) const { 
     EdgeVector ev;
-    HEOutEdgeItr it, it_end;
-    boost::tie( it, it_end ) = boost::out_edges( v, g );
-    for ( ; it != it_end ; ++it ) {
-        ev.push_back(*it);
-    }
+    for ( uint32_t e = vertex_array[v.idx].out; e != NULL_INDEX; e = edge_array[e].next_out )
+        ev.push_back( Edge(e) );
     return ev;
 }
 
 /// return all edges
-EdgeVector  edges() {
-    typedef typename boost::graph_traits< BGLGraph >::edge_iterator      HEEdgeItr; 
+EdgeVector edges() const {
     EdgeVector ev;
-    HEEdgeItr it, it_end;
-    boost::tie( it, it_end ) = boost::edges( g );
-    for ( ; it != it_end ; ++it ) {
-        ev.push_back(*it);
+    ev.reserve( ne );
+    for ( uint32_t i=0; i<edge_array.size(); ++i ) {
+        if ( edge_array[i].source != NULL_INDEX )
+            ev.push_back( Edge(i) );
     }
     return ev;
 }
 
-/// return v1-v2 edge descriptor
-Edge edge( Vertex v1, Vertex v2 ) {
-    typedef typename std::pair<Edge, bool> EdgeBool;
-    EdgeBool result = boost::edge(v1, v2, g );
-    return result.first;
+/// return v1-v2 edge descriptor, or null_edge() if there is no such edge
+Edge edge( Vertex v1, Vertex v2 ) const {
+    for ( uint32_t e = vertex_array[v1.idx].out; e != NULL_INDEX; e = edge_array[e].next_out ) {
+        if ( edge_array[e].target == v2.idx )
+            return Edge(e);
+    }
+    return Edge();
 }
 
 /// return the previous edge. traverses all edges in face until previous found.
-Edge previous_edge( Edge e ) {
-    Edge previous = g[e].next;
-    while ( g[previous].next != e ) {
-        previous = g[previous].next;
+Edge previous_edge( Edge e ) const {
+    Edge previous = (*this)[e].next;
+    while ( (*this)[previous].next != e ) {
+        previous = (*this)[previous].next;
     }
     return previous;
 }
 
-
 /// return true if v1-v2 edge exists
-bool has_edge( Vertex v1, Vertex v2) {
-    typedef typename std::pair<Edge, bool> EdgeBool;
-    EdgeBool result = boost::edge(v1, v2, g );
-    return result.second;
+bool has_edge( Vertex v1, Vertex v2) const {
+    return edge(v1, v2) != Edge();
 }
 
 /// return adjacent faces to the given vertex
-FaceVector adjacent_faces( Vertex q ) {
-    typedef typename boost::graph_traits< BGLGraph >::out_edge_iterator  HEOutEdgeItr;
+FaceVector adjacent_faces( Vertex q ) const {
     std::set<unsigned int> face_set;
-    HEOutEdgeItr itr, itr_end;
-    boost::tie( itr, itr_end) = boost::out_edges(q, g);
-    for ( ; itr!=itr_end ; ++itr ) {
-        face_set.insert( g[*itr].face );
-    }
-    FaceVector fv;
-    BOOST_FOREACH(unsigned int m, face_set) {
-        fv.push_back(m);
-    }
-    return fv;
+    for ( uint32_t e = vertex_array[q.idx].out; e != NULL_INDEX; e = edge_array[e].next_out )
+        face_set.insert( edge_array[e].props.face );
+    return FaceVector( face_set.begin(), face_set.end() );
 }
 
 /// return number of faces in graph
@@ -314,7 +422,7 @@ unsigned int num_faces() const {
 
 /// return number of edges in graph
 unsigned int num_edges() const { 
-    return static_cast<unsigned int>(boost::num_edges( g ));
+    return ne;
 }
 
 /// inserts given vertex into edge e, and into the twin edge e_twin
@@ -327,106 +435,55 @@ void insert_vertex_in_edge(Vertex v, Edge e ) {
     //                    te2  te1
     //                    twin_face
     
-    Edge twin = g[e].twin;
-    Vertex source = boost::source( e , g );
-    Vertex target = boost::target( e , g);
-    Vertex twin_source = boost::source( twin , g);
-    Vertex twin_target = boost::target( twin , g );
-    assert( source == twin_target );    
-    assert( target == twin_source );
+    Edge twin = (*this)[e].twin;
+    Vertex src = source( e );
+    Vertex trg = target( e );
+    Vertex twin_source = source( twin );
+    Vertex twin_target = target( twin );
+    assert( src == twin_target );    
+    assert( trg == twin_source );
     
-    Face face = g[e].face;
-    Face twin_face = g[twin].face;
+    Face face = (*this)[e].face;
+    Face twin_face = (*this)[twin].face;
     Edge previous = previous_edge(e);
-    assert( g[previous].face == g[e].face );
+    assert( (*this)[previous].face == (*this)[e].face );
     Edge twin_previous = previous_edge(twin);
-    assert( g[twin_previous].face == g[twin].face );
+    assert( (*this)[twin_previous].face == (*this)[twin].face );
     
-    Edge e1 = add_edge( source, v );
-    Edge e2 = add_edge( v, target );
+    Edge e1 = add_edge( src, v );
+    Edge e2 = add_edge( v, trg );
     
     // preserve the left/right face link
-    g[e1].face = face;
-    g[e2].face = face;
+    (*this)[e1].face = face;
+    (*this)[e2].face = face;
     // next-pointers
-    g[previous].next = e1;
-    g[e1].next = e2;
-    g[e2].next = g[e].next;
-    
+    (*this)[previous].next = e1;
+    (*this)[e1].next = e2;
+    (*this)[e2].next = (*this)[e].next;
     
     Edge te1 = add_edge( twin_source, v  );
     Edge te2 = add_edge( v, twin_target  );
     
-    g[te1].face = twin_face;
-    g[te2].face = twin_face;
+    (*this)[te1].face = twin_face;
+    (*this)[te2].face = twin_face;
     
-    g[twin_previous].next = te1;
-    g[te1].next = te2;
-    g[te2].next = g[twin].next;
+    (*this)[twin_previous].next = te1;
+    (*this)[te1].next = te2;
+    (*this)[te2].next = (*this)[twin].next;
     
     // TWINNING (note indices 'cross', see ASCII art above)
-    g[e1].twin = te2;
-    g[te2].twin = e1;
-    g[e2].twin = te1;
-    g[te1].twin = e2;
+    twin_edges( e1, te2 );
+    twin_edges( e2, te1 );
     
     // update the faces (required here?)
     faces[face].edge = e1;
     faces[twin_face].edge = te1;
     
     // finally, remove the old edge
-    boost::remove_edge( e   , g);
-    boost::remove_edge( twin, g);
+    remove_edge( e );
+    remove_edge( twin );
 }
 
-
-/// inserts given vertex into edge e
-/*
-template <class BGLGraph>
-void insert_vertex_in_half_edge(typename boost::graph_traits< BGLGraph >::vertex_descriptor  v, 
-                           typename boost::graph_traits< BGLGraph >::edge_descriptor e, 
-                           BGLGraph& g) {
-    typedef typename boost::graph_traits< BGLGraph >::edge_descriptor    HEEdge;
-    typedef typename boost::graph_traits< BGLGraph >::vertex_descriptor  HEVertex;
-    // the vertex v is in the middle of edge e
-    //                    face
-    //                    e1   e2
-    // previous-> source  -> v -> target -> next
-    
-    HEVertex source = boost::source( e , g );
-    HEVertex target = boost::target( e , g);
-    unsigned int face = g[e].face;
-    HEEdge previous = previous_edge(e, g);
-    assert( g[previous].face == g[e].face );
-    HEEdge e1 = add_edge( source, v , g);
-    HEEdge e2 = add_edge( v, target , g);
-    // preserve the left/right face link
-    g[e1].face = face;
-    g[e2].face = face;
-    // next-pointers
-    g[previous].next = e1;
-    g[e1].next = e2;
-    g[e2].next = g[e].next;
-    // update the faces (required here?)
-    g.faces[face].edge = e1;
-    // finally, remove the old edge
-    boost::remove_edge( e   , g);
-    // NOTE: twinning is not done here, since the twin edge is not split...
-}
-
-*/
-        /// check that all edges belong to the correct face, TODO: template this to make it a useful check
-        /*
-        bool checkFaces() {
-            BOOST_FOREACH(FaceProps f, faces) {
-                BOOST_FOREACH( HEEdge e, face_edges(f.idx)) {
-                    if ( g[e].face != f.idx )
-                        return false;
-                }
-            }
-            return true;
-        }*/
-
 /// delete a vertex
 void delete_vertex(Vertex v) { 
     clear_vertex(v);
@@ -435,19 +492,54 @@ void delete_vertex(Vertex v) {
 
 /// clear given vertex. this removes all edges connecting to the vertex.
 void clear_vertex( Vertex v) { 
-    boost::clear_vertex( v, g ); 
+    while ( vertex_array[v.idx].out != NULL_INDEX )
+        remove_edge( Edge( vertex_array[v.idx].out ) );
+    while ( vertex_array[v.idx].in != NULL_INDEX )
+        remove_edge( Edge( vertex_array[v.idx].in ) );
 }
-/// remove given vertex
+
+/// remove given vertex. the vertex must not have any edges.
 void remove_vertex( Vertex v) { 
-    boost::remove_vertex( v , g );
+    assert( is_valid(v) );
+    assert( vertex_array[v.idx].out == NULL_INDEX && vertex_array[v.idx].in == NULL_INDEX );
+    vertex_array[v.idx].alive = false;
+    vertex_array[v.idx].out = free_vertex;
+    free_vertex = v.idx;
+    --nv;
 }
 
+/// remove all v1-v2 edges
 void remove_edge( Vertex v1, Vertex v2) {
-    boost::remove_edge( v1, v2  , g);
+    uint32_t e = vertex_array[v1.idx].out;
+    while ( e != NULL_INDEX ) {
+        uint32_t next = edge_array[e].next_out;
+        if ( edge_array[e].target == v2.idx )
+            remove_edge( Edge(e) );
+        e = next;
+    }
 }
 
+/// remove edge e
 void remove_edge( Edge e) {
-    boost::remove_edge( e   , g);
+    assert( is_valid(e) );
+    EdgeRecord& r = edge_array[e.idx];
+    if ( r.prev_out != NULL_INDEX )
+        edge_array[r.prev_out].next_out = r.next_out;
+    else
+        vertex_array[r.source].out = r.next_out;
+    if ( r.next_out != NULL_INDEX )
+        edge_array[r.next_out].prev_out = r.prev_out;
+    if ( r.prev_in != NULL_INDEX )
+        edge_array[r.prev_in].next_in = r.next_in;
+    else
+        vertex_array[r.target].in = r.next_in;
+    if ( r.next_in != NULL_INDEX )
+        edge_array[r.next_in].prev_in = r.prev_in;
+    r.source = NULL_INDEX;
+    r.target = NULL_INDEX;
+    r.next_out = free_edge;
+    free_edge = e.idx;
+    --ne;
 }
 
 }; // end class definition
@@ -21,11 +21,11 @@
 #ifndef KDNODE_H
 #define KDNODE_H
 
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 #include <string>
-
-#include <list>
+#include <vector>
 
 namespace ocl
 {
@@ -33,19 +33,19 @@ namespace ocl
 /// \brief K-D tree node. http://en.wikipedia.org/wiki/Kd-tree
 ///
 /// A k-d tree is used for searching for triangles overlapping with the cutter.
+/// Bucket-nodes hold the indices of their faces in the mesh of the tree.
 ///
-template < class BBObj > 
 class KDNode {
     public:
         /// Create a node which partitions(cuts) along dimension d, at 
         /// cut value cv, with child-nodes hi_c and lo_c.
-        /// If this is a bucket-node containing triangles, 
-        /// they are in the list tris
-        /// depth indicates the depth of the node in the tree
-        KDNode(int d, double cv,  KDNode<BBObj> *parentNode,                        // parent node
-                                  KDNode<BBObj> *hi_child,                        // hi-child
-                                  KDNode<BBObj> *lo_child,                        // lo-child
-                                  const std::list< BBObj >* tlist,     // list of tris, if bucket
+        /// depth indicates the depth of the node in the tree.
+        /// The node is a bucket-node if leaf is set, its faces are added
+        /// to faces afterwards.
+        KDNode(int d, double cv,  KDNode *parentNode,                        // parent node
+                                  KDNode *hi_child,                        // hi-child
+                                  KDNode *lo_child,                        // lo-child
+                                  bool leaf,                               // bucket?
                                   int nodeDepth)                           // depth of node
                                   {
             dim = d;
@@ -53,15 +53,8 @@ class KDNode {
             parent = parentNode;
             hi = hi_child;
             lo = lo_child;
-            tris = new std::list<BBObj>();
             depth = nodeDepth;
-            isLeaf = false;
-            if (tlist) {
-                isLeaf = true;
-                BOOST_FOREACH(BBObj bo, *tlist) {
-                    tris->push_back(bo);
-                }
-            }
+            isLeaf = leaf;
         }
         virtual ~KDNode() {
             // std::cout << " ~KDNode3()\n";
@@ -69,8 +62,6 @@ class KDNode {
                 delete hi;
             if (lo)
                 delete lo;
-            if (tris)
-                delete tris;
         }
         /// string repr
         std::string str() const {
@@ -94,9 +85,9 @@ class KDNode {
         KDNode* hi; 
         /// Child-node lo.
         KDNode* lo; 
-        /// A list of triangles, if this is a bucket-node (NULL for internal nodes)
-        std::list< BBObj >* tris;
-        /// flag to indicate leaf in the tree. Leafs or bucket-nodes contain triangles in the list tris.
+        /// indices of the faces in the mesh, if this is a bucket-node (empty for internal nodes)
+        std::vector<std::uint32_t> faces;
+        /// flag to indicate leaf in the tree. Leafs or bucket-nodes contain the faces in faces.
         bool isLeaf;
 };
 
@@ -22,9 +22,12 @@
 #ifndef KDTREE_H
 #define KDTREE_H
 
-#include <boost/foreach.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <iostream>
-#include <list>
+#include <numeric>
+#include <vector>
 #include <spdlog/spdlog.h>
 #include <spdlog/stopwatch.h>
 
@@ -75,15 +78,20 @@ public:
     };
 };
 
-/// a kd-tree for storing triangles and fast searching for triangles
-/// that overlap the cutter
-template<class BBObj>
+/// \brief a kd-tree over the faces of a triangle mesh, for fast searching
+/// for the faces that overlap the cutter.
+///
+/// Mesh is an IndexedMesh or IndexedMeshF. The tree stores face indices only;
+/// the bounds of the faces are read from the mesh, which must outlive the
+/// tree or stay until the next build().
+template<class Mesh>
 class KDTree
 {
 public:
     KDTree()
     {
         root = nullptr;
+        mesh = nullptr;
     }
     virtual ~KDTree()
     {
@@ -96,6 +104,16 @@ public:
         // std::cout << "KDTree::setBucketSize = " << b << "\n";
         bucketSize = b;
     }
+    /// return the bucket-size
+    unsigned int getBucketSize() const
+    {
+        return bucketSize;
+    }
+    /// return the bounding-box dimensions the tree is cut along
+    const std::vector<int>& getDimensions() const
+    {
+        return dimensions;
+    }
     /// set the search dimension to the XY-plane
     void setXYDimensions()
     {
@@ -126,220 +144,184 @@ public:
         dimensions.push_back(4);  // z
         dimensions.push_back(5);  // z
     }                             // for Y-fibers
-    /// build the kd-tree based on a list of input objects
-    void build(const std::list<BBObj>& list)
+    /// \brief return found faces by descending max-z of their bounds.
+    /// A drop-cutter then meets the high triangles first, and
+    /// CLPoint::below() rejects most of the remaining ones without a
+    /// dropCutter() call.
+    void setSortByMaxZ(bool s)
+    {
+        sortByMaxZ = s;
+    }
+    /// build the kd-tree over all faces of mesh m
+    void build(const Mesh& m)
     {
-        // std::cout << "KDTree::build() list.size()= " << list.size() << " \n";
-
         delete root;
+        root = nullptr;
+        mesh = &m;
         spdlog::stopwatch sw;
-        root = build_node(&list, 0, NULL);
-        spdlog::info("KDTree::build() size:={} time:={} s", list.size(), sw);
+        if (!m.empty()) {
+            std::vector<std::uint32_t> faces(m.size());
+            std::iota(faces.begin(), faces.end(), std::uint32_t(0));
+            root = build_node(faces.begin(), faces.end(), 0, NULL);
+        }
+        spdlog::info("KDTree::build() size:={} time:={} s", m.size(), sw);
+    }
+
+    /// \brief take ownership of the nodes below r as the tree over the faces
+    /// of m, e.g. a tree restored from a MeshIndex. The nodes must have been
+    /// cut along the dimensions of this tree.
+    void adopt(const Mesh& m, KDNode* r)
+    {
+        if (r != root)
+            delete root;
+        root = r;
+        mesh = &m;
     }
 
     /// Get the root node of the kd-tree
-    KDNode<BBObj>* getRoot() const
+    KDNode* getRoot() const
     {
         return root;
     }
+    /// the mesh the tree was built over
+    const Mesh* getMesh() const
+    {
+        return mesh;
+    }
 
-    /// search for overlap with input Bbox bb, return found objects
-    std::list<BBObj>* search(const Bbox& bb)
+    /// \brief search for overlap with input Bbox bb. The indices of the found
+    /// faces replace the contents of faces, so a caller that keeps the vector
+    /// between searches does not allocate.
+    void search(const Bbox& bb, std::vector<std::uint32_t>& faces) const
     {
         assert(!dimensions.empty());
-        std::list<BBObj>* tris = new std::list<BBObj>();
-        this->search_node(tris, bb, root);
-        return tris;
+        faces.clear();
+        if (root)
+            this->search_node(faces, bb, root);
+        if (sortByMaxZ) {
+            const Mesh& m = *mesh;
+            std::stable_sort(faces.begin(), faces.end(), [&m](std::uint32_t a, std::uint32_t b) {
+                return m.bound(a, 5) > m.bound(b, 5);
+            });
+        }
     }
-    /// search for overlap with a MillingCutter c positioned at cl, return found
-    /// objects
-    std::list<BBObj>* search_cutter_overlap(const MillingCutter* c, CLPoint* cl)
+    /// search for overlap with a MillingCutter c positioned at cl, see search()
+    void search_cutter_overlap(const MillingCutter* c, const CLPoint* cl,
+                               std::vector<std::uint32_t>& faces) const
     {
         double r = c->getRadius();
         // build a bounding-box at the current CL
         Bbox bb(cl->x - r, cl->x + r, cl->y - r, cl->y + r, cl->z, cl->z + c->getLength());
-        return this->search(bb);
+        this->search(bb, faces);
     }
     /// string repr
     std::string str() const;
 
 protected:
-    /// build and return a KDNode containing list *tris at depth dep.
-    KDNode<BBObj>* build_node(const std::list<BBObj>* tris,  // triangles
-                              int dep,                       // depth of node
-                              KDNode<BBObj>* par)
-    {  // parent node
-        // std::cout << "KDNode::build_node list.size()=" << tris->size() << "\n";
+    typedef std::vector<std::uint32_t>::iterator FaceIter;
 
-        if (tris->size() == 0) {  // this is a fatal error.
-            std::cout << "ERROR: KDTree::build_node() called with tris->size()==0 ! \n";
-            assert(0);
-            return 0;
-        }
-        Spread* spr = calc_spread(tris);  // calculate spread in order to know how to cut
-        double cutvalue = spr->start + spr->val / 2;  // cut in the middle
-        // std::cout << " cutvalue= " << cutvalue << "\n";
-        if ((tris->size() <= bucketSize)
-            || isZero_tol(spr->val)) {  // then return a bucket/leaf node
-            // std::cout << "KDNode::build_node BUCKET list.size()=" << tris->size()
-            // << "\n";
-            KDNode<BBObj>* bucket;  //  dim   cutv   parent   hi    lo   triangles depth
-            bucket = new KDNode<BBObj>(spr->d, cutvalue, par, NULL, NULL, tris, dep);
-            assert(bucket->isLeaf);
-            delete spr;
+    /// build and return a KDNode over the faces first..last at depth dep.
+    KDNode* build_node(FaceIter first, FaceIter last,  // faces
+                       int dep,                        // depth of node
+                       KDNode* par)
+    {  // parent node
+        assert(first != last);
+        Spread spr = calc_spread(first, last);  // calculate spread in order to know how to cut
+        double cutvalue = spr.start + spr.val / 2;  // cut in the middle
+        if ((std::size_t(last - first) <= bucketSize)
+            || isZero_tol(spr.val)) {  // then return a bucket/leaf node
+            //                               dim   cutv   parent   hi    lo  leaf  depth
+            KDNode* bucket = new KDNode(spr.d, cutvalue, par, NULL, NULL, true, dep);
+            bucket->faces.assign(first, last);
             return bucket;  // this is the leaf/end of the recursion-tree
         }
-        // build lists of triangles for hi and lo child nodes
-        std::list<BBObj>* lolist = new std::list<BBObj>();
-        std::list<BBObj>* hilist = new std::list<BBObj>();
-        BOOST_FOREACH (BBObj t, *tris) {  // loop through each triangle and put it in
-                                          // either lolist or hilist
-            if (t.bb[spr->d] > cutvalue)
-                hilist->push_back(t);
-            else
-                lolist->push_back(t);
-        }
-
-        /*
-        if (hilist->empty() || lolist->empty()) {// an error ??
-            std::cout << "kdtree: hilist.size()==0! or lolist.size()==0! \n";
-            std::cout << "kdtree: tris->size()= " << tris->size()<< "\n";
-            std::cout << "kdtree: hilist.size()= " << hilist->size()<< "\n";
-            std::cout << "kdtree: lolist.size()= " << lolist->size()<< "\n";
-            BOOST_FOREACH(BBObj t, *tris) {
-                std::cout << t << "\n";
-                std::cout << t.bb << "\n";
-            }
-            std::cout << "kdtree: spr->d= " << spr->d << "\n";
-            std::cout << "kdtree: cutvalue= " << cutvalue << "\n";
-            assert(0);
-        }*/
+        // faces for the hi child node first, then those for the lo child
+        // node, each in their original order
+        const Mesh& m = *mesh;
+        FaceIter mid = std::stable_partition(first, last, [&](std::uint32_t f) {
+            return m.bound(f, spr.d) > cutvalue;
+        });
 
-        // create the current node  dim     value    parent  hi   lo   trilist depth
-        KDNode<BBObj>* node = new KDNode<BBObj>(spr->d, cutvalue, par, NULL, NULL, NULL, dep);
+        // create the current node   dim   value    parent  hi   lo   leaf  depth
+        KDNode* node = new KDNode(spr.d, cutvalue, par, NULL, NULL, false, dep);
         // create the child-nodes through recursion
-        //                    list    depth   parent
-        if (!hilist->empty())
-            node->hi = build_node(hilist, dep + 1, node);
-        // else
-        // std::cout << "hilist empty!\n";
-
-        if (!lolist->empty()) {
-            node->lo = build_node(lolist, dep + 1, node);
-        }
-        else {
-            // std::cout << "lolist empty!\n";
-        }
-
-        lolist->clear();
-        hilist->clear();
-        delete spr;
-        delete lolist;
-        delete hilist;
-
+        if (first != mid)
+            node->hi = build_node(first, mid, dep + 1, node);
+        if (mid != last)
+            node->lo = build_node(mid, last, dep + 1, node);
         return node;  // return a new node
     };
 
-    /// calculate the spread of list *tris
-    Spread* calc_spread(const std::list<BBObj>* tris)
+    /// calculate the spread of the faces first..last
+    Spread calc_spread(FaceIter first, FaceIter last) const
     {
-        std::vector<double> maxval(6);
-        std::vector<double> minval(6);
-        if (tris->empty()) {
-            std::cout << " ERROR, KDTree::calc_spread() called with tris->size()==0 ! \n";
-            assert(0);
-            return NULL;
+        double maxval[6];
+        double minval[6];
+        for (unsigned int m = 0; m < dimensions.size(); ++m) {
+            maxval[dimensions[m]] = mesh->bound(*first, dimensions[m]);
+            minval[dimensions[m]] = maxval[dimensions[m]];
         }
-        else {
-            // find out the maximum spread
-            // std::cout << "calc_spread()...\n";
-            bool first = true;
-            BOOST_FOREACH (BBObj t, *tris) {  // check each triangle
-                for (unsigned int m = 0; m < dimensions.size(); ++m) {
-                    // dimensions[m] is the dimensions we want to update
-                    // t.bb[ dimensions[m] ]   is the update value
-                    double point = dimensions[m];
-                    double tbbpoint = t.bb[point];
-                    if (first) {
-                        maxval[point] = tbbpoint;
-                        minval[point] = tbbpoint;
-                        if (m == (dimensions.size() - 1))
-                            first = false;
-                    }
-                    else {
-                        if (maxval[point] < tbbpoint)
-                            maxval[point] = tbbpoint;
-                        if (minval[point] > tbbpoint)
-                            minval[point] = tbbpoint;
-                    }
-                }
+        // find out the maximum spread
+        for (FaceIter f = first + 1; f != last; ++f) {  // check each face
+            for (unsigned int m = 0; m < dimensions.size(); ++m) {
+                // dimensions[m] is the dimension we want to update
+                const int d = dimensions[m];
+                const double v = mesh->bound(*f, d);
+                if (maxval[d] < v)
+                    maxval[d] = v;
+                if (minval[d] > v)
+                    minval[d] = v;
             }
+        }
 
-            double max = 0;
-            double maxM = 0;
-            // std::vector<Spread*> spreads;// calculate the spread along each
-            // dimension
-            for (unsigned int m = 0; m < dimensions.size(); ++m) {  // dim,  spread, start
-                double val = maxval[dimensions[m]] - minval[dimensions[m]];
-                if (val > max) {
-                    max = val;
-                    maxM = m;
-                }
-                // spreads.push_back( new Spread(dimensions[m] ,
-                //                    maxval[dimensions[m]]-minval[dimensions[m]],
-                //                    minval[dimensions[m]] ) );
-            }  // priority-queue could also be used ??
-            // assert( !spreads.empty() );
-            // std::cout << " spreads.size()=" << spreads.size() << "\n";
-            // std::sort(spreads.begin(), spreads.end(), Spread::spread_compare); //
-            // sort the list Spread* s= new Spread(*spreads[0]); // this is the one we
-            // want to return while(!spreads.empty()) delete spreads.back(),
-            // spreads.pop_back(); // delete the others
-            // std::cout << "calc_spread() done\n";
-            return new Spread(dimensions[maxM],
-                              maxval[dimensions[maxM]] - minval[dimensions[maxM]],
-                              minval[dimensions[maxM]]);
-            // return s; // select the biggest spread and return
-        }  // end tris->size != 0
-    }      // end spread();
+        double max = 0;
+        unsigned int maxM = 0;
+        // select the biggest spread, the first one of equal spreads
+        for (unsigned int m = 0; m < dimensions.size(); ++m) {  // dim,  spread, start
+            double val = maxval[dimensions[m]] - minval[dimensions[m]];
+            if (val > max) {
+                max = val;
+                maxM = m;
+            }
+        }
+        return Spread(dimensions[maxM], maxval[dimensions[maxM]] - minval[dimensions[maxM]],
+                      minval[dimensions[maxM]]);
+    }  // end spread();
 
     /// search kd-tree starting at *node, looking for overlap with bb, and placing
-    /// found objects in *tris
-    void search_node(std::list<BBObj>* tris, const Bbox& bb, KDNode<BBObj>* node)
+    /// found faces in faces
+    void search_node(std::vector<std::uint32_t>& faces, const Bbox& bb, const KDNode* node) const
     {
-        if (node->isLeaf) {  // we found a bucket node, so add all triangles and
+        if (node->isLeaf) {  // we found a bucket node, so add all faces and
                              // return.
-
-            BOOST_FOREACH (BBObj t, *(node->tris)) {
-                tris->push_back(t);
-            }
-            // std::cout << " search_node Leaf bucket tris-size() = " << tris->size()
-            // << "\n";
+            faces.insert(faces.end(), node->faces.begin(), node->faces.end());
             return;  // end recursion
         }
         else if ((node->dim % 2) == 0) {  // cutting along a min-direction: 0, 2, 4
             // not a bucket node, so recursevily search hi/lo branches of KDNode
             unsigned int maxdim = node->dim + 1;
             if (node->cutval > bb[maxdim]) {  // search only lo
-                search_node(tris, bb, node->lo);
+                if (node->lo)
+                    search_node(faces, bb, node->lo);
             }
             else {  // need to search both child nodes
                 if (node->hi)
-                    search_node(tris, bb, node->hi);
+                    search_node(faces, bb, node->hi);
                 if (node->lo)
-                    search_node(tris, bb, node->lo);
+                    search_node(faces, bb, node->lo);
             }
         }
         else {  // cutting along a max-dimension: 1,3,5
             unsigned int mindim = node->dim - 1;
             if (node->cutval < bb[mindim]) {  // search only hi
-                search_node(tris, bb, node->hi);
+                if (node->hi)
+                    search_node(faces, bb, node->hi);
             }
             else {  // need to search both child nodes
                 if (node->hi)
-                    search_node(tris, bb, node->hi);
+                    search_node(faces, bb, node->hi);
                 if (node->lo)
-                    search_node(tris, bb, node->lo);
+                    search_node(faces, bb, node->lo);
             }
         }
         return;  // Done. We get here after all the recursive calls above.
@@ -348,9 +330,13 @@ protected:
     /// bucket size of tree
     unsigned int bucketSize {1};
     /// pointer to root KDNode
-    KDNode<BBObj>* root;
+    KDNode* root;
+    /// the mesh whose faces are in the tree
+    const Mesh* mesh;
     /// the dimensions in this kd-tree
     std::vector<int> dimensions {0, 1, 2, 3};
+    /// sort search results by descending max-z
+    bool sortByMaxZ {false};
 };
 
 }  // namespace ocl
@@ -0,0 +1,157 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LEVELREFINER_HPP
+#define LEVELREFINER_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace ocl {
+
+/// \brief breadth-first adaptive subdivision of parameter ranges
+///
+/// Each root is a parameter range [start_t, stop_t] with already evaluated
+/// end-point samples. The refiner works one level at a time: it creates the
+/// mid-point sample of every segment still being refined, hands all of them
+/// to one evaluate() call (e.g. a batch drop-cutter or a parallel push-cutter),
+/// and then asks decide() for each segment whether to accept its stop sample,
+/// subdivide it into two halves for the next level, or discard it.
+///
+/// The set of evaluated mid-points and decisions is the same as for the usual
+/// depth-first recursion
+///   sample(start, stop): mid = eval(); if subdivide: sample(start, mid); sample(mid, stop)
+///                        else if accept: output(stop)
+/// and the output of each root is returned in order of increasing t, so it can
+/// replace such a recursion without changing the result.
+///
+/// Sample is the evaluated type (CLPoint, Fiber, ...). The callbacks are
+///  - Sample make(int root, double t)                         un-evaluated sample at t
+///  - void evaluate(std::vector<Sample>& samples)             evaluate all samples
+///  - Decision decide(int root, const Sample& start, const Sample& mid, const Sample& stop)
+template <class Sample>
+class LevelRefiner {
+public:
+  /// what to do with a segment once its mid-point is known
+  enum Decision {
+    ACCEPT,    ///< output the stop sample, stop refining
+    SUBDIVIDE, ///< refine both halves in the next level
+    DISCARD    ///< stop refining without output
+  };
+
+  LevelRefiner() {}
+  /// add a root range with evaluated end-point samples, returns the root index
+  int addRoot(double start_t, double stop_t, const Sample &start,
+              const Sample &stop) {
+    int root = static_cast<int>(roots);
+    ++roots;
+    segments.push_back(
+        Segment(root, start_t, stop_t, store(start), store(stop)));
+    return root;
+  }
+  /// number of levels processed by the last run()
+  int getLevels() const { return levels; }
+
+  /// refine all roots. Returns, per root, the accepted stop samples in order
+  /// of increasing t.
+  template <class Make, class Evaluate, class Decide>
+  std::vector<std::vector<Sample>> run(Make make, Evaluate evaluate,
+                                       Decide decide) {
+    std::vector<std::vector<std::pair<double, int>>> accepted(roots);
+    std::vector<Sample> mids;
+    std::vector<Segment> next;
+    levels = 0;
+    while (!segments.empty()) {
+      ++levels;
+      mids.clear();
+      mids.reserve(segments.size());
+      for (const Segment &s : segments) {
+        const double mid_t = s.start_t + (s.stop_t - s.start_t) / 2.0;
+        assert(mid_t > s.start_t);
+        assert(mid_t < s.stop_t);
+        mids.push_back(make(s.root, mid_t));
+      }
+      evaluate(mids);
+      next.clear();
+      for (unsigned int n = 0; n < segments.size(); ++n) {
+        const Segment &s = segments[n];
+        const int mid = store(std::move(mids[n]));
+        switch (decide(s.root, samples[s.start], samples[mid],
+                       samples[s.stop])) {
+        case SUBDIVIDE: {
+          const double mid_t = s.start_t + (s.stop_t - s.start_t) / 2.0;
+          next.push_back(Segment(s.root, s.start_t, mid_t, s.start, mid));
+          next.push_back(Segment(s.root, mid_t, s.stop_t, mid, s.stop));
+          break;
+        }
+        case ACCEPT:
+          accepted[s.root].push_back(std::make_pair(s.stop_t, s.stop));
+          break;
+        case DISCARD:
+          break;
+        }
+      }
+      segments.swap(next);
+    }
+    // accepted segments of one root are disjoint, so their stop t-values
+    // are distinct and give the depth-first output order
+    std::vector<std::vector<Sample>> out(roots);
+    for (unsigned int r = 0; r < roots; ++r) {
+      std::sort(accepted[r].begin(), accepted[r].end());
+      out[r].reserve(accepted[r].size());
+      for (const std::pair<double, int> &a : accepted[r])
+        out[r].push_back(samples[a.second]);
+    }
+    samples.clear();
+    roots = 0;
+    return out;
+  }
+
+protected:
+  /// a parameter range, with end-points as indices into samples
+  struct Segment {
+    Segment(int r, double t0, double t1, int s0, int s1)
+        : root(r), start_t(t0), stop_t(t1), start(s0), stop(s1) {}
+    int root;
+    double start_t;
+    double stop_t;
+    int start;
+    int stop;
+  };
+  int store(Sample s) {
+    samples.push_back(std::move(s));
+    return static_cast<int>(samples.size()) - 1;
+  }
+
+  // DATA
+  /// all evaluated samples, segments refer to them by index
+  std::vector<Sample> samples;
+  /// segments of the current level, in root and t order
+  std::vector<Segment> segments;
+  unsigned int roots{0};
+  int levels{0};
+};
+
+} // namespace ocl
+
+#endif
+// end file levelrefiner.hpp
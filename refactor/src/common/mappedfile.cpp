@@ -0,0 +1,130 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mappedfile.hpp"
+
+namespace ocl {
+
+std::string narrowPath(const std::wstring &path) {
+  std::string s;
+  s.reserve(path.size());
+  for (wchar_t c : path)
+    s.push_back(static_cast<char>(c));
+  return s;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::wstring &path) {
+  close();
+  HANDLE f = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                         OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (f == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER sz;
+  if (!GetFileSizeEx(f, &sz)) {
+    CloseHandle(f);
+    return false;
+  }
+  file = f;
+  length = static_cast<std::size_t>(sz.QuadPart);
+  opened = true;
+  if (length == 0)
+    return true;
+  HANDLE m = CreateFileMappingW(f, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (m == NULL) {
+    close();
+    return false;
+  }
+  mapping = m;
+  ptr = static_cast<const char *>(MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0));
+  if (ptr == nullptr) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void MappedFile::close() {
+  if (ptr)
+    UnmapViewOfFile(ptr);
+  if (mapping)
+    CloseHandle(static_cast<HANDLE>(mapping));
+  if (file)
+    CloseHandle(static_cast<HANDLE>(file));
+  ptr = nullptr;
+  mapping = nullptr;
+  file = nullptr;
+  length = 0;
+  opened = false;
+}
+
+#else
+
+bool MappedFile::open(const std::wstring &path) {
+  close();
+  int f = ::open(narrowPath(path).c_str(), O_RDONLY);
+  if (f < 0)
+    return false;
+  struct stat st;
+  if (fstat(f, &st) != 0) {
+    ::close(f);
+    return false;
+  }
+  fd = f;
+  length = static_cast<std::size_t>(st.st_size);
+  opened = true;
+  if (length == 0)
+    return true;
+  void *p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, f, 0);
+  if (p == MAP_FAILED) {
+    close();
+    return false;
+  }
+  // the readers go through the file front to back
+  madvise(p, length, MADV_SEQUENTIAL);
+  ptr = static_cast<const char *>(p);
+  return true;
+}
+
+void MappedFile::close() {
+  if (ptr)
+    munmap(const_cast<char *>(ptr), length);
+  if (fd >= 0)
+    ::close(fd);
+  ptr = nullptr;
+  fd = -1;
+  length = 0;
+  opened = false;
+}
+
+#endif
+
+} // namespace ocl
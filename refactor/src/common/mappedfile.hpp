@@ -0,0 +1,73 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <string>
+
+#include "ocl_export.hpp"
+
+namespace ocl {
+
+/// \brief a file mapped read-only into memory.
+///
+/// The whole file is available through data() without copying, and the
+/// operating system pages it in on demand. Independent MappedFiles can be
+/// opened and read from any number of threads.
+class OCL_API MappedFile {
+public:
+  MappedFile() {}
+  /// map the file at path, check isOpen() for success
+  explicit MappedFile(const std::wstring &path) { open(path); }
+  ~MappedFile() { close(); }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /// map the file at path, return false if it can not be opened
+  bool open(const std::wstring &path);
+  /// unmap the file
+  void close();
+  bool isOpen() const { return opened; }
+  /// the contents of the file, nullptr for an empty file
+  const char *data() const { return ptr; }
+  /// size of the file in bytes
+  std::size_t size() const { return length; }
+
+private:
+  bool opened{false};
+  const char *ptr{nullptr};
+  std::size_t length{0};
+#ifdef _WIN32
+  void *file{nullptr};
+  void *mapping{nullptr};
+#else
+  int fd{-1};
+#endif
+};
+
+/// narrow a file path for the char based file APIs, keeping the low byte of
+/// each character
+std::string narrowPath(const std::wstring &path);
+
+} // namespace ocl
+
+#endif
@@ -0,0 +1,82 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef NEWTON_ZERO_H
+#define NEWTON_ZERO_H
+
+#include <cmath>
+
+namespace ocl
+{
+
+/// safeguarded Newton iteration for a zero of f in the bracket [lo, hi]
+///
+/// f(x, df) must return f(x) and set df = f'(x), with f(lo) <= 0 <= f(hi).
+/// A Newton step is taken when it stays inside the current bracket and
+/// shrinks the step at least as fast as bisection would, otherwise the
+/// bracket is bisected. The bracket is updated from the sign of f after every
+/// evaluation, so the iteration converges even where Newton alone would not.
+///
+/// x0 is the starting point (a warm start from a neighbouring problem, or any
+/// guess; it is clamped into the bracket). The iteration stops when the step is
+/// below tol or after max_iter evaluations of f. iters is set to the number of
+/// evaluations.
+template <class Func>
+double newton_zero( Func f, double lo, double hi, double x0, double tol, int max_iter, int& iters ) {
+    double xl = lo; // f(xl) <= 0
+    double xh = hi; // f(xh) >= 0
+    double x = x0;
+    if ( !(x > lo && x < hi) ) // also catches NaN
+        x = 0.5*(lo+hi);
+    double dx_old = fabs(hi-lo);
+    double dx = dx_old;
+    double df;
+    double fx = f(x, df);
+    iters = 1;
+    while ( iters < max_iter ) {
+        if ( fx == 0.0 )
+            return x;
+        if ( fx < 0.0 )
+            xl = x;
+        else
+            xh = x;
+        // x stays strictly inside (xl, xh). Bisect if the Newton step leaves the
+        // bracket (this also catches df == 0) or is not decreasing fast enough.
+        const double x_newton = x - fx/df;
+        if ( !(x_newton > xl && x_newton < xh) || ( fabs(2.0*fx) > fabs(dx_old*df) ) ) {
+            dx_old = dx;
+            dx = 0.5*(xh-xl);
+            x = xl + dx;
+        } else {
+            dx_old = dx;
+            dx = x_newton - x;
+            x = x_newton;
+        }
+        if ( fabs(dx) < tol )
+            return x;
+        fx = f(x, df);
+        ++iters;
+    }
+    return x;
+}
+
+} // end namespace
+#endif
+// end file newton_zero.hpp
@@ -21,6 +21,7 @@
 #ifndef NUMERIC_H
 #define NUMERIC_H
 
+#include <atomic>
 #include <string>
 
 #include "geo/point.hpp"
@@ -48,6 +49,17 @@ double sign(double x);
 /// return x*x
 inline double square(double x) { return x * x; }
 
+/// lock-free atomic max: raise a to v if v is larger.
+/// return true if this call raised a
+inline bool atomic_max(std::atomic<double> &a, double v) {
+  double cur = a.load(std::memory_order_relaxed);
+  while (v > cur) {
+    if (a.compare_exchange_weak(cur, v, std::memory_order_relaxed))
+      return true;
+  }
+  return false;
+}
+
 /// return true if x is negative
 bool isNegative(double x);
 
@@ -0,0 +1,103 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include <tbb/global_control.h>
+#include <tbb/info.h>
+
+#include "threadbudget.hpp"
+
+namespace ocl {
+
+namespace {
+
+std::mutex controlMutex;
+std::unique_ptr<tbb::global_control> control; // caps TBB, reset for "all"
+std::atomic<unsigned int> maxThreads{0};      // 0 means all hardware threads
+std::atomic<unsigned int> leased{0};          // workers in use
+thread_local int arenaDepth = 0;              // leased arenas entered
+#ifdef _OPENMP
+std::atomic<bool> openmp{true};
+#else
+std::atomic<bool> openmp{false};
+#endif
+
+unsigned int hardwareThreads() {
+  return static_cast<unsigned int>(
+      std::max(1, tbb::info::default_concurrency()));
+}
+
+} // namespace
+
+void ThreadBudget::setMaxThreads(unsigned int n) {
+  std::lock_guard<std::mutex> lock(controlMutex);
+  control.reset();
+  maxThreads = n;
+  if (n)
+    control.reset(new tbb::global_control(
+        tbb::global_control::max_allowed_parallelism, n));
+}
+
+unsigned int ThreadBudget::getMaxThreads() {
+  const unsigned int n = maxThreads;
+  return n ? n : hardwareThreads();
+}
+
+void ThreadBudget::setOpenMPEnabled(bool e) {
+#ifdef _OPENMP
+  openmp = e;
+#else
+  (void)e; // there is no OpenMP to enable
+#endif
+}
+
+bool ThreadBudget::isOpenMPEnabled() { return openmp; }
+
+unsigned int ThreadBudget::acquire(unsigned int n) {
+  if (n <= 1)
+    return 1;
+  const unsigned int pool = getMaxThreads() - 1;
+  unsigned int used = leased.load();
+  unsigned int take;
+  do {
+    take = std::min(n - 1, used < pool ? pool - used : 0u);
+  } while (take && !leased.compare_exchange_weak(used, used + take));
+  return take + 1;
+}
+
+void ThreadBudget::release(unsigned int n) {
+  if (n > 1)
+    leased -= n - 1;
+}
+
+unsigned int ThreadBudget::leasedWorkers() { return leased; }
+
+void ThreadBudget::enterArena() { ++arenaDepth; }
+
+void ThreadBudget::leaveArena() { --arenaDepth; }
+
+bool ThreadBudget::inArena() { return arenaDepth > 0; }
+
+} // namespace ocl
@@ -0,0 +1,85 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef THREADBUDGET_HPP
+#define THREADBUDGET_HPP
+
+#include "ocl_export.hpp"
+
+namespace ocl {
+
+/// \brief process-wide limit on the threads used by all Operations
+///
+/// Several Operations may run at the same time, each from its own calling
+/// thread. Without a common limit every one of them would start a full
+/// OpenMP team or TBB arena and the machine would be oversubscribed. The
+/// budget is a pool of getMaxThreads()-1 worker threads shared by all
+/// callers: OpenMP teams and TBB arenas of any Executor lease theirs with
+/// acquire(), whatever the backend. Every caller also runs work on its own
+/// thread, so with k concurrent callers at most k + getMaxThreads() - 1
+/// threads are busy. A tbb::global_control of the same size caps TBB work
+/// started outside an Executor.
+class OCL_API ThreadBudget {
+public:
+  /// set the budget to n threads, 0 for the hardware threads available to
+  /// this process (the default)
+  static void setMaxThreads(unsigned int n);
+  /// the number of threads in the budget
+  static unsigned int getMaxThreads();
+  /// allow or forbid OpenMP. When forbidden, OpenMP Executors run on TBB
+  /// and the weave runs single-threaded.
+  static void setOpenMPEnabled(bool e);
+  static bool isOpenMPEnabled();
+
+  /// \brief lease worker threads for a team of up to n threads.
+  /// Returns the team size granted, at least 1 (the calling thread).
+  /// Give the workers back with release() when the team is done.
+  static unsigned int acquire(unsigned int n);
+  /// give back the workers of a team of n threads returned by acquire()
+  static void release(unsigned int n);
+  /// the number of worker threads currently leased
+  static unsigned int leasedWorkers();
+
+  /// \brief count the calling thread into or out of a TBB arena that an
+  /// Executor leased. Nested parallel work on such a thread runs in that
+  /// arena instead of leasing another one.
+  static void enterArena();
+  static void leaveArena();
+  /// true if the calling thread runs in a leased TBB arena
+  static bool inArena();
+};
+
+/// leases a team from the ThreadBudget for the lifetime of the object
+class ThreadLease {
+public:
+  explicit ThreadLease(unsigned int n) : team(ThreadBudget::acquire(n)) {}
+  ~ThreadLease() { ThreadBudget::release(team); }
+  ThreadLease(const ThreadLease &) = delete;
+  ThreadLease &operator=(const ThreadLease &) = delete;
+  /// the size of the leased team, including the calling thread
+  unsigned int threads() const { return team; }
+
+private:
+  unsigned int team;
+};
+
+} // namespace ocl
+
+#endif
@@ -89,35 +89,86 @@ CC_CLZ_Pair BullCutter::singleEdgeDropCanonical(const Point &u1,
   if (isZero_tol(u1.z - u2.z)) { // horizontal edge special case
     return CC_CLZ_Pair(0, u1.z - height(u1.y));
   } else {                   // the general offset-ellipse case
-    double b_axis = radius2; // short axis of ellipse = radius2
-    double theta =
-        atan((u2.z - u1.z) / (u2.x - u1.x)); // theta is the slope of the line
-    double a_axis =
-        fabs(radius2 / sin(theta)); // long axis of ellipse = radius2/sin(theta)
     Point ellcenter(0, u1.y, 0);
-    Ellipse e = Ellipse(ellcenter, a_axis, b_axis,
+    Ellipse e = Ellipse(ellcenter, ellipseAxis(u1, u2), radius2,
                         radius1); // radius1 is the ellipse-offset
-    int iters =
-        e.solver_brent(); // numerical solver that searches for a point on the
-                          // ellipse such that a radius1-length normal-vector
-                          // from this ellipse-point is at the CL point (0,0)
-    if (iters > 200)
-      std::cout
-          << "WARNING: BullCutter::singleEdgeDropCanonical() iters>200 !!\n";
-    assert(iters < 200);
-    e.setEllipsePositionHi(
-        u1, u2); // this selects either EllipsePosition1 or
-                 // EllipsePosition2 and sets it to EllipsePosition_hi
-    // pseudo cc-point on the ellipse/cylinder, in the CL=(0,0) system
-    Point ell_ccp = e.ePointHi();
-    assert(fabs(ell_ccp.xyNorm() - radius1) <
-           1E-5); // ell_ccp should be on the cylinder-circle
-    Point cc_tmp_u =
-        ell_ccp.closestPoint(u1, u2); // find cc-point on u1-u2 edge
-    return CC_CLZ_Pair(cc_tmp_u.x, e.getCenterZ() - radius2);
+    e.solver(); // safeguarded Newton solver that searches for a point on the
+                // ellipse such that a radius1-length normal-vector from this
+                // ellipse-point is at the CL point (0,0)
+    return ellipseContact(e, u1, u2);
   }
 }
 
+// the short axis of the ellipse is radius2
+double BullCutter::ellipseAxis(const Point &u1, const Point &u2) const {
+  double theta =
+      atan((u2.z - u1.z) / (u2.x - u1.x)); // theta is the slope of the line
+  return fabs(radius2 / sin(theta)); // long axis of ellipse = radius2/sin(theta)
+}
+
+CC_CLZ_Pair BullCutter::ellipseContact(Ellipse &e, const Point &u1,
+                                       const Point &u2) const {
+  e.setEllipsePositionHi(
+      u1, u2); // this selects either EllipsePosition1 or
+               // EllipsePosition2 and sets it to EllipsePosition_hi
+  // pseudo cc-point on the ellipse/cylinder, in the CL=(0,0) system
+  Point ell_ccp = e.ePointHi();
+  assert(fabs(ell_ccp.xyNorm() - radius1) <
+         1E-5); // ell_ccp should be on the cylinder-circle
+  Point cc_tmp_u =
+      ell_ccp.closestPoint(u1, u2); // find cc-point on u1-u2 edge
+  return CC_CLZ_Pair(cc_tmp_u.x, e.getCenterZ() - radius2);
+}
+
+// batched edge-drop against the unique edges of one CL-point.
+// horizontal edges are dropped as in singleEdgeDrop(). The offset-ellipses of
+// the other edges are solved together by Ellipse::solve_drops(), and for the
+// same edge at a neighbouring CL-point only the ellipse center moves, so the t
+// of the previous CL-point is a much better start than the default guess.
+int BullCutter::edgeDrops(CLPoint &cl, std::vector<DropEdge> &edges,
+                          int &iters) const {
+  int count = 0;
+  std::vector<EllipseDrop> drops;
+  std::vector<std::size_t> at; // index into edges of each drop
+  Point sc, vxy, u1, u2;
+  for (std::size_t n = 0; n < edges.size(); ++n) {
+    const DropEdge &e = edges[n];
+    if (!(e.p1.z > cl.z || e.p2.z > cl.z)) // an edge below the cutter can not
+      continue;                            // lift it
+    ++count;
+    if (isZero_tol(e.p1.x - e.p2.x) && isZero_tol(e.p1.y - e.p2.y))
+      continue; // vertical edge
+    const double d = cl.xyDistanceToLine(e.p1, e.p2);
+    if (d > radius)
+      continue;
+    canonicalEdge(cl, e.p1, e.p2, d, sc, vxy, u1, u2);
+    if (isZero_tol(u1.z - u2.z)) {
+      liftEdge(cl, e.p1, e.p2, sc, vxy, singleEdgeDropCanonical(u1, u2));
+      continue;
+    }
+    EllipseDrop drop;
+    drop.y = u1.y;
+    drop.a = ellipseAxis(u1, u2);
+    drop.b = radius2;
+    drop.offset = radius1;
+    drop.t = e.t;
+    drop.iters = 0;
+    drops.push_back(drop);
+    at.push_back(n);
+  }
+  iters += Ellipse::solve_drops(drops);
+  for (std::size_t k = 0; k < drops.size(); ++k) {
+    DropEdge &e = edges[at[k]];
+    e.t = drops[k].t;
+    canonicalEdge(cl, e.p1, e.p2, drops[k].y, sc, vxy, u1, u2);
+    Point ellcenter(0, drops[k].y, 0);
+    Ellipse ell(ellcenter, drops[k].a, drops[k].b, drops[k].offset);
+    ell.setT(drops[k].t);
+    liftEdge(cl, e.p1, e.p2, sc, vxy, ellipseContact(ell, u1, u2));
+  }
+  return count;
+}
+
 // push-cutter: vertex and facet handled by base-class
 //  edge handled here
 bool BullCutter::generalEdgePush(const Fiber &f, Interval &i, const Point &p1,
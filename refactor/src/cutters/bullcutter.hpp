@@ -47,11 +47,19 @@ public:
   std::string str() const;
   /// 获取圆角半径
   double getRadius2() const;
+  /// batched edge-drop, solves the offset-ellipses of all edges with
+  /// Ellipse::solve_drops(), each started from its DropEdge::t
+  int edgeDrops(CLPoint &cl, std::vector<DropEdge> &edges, int &iters) const;
 
 protected:
   bool generalEdgePush(const Fiber &f, Interval &i, const Point &p1,
                        const Point &p2) const;
   CC_CLZ_Pair singleEdgeDropCanonical(const Point &u1, const Point &u2) const;
+  /// long axis of the offset-ellipse of the non-horizontal canonical edge u1-u2
+  double ellipseAxis(const Point &u1, const Point &u2) const;
+  /// cc-point x-coordinate and cl.z of a solved offset-ellipse e of edge u1-u2
+  CC_CLZ_Pair ellipseContact(Ellipse &e, const Point &u1,
+                             const Point &u2) const;
   double height(double r) const;
   double width(double h) const;
   /// radius of cylindrical part of cutter
@@ -91,7 +91,7 @@ unsigned int CompositeCutter::radius_to_index(double r) const {
 }
 
 bool CompositeCutter::ccValidRadius(unsigned int n, CLPoint& cl) const {
-    if (cl.cc.load()->type == NONE)
+    if (cl.cc->type == NONE)
         return false;
     double d = cl.xyDistance(*cl.cc);
     double lolimit;
@@ -153,18 +153,13 @@ bool CompositeCutter::facetDrop(CLPoint &cl, const Triangle &t) const {
     bool result = false;
     for (unsigned int n=0; n<cutter.size(); ++n) { // loop through cutters
         CLPoint cl_tmp = cl + CLPoint(0,0,zoffset[n]);
-        CCPoint* cc_tmp;
         if ( cutter[n]->facetDrop(cl_tmp, t) ) {
             assert( cl_tmp.cc != 0);
             if ( ccValidRadius(n,cl_tmp) ) { // cc-point is valid
-                cc_tmp = new CCPoint(*cl_tmp.cc);
-                if (cl.liftZ( cl_tmp.z - zoffset[n] )) { // we need to lift the cutter
-                    cc_tmp->type = FACET;
-                    cl.cc = cc_tmp;
+                CCPoint cc_tmp(*cl_tmp.cc);
+                cc_tmp.type = FACET;
+                if (cl.liftZ( cl_tmp.z - zoffset[n], cc_tmp )) // we need to lift the cutter
                     result = true;
-                } else {
-                    delete cc_tmp;
-                }
             }
         }
     }
@@ -176,17 +171,28 @@ bool CompositeCutter::edgeDrop(CLPoint &cl, const Triangle &t) const {
     bool result = false;
     for (unsigned int n=0; n<cutter.size(); ++n) { // loop through cutters
         CLPoint cl_tmp = cl + Point(0,0,zoffset[n]);
-        CCPoint* cc_tmp;
         if ( cutter[n]->edgeDrop(cl_tmp,t) ) { // drop sub-cutter against edge
             if ( ccValidRadius(n,cl_tmp) ) { // check if cc-point is valid
-                cc_tmp = new CCPoint(*cl_tmp.cc);
-                if (cl.liftZ( cl_tmp.z - zoffset[n] ) ) { // we need to lift the cutter
-                    cc_tmp->type = EDGE;
-                    cl.cc = cc_tmp;
+                CCPoint cc_tmp(*cl_tmp.cc);
+                cc_tmp.type = EDGE;
+                if (cl.liftZ( cl_tmp.z - zoffset[n], cc_tmp ) ) // we need to lift the cutter
+                    result = true;
+            }
+        }
+    }
+    return result;
+}
+
+bool CompositeCutter::edgeDrop(CLPoint &cl, const Point &p1, const Point &p2) const {
+    bool result = false;
+    for (unsigned int n=0; n<cutter.size(); ++n) { // loop through cutters
+        CLPoint cl_tmp = cl + Point(0,0,zoffset[n]);
+        if ( cutter[n]->edgeDrop(cl_tmp,p1,p2) ) { // drop sub-cutter against edge
+            if ( ccValidRadius(n,cl_tmp) ) { // check if cc-point is valid
+                CCPoint cc_tmp(*cl_tmp.cc);
+                cc_tmp.type = EDGE;
+                if (cl.liftZ( cl_tmp.z - zoffset[n], cc_tmp ) ) // we need to lift the cutter
                     result = true;
-                } else {
-                    delete cc_tmp;
-                }
             }
         }
     }
@@ -53,6 +53,8 @@ public:
   /// call edgeDrop on each cutter and pick the correct (highest valid CL-point)
   /// result
   bool edgeDrop(CLPoint &cl, const Triangle &t) const;
+  /// the same for the single edge p1-p2
+  bool edgeDrop(CLPoint &cl, const Point &p1, const Point &p2) const;
 
   std::string str() const;
 
@@ -18,6 +18,7 @@
  *  You should have received a copy of the GNU Lesser General Public License
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
 */
+#include <algorithm>
 #include <sstream>
 #include <cmath>
 #include <string>
@@ -27,7 +28,7 @@
 
 #include "cutters/ellipse.hpp"
 #include "common/numeric.hpp"
-#include "common/brent_zero.hpp"
+#include "common/newton_zero.hpp"
 #include "algo/fiber.hpp"
 
 namespace ocl
@@ -114,200 +115,119 @@ Point AlignedEllipse::normal(const EllipsePosition& pos) const {
 }    
 
 
-#define OE_ERROR_TOLERANCE 1e-10  /// \todo magic number tolerance
-// #define DEBUG_SOLVER
-//
-// given a known EllipsePosition1, look for the other symmetric
-// solution EllipsePosition2
-bool Ellipse::find_EllipsePosition2() { // a horrible horrible function... :(
-    assert( EllipsePosition1.isValid() );
-    double err1 = fabs(this->error(this->EllipsePosition1));
-    this->EllipsePosition2.s =  this->EllipsePosition1.s;  // plus
-    this->EllipsePosition2.t = -this->EllipsePosition1.t; // minus
-    if  ( fabs(this->error(this->EllipsePosition2)) < err1+OE_ERROR_TOLERANCE)     {   
-        if ( (fabs(this->EllipsePosition2.s - this->EllipsePosition1.s) > 1E-8) || (fabs(this->EllipsePosition2.t - this->EllipsePosition1.t) > 1E-8) ) {
-            #ifdef DEBUG_SOLVER
-                std::cout << "2nd: (s, t)= " << this->EllipsePosition2 << " oePoint()= " << this->oePoint(this->EllipsePosition2) << " e=" << this->error(this->EllipsePosition2) << "\n";
-            #endif
-            return true;
-        }
-    }
-    
-    this->EllipsePosition2.s = -this->EllipsePosition1.s;  
-    this->EllipsePosition2.t =  this->EllipsePosition1.t; 
-    if  ( fabs(this->error(this->EllipsePosition2)) < err1+OE_ERROR_TOLERANCE)     { 
-        if ( (fabs(this->EllipsePosition2.s - this->EllipsePosition1.s) > 1E-8) || (fabs(this->EllipsePosition2.t - this->EllipsePosition1.t) > 1E-8) ) {  
-            #ifdef DEBUG_SOLVER
-                std::cout << "2nd: (s, t)= " << this->EllipsePosition2 << " oePoint()= " << this->oePoint(this->EllipsePosition2) << " e=" << this->error(this->EllipsePosition2) << "\n";
-            #endif
-            return true;
-        }   
-    }
-    
-    this->EllipsePosition2.s = -this->EllipsePosition1.s;  
-    this->EllipsePosition2.t = -this->EllipsePosition1.t; 
-    if  ( fabs(this->error(this->EllipsePosition2)) < err1+OE_ERROR_TOLERANCE)     {  
-        if ( (fabs(this->EllipsePosition2.s - this->EllipsePosition1.s) > 1E-8) || (fabs(this->EllipsePosition2.t - this->EllipsePosition1.t) > 1E-8) ) {   
-            #ifdef DEBUG_SOLVER
-                std::cout << "2nd: (s, t)= " << this->EllipsePosition2 << " oePoint()= " << this->oePoint(this->EllipsePosition2) << " e=" << this->error(this->EllipsePosition2) << "\n";
-            #endif
-            return true;
-        }
-    }
-    
-    // last desperate attempt is identical solutions
-    this->EllipsePosition2.s = this->EllipsePosition1.s;  
-    this->EllipsePosition2.t = this->EllipsePosition1.t; 
-    if  ( fabs(this->error(this->EllipsePosition2)) < err1+OE_ERROR_TOLERANCE)     {  
-        // DON'T require solutions to differ
-        // if ( (fabs(this->EllipsePosition2.s - this->EllipsePosition1.s) > 1E-8) || (fabs(this->EllipsePosition2.t - this->EllipsePosition1.t) > 1E-8) ) {   
-            #ifdef DEBUG_SOLVER
-                std::cout << "2nd: (s, t)= " << this->EllipsePosition2 << " oePoint()= " << this->oePoint(this->EllipsePosition2) << " e=" << this->error(this->EllipsePosition2) << "\n";
-            #endif
-            //std::cout << " find_EllipsePosition2() desperate-mode\n";
-            return true;
-        //}
+#define OE_PARAM_TOLERANCE 1e-14  ///< step tolerance of the solvers, in t or in radians
+#define OE_MAX_ITERS 64            ///< iteration budget, enough for pure bisection to reach OE_PARAM_TOLERANCE
+
+namespace {
+
+// the canonical drop problem of Ellipse::solver(). At (s, t) the offset-ellipse point is
+//   ( a s + offset b s / D ,  y + b t + offset a t / D ),   D = sqrt( b^2 s^2 + a^2 t^2 )
+// with s^2 = 1 - t^2 the y-coordinate is
+//   g(t) = y + t ( b + offset a / D(t) ),   D(t)^2 = b^2 + (a^2 - b^2) t^2
+// and g'(t) = b + offset a b^2 / D^3 > 0. So g is increasing and [-1, 1] brackets
+// the zero whenever |y| <= b + offset, which edgeDrop() guarantees.
+struct DropError {
+    double y, a, b, offset;
+    double operator()(double t, double& dg) const {
+        const double D = sqrt( square(b) + (square(a) - square(b))*square(t) );
+        dg = b + offset*a*square(b)/(D*D*D);
+        return y + t*( b + offset*a/D );
     }
-    std::cout << "Ellipse::find_EllipsePosition2 cannot find EllipsePosition2! \n"; 
-    std::cout << "ellipse= "<< *this << "\n"; 
-    print_solutions();
-    assert(0); // serious error if we get here!
-        
-    return false;
+};
+
+double solve_drop(double y, double a, double b, double offset, double t_start, int& iters) {
+    DropError g = { y, a, b, offset };
+    return newton_zero( g, -1.0, 1.0, t_start, OE_PARAM_TOLERANCE, OE_MAX_ITERS, iters );
+}
+
+// exact for a == b
+double drop_start(double y, double b, double offset) {
+    return -y/(b+offset);
+}
+
+void set_position(EllipsePosition& pos, double s, double t) {
+    pos.s = s;
+    pos.t = t;
+    pos.diangle = xyVectorToDiangle(s, t);
 }
 
-/// offfset-ellipse solver using Brent's method
-/// find the EllipsePosition that makes the offset-ellipse point be at p
-/// this is a zero of Ellipse::error()
-/// returns number of iterations
-///
-/// called (only?) by BullCutter::singleEdgeDropCanonical()   
-int Ellipse::solver_brent() {
-    int iters = 1;
-    EllipsePosition apos, bpos; // Brent's method requires bracketing the root in [apos.diangle, bpos.diangle]
-    apos.setDiangle( 0.0 );         assert( apos.isValid() );
-    bpos.setDiangle( 3.0 );         assert( bpos.isValid() );
-    if ( fabs( error(apos) ) < OE_ERROR_TOLERANCE ) { // if we are lucky apos is the solution
-        EllipsePosition1 = apos;                      // and we do not need to search further.
-        find_EllipsePosition2();
-        return iters;
-    } else if ( fabs( error(bpos) ) < OE_ERROR_TOLERANCE ) { // or bpos might be the solution?
-        EllipsePosition1 = bpos;
-        find_EllipsePosition2();
-        return iters;
+// projection onto error_dir of the AlignedEllipse offset-point at angle phi,
+// relative to the center: with (s, t) = (cos(phi), sin(phi))
+//   h(phi) = a me s + b ne t + offset ( b me s + a ne t ) / D,   D = sqrt( b^2 s^2 + a^2 t^2 )
+// where me, ne are the components of error_dir along the major and minor axes.
+// sign = -1 gives -h, for the arc where h is decreasing.
+struct PushProjection {
+    double a, b, offset, me, ne, c0, sign;
+    double operator()(double phi, double& dh) const {
+        const double s = cos(phi);
+        const double t = sin(phi);
+        const double D = sqrt( square(b*s) + square(a*t) );
+        const double dD = (square(a) - square(b))*s*t/D;
+        const double n = b*me*s + a*ne*t;
+        const double dn = -b*me*t + a*ne*s;
+        const double h = a*me*s + b*ne*t + offset*n/D;
+        dh = sign*( -a*me*t + b*ne*s + offset*(dn*D - n*dD)/square(D) );
+        return sign*(h - c0);
     }
-    // neither apos nor bpos is the solution
-    // but root is now bracketed, so we can use brent_zero
-    assert( error(apos) * error(bpos) < 0.0  );
-    // this looks for the diangle that makes the offset-ellipse point y-coordinate zero
-    double dia_sln = brent_zero( apos.diangle, bpos.diangle , 3E-16, OE_ERROR_TOLERANCE, this ); // brent_zero.hpp
-    EllipsePosition1.setDiangle( dia_sln );     assert( EllipsePosition1.isValid() );
-    // because we only work with the y-coordinate of the offset-ellipse-point, there are two symmetric solutions
-    find_EllipsePosition2();
+};
+
+} // end anonymous namespace
+
+// the canonical edge-drop problem: the ellipse is centered at (0, center.y), and we look
+// for the positions where the offset-ellipse point is at y == 0. The two solutions are
+// symmetric: (s, t) and (-s, t).
+int Ellipse::solver(double t_start) {
+    int iters = 0;
+    setT( solve_drop( center.y, a, b, offset, t_start, iters ) );
     return iters;
 }
 
+int Ellipse::solver() {
+    return solver( drop_start(center.y, b, offset) );
+}
+
+void Ellipse::setT(double t) {
+    const double s = sqrt( std::max(0.0, 1.0 - square(t)) );
+    set_position( EllipsePosition1,  s, t );
+    set_position( EllipsePosition2, -s, t );
+}
+
+int Ellipse::solve_drops(std::vector<EllipseDrop>& drops) {
+    int total = 0;
+    for (EllipseDrop& d : drops) {
+        const double t_start = std::isnan(d.t) ? drop_start(d.y, d.b, d.offset) : d.t;
+        d.t = solve_drop( d.y, d.a, d.b, d.offset, t_start, d.iters );
+        total += d.iters;
+    }
+    return total;
+}
 
 // used by BullCutter pushcutter edge-test
+// The offset-ellipse is convex and its point moves monotonically around it with phi, so the
+// projection h(phi) onto error_dir has one maximum and one minimum, half a turn apart, and is
+// monotonic in between. The extremes are where the ellipse tangent is parallel to the fiber,
+// at (s, t) proportional to (a me, b ne). Each half-turn brackets one solution.
 bool AlignedEllipse::aligned_solver( const Fiber& f ) {
     error_dir = f.dir.xyPerp(); // now calls to error(diangle) will give the right error
     assert( error_dir.xyNorm() > 0.0 );
-    target = f.p1; // target is either x or y-coord of f.p1
-    // find position(s) where ellipse tangent is parallel to fiber. Here error() will be minimized/maximized.
-    // tangent at point is:  -a t + b s = -a*major_dir*t + b*minor_dir*s 
-    // -at ma.y + bs mi.y = 0   for X-fiber
-    // s = sqrt(1-t^2)
-    //  -a*ma.y * t + b*mi.y* sqrt(1-t^2) = 0
-    //  =>  t^2 = b^2 / (a^2 + b^2)
-    double t1(0.0);
-    if (f.p1.y == f.p2.y)
-        t1 = sqrt( square( b*minor_dir.y ) / ( square( a*major_dir.y ) + square( b*minor_dir.y ) ) );
-    else if (f.p1.x == f.p2.x)
-        t1 = sqrt( square( b*minor_dir.x ) / ( square( a*major_dir.x ) + square( b*minor_dir.x ) ) );
-    else
-        assert(0);
-    // bracket root
-    EllipsePosition tmp,apos,bpos;
-    double s1 = sqrt(1.0-square(t1));
-    bool found_positive=false;
-    bool found_negative=false;
-    tmp.setDiangle( xyVectorToDiangle(s1,t1) );
-    double err = error(tmp.diangle);
-    if (err > 0) {
-        found_positive = true;
-        apos = tmp;
-    } else if (err < 0) {
-        found_negative = true;
-        bpos = tmp;
-    }
-    tmp.setDiangle( xyVectorToDiangle(s1,-t1) );
-    err = error(tmp.diangle);
-    if (err > 0) {
-        found_positive = true;
-        apos = tmp;
-    }
-    else if (err < 0) {
-        found_negative = true;
-        bpos = tmp;
-    }
-    tmp.setDiangle( xyVectorToDiangle(-s1,t1) );
-    err = error(tmp.diangle);
-    if (err > 0) {
-        found_positive = true;
-        apos = tmp;
-    }
-    else if (err < 0) {
-        found_negative = true;
-        bpos = tmp;
-    }
-    tmp.setDiangle( xyVectorToDiangle(-s1,-t1) );
-    err = error(tmp.diangle);
-    if (err > 0) {
-        found_positive = true;
-        apos = tmp;
-    }
-    else if (err < 0) {
-        found_negative = true;
-        bpos = tmp;
-    }
-
-    if (found_positive) {
-        if (found_negative) {
-            assert( this->error(apos.diangle) * this->error(bpos.diangle) < 0.0 ); // root is now bracketed.
-            double lolim(0.0), hilim(0.0);
-            if (apos.diangle > bpos.diangle ) {
-                lolim = bpos.diangle;
-                hilim = apos.diangle;
-            } else if (bpos.diangle > apos.diangle) {
-                hilim = bpos.diangle;
-                lolim = apos.diangle;
-            }
-            double dia_sln = brent_zero( lolim, hilim , 3E-16, OE_ERROR_TOLERANCE, this );
-            double dia_sln2 = brent_zero( hilim-4.0, lolim , 3E-16, OE_ERROR_TOLERANCE, this );
-            
-            EllipsePosition1.setDiangle( dia_sln );  
-            EllipsePosition2.setDiangle( dia_sln2 );   
-                   
-            assert( EllipsePosition1.isValid() );
-            assert( EllipsePosition2.isValid() );
-            /*
-            // FIXME. This assert fails in some cases (30sphere.stl z=0, for example)
-            // FIXME. The allowed error should probably be in proportion to the difficulty of the case.
-            
-            if (!isZero_tol( error(EllipsePosition1.diangle) )) {
-                std::cout << "AlignedEllipse::aligned_solver() ERROR \n";
-                std::cout << "error(EllipsePosition1.diangle)= "<< error(EllipsePosition1.diangle) << " (expected zero)\n";
-                
-            }         
-            assert( isZero_tol( error(EllipsePosition1.diangle) ) );
-            assert( isZero_tol( error(EllipsePosition2.diangle) ) );
-            */
-            
-            return true;
-        }
-    }
-    
-    return false;
+    target = f.p1;
+    const double me = major_dir.dot(error_dir);
+    const double ne = minor_dir.dot(error_dir);
+    const double c0 = (target - center).dot(error_dir);
+    PushProjection h = { a, b, offset, me, ne, c0, 1.0 };
+    const double phi_max = atan2( b*ne, a*me );
+    double dh;
+    const double h_max = h(phi_max, dh) + c0; // h(phi_max + pi) = -h_max
+    if ( !( fabs(c0) < h_max ) )
+        return false; // the fiber does not cross the offset-ellipse
+    const double dphi = acos( c0/h_max ); // exact if the offset-ellipse is a circle
+    int iters;
+    const double phi1 = newton_zero( h, phi_max - PI, phi_max, phi_max - dphi, OE_PARAM_TOLERANCE, OE_MAX_ITERS, iters );
+    h.sign = -1.0;
+    const double phi2 = newton_zero( h, phi_max, phi_max + PI, phi_max + dphi, OE_PARAM_TOLERANCE, OE_MAX_ITERS, iters );
+    set_position( EllipsePosition1, cos(phi1), sin(phi1) );
+    set_position( EllipsePosition2, cos(phi2), sin(phi2) );
+    return true;
 }
 
 double AlignedEllipse::error(double diangle) const {
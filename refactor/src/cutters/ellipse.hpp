@@ -23,6 +23,7 @@
 #define ELLIPSE_H
 
 #include <list>
+#include <vector>
 
 #include "geo/point.hpp"
 #include "ellipseposition.hpp"
@@ -32,6 +33,16 @@ namespace ocl
 
 class Fiber;
 
+/// one canonical offset-ellipse drop problem, see Ellipse::solver()
+struct EllipseDrop {
+    double y;       ///< y-coordinate of the ellipse center, the CL-point is at (0,0)
+    double a;       ///< axis in the X-direction
+    double b;       ///< axis in the Y-direction
+    double offset;  ///< offset distance
+    double t;       ///< starting guess on input, NAN for the default guess. solution on output
+    int iters;      ///< solver iterations used
+};
+
 /// An Ellipse. 
 class Ellipse {
     public:
@@ -47,12 +58,19 @@ class Ellipse {
         /// return a normalized normal vector of the ellipse at the given EllipsePosition
         virtual Point normal(const EllipsePosition& position) const;
 
-        /// offset-ellipse Brent solver
-        int solver_brent();
+        /// offset-ellipse solver for the canonical edge-drop problem: finds the two
+        /// EllipsePositions where the offset-ellipse point has y == 0.
+        /// t_start is a starting guess for the t-parameter. Returns the number of iterations.
+        int solver(double t_start);
+        /// solver() for the default starting guess
+        int solver();
+        /// solve a batch of canonical drop problems, each started from its own t, or from
+        /// the default guess where t is NAN. Returns the total number of iterations.
+        static int solve_drops(std::vector<EllipseDrop>& drops);
+        /// set the two solutions (s, t) and (-s, t) of the canonical drop problem
+        void setT(double t);
         /// print out the found solutions
         void print_solutions();
-        /// given one EllipsePosition solution, find the other.
-        bool find_EllipsePosition2();
         /// error function for the solver
         double error(EllipsePosition& position) const; 
         /// error function for solver
@@ -127,7 +145,8 @@ class AlignedEllipse : public Ellipse {
         Point oePoint(const EllipsePosition& pos) const;
         /// error-function for the solver
         double error(double dia) const;
-        /// aligned offset-ellipse solver. callsn Numeric::brent_solver()
+        /// aligned offset-ellipse solver, finds the two positions where the offset-ellipse
+        /// point lies on the fiber. Returns false if the offset-ellipse does not reach the fiber.
         bool aligned_solver( const Fiber& f );
     private:
         /// direction of the major axis
@@ -19,6 +19,9 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cmath>
+
 #include <boost/foreach.hpp>
 #include <spdlog/spdlog.h>
 
@@ -40,19 +43,39 @@ bool MillingCutter::vertexDrop(CLPoint& cl, const Triangle& t) const
 {
     bool result = false;
     BOOST_FOREACH (const Point& p, t.p) {  // test each vertex of triangle
-        double q = cl.xyDistance(p);       // distance in XY-plane from cl to p
-        if (q <= radius) {                 // p is inside the cutter
-            CCPoint cc_tmp(p, VERTEX);
-            if (cl.liftZ(p.z - this->height(q), cc_tmp))
-                result = true;
-        }
+        if (vertexDrop(cl, p))
+            result = true;
     }
     return result;
 }
 
+bool MillingCutter::vertexDrop(CLPoint& cl, const Point& p) const
+{
+    double q = cl.xyDistance(p);  // distance in XY-plane from cl to p
+    if (q <= radius) {            // p is inside the cutter
+        CCPoint cc_tmp(p, VERTEX);
+        return cl.liftZ(p.z - this->height(q), cc_tmp);
+    }
+    return false;
+}
+
 // general purpose facet-drop which calls xy_normal_length(), normal_length(),
 // and center_height() on the subclass
 bool MillingCutter::facetDrop(CLPoint& cl, const Triangle& t) const
+{
+    return generalFacetDrop(this->normal_length,
+                            this->center_height,
+                            this->xy_normal_length,
+                            cl,
+                            t);
+}
+
+// general purpose facet-drop with given normal/center/xy_length
+bool MillingCutter::generalFacetDrop(double normal_length,
+                                     double center_height,
+                                     double xy_normal_length,
+                                     CLPoint& cl,
+                                     const Triangle& t) const
 {                                 // Drop cutter at (cl.x, cl.y) against facet of Triangle t
     Point normal = t.upNormal();  // facet surface normal
     if (isZero_tol(normal.z))     // vertical surface
@@ -72,12 +95,12 @@ bool MillingCutter::facetDrop(CLPoint& cl, const Triangle& t) const
         xyNormal.xyNormalize();
         // define the radiusvector which points from the cc-point to the
         // cutter-center
-        Point radiusvector = this->xy_normal_length * xyNormal + this->normal_length * normal;
+        Point radiusvector = xy_normal_length * xyNormal + normal_length * normal;
         CCPoint cc_tmp = cl - radiusvector;  // NOTE xy-coords right, z-coord is not.
         cc_tmp.z = (1.0 / normal.z)
             * (-d - normal.x * cc_tmp.x - normal.y * cc_tmp.y);  // cc-point lies in the plane.
         cc_tmp.type = FACET;
-        double tip_z = cc_tmp.z + radiusvector.z - this->center_height;
+        double tip_z = cc_tmp.z + radiusvector.z - center_height;
         return cl.liftZ_if_inFacet(tip_z, cc_tmp, t);
     }
 }
@@ -90,18 +113,34 @@ bool MillingCutter::edgeDrop(CLPoint& cl, const Triangle& t) const
     for (int n = 0; n < 3; n++) {  // loop through all three edges
         int start = n;             // index of the start-point of the edge
         int end = (n + 1) % 3;     // index of the end-point of the edge
-        const Point p1 = t.p[start];
-        const Point p2 = t.p[end];
-        if (!isZero_tol(p1.x - p2.x) || !isZero_tol(p1.y - p2.y)) {
-            const double d = cl.xyDistanceToLine(p1, p2);
-            if (d <= radius)  // potential contact with edge
-                if (this->singleEdgeDrop(cl, p1, p2, d))
-                    result = true;
-        }
+        if (this->edgeDrop(cl, t.p[start], t.p[end]))
+            result = true;
     }
     return result;
 }
 
+bool MillingCutter::edgeDrop(CLPoint& cl, const Point& p1, const Point& p2) const
+{
+    if (!isZero_tol(p1.x - p2.x) || !isZero_tol(p1.y - p2.y)) {
+        const double d = cl.xyDistanceToLine(p1, p2);
+        if (d <= radius)  // potential contact with edge
+            return this->singleEdgeDrop(cl, p1, p2, d);
+    }
+    return false;
+}
+
+int MillingCutter::edgeDrops(CLPoint& cl, std::vector<DropEdge>& edges, int& iters) const
+{
+    int count = 0;
+    BOOST_FOREACH (const DropEdge& e, edges) {
+        if (e.p1.z > cl.z || e.p2.z > cl.z) {  // an edge below the cutter can not lift it
+            this->edgeDrop(cl, e.p1, e.p2);
+            ++count;
+        }
+    }
+    return count;
+}
+
 // 1) translate the geometry so that in the XY plane cl = (0,0)
 // 2) rotate the p1-p2 edge so that a new edge u1-u2 lies along the x-axis
 // 3) call singleEdgeDropCanonical(), implemented in the sub-class.
@@ -133,19 +172,42 @@ bool MillingCutter::edgeDrop(CLPoint& cl, const Triangle& t) const
 // d is the distance from the p1-p2 line to cl, in the 2D XY plane
 bool MillingCutter::singleEdgeDrop(CLPoint& cl, const Point& p1, const Point& p2, double d) const
 {
-    Point v = p2 - p1;         // vector along edge, from p1 -> p2
-    Point vxy(v.x, v.y, 0.0);  // XY projection
-    vxy.xyNormalize();         // normalized XY edge vector
+    Point sc, vxy, u1, u2;
+    canonicalEdge(cl, p1, p2, d, sc, vxy, u1, u2);
+    CC_CLZ_Pair contact = this->singleEdgeDropCanonical(u1, u2);  // the subclass handles this
+    return liftEdge(cl, p1, p2, sc, vxy, contact);
+}
+
+void MillingCutter::canonicalEdge(const CLPoint& cl,
+                                  const Point& p1,
+                                  const Point& p2,
+                                  double d,
+                                  Point& sc,
+                                  Point& vxy,
+                                  Point& u1,
+                                  Point& u2) const
+{
+    Point v = p2 - p1;           // vector along edge, from p1 -> p2
+    vxy = Point(v.x, v.y, 0.0);  // XY projection
+    vxy.xyNormalize();           // normalized XY edge vector
     // figure out u-coordinates of p1 and p2 (i.e. x-coord in the rotated system)
-    Point sc = cl.xyClosestPoint(p1, p2);
+    sc = cl.xyClosestPoint(p1, p2);
     assert(((cl - sc).xyNorm() - d) < 1E-6);
     // edge endpoints in the new coordinate system, in these coordinates, CL is at
     // origo
-    Point u1((p1 - sc).dot(vxy),
-             d,
-             p1.z);  // d, the distance to line, is the y-coord in the rotated system
-    Point u2((p2 - sc).dot(vxy), d, p2.z);
-    CC_CLZ_Pair contact = this->singleEdgeDropCanonical(u1, u2);  // the subclass handles this
+    u1 = Point((p1 - sc).dot(vxy),
+               d,
+               p1.z);  // d, the distance to line, is the y-coord in the rotated system
+    u2 = Point((p2 - sc).dot(vxy), d, p2.z);
+}
+
+bool MillingCutter::liftEdge(CLPoint& cl,
+                             const Point& p1,
+                             const Point& p2,
+                             const Point& sc,
+                             const Point& vxy,
+                             const CC_CLZ_Pair& contact) const
+{
     CCPoint cc_tmp(sc + contact.first * vxy,
                    EDGE);  // translate back into original coord-system
     cc_tmp.z_projectOntoEdge(p1, p2);
@@ -518,5 +580,82 @@ bool MillingCutter::overlaps(Point& cl, const Triangle& t) const
         return true;
 }
 
+namespace
+{
+
+// squared distance from the origin to the segment a-b, in the xy-plane
+double xySegmentDistance2(double ax, double ay, double bx, double by)
+{
+    double dx = bx - ax;
+    double dy = by - ay;
+    double len2 = dx * dx + dy * dy;
+    double s = 0.0;
+    if (len2 > 0.0)
+        s = std::min(1.0, std::max(0.0, -(ax * dx + ay * dy) / len2));
+    double px = ax + s * dx;
+    double py = ay + s * dy;
+    return px * px + py * py;
+}
+
+}  // namespace
+
+bool MillingCutter::overlapsDisc(const Point& cl, const Triangle& t) const
+{
+    double x[3], y[3];
+    for (int n = 0; n < 3; ++n) {
+        x[n] = t.p[n].x - cl.x;
+        y[n] = t.p[n].y - cl.y;
+    }
+    // is the disc center inside the triangle? (either orientation)
+    double c0 = x[0] * y[1] - y[0] * x[1];
+    double c1 = x[1] * y[2] - y[1] * x[2];
+    double c2 = x[2] * y[0] - y[2] * x[0];
+    if ((c0 >= 0 && c1 >= 0 && c2 >= 0) || (c0 <= 0 && c1 <= 0 && c2 <= 0))
+        return true;
+    // otherwise one of the edges must come within radius of the center
+    double r2 = radius * radius;
+    for (int n = 0; n < 3; ++n) {
+        int m = (n + 1) % 3;
+        if (xySegmentDistance2(x[n], y[n], x[m], y[m]) <= r2)
+            return true;
+    }
+    return false;
+}
+
+bool MillingCutter::overlapsFiber(const Fiber& f, const Triangle& t) const
+{
+    // coordinates (u, v) in the plane normal to the fiber: u is the horizontal
+    // offset from the fiber, v the height above it. The cutter sweeps the
+    // rectangle [-radius, radius] x [0, length].
+    double u[3], v[3];
+    for (int n = 0; n < 3; ++n) {
+        Point d = t.p[n] - f.p1;
+        u[n] = d.y * f.dir.x - d.x * f.dir.y;
+        v[n] = d.z;
+    }
+    // separating axes of the rectangle
+    if (std::max(u[0], std::max(u[1], u[2])) < -radius
+        || std::min(u[0], std::min(u[1], u[2])) > radius)
+        return false;
+    if (std::max(v[0], std::max(v[1], v[2])) < 0.0
+        || std::min(v[0], std::min(v[1], v[2])) > length)
+        return false;
+    // separating axes normal to the projected triangle edges
+    double half = 0.5 * length;
+    for (int n = 0; n < 3; ++n) {
+        int m = (n + 1) % 3;
+        int k = (n + 2) % 3;
+        double nu = -(v[m] - v[n]);
+        double nv = u[m] - u[n];
+        double edge = nu * u[n] + nv * v[n];
+        double apex = nu * u[k] + nv * v[k];
+        double center = nv * half;
+        double extent = std::fabs(nu) * radius + std::fabs(nv) * half;
+        if (center + extent < std::min(edge, apex) || center - extent > std::max(edge, apex))
+            return false;
+    }
+    return true;
+}
+
 }  // namespace ocl
 // end file cutter.cpp
@@ -43,6 +43,15 @@ class STLSurf;
 typedef std::pair<double, double> CC_CLZ_Pair;
 typedef std::pair<double, double> DoublePair;
 
+/// an edge for MillingCutter::edgeDrops(). t is the state of the edge solver,
+/// carried from one CL-point to the next: the starting guess on input, NAN for
+/// none, and the solution on output.
+struct DropEdge {
+  Point p1;
+  Point p2;
+  double t;
+};
+
 ///
 /// \brief MillingCutter is a base-class for all milling cutters
 ///
@@ -68,21 +77,48 @@ public:
   /// overlaps with the bounding-box of Triangle t.
   /// works in the xy-plane
   bool overlaps(Point &cl, const Triangle &t) const;
+  /// \brief exact xy-plane test: does the disc of radius this->radius
+  /// centered at cl intersect Triangle t. A triangle which fails this test
+  /// cannot change cl in dropCutter().
+  bool overlapsDisc(const Point &cl, const Triangle &t) const;
+  /// \brief exact test in the plane normal to Fiber f: does Triangle t,
+  /// projected along f, intersect the rectangle swept by the cutter
+  /// (width 2*radius, height length, bottom at f.p1.z). A triangle which
+  /// fails this test cannot add an Interval in pushCutter().
+  bool overlapsFiber(const Fiber &f, const Triangle &t) const;
 
   /// \brief drop cutter at (cl.x, cl.y) against the three vertices of Triangle
   /// t. calls this->height(r) on the subclass of MillingCutter we are using. if
   /// cl.z is too low, updates cl.z so that cutter does not cut any vertex.
   bool vertexDrop(CLPoint &cl, const Triangle &t) const;
+  /// drop cutter at (cl.x, cl.y) against the single vertex p
+  bool vertexDrop(CLPoint &cl, const Point &p) const;
   /// \brief drop cutter at (cl.x, cl.y) against facet of Triangle t
   /// calls xy_normal_length(), normal_length(), and center_height() on the
   /// subclass. if cl.z is too low, updates cl.z so that cutter does not cut the
   /// facet. CompositeCutter may be the only sub-class that needs to reimplement
   /// this function.
   virtual bool facetDrop(CLPoint &cl, const Triangle &t) const;
+  /// drop cutter with given normal/center/xy_length against the facet of
+  /// Triangle t
+  bool generalFacetDrop(double normal_length, double center_height,
+                        double xy_normal_length, CLPoint &cl,
+                        const Triangle &t) const;
   /// \brief drop cutter at (cl.x, cl.y) against the three edges of input
   /// Triangle t. calls the sub-class MillingCutter::singleEdgeDrop on each edge
   /// if cl.z is too low, updates cl.z so that cutter does not cut any edge.
   virtual bool edgeDrop(CLPoint &cl, const Triangle &t) const;
+  /// \brief drop cutter at (cl.x, cl.y) against the single edge p1-p2.
+  /// edgeDrop(cl, t) calls this on the three edges of t.
+  virtual bool edgeDrop(CLPoint &cl, const Point &p1, const Point &p2) const;
+  /// \brief drop cutter at (cl.x, cl.y) against the unique edges of one
+  /// CL-point, skipping edges below cl.z. Calls edgeDrop(cl, p1, p2) on each
+  /// edge. A sub-class with an iterative edge solver starts it from DropEdge::t,
+  /// so a caller dropping neighbouring CL-points in sequence can pass on the t
+  /// of the previous point. Returns the number of edges dropped against, and
+  /// adds the solver iterations to iters.
+  virtual int edgeDrops(CLPoint &cl, std::vector<DropEdge> &edges,
+                        int &iters) const;
   /// \brief drop the MillingCutter at Point cl down along the z-axis until it
   /// makes contact with Triangle t. This function calls vertexDrop, facetDrop,
   /// and edgeDrop to do its job. Follows the template-method, or
@@ -172,6 +208,16 @@ protected:
   /// for call to singleEdgeDropCanonical()
   bool singleEdgeDrop(CLPoint &cl, const Point &p1, const Point &p2,
                       double d) const;
+  /// the canonical position of singleEdgeDrop(): sc is the point of the p1-p2
+  /// line closest to cl, vxy the XY direction of the edge, and u1 u2 the edge
+  /// end-points with cl at the origin and the edge along the x-axis
+  void canonicalEdge(const CLPoint &cl, const Point &p1, const Point &p2,
+                     double d, Point &sc, Point &vxy, Point &u1,
+                     Point &u2) const;
+  /// translate a canonical contact back to sc and vxy, and lift cl if the
+  /// cc-point lies inside the p1-p2 edge
+  bool liftEdge(CLPoint &cl, const Point &p1, const Point &p2, const Point &sc,
+                const Point &vxy, const CC_CLZ_Pair &contact) const;
   /// edge-drop in the 'canonical' position with cl=(0,0,cl.z) and edge u1-u2
   /// along x-axis. returns x-coordinate of cc-point and cl.z as a CC_CLZ_Pair.
   /// must be implemented in a subclass.
@@ -0,0 +1,500 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include <boost/foreach.hpp>
+
+#include "common/numeric.hpp"
+#include "profilecutter.hpp"
+
+namespace ocl {
+
+namespace {
+
+// roots of a*x^2 + b*x + c = 0, returns the number of roots. A slightly
+// negative discriminant is taken as a double root, the callers only use the
+// roots as candidates.
+int quadratic_roots(double a, double b, double c, double roots[2]) {
+  if (a == 0.0) {
+    if (b == 0.0)
+      return 0;
+    roots[0] = -c / b;
+    return 1;
+  }
+  double discr = std::max(b * b - 4 * a * c, 0.0);
+  // avoid cancellation, see Numerical Recipes 5.6
+  double q = -0.5 * (b + std::copysign(sqrt(discr), b));
+  roots[0] = q / a;
+  if (q == 0.0)
+    return 1;
+  roots[1] = c / q;
+  return 2;
+}
+
+} // namespace
+
+ProfileCutter::ProfileCutter() { assert(0); }
+
+ProfileCutter::ProfileCutter(const std::vector<DoublePair> &profile, double l,
+                             int table_size) {
+  silhouette = profile;
+  length = l;
+  init(table_size);
+}
+
+void ProfileCutter::init(int table_size) {
+  assert(silhouette.size() >= 2);
+  assert(table_size >= 1);
+  assert(isZero_tol(silhouette.front().first));
+  assert(isZero_tol(silhouette.front().second));
+  silhouette.front() = DoublePair(0.0, 0.0);
+  for (unsigned int n = 1; n < silhouette.size(); ++n) {
+    assert(silhouette[n].first >= 0.0);
+    assert(silhouette[n].second >= silhouette[n - 1].second);
+  }
+  profile_top = silhouette.back().second;
+  shaft_radius = silhouette.back().first;
+  assert(length >= profile_top);
+  if (length > profile_top)
+    silhouette.push_back(DoublePair(shaft_radius, length));
+
+  // lower envelope: walk up the silhouette and keep the parts that reach
+  // further out than anything below them.
+  envelope.clear();
+  envelope.push_back(silhouette.front());
+  double rmax = 0.0;
+  for (unsigned int n = 0; n + 1 < silhouette.size(); ++n) {
+    const DoublePair &a = silhouette[n];
+    const DoublePair &b = silhouette[n + 1];
+    if (b.first <= rmax)
+      continue;
+    // height where this segment grows past rmax
+    double h = a.second + (b.second - a.second) * (rmax - a.first) /
+                              (b.first - a.first);
+    if (a.first >= rmax)
+      h = a.second;
+    if (h > envelope.back().second)
+      envelope.push_back(DoublePair(rmax, h)); // vertical step
+    envelope.push_back(b);
+    rmax = b.first;
+  }
+  radius = rmax;
+  assert(radius > 0.0);
+  diameter = 2 * radius;
+
+  // lower convex hull of the envelope, only these samples can support a plane
+  hull.clear();
+  BOOST_FOREACH (const DoublePair &p, envelope) {
+    if (!hull.empty() && p.first == hull.back().first)
+      continue; // upper end of a vertical step
+    while (hull.size() >= 2) {
+      const DoublePair &o = hull[hull.size() - 2];
+      const DoublePair &a = hull.back();
+      double cross = (a.first - o.first) * (p.second - o.second) -
+                     (a.second - o.second) * (p.first - o.first);
+      if (cross > 0.0)
+        break;
+      hull.pop_back();
+    }
+    hull.push_back(p);
+  }
+  hull_slope.clear();
+  for (unsigned int n = 0; n + 1 < hull.size(); ++n)
+    hull_slope.push_back((hull[n + 1].second - hull[n].second) /
+                         (hull[n + 1].first - hull[n].first));
+
+  convex = (hull.size() == envelope.size());
+  undercut = (envelope.size() != silhouette.size() - (length > profile_top));
+
+  rims.clear();
+  for (unsigned int n = 0; n < silhouette.size(); ++n) {
+    const double w = silhouette[n].first;
+    if ((n > 0 && silhouette[n - 1].first >= w) ||
+        (n + 1 < silhouette.size() && silhouette[n + 1].first > w))
+      continue;
+    rims.push_back(silhouette[n]);
+  }
+
+  // these are never used by ProfileCutter, set them like a CylCutter
+  xy_normal_length = radius;
+  normal_length = 0.0;
+  center_height = envelope.back().second;
+
+  // lookup tables
+  height_table.resize(table_size + 1);
+  height_scale = table_size / radius;
+  for (int n = 0; n <= table_size; ++n)
+    height_table[n] = profile_height(n / height_scale);
+  width_table.resize(table_size + 1);
+  width_scale = (profile_top > 0.0) ? table_size / profile_top : 0.0;
+  for (int n = 0; n <= table_size; ++n)
+    width_table[n] = profile_width((profile_top > 0.0) ? n / width_scale : 0.0);
+
+  // both the tables and the profile are piecewise linear, so the error is
+  // largest at a profile sample. Compare there, including the one-sided
+  // limits on either side of a step.
+  height_error = 0.0;
+  BOOST_FOREACH (const DoublePair &p, envelope)
+    height_error = std::max(height_error, fabs(height(p.first) - p.second));
+  width_error = 0.0;
+  BOOST_FOREACH (const DoublePair &p, silhouette) {
+    double h = p.second;
+    if (h > profile_top)
+      continue;
+    double w = width(h);
+    width_error = std::max(width_error, fabs(w - profile_width(h)));
+    for (unsigned int n = 0; n + 1 < silhouette.size(); ++n) {
+      const DoublePair &a = silhouette[n];
+      const DoublePair &b = silhouette[n + 1];
+      if (a.second == b.second)
+        continue;
+      if (a.second == h || b.second == h) {
+        double limit = (a.second == h) ? a.first : b.first;
+        width_error = std::max(width_error, fabs(w - limit));
+      }
+    }
+  }
+}
+
+double ProfileCutter::height(double r) const {
+  if (r <= 0.0)
+    return height_table.front();
+  double x = r * height_scale;
+  unsigned int n = static_cast<unsigned int>(x);
+  if (n >= height_table.size() - 1)
+    return height_table.back();
+  double frac = x - n;
+  return height_table[n] + frac * (height_table[n + 1] - height_table[n]);
+}
+
+double ProfileCutter::width(double h) const {
+  if (h > profile_top)
+    return shaft_radius;
+  if (h <= 0.0 || profile_top <= 0.0)
+    return width_table.front();
+  double x = h * width_scale;
+  unsigned int n = static_cast<unsigned int>(x);
+  if (n >= width_table.size() - 1)
+    return width_table.back();
+  double frac = x - n;
+  return width_table[n] + frac * (width_table[n + 1] - width_table[n]);
+}
+
+double ProfileCutter::profile_height(double r) const {
+  for (unsigned int n = 0; n + 1 < envelope.size(); ++n) {
+    const DoublePair &a = envelope[n];
+    const DoublePair &b = envelope[n + 1];
+    if (a.first <= r && r <= b.first) {
+      if (b.first == a.first)
+        return a.second; // bottom of a vertical step
+      return a.second +
+             (b.second - a.second) * (r - a.first) / (b.first - a.first);
+    }
+  }
+  return envelope.back().second;
+}
+
+double ProfileCutter::profile_width(double h) const {
+  if (h > profile_top)
+    return shaft_radius;
+  double w = 0.0;
+  for (unsigned int n = 0; n + 1 < silhouette.size(); ++n) {
+    const DoublePair &a = silhouette[n];
+    const DoublePair &b = silhouette[n + 1];
+    if (a.second <= h && h <= b.second) {
+      if (b.second == a.second) // horizontal step, take the outer end
+        w = std::max(w, std::max(a.first, b.first));
+      else
+        w = std::max(w, a.first + (b.first - a.first) * (h - a.second) /
+                                      (b.second - a.second));
+    }
+  }
+  return w;
+}
+
+// the sample maximizing r*slope - h touches the plane first. Along the hull
+// that is the first vertex whose outgoing segment is at least as steep.
+const DoublePair &ProfileCutter::support(double slope) const {
+  unsigned int n =
+      std::lower_bound(hull_slope.begin(), hull_slope.end(), slope) -
+      hull_slope.begin();
+  return hull[n];
+}
+
+// a ring (r, h) of the cutter touches a plane of slope s where r*s - h has a
+// local maximum along the profile. The global maximum is the hull support.
+bool ProfileCutter::facetDrop(CLPoint &cl, const Triangle &t) const {
+  Point normal = t.upNormal();
+  if (isZero_tol(normal.z)) // vertical surface
+    return false;
+  normal.normalize();
+  const double slope = normal.xyNorm() / normal.z;
+  const DoublePair &s = support(slope);
+  // contact on a ring of radius s.first at height s.second above the tip
+  if (generalFacetDrop(0.0, s.second, s.first, cl, t))
+    return true;
+  if (convex)
+    return false;
+  for (unsigned int n = 0; n < envelope.size(); ++n) {
+    const double g = slope * envelope[n].first - envelope[n].second;
+    if ((n > 0 &&
+         slope * envelope[n - 1].first - envelope[n - 1].second > g) ||
+        (n + 1 < envelope.size() &&
+         slope * envelope[n + 1].first - envelope[n + 1].second > g))
+      continue;
+    generalFacetDrop(0.0, envelope[n].second, envelope[n].first, cl, t);
+  }
+  return false;
+}
+
+// as facetDrop(), and for an undercut profile also rings touching the facet
+// from below, where r*s + h has a local maximum. The top of the shaft is left
+// out, as for the other cutters.
+bool ProfileCutter::facetPush(const Fiber &fib, Interval &i,
+                              const Triangle &t) const {
+  Point normal = t.upNormal();
+  if (normal.zParallel())
+    return false;
+  bool result = false;
+  if (isZero_tol(normal.z)) { // vertical facet, try each widest ring
+    BOOST_FOREACH (const DoublePair &s, rims) {
+      if (generalFacetPush(0.0, s.second, s.first, fib, i, t))
+        result = true;
+      if (generalFacetPush(0.0, s.second, -s.first, fib, i, t))
+        result = true;
+    }
+    return result;
+  }
+  normal.normalize();
+  const double slope = normal.xyNorm() / normal.z;
+  if (convex && !undercut) {
+    const DoublePair &s = support(slope);
+    return generalFacetPush(0.0, s.second, s.first, fib, i, t);
+  }
+  const unsigned int top = silhouette.size() - 1;
+  for (unsigned int n = 0; n <= top; ++n) {
+    const double r = silhouette[n].first;
+    const double h = silhouette[n].second;
+    const double below = slope * r - h;
+    if (!((n > 0 && slope * silhouette[n - 1].first -
+                            silhouette[n - 1].second >
+                        below) ||
+          (n < top &&
+           slope * silhouette[n + 1].first - silhouette[n + 1].second >
+               below)))
+      if (generalFacetPush(0.0, h, r, fib, i, t))
+        result = true;
+    const double above = slope * r + h;
+    if (n < top &&
+        !((n > 0 && slope * silhouette[n - 1].first +
+                            silhouette[n - 1].second >
+                        above) ||
+          slope * silhouette[n + 1].first + silhouette[n + 1].second > above))
+      if (generalFacetPush(0.0, h, -r, fib, i, t))
+        result = true;
+  }
+  return result;
+}
+
+// the edge is at y = u1.y = d. For each envelope segment h = ha + k*(r - ra)
+// the cl-height along the edge is z(x) - ha - k*(sqrt(x^2+d^2) - ra), which is
+// concave in x, so its maximum over the part of the edge covered by the segment
+// is either where the slopes match, x/r = m/k, or at an end of that part.
+CC_CLZ_Pair ProfileCutter::singleEdgeDropCanonical(const Point &u1,
+                                                   const Point &u2) const {
+  const double d = fabs(u1.y);
+  const double m = (u2.z - u1.z) / (u2.x - u1.x);
+  const double xlo = std::min(u1.x, u2.x);
+  const double xhi = std::max(u1.x, u2.x);
+  double cc_x = u1.x;
+  double cl_z = -std::numeric_limits<double>::max();
+  // first segment that reaches out to d
+  unsigned int n0 =
+      std::lower_bound(envelope.begin() + 1, envelope.end(), d,
+                       [](const DoublePair &p, double r) { return p.first < r; }) -
+      envelope.begin();
+  for (unsigned int n = n0 - 1; n + 1 < envelope.size(); ++n) {
+    const DoublePair &a = envelope[n];
+    const DoublePair &b = envelope[n + 1];
+    const double r0 = std::max(a.first, d);
+    const double k =
+        (b.first == a.first) ? 0.0 : (b.second - a.second) / (b.first - a.first);
+    const double x0 = sqrt(square(r0) - square(d));
+    const double x1 = sqrt(square(b.first) - square(d));
+    double cand[7] = {x0, -x0, x1, -x1, u1.x, u2.x, 0.0};
+    int ncand = 6;
+    if (d > 0.0 && k > fabs(m)) {
+      const double tau = m / k;
+      cand[ncand++] = d * tau / sqrt(1.0 - square(tau));
+    }
+    for (int c = 0; c < ncand; ++c) {
+      const double x = cand[c];
+      if (x < xlo || x > xhi || fabs(x) < x0 || fabs(x) > x1)
+        continue;
+      const double r = std::min(sqrt(square(x) + square(d)), b.first);
+      const double z = u1.z + m * (x - u1.x) - (a.second + k * (r - a.first));
+      if (z > cl_z) {
+        cl_z = z;
+        cc_x = x;
+      }
+    }
+  }
+  return CC_CLZ_Pair(cc_x, cl_z);
+}
+
+// the cutter at height h is a disc of radius width(h). Each silhouette segment
+// (and the shaft) covers a range of heights, and so a range u of the edge, over
+// which the disc radius is linear in u.
+bool ProfileCutter::edgePush(const Fiber &f, Interval &i,
+                             const Triangle &t) const {
+  bool result = false;
+  for (int n = 0; n < 3; n++) {
+    const Point &p1 = t.p[n];
+    const Point &p2 = t.p[(n + 1) % 3];
+    const double h1 = p1.z - f.p1.z; // edge height above fiber is h1 + dz*u
+    const double dz = p2.z - p1.z;
+    const bool horizontal = isZero_tol(dz);
+    const double hmin = std::min(h1, h1 + dz);
+    const double hmax = std::max(h1, h1 + dz);
+    // first segment that reaches up to hmin
+    unsigned int s0 =
+        std::lower_bound(silhouette.begin() + 1, silhouette.end(), hmin,
+                         [](const DoublePair &p, double h) {
+                           return p.second < h;
+                         }) -
+        silhouette.begin();
+    for (unsigned int s = s0 - 1; s + 1 < silhouette.size(); ++s) {
+      const DoublePair &a = silhouette[s];
+      const DoublePair &b = silhouette[s + 1];
+      if (a.second > hmax)
+        break;
+      const CCType cctyp = horizontal                 ? EDGE_HORIZ
+                           : (a.second >= profile_top) ? EDGE_SHAFT
+                                                       : EDGE;
+      if (horizontal) {
+        double w = (b.second == a.second)
+                       ? std::max(a.first, b.first)
+                       : a.first + (b.first - a.first) * (h1 - a.second) /
+                                       (b.second - a.second);
+        if (segmentEdgePush(f, i, p1, p2, 0.0, 1.0, w, 0.0, cctyp))
+          result = true;
+      } else if (b.second == a.second) { // horizontal step, a single height
+        double u = (a.second - h1) / dz;
+        if (u >= 0.0 && u <= 1.0 &&
+            segmentEdgePush(f, i, p1, p2, u, u, std::max(a.first, b.first),
+                            0.0, cctyp))
+          result = true;
+      } else {
+        double ua = (a.second - h1) / dz;
+        double ub = (b.second - h1) / dz;
+        if (ua > ub)
+          std::swap(ua, ub);
+        ua = std::max(ua, 0.0);
+        ub = std::min(ub, 1.0);
+        if (ua > ub)
+          continue;
+        const double k = (b.first - a.first) / (b.second - a.second);
+        if (segmentEdgePush(f, i, p1, p2, ua, ub,
+                            a.first + k * (h1 - a.second), k * dz, cctyp))
+          result = true;
+      }
+    }
+  }
+  return result;
+}
+
+// along the fiber the edge point p1+u*(p2-p1) is at X(u) = X0 + X1*u and at a
+// distance e(u) = e0 + e1*u to the side. The disc w(u) = alpha + beta*u covers
+// the fiber over X -/+ sqrt(Q) with Q = (w-e)*(w+e). sqrt(Q) is concave where
+// w >= |e|, so X +/- sqrt(Q) has its extremes at the ends of that range or
+// where X1 = -/+ Q'/(2*sqrt(Q)). Squaring gives the same quadratic for both.
+bool ProfileCutter::segmentEdgePush(const Fiber &f, Interval &i,
+                                    const Point &p1, const Point &p2,
+                                    double ua, double ub, double alpha,
+                                    double beta, CCType cctyp) const {
+  const Point v = p2 - p1;
+  const Point w0 = p1 - f.p1;
+  const Point perp = f.dir.xyPerp();
+  const double X0 = w0.x * f.dir.x + w0.y * f.dir.y;
+  const double X1 = v.x * f.dir.x + v.y * f.dir.y;
+  const double e0 = w0.x * perp.x + w0.y * perp.y;
+  const double e1 = v.x * perp.x + v.y * perp.y;
+  // w - e and w + e must both be non-negative
+  const double gm0 = alpha - e0, gm1 = beta - e1;
+  const double gp0 = alpha + e0, gp1 = beta + e1;
+  const double g[2][2] = {{gm0, gm1}, {gp0, gp1}};
+  for (int n = 0; n < 2; ++n) {
+    if (g[n][1] > 0.0)
+      ua = std::max(ua, -g[n][0] / g[n][1]);
+    else if (g[n][1] < 0.0)
+      ub = std::min(ub, -g[n][0] / g[n][1]);
+    else if (g[n][0] < 0.0)
+      return false;
+  }
+  if (ua > ub)
+    return false;
+
+  const double A = gm1 * gp1;
+  const double B = gm0 * gp1 + gp0 * gm1;
+  const double C = gm0 * gp0;
+  double u[4] = {ua, ub, 0.0, 0.0};
+  int nu = 2;
+  double roots[2];
+  int nroots = quadratic_roots(4 * A * (A - square(X1)),
+                               4 * B * (A - square(X1)),
+                               square(B) - 4 * square(X1) * C, roots);
+  for (int n = 0; n < nroots; ++n)
+    if (roots[n] > ua && roots[n] < ub)
+      u[nu++] = roots[n];
+
+  for (int n = 0; n < nu; ++n) {
+    const double q = (gm0 + gm1 * u[n]) * (gp0 + gp1 * u[n]);
+    const double ofs = sqrt(std::max(q, 0.0));
+    const double x = X0 + X1 * u[n];
+    Point start = f.p1 + (x - ofs) * f.dir;
+    Point stop = f.p1 + (x + ofs) * f.dir;
+    CCPoint cc_tmp = p1 + u[n] * v;
+    cc_tmp.type = cctyp;
+    i.updateUpper(f.tval(stop), cc_tmp);
+    i.updateLower(f.tval(start), cc_tmp);
+  }
+  return true;
+}
+
+std::string ProfileCutter::str() const {
+  std::ostringstream o;
+  o << *this;
+  return o.str();
+}
+
+std::ostream &operator<<(std::ostream &stream, ProfileCutter c) {
+  stream << "ProfileCutter (d=" << c.diameter << ", samples="
+         << c.silhouette.size() << ", L=" << c.length << ")";
+  return stream;
+}
+
+} // namespace ocl
+// end file profilecutter.cpp
@@ -0,0 +1,128 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010-2011 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PROFILE_CUTTER_HPP
+#define PROFILE_CUTTER_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "millingcutter.hpp"
+
+namespace ocl {
+
+/// \brief MillingCutter defined by a sampled (r, h) profile
+///
+/// The profile is the silhouette of the cutter, listed from the tip upwards:
+/// the first sample is (0, 0) and h never decreases along the list, while r
+/// may shrink again (dovetail, lollipop and other undercut form tools). Above
+/// the last sample the cutter continues as a cylindrical shaft with the radius
+/// of the last sample, up to the total length.
+///
+/// height(r) and width(h) are O(1) lookups in uniform tables with linear
+/// interpolation. Both the tables and the exact profile are piecewise linear,
+/// so the largest table error occurs at a profile sample; getHeightError() and
+/// getWidthError() return that bound. Facet, edge-drop and edge-push contacts
+/// are solved against the exact polyline, not by splitting the profile into
+/// sub-cutters.
+class OCL_API ProfileCutter : public MillingCutter {
+public:
+  ProfileCutter();
+  /// create a ProfileCutter from (r, h) samples, with total length l and
+  /// lookup tables of table_size cells
+  ProfileCutter(const std::vector<DoublePair> &profile, double l,
+                int table_size = 1024);
+  /// drop against a facet, touching at the profile sample that supports the
+  /// facet slope. For a non-convex profile the other local supports lift cl
+  /// too, but only the global one returns true, so that dropCutter() still
+  /// checks vertices and edges.
+  bool facetDrop(CLPoint &cl, const Triangle &t) const;
+  /// string repr
+  friend std::ostream &operator<<(std::ostream &stream, ProfileCutter c);
+  std::string str() const;
+
+  /// largest difference between the height table and the exact profile
+  double getHeightError() const { return height_error; }
+  /// largest difference between the width table and the exact profile
+  double getWidthError() const { return width_error; }
+  /// the silhouette samples, including the top of the shaft
+  const std::vector<DoublePair> &getProfile() const { return silhouette; }
+
+protected:
+  CC_CLZ_Pair singleEdgeDropCanonical(const Point &u1, const Point &u2) const;
+
+  bool facetPush(const Fiber &fib, Interval &i, const Triangle &t) const;
+  /// push against all three edges of t, one silhouette segment at a time
+  bool edgePush(const Fiber &f, Interval &i, const Triangle &t) const;
+  /// push against edge p1-p2 for the part of the edge at heights where the
+  /// cutter radius is w(u) = alpha + beta*u (u along the edge, in [ua, ub])
+  bool segmentEdgePush(const Fiber &f, Interval &i, const Point &p1,
+                       const Point &p2, double ua, double ub, double alpha,
+                       double beta, CCType cctyp) const;
+
+  double height(double r) const;
+  double width(double h) const;
+
+  /// exact height of the lower envelope at radius r
+  double profile_height(double r) const;
+  /// exact width of the silhouette at height h
+  double profile_width(double h) const;
+  /// (r, h) of the lower-hull sample that touches a plane with the given slope
+  const DoublePair &support(double slope) const;
+
+  /// build envelope, hull and lookup tables from silhouette
+  void init(int table_size);
+
+  /// silhouette samples from the tip up to the top of the shaft
+  std::vector<DoublePair> silhouette;
+  /// lower envelope: for each radius the lowest height where the cutter
+  /// reaches that radius. r is nondecreasing, equal r marks a vertical step.
+  std::vector<DoublePair> envelope;
+  /// lower convex hull of the envelope
+  std::vector<DoublePair> hull;
+  /// slope of hull segment n, from hull[n] to hull[n+1]
+  std::vector<double> hull_slope;
+  /// silhouette samples where the width has a local maximum, these are the
+  /// candidate contacts with a vertical facet
+  std::vector<DoublePair> rims;
+  /// true if the envelope is its own convex hull: one facet contact per slope
+  bool convex;
+  /// true if the silhouette narrows again below the shaft
+  bool undercut;
+  /// height(r) at r = n*radius/(size-1)
+  std::vector<double> height_table;
+  /// width(h) at h = n*profile_top/(size-1)
+  std::vector<double> width_table;
+  /// table cells per unit of radius
+  double height_scale;
+  /// table cells per unit of height
+  double width_scale;
+  /// height of the last profile sample, where the shaft starts
+  double profile_top;
+  /// radius of the shaft
+  double shaft_radius;
+  double height_error;
+  double width_error;
+};
+
+} // namespace ocl
+#endif
+// end profilecutter.hpp
@@ -19,12 +19,14 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+
 #include <boost/foreach.hpp>
 
 #include "adaptivepathdropcutter.hpp"
+#include "common/levelrefiner.hpp"
 #include "cutters/millingcutter.hpp"
 #include "geo/clpoint.hpp"
-#include "pointdropcutter.hpp"
 
 
 namespace ocl {
@@ -38,7 +40,7 @@ AdaptivePathDropCutter::AdaptivePathDropCutter() {
   path = NULL;
   minimumZ = 0.0;
   subOp.clear();
-  subOp.push_back(new PointDropCutter()); // we delegate to PointDropCutter, who
+  subOp.push_back(new BatchDropCutter()); // we delegate to BatchDropCutter, who
                                           // does the heavy lifting
   sampling = 0.1;
   min_sampling = 0.01;
@@ -53,45 +55,75 @@ AdaptivePathDropCutter::~AdaptivePathDropCutter() {
 
 void AdaptivePathDropCutter::run() { adaptive_sampling_run(); }
 
+// all spans are refined together, one level at a time: the mid-points of every
+// segment that is not yet flat are dropped in one BatchDropCutter run.
+// The points come out in the same order as with depth-first subdivision.
 void AdaptivePathDropCutter::adaptive_sampling_run() {
-  // std::cout << " apdc::adaptive_sampling_run()... ";
-
   clpoints.clear();
-  BOOST_FOREACH (const Span *span,
-                 path->span_list) { // this loop could run in parallel, since
-                                    // spans don't depend on eachother
-    CLPoint start = span->getPoint(0.0);
-    CLPoint stop = span->getPoint(1.0);
-    subOp[0]->run(start);
-    subOp[0]->run(stop);
-    clpoints.push_back(start);
-    adaptive_sample(span, 0.0, 1.0, start, stop);
+  std::vector<const Span *> spans(path->span_list.begin(),
+                                  path->span_list.end());
+  std::vector<CLPoint> ends;
+  ends.reserve(2 * spans.size());
+  BOOST_FOREACH (const Span *span, spans) {
+    ends.push_back(span->getPoint(0.0));
+    ends.push_back(span->getPoint(1.0));
+  }
+  drop(ends);
+
+  typedef LevelRefiner<CLPoint> Refiner;
+  Refiner refiner;
+  for (unsigned int n = 0; n < spans.size(); ++n)
+    refiner.addRoot(0.0, 1.0, ends[2 * n], ends[2 * n + 1]);
+  std::vector<std::vector<CLPoint>> samples = refiner.run(
+      [&spans](int span, double t) { return CLPoint(spans[span]->getPoint(t)); },
+      [this](std::vector<CLPoint> &pts) { drop(pts); },
+      [this](int, const CLPoint &start_cl, const CLPoint &mid_cl,
+             const CLPoint &stop_cl) {
+        double fw_step = (stop_cl - start_cl).xyNorm();
+        if (fw_step > sampling) // above minimum step-forward, need to sample more
+          return Refiner::SUBDIVIDE;
+        // an end outside the region of interest was not dropped, so the
+        // segment can not be tested for flatness
+        if (!roi.empty() && (!roi.contains(start_cl) || !roi.contains(stop_cl)))
+          return Refiner::ACCEPT;
+        if (!flat(start_cl, mid_cl, stop_cl) &&
+            fw_step > min_sampling) // not flat, and not max sampling
+          return Refiner::SUBDIVIDE;
+        return Refiner::ACCEPT;
+      });
+  for (unsigned int n = 0; n < spans.size(); ++n) {
+    clpoints.push_back(ends[2 * n]);
+    clpoints.insert(clpoints.end(), samples[n].begin(), samples[n].end());
   }
-  // std::cout << " DONE clpoints.size()=" << clpoints.size() << "\n";
+  // the points outside the region of interest were never dropped
+  if (!roi.empty())
+    clpoints.erase(std::remove_if(clpoints.begin(), clpoints.end(),
+                                  [this](const CLPoint &p) {
+                                    return !roi.contains(p);
+                                  }),
+                   clpoints.end());
 }
 
-void AdaptivePathDropCutter::adaptive_sample(const Span *span, double start_t,
-                                             double stop_t, CLPoint start_cl,
-                                             CLPoint stop_cl) {
-  const double mid_t = start_t + (stop_t - start_t) / 2.0; // mid point sample
-  assert(mid_t > start_t);
-  assert(mid_t < stop_t);
-  CLPoint mid_cl = span->getPoint(mid_t);
-  // std::cout << " apdc sampling at " << mid_t << "\n";
-  subOp[0]->run(mid_cl);
-  double fw_step = (stop_cl - start_cl).xyNorm();
-  if ((fw_step > sampling) || // above minimum step-forward, need to sample more
-      ((!flat(start_cl, mid_cl, stop_cl)) &&
-       (fw_step > min_sampling))) { // OR not flat, and not max sampling
-    adaptive_sample(span, start_t, mid_t, start_cl, mid_cl);
-    adaptive_sample(span, mid_t, stop_t, mid_cl, stop_cl);
-  } else {
-    clpoints.push_back(stop_cl);
+void AdaptivePathDropCutter::drop(std::vector<CLPoint> &pts) {
+  std::vector<std::size_t> at;
+  subOp[0]->clearCLPoints();
+  for (std::size_t n = 0; n < pts.size(); ++n) {
+    if (roi.empty() || roi.contains(pts[n])) {
+      at.push_back(n);
+      subOp[0]->appendPoint(pts[n]);
+    }
   }
+  if (at.empty())
+    return;
+  subOp[0]->run();
+  std::vector<CLPoint> dropped = subOp[0]->getCLPoints();
+  for (std::size_t k = 0; k < at.size(); ++k)
+    pts[at[k]] = dropped[k];
 }
 
-bool AdaptivePathDropCutter::flat(CLPoint &start_cl, CLPoint &mid_cl,
-                                  CLPoint &stop_cl) {
+bool AdaptivePathDropCutter::flat(const CLPoint &start_cl,
+                                  const CLPoint &mid_cl,
+                                  const CLPoint &stop_cl) const {
   CLPoint v1 = mid_cl - start_cl;
   CLPoint v2 = stop_cl - mid_cl;
   v1.normalize();
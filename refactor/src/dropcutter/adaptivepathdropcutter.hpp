@@ -30,8 +30,8 @@
 
 #include "geo/clpoint.hpp"
 #include "geo/path.hpp"
+#include "batchdropcutter.hpp"
 #include "pathdropcutter.hpp"
-#include "pointdropcutter.hpp"
 
 namespace ocl {
 
@@ -47,7 +47,8 @@ public:
   AdaptivePathDropCutter();
   virtual ~AdaptivePathDropCutter();
 
-  /// run drop-cutter on the whole Path
+  /// \brief run drop-cutter on the whole Path. With a region of interest
+  /// (setROI()) only the CL-points inside it are dropped and returned.
   virtual void run();
   /// set the minimum sapling interval
   void setMinSampling(double s) {
@@ -67,13 +68,13 @@ public:
   std::vector<CLPoint> getPoints() const { return clpoints; }
 
 protected:
-  /// run adaptive sample on the given Span between t-values of start_t and
-  /// stop_t
-  void adaptive_sample(const Span *span, double start_t, double stop_t,
-                       CLPoint start_cl, CLPoint stop_cl);
+  /// \brief drop the points inside the region of interest through the
+  /// BatchDropCutter sub-operation
+  void drop(std::vector<CLPoint> &pts);
   /// flatness predicate for adaptive sampling
-  bool flat(CLPoint &start_cl, CLPoint &mid_cl, CLPoint &stop_cl);
-  /// run adaptive sampling
+  bool flat(const CLPoint &start_cl, const CLPoint &mid_cl,
+            const CLPoint &stop_cl) const;
+  /// run adaptive sampling, one subdivision level of all spans at a time
   void adaptive_sampling_run();
   // DATA
   /// the smallest sampling interval used when adaptively subdividing
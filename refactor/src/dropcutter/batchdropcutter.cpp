@@ -19,21 +19,17 @@
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <atomic>
+#include <cmath>
+#include <functional>
 #include <boost/foreach.hpp>
-#include <tbb/blocked_range.h>
-#include <tbb/global_control.h>
-#include <tbb/parallel_for.h>
-#include <tbb/tbb.h>
-
-
-#ifdef _OPENMP  // this should really not be a check for Windows, but a check for
-                // OpenMP
-#include <omp.h>
-#endif
 
 #include "batchdropcutter.hpp"
+#include "common/numeric.hpp"
+#include "geo/meshindex.hpp"
 #include "geo/point.hpp"
+#include "geo/stlsurf.hpp"
 #include "geo/triangle.hpp"
 
 namespace ocl
@@ -45,12 +41,15 @@ BatchDropCutter::BatchDropCutter()
 {
     clpoints = new std::vector<CLPoint>();
     nCalls = 0;
-#ifdef _OPENMP
-    nthreads = omp_get_num_procs();  // figure out how many cores we have
-#endif
     cutter = NULL;
     bucketSize = 1;
-    root = new KDTree<Triangle>();
+    splitThreshold = 1024;
+    uniqueElements = false;
+    topology = NULL;
+    nVertexCalls = 0;
+    nEdgeCalls = 0;
+    nEdgeIterations = 0;
+    root = new KDTree<IndexedMesh>();
 }
 
 BatchDropCutter::~BatchDropCutter()
@@ -58,25 +57,69 @@ BatchDropCutter::~BatchDropCutter()
     clpoints->clear();
     delete clpoints;
     delete root;
+    delete topology;
 }
 
 void BatchDropCutter::run()
 {
-    if (force_use_tbb) {
-        dropCutter6();
+    inROI(
+        [this] {
+            if (uniqueElements)
+                dropCutter5();
+            else
+                dropCutter4();
+        },
+        false);
+}
+
+void BatchDropCutter::inROI(const std::function<void()>& drop, bool cutterColumns)
+{
+    if (roi.empty()) {
+        drop();
+        return;
+    }
+    std::vector<CLPoint>* all = clpoints;
+    std::vector<CLPoint> inside;
+    std::vector<std::size_t> at;
+    for (std::size_t n = 0; n < all->size(); ++n) {
+        if (roi.contains((*all)[n])) {
+            at.push_back(n);
+            inside.push_back((*all)[n]);
+        }
     }
-    else {
-        dropCutter5();
+    clpoints = &inside;
+    try {
+        drop();
+    } catch (...) {
+        clpoints = all;
+        throw;
     }
+    clpoints = all;
+    if (cutterColumns) {
+        // the CL-points outside the region keep their place in every column
+        for (std::vector<CLPoint>& column : columns) {
+            std::vector<CLPoint> full(*all);
+            for (std::size_t k = 0; k < at.size(); ++k)
+                full[at[k]] = column[k];
+            column.swap(full);
+        }
+        return;
+    }
+    for (std::size_t k = 0; k < at.size(); ++k)
+        (*all)[at[k]] = inside[k];
 }
+
 void BatchDropCutter::setSTL(const STLSurf& s)
 {
     // std::cout << "bdc::setSTL()\n";
-    surf = &s;
+    surf = &cullROI(s);
     root->setXYDimensions();  // we search for triangles in the XY plane, don't
                               // care about Z-coordinate
     root->setBucketSize(bucketSize);
-    root->build(s.tris);
+    MeshIndex::buildTree(*root, *surf);
+    // the topology for dropCutter5() is built when first needed
+    delete topology;
+    topology = NULL;
     // std::cout << "bdc::setSTL() done.\n";
 }
 
@@ -110,14 +153,15 @@ void BatchDropCutter::dropCutter2()
     //         " cl-points and " << surf->tris.size() << " triangles.\n";
     std::cout.flush();
     nCalls = 0;
-    std::list<Triangle>* triangles_under_cutter;
+    std::vector<std::uint32_t> faces_under_cutter;
+    Triangle t;
     BOOST_FOREACH (CLPoint& cl, *clpoints) {  // loop through each CL-point
-        triangles_under_cutter = root->search_cutter_overlap(cutter, &cl);
-        BOOST_FOREACH (const Triangle& t, *triangles_under_cutter) {
+        root->search_cutter_overlap(cutter, &cl, faces_under_cutter);
+        BOOST_FOREACH (std::uint32_t f, faces_under_cutter) {
+            surf->mesh.triangle(f, t);
             cutter->dropCutter(cl, t);
             ++nCalls;
         }
-        delete triangles_under_cutter;
     }
 
     // std::cout << "done. " << nCalls << " dropCutter() calls.\n";
@@ -132,188 +176,270 @@ void BatchDropCutter::dropCutter3()
     // std::cout << "dropCutterSTL3 " << clpoints->size() <<
     //         " cl-points and " << surf->tris.size() << " triangles.\n";
     nCalls = 0;
-    std::list<Triangle>* triangles_under_cutter;
+    nSkipped = 0;
+    std::vector<std::uint32_t> faces_under_cutter;
+    Triangle t;
     BOOST_FOREACH (CLPoint& cl, *clpoints) {  // loop through each CL-point
-        triangles_under_cutter = root->search_cutter_overlap(cutter, &cl);
-        BOOST_FOREACH (const Triangle& t, *triangles_under_cutter) {
+        root->search_cutter_overlap(cutter, &cl, faces_under_cutter);
+        BOOST_FOREACH (std::uint32_t f, faces_under_cutter) {
+            surf->mesh.triangle(f, t);
             if (cutter->overlaps(cl, t)) {
                 if (cl.below(t)) {
+                    if (!cutter->overlapsDisc(cl, t)) {
+                        ++nSkipped;
+                        continue;
+                    }
                     cutter->dropCutter(cl, t);
                     ++nCalls;
                 }
             }
         }
-        delete triangles_under_cutter;
     }
 
     // std::cout << "done. " << nCalls << " dropCutter() calls.\n";
     return;
 }
 
-// use OpenMP to share work between threads
+// kd-tree search, exact overlap test, and the Executor to share CL-points
+// between threads
 void BatchDropCutter::dropCutter4()
 {
-    // std::cout << "dropCutterSTL4 " << clpoints->size() <<
-    //         " cl-points and " << surf->tris.size() << " triangles.\n";
-    nCalls = 0;
-    int calls = 0;
-    std::list<Triangle>* tris;
-#ifdef _WIN32  // OpenMP version 2 of VS2013 OpenMP need signed loop variable
-    int n;  // loop variable
-    int Nmax = static_cast<int>(clpoints->size());
-#else
-    unsigned int n;  // loop variable
-    unsigned int Nmax = clpoints->size();
-#endif
+    const IndexedMesh& mesh = surf->mesh;
     std::vector<CLPoint>& clref = *clpoints;
-#ifdef _OPENMP
-    omp_set_num_threads(nthreads);  // the constructor sets number of threads right
-                                    // or the user can explicitly specify something else
-#endif
-    std::list<Triangle>::iterator it;
-#pragma omp parallel for shared(calls, clref) private(n, tris, it)
-    for (n = 0; n < Nmax; n++) {  // PARALLEL OpenMP loop!
-                                  // #ifdef _OPENMP
-                                  //             if ( n== 0 ) { // first iteration
-        //                 if (omp_get_thread_num() == 0 )
-        //                     std::cout << "Number of OpenMP threads = "<<
-        //                     omp_get_num_threads() << "\n";// print out how many
-        //                     threads we are using
-        //             }
-        // #endif
-        tris = root->search_cutter_overlap(cutter, &clref[n]);
-        // assert( tris->size() <= ntriangles ); // can't possibly find more
-        // triangles than in the STLSurf
-        for (it = tris->begin(); it != tris->end(); ++it) {  // loop over found triangles
-            if (cutter->overlaps(clref[n], *it)) {           // cutter overlap triangle? check
-                if (clref[n].below(*it)) {
-                    cutter->vertexDrop(clref[n], *it);
-                    ++calls;
-                }
+    std::atomic<int> calls(0);
+    std::atomic<int> skipped(0);
+    executor.parallel_for(clref.size(), [&](size_t begin, size_t end) {
+        int local_calls = 0;
+        int local_skipped = 0;
+        std::vector<std::uint32_t> faces;
+        Triangle t;
+        for (size_t n = begin; n != end; ++n) {
+            root->search_cutter_overlap(cutter, &clref[n], faces);
+            // 候选三角形过多（陡壁、密集圆角）时，把这个点的三角形拆给多个任务
+            if (faces.size() > splitThreshold) {
+                dropCutterSplit(clref[n], faces, local_calls, local_skipped);
+                continue;
             }
-        }
-        for (it = tris->begin(); it != tris->end(); ++it) {  // loop over found triangles
-            if (cutter->overlaps(clref[n], *it)) {           // cutter overlap triangle? check
-                if (clref[n].below(*it))
-                    cutter->facetDrop(clref[n], *it);
+            BOOST_FOREACH (std::uint32_t f, faces) {
+                mesh.triangle(f, t);
+                if (cutter->overlaps(clref[n], t) && clref[n].below(t)) {
+                    if (!cutter->overlapsDisc(clref[n], t)) {
+                        ++local_skipped;
+                        continue;
+                    }
+                    cutter->dropCutter(clref[n], t);
+                    ++local_calls;
+                }
             }
         }
-        for (it = tris->begin(); it != tris->end(); ++it) {  // loop over found triangles
-            if (cutter->overlaps(clref[n], *it)) {           // cutter overlap triangle? check
-                if (clref[n].below(*it))
-                    cutter->edgeDrop(clref[n], *it);
+        calls += local_calls;
+        skipped += local_skipped;
+    });
+    nCalls = calls;
+    nSkipped = skipped;
+}
+
+void BatchDropCutter::dropCutterSplit(CLPoint& cl, const std::vector<std::uint32_t>& faces,
+                                      int& calls, int& skipped) const
+{
+    const IndexedMesh& mesh = surf->mesh;
+    const size_t chunk = std::max(size_t(32), size_t(splitThreshold / 8));
+    size_t nchunks = (faces.size() + chunk - 1) / chunk;
+    std::vector<CLPoint> local(nchunks, cl);
+    std::vector<int> local_calls(nchunks, 0);
+    std::vector<int> local_skipped(nchunks, 0);
+    // highest z found by any task so far
+    std::atomic<double> zmax(cl.z);
+
+    // one chunk per task: the chunk boundaries, and so the result, do not
+    // depend on the executor's partitioning
+    Executor split = executor;
+    split.setGrainSize(1);
+    split.setPartitioner(Executor::SIMPLE);
+    split.parallel_for(nchunks, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c != end; ++c) {
+            CLPoint& lc = local[c];
+            Triangle t;
+            size_t last = std::min(faces.size(), (c + 1) * chunk);
+            for (size_t k = c * chunk; k < last; ++k) {
+                // the cutter tip never rises above the triangle, so a triangle
+                // entirely below zmax cannot win, not even a tie
+                if (mesh.bound(faces[k], 5) < zmax.load(std::memory_order_relaxed))
+                    continue;
+                mesh.triangle(faces[k], t);
+                if (cutter->overlaps(lc, t) && lc.below(t)) {
+                    if (!cutter->overlapsDisc(lc, t)) {
+                        ++local_skipped[c];
+                        continue;
+                    }
+                    if (cutter->dropCutter(lc, t))
+                        atomic_max(zmax, lc.z);
+                    ++local_calls[c];
+                }
             }
         }
-        delete (tris);
-    }  // end OpenMP PARALLEL for
-    nCalls = calls;
-    // std::cout << " " << nCalls << " dropCutter() calls.\n";
-    return;
+    });
+
+    // deterministic resolution: the first chunk reaching the highest z
+    size_t best = 0;
+    for (size_t c = 0; c < nchunks; ++c) {
+        if (local[c].z > local[best].z)
+            best = c;
+        calls += local_calls[c];
+        skipped += local_skipped[c];
+    }
+    if (nchunks)
+        cl.liftZ(local[best].z, *local[best].cc);
+}
+
+void BatchDropCutter::buildTopology()
+{
+    topology = new MeshTopology(surf->mesh);
 }
 
-// use OpenMP to share work between threads
+// like dropCutter4(), but the vertex and edge kernels run once per unique
+// element of the candidate faces instead of once per face
 void BatchDropCutter::dropCutter5()
 {
-    // std::cout << "dropCutterSTL5 " << clpoints->size() <<
-    //         " cl-points and " << surf->tris.size() << " triangles.\n";
-    nCalls = 0;
-    int calls = 0;
-    std::list<Triangle>* tris;
-#ifdef _WIN32  // OpenMP version 2 of VS2013 OpenMP need signed loop variable
-    int Nmax = static_cast<int>(clpoints->size());
-    int n;  // loop variable
-#else
-    unsigned int Nmax = clpoints->size();
-    unsigned int n;  // loop variable
-#endif
+    if (!topology)
+        buildTopology();
+    const IndexedMesh& mesh = surf->mesh;
     std::vector<CLPoint>& clref = *clpoints;
+    std::atomic<int> calls(0);
+    std::atomic<int> skipped(0);
+    std::atomic<int> vertex_calls(0);
+    std::atomic<int> edge_calls(0);
+    std::atomic<int> edge_iters(0);
+    executor.parallel_for(clref.size(), [&](size_t begin, size_t end) {
+        int local_calls = 0;
+        int local_skipped = 0;
+        int local_vertex = 0;
+        int local_edge = 0;
+        int local_iters = 0;
+        std::vector<std::uint32_t> faces;
+        std::vector<std::uint32_t> verts;
+        std::vector<std::uint32_t> edges;
+        std::vector<std::uint32_t> prev_edges;
+        std::vector<DropEdge> drops;
+        std::vector<DropEdge> prev_drops;
+        Triangle t;
+        for (size_t n = begin; n != end; ++n) {
+            CLPoint& cl = clref[n];
+            root->search_cutter_overlap(cutter, &cl, faces);
+            verts.clear();
+            edges.clear();
+            BOOST_FOREACH (std::uint32_t f, faces) {
+                mesh.triangle(f, t);
+                if (cutter->overlaps(cl, t) && cl.below(t)) {
+                    if (!cutter->overlapsDisc(cl, t)) {
+                        ++local_skipped;
+                        continue;
+                    }
+                    cutter->facetDrop(cl, t);
+                    ++local_calls;
+                    for (int k = 0; k < 3; ++k) {
+                        verts.push_back(mesh.index(f, k));
+                        edges.push_back(topology->edge(f, k));
+                    }
+                }
+            }
 
-#ifdef _OPENMP
-    omp_set_num_threads(nthreads);  // the constructor sets number of threads right
-                                    // or the user can explicitly specify something else
-#endif
-    std::list<Triangle>::iterator it;
-#pragma omp parallel for schedule(dynamic) shared(calls, clref) private(n, tris, it)
-    for (n = 0; n < Nmax; ++n) {  // PARALLEL OpenMP loop!
-                                  // #ifdef _OPENMP
-                                  //             if ( n== 0 ) { // first iteration
-        //                 if (omp_get_thread_num() == 0 )
-        //                     std::cout << "Number of OpenMP threads = "<<
-        //                     omp_get_num_threads() << "\n";
-        //             }
-        // #endif
-        tris = root->search_cutter_overlap(cutter, &clref[n]);
-        assert(tris);
-        // assert( tris->size() <= ntriangles ); // can't possibly find more
-        // triangles than in the STLSurf
-        for (it = tris->begin(); it != tris->end(); ++it) {  // loop over found triangles
-            if (cutter->overlaps(clref[n], *it)) {           // cutter overlap triangle? check
-                if (clref[n].below(*it)) {
-                    cutter->dropCutter(clref[n], *it);
-                    ++calls;
+            std::sort(verts.begin(), verts.end());
+            verts.erase(std::unique(verts.begin(), verts.end()), verts.end());
+            BOOST_FOREACH (std::uint32_t v, verts) {
+                const Point p = mesh.vertex(v);
+                if (p.z > cl.z) {  // a vertex below the cutter can not lift it
+                    cutter->vertexDrop(cl, p);
+                    ++local_vertex;
                 }
             }
+            std::sort(edges.begin(), edges.end());
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+            // the CL-points of a task are neighbours, so an edge shared with the
+            // previous CL-point starts its solver from the t found there
+            drops.clear();
+            std::size_t j = 0;
+            BOOST_FOREACH (std::uint32_t e, edges) {
+                while (j < prev_edges.size() && prev_edges[j] < e)
+                    ++j;
+                DropEdge d;
+                d.p1 = mesh.vertex(topology->edgeVertex(e, 0));
+                d.p2 = mesh.vertex(topology->edgeVertex(e, 1));
+                d.t = (j < prev_edges.size() && prev_edges[j] == e) ? prev_drops[j].t : NAN;
+                drops.push_back(d);
+            }
+            local_edge += cutter->edgeDrops(cl, drops, local_iters);
+            edges.swap(prev_edges);
+            drops.swap(prev_drops);
         }
-        delete (tris);
-    }  // end OpenMP PARALLEL for
+        calls += local_calls;
+        skipped += local_skipped;
+        vertex_calls += local_vertex;
+        edge_calls += local_edge;
+        edge_iters += local_iters;
+    });
     nCalls = calls;
-    // std::cout << "\n " << nCalls << " dropCutter() calls.\n";
-    return;
+    nSkipped = skipped;
+    nVertexCalls = vertex_calls;
+    nEdgeCalls = edge_calls;
+    nEdgeIterations = edge_iters;
 }
 
-void BatchDropCutter::dropCutter6()
+void BatchDropCutter::runCutters(const std::vector<const MillingCutter*>& cutters)
 {
-    nCalls = 0;
-    std::vector<CLPoint>& clref = *clpoints;
-    unsigned int Nmax = clpoints->size();
-
-    // 使用较大的粒度，减少任务创建的开销
-    size_t grain_size = std::max(
-        size_t(100),
-        Nmax
-            / (4
-               * tbb::global_control::active_value(tbb::global_control::max_allowed_parallelism)));
-
-    // 使用combinable来收集每个线程本地的调用计数，避免频繁的原子操作
-    tbb::combinable<int> local_calls([]() {
-        return 0;
-    });
+    inROI([&] { dropCutters(cutters); }, true);
+}
 
-    // 使用单层并行和auto_partitioner自动调整工作分配
-    tbb::parallel_for(
-        tbb::blocked_range<size_t>(0, Nmax, grain_size),
-        [&](const tbb::blocked_range<size_t>& range) {
-            int thread_local_calls = 0;
-            std::list<Triangle>::iterator it;
+void BatchDropCutter::dropCutters(const std::vector<const MillingCutter*>& cutters)
+{
+    nCalls = 0;
+    nSkipped = 0;
+    columns.assign(cutters.size(), *clpoints);
+    if (cutters.empty())
+        return;
 
-            // 处理当前线程分配到的点
-            for (size_t n = range.begin(); n != range.end(); ++n) {
-                std::list<Triangle>* tris = root->search_cutter_overlap(cutter, &clref[n]);
-                assert(tris);
+    // one search box that covers the footprint of every cutter
+    double r = 0.0;
+    double len = 0.0;
+    BOOST_FOREACH (const MillingCutter* c, cutters) {
+        r = std::max(r, c->getRadius());
+        len = std::max(len, c->getLength());
+    }
 
-                // 直接处理所有三角形，不进行二次并行
-                for (it = tris->begin(); it != tris->end(); ++it) {
-                    if (cutter->overlaps(clref[n], *it)) {
-                        if (clref[n].below(*it)) {
-                            cutter->dropCutter(clref[n], *it);
-                            ++thread_local_calls;
+    const IndexedMesh& mesh = surf->mesh;
+    std::atomic<int> calls(0);
+    std::atomic<int> skipped(0);
+    executor.parallel_for(clpoints->size(), [&](size_t begin, size_t end) {
+        int local_calls = 0;
+        int local_skipped = 0;
+        std::vector<std::uint32_t> faces;
+        Triangle t;
+        for (size_t n = begin; n != end; ++n) {
+            const CLPoint& p = (*clpoints)[n];
+            Bbox bb(p.x - r, p.x + r, p.y - r, p.y + r, p.z, p.z + len);
+            root->search(bb, faces);
+            // each cutter runs its kernels on the shared candidate list, in
+            // the same order for every cutter
+            BOOST_FOREACH (std::uint32_t f, faces) {
+                mesh.triangle(f, t);
+                for (size_t k = 0; k < cutters.size(); ++k) {
+                    CLPoint& cl = columns[k][n];
+                    if (cutters[k]->overlaps(cl, t) && cl.below(t)) {
+                        if (!cutters[k]->overlapsDisc(cl, t)) {
+                            ++local_skipped;
+                            continue;
                         }
+                        cutters[k]->dropCutter(cl, t);
+                        ++local_calls;
                     }
                 }
-
-                delete tris;
             }
-
-            // 更新线程本地计数
-            local_calls.local() += thread_local_calls;
-        },
-        tbb::auto_partitioner());  // 使用auto_partitioner而不是固定粒度
-
-    // 合并所有线程的结果
-    nCalls = local_calls.combine([](int x, int y) {
-        return x + y;
+        }
+        calls += local_calls;
+        skipped += local_skipped;
     });
-    return;
+    nCalls = calls;
+    nSkipped = skipped;
 }
 
 }  // namespace ocl
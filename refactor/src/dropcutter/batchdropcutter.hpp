@@ -22,6 +22,8 @@
 #ifndef BDC_H
 #define BDC_H
 
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -30,6 +32,7 @@
 #include "common/kdtree.hpp"
 #include "cutters/millingcutter.hpp"
 #include "geo/clpoint.hpp"
+#include "geo/meshtopology.hpp"
 
 namespace ocl
 {
@@ -43,7 +46,7 @@ class Triangle;
 /// To find triangles overlapping the cutter a kd-tree data structure is used.
 /// The list of CLPoint's will be updated with the correct z-height as well
 /// as corresponding CCPoint's
-/// Some versions of this algorithm use OpenMP for multi-threading.
+/// The parallel version runs on the Executor of the Operation.
 class OCL_API BatchDropCutter: public Operation
 {
 public:
@@ -51,9 +54,15 @@ public:
     virtual ~BatchDropCutter();
     /// set the STL-surface and build kd-tree to enable optimized algorithm
     void setSTL(const STLSurf& s);
+    /// order the kd-tree candidates by descending triangle max-z
+    void setSortByMaxZ(bool s) override
+    {
+        root->setSortByMaxZ(s);
+    }
     /// append to list of CL-points to evaluate
     void appendPoint(CLPoint& p);
-    /// run drop-cutter on all clpoints
+    /// \brief run drop-cutter on all clpoints. With a region of interest
+    /// (setROI()) the CL-points outside it are left as they are.
     void run() override;
     // getters and setters
     /// return a vector of CLPoints, the result of this operation
@@ -65,6 +74,49 @@ public:
     void clearCLPoints()
     {
         clpoints->clear();
+        columns.clear();
+    }
+    /// \brief drop several cutters at the same CL-points.
+    /// The kd-tree is searched once per CL-point with a footprint that covers
+    /// all cutters, and each cutter's kernels then run on the shared candidate
+    /// list. CL-points are shared between threads by the Executor. The result
+    /// for cutters[k] is returned by getCLPoints(k), the CL-points appended
+    /// with appendPoint() are left unchanged. CL-points outside the region of
+    /// interest are copied to every column as they are.
+    void runCutters(const std::vector<const MillingCutter*>& cutters);
+    /// \brief CL-points with more candidate triangles than this are dropped by
+    /// several tasks in dropCutter4(), each taking a slice of the candidates
+    void setSplitThreshold(unsigned int n)
+    {
+        splitThreshold = n;
+    }
+    /// \brief let run() use dropCutter5(), which tests every vertex and edge
+    /// shared by several candidate triangles once per CL-point. Weld the
+    /// surface first with STLSurf::weld(), otherwise nothing is shared.
+    void setUniqueElements(bool u)
+    {
+        uniqueElements = u;
+    }
+    /// number of single-vertex drops made by the last dropCutter5()
+    int getVertexCalls() const
+    {
+        return nVertexCalls;
+    }
+    /// number of single-edge drops made by the last dropCutter5()
+    int getEdgeCalls() const
+    {
+        return nEdgeCalls;
+    }
+    /// edge-solver iterations of the last dropCutter5(), see MillingCutter::edgeDrops()
+    int getEdgeIterations() const
+    {
+        return nEdgeIterations;
+    }
+    /// return the CL-points of cutter k from the last runCutters()
+    std::vector<CLPoint> getCLPoints(unsigned int k) const
+    {
+        assert(k < columns.size());
+        return columns[k];
     }
 
 protected:
@@ -74,15 +126,41 @@ protected:
     void dropCutter2();
     /// kd-tree and explicit overlap test
     void dropCutter3();
-    /// use OpenMP for multi-threading
+    /// kd-tree, exact overlap test, CL-points shared between threads by the
+    /// Executor. Points with many candidates are split with dropCutterSplit()
     void dropCutter4();
-    /// version 5 of the algorithm
+    /// drop cl against a large candidate list split across tasks. Each task
+    /// lifts its own copy of cl, the highest copy wins, ties going to the
+    /// first in candidate order, so the result equals a sequential drop.
+    void dropCutterSplit(CLPoint& cl, const std::vector<std::uint32_t>& faces, int& calls,
+                         int& skipped) const;
+    /// kd-tree of mesh faces, facet-drop against each candidate face, then
+    /// vertex- and edge-drop once against each vertex and edge of the
+    /// candidates, found through the mesh index and the MeshTopology
     void dropCutter5();
-    /// version 6 of the algorithm (force with tbb)
-    void dropCutter6();
+    /// body of runCutters(), on all clpoints
+    void dropCutters(const std::vector<const MillingCutter*>& cutters);
+    /// \brief call drop with clpoints holding only the CL-points inside the
+    /// region of interest, then put the results back in place: into
+    /// clpoints, or into columns if cutterColumns is true
+    void inROI(const std::function<void()>& drop, bool cutterColumns);
+    /// build topology for the surface
+    void buildTopology();
     // DATA
     /// pointer to list of CL-points on which to run drop-cutter.
     std::vector<CLPoint>* clpoints;
+    /// one column of CL-points per cutter, the result of runCutters()
+    std::vector<std::vector<CLPoint>> columns;
+    /// candidate count above which dropCutter4() splits a CL-point
+    unsigned int splitThreshold;
+    /// run() uses dropCutter5()
+    bool uniqueElements;
+    /// unique edges and adjacency of the surface mesh, for dropCutter5()
+    MeshTopology* topology;
+    /// vertex- and edge-drops, and edge-solver iterations, of the last dropCutter5()
+    int nVertexCalls;
+    int nEdgeCalls;
+    int nEdgeIterations;
 };
 
 }  // namespace ocl
@@ -0,0 +1,223 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+#include "common/mappedfile.hpp"
+#include "dropcutterpipeline.hpp"
+#include "geo/stlreader.hpp"
+#include "pathdropcutter.hpp"
+
+namespace ocl
+{
+
+DropCutterPipeline::DropCutterPipeline()
+{
+    blockFaces = 1 << 16;
+    loadedFaces = 0;
+    loadTime = 0.0;
+    indexTime = 0.0;
+    pointTime = 0.0;
+    totalTime = 0.0;
+    given = 0;
+    generated = false;
+}
+
+DropCutterPipeline::~DropCutterPipeline()
+{
+    try {
+        wait();
+    } catch (const std::exception& e) {
+        spdlog::error("DropCutterPipeline: {}", e.what());
+    }
+}
+
+void DropCutterPipeline::setPath(const Path* p, double sampling, double z)
+{
+    assert(sampling > 0.0);
+    source = [this, p, sampling, z](std::vector<CLPoint>& out) {
+        const std::size_t first = out.size();
+        PathDropCutter::samplePath(*p, sampling, z, out);
+        if (!roi.empty())
+            out.erase(std::remove_if(out.begin() + first, out.end(),
+                                     [this](const CLPoint& q) { return !roi.contains(q); }),
+                      out.end());
+    };
+}
+
+void DropCutterPipeline::setRaster(double xmin, double xmax, double ymin, double ymax, double step,
+                                   double z)
+{
+    assert(step > 0.0);
+    source = [=](std::vector<CLPoint>& out) {
+        const int nx = static_cast<int>((xmax - xmin) / step + 1e-9) + 1;
+        const int ny = static_cast<int>((ymax - ymin) / step + 1e-9) + 1;
+        // only the rows and columns that cross the region of interest
+        int i0 = 0;
+        int i1 = nx - 1;
+        int j0 = 0;
+        int j1 = ny - 1;
+        if (!roi.empty()) {
+            const Bbox b = roi.bounds(0.0);
+            i0 = std::max(i0, static_cast<int>(std::ceil((b.minpt.x - xmin) / step - 1e-9)));
+            i1 = std::min(i1, static_cast<int>(std::floor((b.maxpt.x - xmin) / step + 1e-9)));
+            j0 = std::max(j0, static_cast<int>(std::ceil((b.minpt.y - ymin) / step - 1e-9)));
+            j1 = std::min(j1, static_cast<int>(std::floor((b.maxpt.y - ymin) / step + 1e-9)));
+        }
+        if (i0 > i1 || j0 > j1)
+            return;
+        out.reserve(out.size() + static_cast<std::size_t>(i1 - i0 + 1) * (j1 - j0 + 1));
+        for (int j = j0; j <= j1; ++j) {
+            const double y = ymin + j * step;
+            for (int i = i0; i <= i1; ++i) {
+                // every other line runs backwards
+                const int k = (j % 2) ? i1 + i0 - i : i;
+                const CLPoint p(xmin + k * step, y, z);
+                if (roi.empty() || roi.contains(p))
+                    out.push_back(p);
+            }
+        }
+    };
+}
+
+void DropCutterPipeline::clearCLPoints()
+{
+    BatchDropCutter::clearCLPoints();
+    given = 0;
+    generated = false;
+}
+
+void DropCutterPipeline::start()
+{
+    assert(cutter);
+    wait();
+    // the points generated by the previous start() are replaced
+    if (generated)
+        clpoints->resize(given);
+    given = clpoints->size();
+    generated = true;
+
+    loaded = STLSurf();
+    loadedFaces = 0;
+    {
+        std::lock_guard<std::mutex> lock(boundsMutex);
+        bounds.clear();
+    }
+    loadTime = 0.0;
+    indexTime = 0.0;
+    pointTime = 0.0;
+    totalTime = 0.0;
+    loadedPromise = std::promise<void>();
+    loadedFuture = loadedPromise.get_future().share();
+
+    const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    auto since = [t0] {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    };
+    points = std::async(std::launch::async, [this, since] {
+        std::vector<CLPoint> p;
+        if (source)
+            source(p);
+        pointTime = since();
+        return p;
+    });
+    done = std::async(std::launch::async, [this, since] {
+        try {
+            load();
+        } catch (...) {
+            loadedPromise.set_exception(std::current_exception());
+            points.wait();
+            throw;
+        }
+        loadedPromise.set_value();
+        loadTime = since();
+        if (loaded.size())
+            setSTL(loaded);
+        indexTime = since();
+        std::vector<CLPoint> p = points.get();
+        clpoints->insert(clpoints->end(), p.begin(), p.end());
+        if (loaded.size())
+            BatchDropCutter::run();
+        else
+            spdlog::warn("DropCutterPipeline: no triangles, the CL-points are not dropped");
+        totalTime = since();
+    });
+}
+
+void DropCutterPipeline::wait()
+{
+    if (done.valid())
+        done.get();
+}
+
+void DropCutterPipeline::run()
+{
+    start();
+    wait();
+}
+
+bool DropCutterPipeline::isLoaded() const
+{
+    return loadedFuture.valid() &&
+           loadedFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+const STLSurf& DropCutterPipeline::getSurface()
+{
+    if (loadedFuture.valid())
+        loadedFuture.get();
+    return loaded;
+}
+
+Bbox DropCutterPipeline::getBounds() const
+{
+    std::lock_guard<std::mutex> lock(boundsMutex);
+    return bounds;
+}
+
+void DropCutterPipeline::load()
+{
+    if (file.empty())
+        return;
+    bool ok = STLReader::read_blocks(file, blockFaces, [this](STLSurf& block) {
+        if (loaded.size())
+            loaded.append(block);
+        else
+            loaded = std::move(block);
+        {
+            std::lock_guard<std::mutex> lock(boundsMutex);
+            bounds.addPoint(loaded.bb.minpt);
+            bounds.addPoint(loaded.bb.maxpt);
+        }
+        loadedFaces = loaded.size();
+    });
+    if (!ok)
+        spdlog::warn("DropCutterPipeline: can not read {}", narrowPath(file));
+}
+
+}  // namespace ocl
@@ -0,0 +1,156 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DROPCUTTER_PIPELINE_H
+#define DROPCUTTER_PIPELINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "batchdropcutter.hpp"
+#include "geo/bbox.hpp"
+#include "geo/path.hpp"
+#include "geo/stlsurf.hpp"
+
+namespace ocl
+{
+
+/// \brief BatchDropCutter that loads its surface from an STL file, with the
+/// stages overlapped.
+///
+/// start() runs two tasks and returns at once. The first reads the file in
+/// blocks, keeping running bounds and face counts, then builds the kd-tree.
+/// The second generates the CL-points (from a Path, a raster, or any
+/// function) while the file is read and indexed. The drop itself starts as
+/// soon as both are done. run() is start() followed by wait(), and the
+/// results equal those of a BatchDropCutter on the same surface and points.
+class OCL_API DropCutterPipeline: public BatchDropCutter
+{
+public:
+    DropCutterPipeline();
+    /// waits for a started pipeline
+    virtual ~DropCutterPipeline();
+    /// read the surface from this STL file
+    void setSTLFile(const std::wstring& path)
+    {
+        file = path;
+    }
+    /// number of triangles the loader passes on at a time
+    void setBlockFaces(std::size_t n)
+    {
+        blockFaces = n;
+    }
+    /// \brief generate the CL-points with f, concurrently with loading.
+    /// The points f appends follow those given to appendPoint().
+    void setPointSource(const std::function<void(std::vector<CLPoint>&)>& f)
+    {
+        source = f;
+    }
+    /// generate the CL-points along p like PathDropCutter, at height z.
+    /// p must stay valid until the pipeline is done. Points outside the
+    /// region of interest are not generated.
+    void setPath(const Path* p, double sampling, double z);
+    /// \brief generate a zigzag raster of CL-points at height z, step apart,
+    /// on lines of constant y from ymin to ymax that run from xmin to xmax.
+    /// Only the points inside the region of interest are generated.
+    void setRaster(double xmin, double xmax, double ymin, double ymax, double step, double z);
+    /// clear the CL-points, given and generated
+    void clearCLPoints();
+    /// start loading, indexing and point generation, and return
+    void start();
+    /// wait until the CL-points are dropped. Rethrows an exception of a stage.
+    void wait();
+    /// load, index, generate and drop
+    void run() override;
+    /// true once the file is read
+    bool isLoaded() const;
+    /// wait until the file is read and return the surface
+    const STLSurf& getSurface();
+    /// number of triangles read so far
+    std::size_t getLoadedFaces() const
+    {
+        return loadedFaces;
+    }
+    /// bounding-box of the triangles read so far
+    Bbox getBounds() const;
+    /// seconds from start() until the file was read
+    double getLoadTime() const
+    {
+        return loadTime;
+    }
+    /// seconds from start() until the kd-tree was built
+    double getIndexTime() const
+    {
+        return indexTime;
+    }
+    /// seconds from start() until the CL-points were generated
+    double getPointTime() const
+    {
+        return pointTime;
+    }
+    /// seconds from start() until the CL-points were dropped
+    double getTotalTime() const
+    {
+        return totalTime;
+    }
+
+protected:
+    /// read the file block by block into loaded
+    void load();
+    // DATA
+    /// the STL file
+    std::wstring file;
+    /// triangles per block
+    std::size_t blockFaces;
+    /// generates the CL-points
+    std::function<void(std::vector<CLPoint>&)> source;
+    /// the surface read from file
+    STLSurf loaded;
+    /// set when the file is read
+    std::promise<void> loadedPromise;
+    std::shared_future<void> loadedFuture;
+    /// the CL-points of source
+    std::future<std::vector<CLPoint>> points;
+    /// the load, index and drop task
+    std::future<void> done;
+    /// triangles read so far and their bounds
+    std::atomic<std::size_t> loadedFaces;
+    mutable std::mutex boundsMutex;
+    Bbox bounds;
+    // stage times, in seconds since start()
+    double loadTime;
+    double indexTime;
+    double pointTime;
+    double totalTime;
+    /// number of CL-points given with appendPoint(), ahead of the generated
+    std::size_t given;
+    /// true if clpoints holds points generated by start()
+    bool generated;
+};
+
+}  // namespace ocl
+
+#endif
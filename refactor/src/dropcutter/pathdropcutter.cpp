@@ -67,14 +67,29 @@ void PathDropCutter::uniform_sampling_run() {
 // this samples the Span and pushes the corresponding sampled points to bdc
 void PathDropCutter::sample_span(const Span *span) {
   assert(sampling > 0.0);
+  std::vector<CLPoint> points;
+  sampleSpan(span, sampling, minimumZ, points);
+  BOOST_FOREACH (CLPoint &p, points) {
+    if (roi.empty() || roi.contains(p))
+      subOp[0]->appendPoint(p);
+  }
+}
+
+void PathDropCutter::samplePath(const Path &path, double sampling, double z,
+                                std::vector<CLPoint> &out) {
+  assert(sampling > 0.0);
+  BOOST_FOREACH (const Span *span, path.span_list) {
+    sampleSpan(span, sampling, z, out);
+  }
+}
+
+void PathDropCutter::sampleSpan(const Span *span, double sampling, double z,
+                                std::vector<CLPoint> &out) {
   unsigned int num_steps = (unsigned int)(span->length2d() / sampling + 1);
   for (unsigned int i = 0; i <= num_steps; i++) {
     double fraction = (double)i / num_steps;
     Point ptmp = span->getPoint(fraction);
-    CLPoint *p = new CLPoint(ptmp.x, ptmp.y, ptmp.z);
-    p->z = minimumZ;
-    subOp[0]->appendPoint(*p);
-    delete p;
+    out.push_back(CLPoint(ptmp.x, ptmp.y, z));
   }
 }
 
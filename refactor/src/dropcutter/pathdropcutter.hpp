@@ -51,8 +51,13 @@ public:
   /// return Z
   double getZ() const { return minimumZ; }
   std::vector<CLPoint> getPoints() const { return clpoints; }
-  /// run drop-cutter on the whole Path
+  /// \brief run drop-cutter on the whole Path. With a region of interest
+  /// (setROI()) only the CL-points inside it are made.
   virtual void run();
+  /// \brief append CL-points along path to out, at most sampling apart in
+  /// XY, all at height z. These are the points run() drops.
+  static void samplePath(const Path &path, double sampling, double z,
+                         std::vector<CLPoint> &out);
 
 protected:
   /// the path to follow
@@ -68,6 +73,9 @@ private:
   void uniform_sampling_run();
   /// sample the span unfirormly with tolerance sampling
   void sample_span(const Span *span);
+  /// append the CL-points of span to out
+  static void sampleSpan(const Span *span, double sampling, double z,
+                         std::vector<CLPoint> &out);
 };
 
 } // namespace ocl
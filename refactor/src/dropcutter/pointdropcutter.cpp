@@ -21,10 +21,7 @@
 
 #include <boost/foreach.hpp>
 
-#ifdef _OPENMP 
-    #include <omp.h>
-#endif
-
+#include "geo/meshindex.hpp"
 #include "geo/point.hpp"
 #include "geo/triangle.hpp"
 #include "pointdropcutter.hpp"
@@ -37,23 +34,22 @@ namespace ocl
 
 PointDropCutter::PointDropCutter() {
     nCalls = 0;
-#ifdef _OPENMP
-    nthreads = omp_get_num_procs(); // figure out how many cores we have
-#endif
     cutter = NULL;
     bucketSize = 1;
-    root = new KDTree<Triangle>();
+    root = new KDTree<IndexedMesh>();
 }
 
 void PointDropCutter::setSTL(const STLSurf &s) {
     //std::cout << "PointDropCutter::setSTL()\n";
-    surf = &s;
+    surf = &cullROI(s);
     root->setXYDimensions(); // we search for triangles in the XY plane, don't care about Z-coordinate
     root->setBucketSize( bucketSize );
-    root->build(s.tris);
+    MeshIndex::buildTree(*root, *surf);
 }
 
 void PointDropCutter::run(CLPoint& clp) {
+    if (!roi.empty() && !roi.contains(clp))
+        return; // outside the region of interest
     //std::cout << "PointDropCutter::run() clp= " << clp << " dropped to ";
     pointDropCutter1(clp);
     //std::cout  << clp << " nCalls = " << nCalls <<"\n ";
@@ -63,20 +59,25 @@ void PointDropCutter::run(CLPoint& clp) {
 void PointDropCutter::pointDropCutter1(CLPoint& clp) {
     nCalls = 0;
     int calls=0;
-    std::list<Triangle>* tris;
-    //tris=new std::list<Triangle>();
-    tris = root->search_cutter_overlap( cutter, &clp );
-    std::list<Triangle>::iterator it;
-    for( it=tris->begin(); it!=tris->end() ; ++it) { // loop over found triangles  
-        if ( cutter->overlaps(clp,*it) ) { // cutter overlap triangle? check
-            if (clp.below(*it)) {
-                cutter->dropCutter(clp,*it);
+    int skipped=0;
+    std::vector<std::uint32_t> faces;
+    root->search_cutter_overlap( cutter, &clp, faces );
+    Triangle t;
+    for (std::uint32_t f : faces) { // loop over found triangles
+        surf->mesh.triangle(f, t);
+        if ( cutter->overlaps(clp,t) ) { // cutter overlap triangle? check
+            if (clp.below(t)) {
+                if ( !cutter->overlapsDisc(clp,t) ) { // exact test, cheaper than the drop
+                    ++skipped;
+                    continue;
+                }
+                cutter->dropCutter(clp,t);
                 ++calls;
             }
         }
     }
-    delete( tris );
     nCalls = calls;
+    nSkipped = skipped;
     return;
 }
 
@@ -44,6 +44,9 @@ public:
     delete root;
   }
   void setSTL(const STLSurf &s);
+  /// order the kd-tree candidates by descending triangle max-z
+  void setSortByMaxZ(bool s) override { root->setSortByMaxZ(s); }
+  /// drop cl, unless it is outside the region of interest
   void run(CLPoint &cl);
   void run() {
     std::cout << "ERROR: can't call run() on PointDropCutter()\n";
@@ -0,0 +1,228 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <list>
+
+#include <spdlog/spdlog.h>
+
+#include "geo/meshindex.hpp"
+#include "geo/triangle.hpp"
+#include "tileddropcutter.hpp"
+
+namespace ocl
+{
+
+namespace
+{
+// memory of a resident tile per stored triangle: mesh arrays, the face
+// index in a kd-tree bucket, and the stored index with up to two nodes per
+// face
+const std::size_t tileFaceBytes =
+    156 + 2 * sizeof(std::uint32_t) + 2 * sizeof(MeshIndex::Node);
+}  // namespace
+
+TiledDropCutter::TiledDropCutter()
+{
+    tiles = NULL;
+    budget = std::size_t(1) << 30;
+    sortByMaxZ = false;
+    residentBytes = 0;
+    peakBytes = 0;
+    tileLoads = 0;
+}
+
+TiledDropCutter::~TiledDropCutter()
+{
+    resident.clear();
+}
+
+void TiledDropCutter::setTiles(const TiledMesh& t)
+{
+    tiles = &t;
+    bucketSize = t.getBucketSize();
+    resident.clear();
+    residentBytes = 0;
+}
+
+void TiledDropCutter::run()
+{
+    assert(tiles);
+    assert(cutter);
+    nCalls = 0;
+    nSkipped = 0;
+    tileLoads = 0;
+    peakBytes = residentBytes;
+    const double r = cutter->getRadius();
+    std::vector<CLPoint>& clref = *clpoints;
+
+    // group the CL-points by the tile they lie in, leaving out those outside
+    // the region of interest
+    std::vector<std::vector<std::size_t>> groups(tiles->tileCount());
+    for (std::size_t n = 0; n < clref.size(); ++n) {
+        if (!roi.empty() && !roi.contains(clref[n]))
+            continue;
+        groups[tiles->tile(tiles->column(clref[n].x), tiles->row(clref[n].y))].push_back(n);
+    }
+
+    // visit the tiles row by row, every other row backwards, so that
+    // consecutive groups share most of their halo tiles
+    std::size_t step = 0;
+    bool warned = false;
+    for (int j = 0; j < tiles->tilesY(); ++j) {
+        for (int c = 0; c < tiles->tilesX(); ++c) {
+            const int i = (j % 2) ? tiles->tilesX() - 1 - c : c;
+            const std::vector<std::size_t>& group = groups[tiles->tile(i, j)];
+            if (group.empty())
+                continue;
+            // the tiles under the cutter at any point of the group
+            double xmin = clref[group[0]].x, xmax = xmin;
+            double ymin = clref[group[0]].y, ymax = ymin;
+            for (std::size_t n : group) {
+                xmin = std::min(xmin, clref[n].x);
+                xmax = std::max(xmax, clref[n].x);
+                ymin = std::min(ymin, clref[n].y);
+                ymax = std::max(ymax, clref[n].y);
+            }
+            if (!loadTiles(tiles->column(xmin - r), tiles->column(xmax + r), tiles->row(ymin - r),
+                           tiles->row(ymax + r), ++step)) {
+                spdlog::error("TiledDropCutter: a tile can not be loaded, CL-points are not dropped");
+                return;
+            }
+            if (residentBytes > budget && !warned) {
+                spdlog::warn("TiledDropCutter: the tiles around one tile take {} bytes, more than "
+                             "the budget of {}; use smaller tiles",
+                             residentBytes, budget);
+                warned = true;
+            }
+            int calls = 0;
+            int skipped = 0;
+            dropPoints(group, calls, skipped);
+            nCalls += calls;
+            nSkipped += skipped;
+        }
+    }
+}
+
+bool TiledDropCutter::loadTiles(int i0, int i1, int j0, int j1, std::size_t step)
+{
+    for (int j = j0; j <= j1; ++j) {
+        for (int i = i0; i <= i1; ++i) {
+            const std::size_t k = tiles->tile(i, j);
+            if (tiles->faceCount(k) == 0)
+                continue;
+            auto it = resident.find(k);
+            if (it != resident.end()) {
+                it->second->lastUse = step;
+                continue;
+            }
+            // evict the least recently used tiles not needed now
+            const std::size_t need = tiles->faceCount(k) * tileFaceBytes;
+            while (residentBytes + need > budget) {
+                auto lru = resident.end();
+                for (auto t = resident.begin(); t != resident.end(); ++t) {
+                    if (t->second->lastUse < step
+                        && (lru == resident.end() || t->second->lastUse < lru->second->lastUse))
+                        lru = t;
+                }
+                if (lru == resident.end())
+                    break;
+                residentBytes -= lru->second->bytes;
+                resident.erase(lru);
+            }
+
+            std::unique_ptr<Resident> res(new Resident());
+            if (!tiles->loadTile(k, res->surf))
+                return false;
+            res->tree.setXYDimensions();
+            res->tree.setBucketSize(bucketSize);
+            res->tree.setSortByMaxZ(sortByMaxZ);
+            MeshIndex::buildTree(res->tree, res->surf);
+            res->bytes = res->surf.mesh.memoryUsage()
+                         + res->surf.size() * sizeof(std::uint32_t);
+            for (const auto& index : res->surf.indexes)
+                res->bytes += index->nodes.size() * sizeof(MeshIndex::Node)
+                              + index->faces.size() * sizeof(std::uint32_t);
+            res->lastUse = step;
+            residentBytes += res->bytes;
+            peakBytes = std::max(peakBytes, residentBytes);
+            ++tileLoads;
+            resident[k] = std::move(res);
+        }
+    }
+    return true;
+}
+
+void TiledDropCutter::dropPoints(const std::vector<std::size_t>& points, int& calls,
+                                 int& skipped) const
+{
+    std::vector<CLPoint>& clref = *clpoints;
+    const double r = cutter->getRadius();
+    std::atomic<int> all_calls(0);
+    std::atomic<int> all_skipped(0);
+    executor.parallel_for(points.size(), [&](size_t begin, size_t end) {
+        int local_calls = 0;
+        int local_skipped = 0;
+        std::vector<std::uint32_t> faces;
+        Triangle t;
+        for (size_t n = begin; n != end; ++n) {
+            CLPoint& cl = clref[points[n]];
+            const int i0 = tiles->column(cl.x - r);
+            const int i1 = tiles->column(cl.x + r);
+            const int j0 = tiles->row(cl.y - r);
+            const int j1 = tiles->row(cl.y + r);
+            for (int j = j0; j <= j1; ++j) {
+                for (int i = i0; i <= i1; ++i) {
+                    auto it = resident.find(tiles->tile(i, j));
+                    if (it == resident.end())
+                        continue;  // an empty tile
+                    const IndexedMesh& mesh = it->second->surf.mesh;
+                    it->second->tree.search_cutter_overlap(cutter, &cl, faces);
+                    for (std::uint32_t f : faces) {
+                        // a triangle is stored in every tile it overlaps; test
+                        // it only from the first of them under the cutter
+                        if (std::max(tiles->column(mesh.bound(f, 0)), i0) != i
+                            || std::max(tiles->row(mesh.bound(f, 2)), j0) != j)
+                            continue;
+                        mesh.triangle(f, t);
+                        if (cutter->overlaps(cl, t) && cl.below(t)) {
+                            if (!cutter->overlapsDisc(cl, t)) {
+                                ++local_skipped;
+                                continue;
+                            }
+                            cutter->dropCutter(cl, t);
+                            ++local_calls;
+                        }
+                    }
+                }
+            }
+        }
+        all_calls += local_calls;
+        all_skipped += local_skipped;
+    });
+    calls = all_calls;
+    skipped = all_skipped;
+}
+
+}  // namespace ocl
+// end file tileddropcutter.cpp
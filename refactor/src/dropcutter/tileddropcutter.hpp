@@ -0,0 +1,112 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TILED_DROPCUTTER_H
+#define TILED_DROPCUTTER_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "batchdropcutter.hpp"
+#include "common/kdtree.hpp"
+#include "geo/stlsurf.hpp"
+#include "geo/tiledmesh.hpp"
+
+namespace ocl
+{
+
+/// \brief BatchDropCutter on a TiledMesh, for surfaces larger than memory.
+///
+/// The CL-points are grouped by the tile they lie in, and the groups are
+/// dropped tile by tile. For each group the tiles within the cutter radius
+/// (the halo) are made resident: loaded from disk with their kd-tree restored
+/// from the stored index. Resident tiles are kept in an LRU and evicted when
+/// their memory exceeds the budget. A triangle stored in several tiles is
+/// only tested from one of them, so calls and results equal those of a
+/// BatchDropCutter on the whole surface.
+class OCL_API TiledDropCutter: public BatchDropCutter
+{
+public:
+    TiledDropCutter();
+    virtual ~TiledDropCutter();
+    /// drop against the tiles of t, which must stay open while this runs
+    void setTiles(const TiledMesh& t);
+    /// memory, in bytes, the resident tiles may take
+    void setMemoryBudget(std::size_t bytes)
+    {
+        budget = bytes;
+    }
+    /// order the kd-tree candidates of each tile by descending max-z
+    void setSortByMaxZ(bool s) override
+    {
+        BatchDropCutter::setSortByMaxZ(s);
+        sortByMaxZ = s;
+    }
+    /// \brief run drop-cutter on all clpoints, tile by tile. With a region of
+    /// interest (setROI()) the CL-points outside it are left as they are, and
+    /// only the tiles near the region are loaded.
+    void run() override;
+    /// number of tiles loaded from disk by the last run()
+    std::size_t getTileLoads() const
+    {
+        return tileLoads;
+    }
+    /// largest memory of the resident tiles during the last run(), in bytes
+    std::size_t getPeakResidentBytes() const
+    {
+        return peakBytes;
+    }
+
+protected:
+    /// a tile in memory
+    struct Resident {
+        STLSurf surf;
+        KDTree<IndexedMesh> tree;
+        /// estimated memory of surf and tree
+        std::size_t bytes;
+        /// run() step at which the tile was last needed
+        std::size_t lastUse;
+    };
+    /// make the tiles in columns i0..i1 and rows j0..j1 resident, evicting
+    /// the least recently used other tiles while over budget
+    bool loadTiles(int i0, int i1, int j0, int j1, std::size_t step);
+    /// drop the CL-points with indices in points against the resident tiles
+    void dropPoints(const std::vector<std::size_t>& points, int& calls, int& skipped) const;
+    // DATA
+    /// the tiled surface
+    const TiledMesh* tiles;
+    /// memory budget of the resident tiles
+    std::size_t budget;
+    /// sort the candidates of the tile kd-trees by max-z
+    bool sortByMaxZ;
+    /// resident tiles by tile index
+    std::map<std::size_t, std::unique_ptr<Resident>> resident;
+    /// memory of the resident tiles
+    std::size_t residentBytes;
+    std::size_t peakBytes;
+    std::size_t tileLoads;
+};
+
+}  // namespace ocl
+
+#endif
@@ -57,7 +57,7 @@ CLPoint::CLPoint(const Point& p)
 }
 
 CLPoint::~CLPoint() {
-   delete cc.load();
+   delete cc;
 }
 
 bool CLPoint::below(const Triangle& t) const {
@@ -79,19 +79,7 @@ bool CLPoint::liftZ(const double zin) {
 bool CLPoint::liftZ(double zin, CCPoint& ccp) {
     if (zin>z) {
         z=zin;
-        auto newCC = new CCPoint(ccp);
-        auto prevCC = cc.load();
-        auto expected = prevCC;
-        // Protect against race between concurrent liftZ calls in multiple
-        // threads
-        cc.compare_exchange_strong(expected, newCC);
-        if (prevCC == expected) {
-            // Successfully replaced cc, go ahead & delete prevCC
-            delete prevCC;
-        } else {
-            // Another thread won the race, back off.
-            delete newCC;
-        }
+        *cc = ccp;
         return true;
     } else {
         return false;
@@ -116,10 +104,7 @@ CLPoint& CLPoint::operator=(const CLPoint &clp) {
     x=clp.x;
     y=clp.y;
     z=clp.z;
-    if (cc) {
-        delete cc.load();
-    }
-    cc= new CCPoint( *(clp.cc) );
+    *cc = *(clp.cc);
     return *this;
 }
 
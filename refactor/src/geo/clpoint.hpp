@@ -21,7 +21,6 @@
 #ifndef CLPOINT_H
 #define CLPOINT_H
 
-#include <atomic>
 #include <iostream>
 #include <string>
 
@@ -47,9 +46,10 @@ public:
   /// cl-point at Point p
   CLPoint(const Point &p);
   virtual ~CLPoint();
-  /// Atomic pointer to the corresponding CCPoint, protected against
-  /// concurrent replacement in liftZ.
-  std::atomic<CCPoint *> cc;
+  /// the corresponding CCPoint, owned by this CLPoint. A CLPoint is lifted by
+  /// one thread at a time; BatchDropCutter gives each task its own copy when
+  /// it splits the triangles of one CL-point.
+  CCPoint *cc;
   /// string repr
   std::string str() const;
 
@@ -0,0 +1,425 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INDEXEDMESH_H
+#define INDEXEDMESH_H
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "bbox.hpp"
+#include "point.hpp"
+#include "triangle.hpp"
+
+namespace ocl {
+
+/// \brief triangle mesh in contiguous arrays: a shared vertex buffer and a
+/// uint32 index buffer.
+///
+/// Vertices are stored as x,y,z triples of Real (float or double) and each
+/// face as three indices into them. The unit normal and the bounding-box of
+/// every face are precomputed when the face is added and kept in one array
+/// per component (structure of arrays), so loops over faces read memory
+/// sequentially. A face takes 12 bytes of indices plus 9 Reals of normal and
+/// bounds, against about 230 bytes for a Triangle in a std::list.
+///
+/// triangle() returns the face as a Triangle with the same vertices, normal
+/// and Bbox that the Triangle constructor computes, so all cutter kernels
+/// work unchanged on a mesh. The normal and Bbox are copied from the arrays,
+/// not computed again.
+template <class Real> class BasicIndexedMesh {
+public:
+  typedef Real real_type;
+
+  /// number of faces
+  std::size_t size() const { return idx.size() / 3; }
+  bool empty() const { return idx.empty(); }
+  /// number of vertices
+  std::size_t vertexCount() const { return xyz.size() / 3; }
+  /// reserve room for nv vertices and nf faces
+  void reserve(std::size_t nv, std::size_t nf) {
+    xyz.reserve(3 * nv);
+    idx.reserve(3 * nf);
+    for (int k = 0; k < 3; ++k)
+      nrm[k].reserve(nf);
+    for (int k = 0; k < 6; ++k)
+      bnd[k].reserve(nf);
+  }
+  /// \brief set the number of vertices and faces to nv and nf.
+  /// New vertices and faces must be filled in with setVertex() and setFace()
+  /// before they are used. Different vertices and faces may be set from
+  /// different threads.
+  void resize(std::size_t nv, std::size_t nf) {
+    assert(nv <= std::numeric_limits<std::uint32_t>::max());
+    xyz.resize(3 * nv);
+    idx.resize(3 * nf);
+    for (int k = 0; k < 3; ++k)
+      nrm[k].resize(nf);
+    for (int k = 0; k < 6; ++k)
+      bnd[k].resize(nf);
+  }
+  /// remove all vertices and faces
+  void clear() {
+    xyz.clear();
+    idx.clear();
+    for (int k = 0; k < 3; ++k)
+      nrm[k].clear();
+    for (int k = 0; k < 6; ++k)
+      bnd[k].clear();
+  }
+
+  /// append vertex p and return its index
+  std::uint32_t addVertex(const Point &p) {
+    assert(vertexCount() < std::numeric_limits<std::uint32_t>::max());
+    xyz.push_back(static_cast<Real>(p.x));
+    xyz.push_back(static_cast<Real>(p.y));
+    xyz.push_back(static_cast<Real>(p.z));
+    return static_cast<std::uint32_t>(vertexCount() - 1);
+  }
+  /// append the face with vertices a, b, c and return its index
+  std::uint32_t addFace(std::uint32_t a, std::uint32_t b, std::uint32_t c) {
+    assert(a < vertexCount() && b < vertexCount() && c < vertexCount());
+    idx.push_back(a);
+    idx.push_back(b);
+    idx.push_back(c);
+    for (int k = 0; k < 3; ++k)
+      nrm[k].push_back(0);
+    for (int k = 0; k < 6; ++k)
+      bnd[k].push_back(0);
+    const std::size_t f = size() - 1;
+    calcFace(f);
+    return static_cast<std::uint32_t>(f);
+  }
+  /// move vertex v to p. The faces using v are not updated, call setFace()
+  /// on them or updateFaces() afterwards.
+  void setVertex(std::uint32_t v, const Point &p) {
+    xyz[3 * v] = static_cast<Real>(p.x);
+    xyz[3 * v + 1] = static_cast<Real>(p.y);
+    xyz[3 * v + 2] = static_cast<Real>(p.z);
+  }
+  /// make face f use vertices a, b, c and compute its normal and bounds
+  void setFace(std::size_t f, std::uint32_t a, std::uint32_t b,
+               std::uint32_t c) {
+    assert(a < vertexCount() && b < vertexCount() && c < vertexCount());
+    idx[3 * f] = a;
+    idx[3 * f + 1] = b;
+    idx[3 * f + 2] = c;
+    calcFace(f);
+  }
+  /// append the vertices and faces of m, with their normals and bounds
+  void append(const BasicIndexedMesh &m) {
+    assert(vertexCount() + m.vertexCount() <=
+           std::numeric_limits<std::uint32_t>::max());
+    const std::uint32_t v0 = static_cast<std::uint32_t>(vertexCount());
+    xyz.insert(xyz.end(), m.xyz.begin(), m.xyz.end());
+    idx.reserve(idx.size() + m.idx.size());
+    for (std::uint32_t i : m.idx)
+      idx.push_back(v0 + i);
+    for (int k = 0; k < 3; ++k)
+      nrm[k].insert(nrm[k].end(), m.nrm[k].begin(), m.nrm[k].end());
+    for (int k = 0; k < 6; ++k)
+      bnd[k].insert(bnd[k].end(), m.bnd[k].begin(), m.bnd[k].end());
+  }
+  /// append a face with three new vertices p1, p2, p3 and return its index
+  std::uint32_t addTriangle(const Point &p1, const Point &p2, const Point &p3) {
+    const std::uint32_t a = addVertex(p1);
+    const std::uint32_t b = addVertex(p2);
+    const std::uint32_t c = addVertex(p3);
+    return addFace(a, b, c);
+  }
+
+  /// position of vertex v
+  Point vertex(std::uint32_t v) const {
+    return Point(xyz[3 * v], xyz[3 * v + 1], xyz[3 * v + 2]);
+  }
+  /// index of corner k (0, 1 or 2) of face f
+  std::uint32_t index(std::size_t f, int k) const { return idx[3 * f + k]; }
+  /// face f as a Triangle, with the stored normal and bounds
+  Triangle triangle(std::size_t f) const {
+    return Triangle(vertex(index(f, 0)), vertex(index(f, 1)),
+                    vertex(index(f, 2)), normal(f), bounds(f));
+  }
+  /// \brief copy face f into t, reading the vertices, normal and bounds
+  /// from the arrays. A caller looping over faces reuses one Triangle.
+  void triangle(std::size_t f, Triangle &t) const {
+    for (int k = 0; k < 3; ++k)
+      t.p[k] = vertex(index(f, k));
+    t.n = normal(f);
+    t.bb = bounds(f);
+  }
+  /// unit normal of face f, oriented like Triangle::n
+  Point normal(std::size_t f) const {
+    return Point(nrm[0][f], nrm[1][f], nrm[2][f]);
+  }
+  /// bounding-box of face f
+  Bbox bounds(std::size_t f) const {
+    return Bbox(bnd[0][f], bnd[1][f], bnd[2][f], bnd[3][f], bnd[4][f],
+                bnd[5][f]);
+  }
+  /// component dim of the bounding-box of face f, in the order
+  /// [minx maxx miny maxy minz maxz] of Bbox::operator[]
+  Real bound(std::size_t f, unsigned int dim) const { return bnd[dim][f]; }
+
+  /// rotate all vertices like Triangle::rotate and update the face data
+  void rotate(double xr, double yr, double zr) {
+    for (std::uint32_t v = 0; v < vertexCount(); ++v) {
+      Point p = vertex(v);
+      p.xRotate(xr);
+      p.yRotate(yr);
+      p.zRotate(zr);
+      xyz[3 * v] = static_cast<Real>(p.x);
+      xyz[3 * v + 1] = static_cast<Real>(p.y);
+      xyz[3 * v + 2] = static_cast<Real>(p.z);
+    }
+    updateFaces();
+  }
+  /// recompute the normals and bounds of all faces from the vertices
+  void updateFaces() {
+    for (std::size_t f = 0; f < size(); ++f)
+      calcFace(f);
+  }
+
+  /// \brief merge vertices closer than tol to each other.
+  /// Each vertex is merged into the first earlier vertex within tol, found
+  /// through a hash grid with cells of size tol. Faces that lose a corner in
+  /// the merge are removed, the others keep their order. Returns the number
+  /// of vertices removed.
+  std::size_t weld(double tol) {
+    assert(tol > 0.0);
+    const std::size_t nv = vertexCount();
+    std::unordered_map<Cell, std::uint32_t, CellHash> grid; // cell -> first
+    std::vector<std::uint32_t> next;  // next kept vertex in the same cell
+    std::vector<std::uint32_t> remap(nv);
+    std::vector<Real> welded;
+    welded.reserve(xyz.size());
+    const std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+    for (std::uint32_t v = 0; v < nv; ++v) {
+      const Point p = vertex(v);
+      const Cell c = {static_cast<long long>(std::floor(p.x / tol)),
+                      static_cast<long long>(std::floor(p.y / tol)),
+                      static_cast<long long>(std::floor(p.z / tol))};
+      std::uint32_t found = none;
+      for (int dx = -1; dx <= 1 && found == none; ++dx) {
+        for (int dy = -1; dy <= 1 && found == none; ++dy) {
+          for (int dz = -1; dz <= 1 && found == none; ++dz) {
+            const Cell n = {c.x + dx, c.y + dy, c.z + dz};
+            auto it = grid.find(n);
+            for (std::uint32_t w = it == grid.end() ? none : it->second;
+                 w != none; w = next[w]) {
+              const Point q(welded[3 * w], welded[3 * w + 1], welded[3 * w + 2]);
+              if ((p - q).norm() <= tol) {
+                found = w;
+                break;
+              }
+            }
+          }
+        }
+      }
+      if (found == none) {
+        found = static_cast<std::uint32_t>(next.size());
+        auto it = grid.find(c);
+        next.push_back(it == grid.end() ? none : it->second);
+        grid[c] = found;
+        welded.insert(welded.end(), &xyz[3 * v], &xyz[3 * v] + 3);
+      }
+      remap[v] = found;
+    }
+
+    std::vector<std::uint32_t> faces;
+    faces.reserve(idx.size());
+    for (std::size_t f = 0; f < size(); ++f) {
+      const std::uint32_t a = remap[index(f, 0)];
+      const std::uint32_t b = remap[index(f, 1)];
+      const std::uint32_t c = remap[index(f, 2)];
+      if (a != b && b != c && c != a) {
+        faces.push_back(a);
+        faces.push_back(b);
+        faces.push_back(c);
+      }
+    }
+    clear();
+    xyz.swap(welded);
+    xyz.shrink_to_fit();
+    for (std::size_t k = 0; k < faces.size(); k += 3)
+      addFace(faces[k], faces[k + 1], faces[k + 2]);
+    return nv - vertexCount();
+  }
+
+  /// the vertex buffer, x,y,z of each vertex
+  const std::vector<Real> &vertices() const { return xyz; }
+  /// the index buffer, three vertex indices per face
+  const std::vector<std::uint32_t> &indices() const { return idx; }
+  /// component k (0, 1 or 2 for x, y, z) of the normals of all faces
+  const std::vector<Real> &normalComponent(int k) const { return nrm[k]; }
+  /// component dim of the bounds of all faces, see bound()
+  const std::vector<Real> &boundComponent(unsigned int dim) const {
+    return bnd[dim];
+  }
+  /// \brief replace the mesh with nv vertices and nf faces copied from raw
+  /// arrays, laid out like vertices(), indices(), normalComponent() and
+  /// boundComponent(). The face data is taken as is, it must be what the
+  /// mesh computes for these vertices (e.g. saved from a mesh earlier).
+  void assign(const Real *vertices, std::size_t nv,
+              const std::uint32_t *indices, std::size_t nf,
+              const Real *const normals[3], const Real *const bounds[6]) {
+    assert(nv <= std::numeric_limits<std::uint32_t>::max());
+    xyz.assign(vertices, vertices + 3 * nv);
+    idx.assign(indices, indices + 3 * nf);
+    for (int k = 0; k < 3; ++k)
+      nrm[k].assign(normals[k], normals[k] + nf);
+    for (int k = 0; k < 6; ++k)
+      bnd[k].assign(bounds[k], bounds[k] + nf);
+  }
+  /// bytes held by the arrays of the mesh
+  std::size_t memoryUsage() const {
+    std::size_t n = xyz.capacity() * sizeof(Real) +
+                    idx.capacity() * sizeof(std::uint32_t);
+    for (int k = 0; k < 3; ++k)
+      n += nrm[k].capacity() * sizeof(Real);
+    for (int k = 0; k < 6; ++k)
+      n += bnd[k].capacity() * sizeof(Real);
+    return n;
+  }
+
+private:
+  /// a cell of the hash grid used by weld()
+  struct Cell {
+    long long x, y, z;
+    bool operator==(const Cell &o) const {
+      return x == o.x && y == o.y && z == o.z;
+    }
+  };
+  struct CellHash {
+    std::size_t operator()(const Cell &c) const {
+      return static_cast<std::size_t>(c.x * 73856093LL ^ c.y * 19349663LL ^
+                                      c.z * 83492791LL);
+    }
+  };
+
+  /// compute normal and bounds of face f, in the same way as Triangle
+  void calcFace(std::size_t f) {
+    const Point p0 = vertex(index(f, 0));
+    const Point p1 = vertex(index(f, 1));
+    const Point p2 = vertex(index(f, 2));
+    Point n = (p0 - p1).cross(p0 - p2);
+    n.normalize();
+    nrm[0][f] = static_cast<Real>(n.x);
+    nrm[1][f] = static_cast<Real>(n.y);
+    nrm[2][f] = static_cast<Real>(n.z);
+    const Point *p[3] = {&p0, &p1, &p2};
+    for (int k = 0; k < 3; ++k) {
+      const double c[3] = {p[k]->x, p[k]->y, p[k]->z};
+      for (int d = 0; d < 3; ++d) {
+        const Real v = static_cast<Real>(c[d]);
+        if (k == 0 || v < bnd[2 * d][f])
+          bnd[2 * d][f] = v;
+        if (k == 0 || v > bnd[2 * d + 1][f])
+          bnd[2 * d + 1][f] = v;
+      }
+    }
+  }
+
+  /// vertex buffer, x,y,z of each vertex
+  std::vector<Real> xyz;
+  /// index buffer, three vertex indices per face
+  std::vector<std::uint32_t> idx;
+  /// face normals, x, y and z components
+  std::vector<Real> nrm[3];
+  /// face bounds, [minx maxx miny maxy minz maxz]
+  std::vector<Real> bnd[6];
+};
+
+/// mesh with double vertices, the storage of STLSurf
+typedef BasicIndexedMesh<double> IndexedMesh;
+/// mesh with float vertices, half the memory for large scans
+typedef BasicIndexedMesh<float> IndexedMeshF;
+
+/// \brief the faces of a mesh seen as a read-only sequence of Triangle.
+///
+/// Iterating yields each face as a Triangle filled in by Mesh::triangle(),
+/// so code written for a std::list<Triangle> (range-for, BOOST_FOREACH)
+/// works on a mesh without storing Triangles. The iterator keeps one
+/// Triangle and copies the face data into it, nothing is recomputed. The
+/// reference returned by an iterator is valid until it is advanced.
+template <class Mesh> class TriangleView {
+public:
+  class const_iterator {
+  public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef Triangle value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const Triangle *pointer;
+    typedef const Triangle &reference;
+
+    const_iterator() : mesh(nullptr), face(0), cached(false) {}
+    const_iterator(const Mesh *m, std::size_t f)
+        : mesh(m), face(f), cached(false) {}
+    reference operator*() const {
+      if (!cached) {
+        mesh->triangle(face, tri);
+        cached = true;
+      }
+      return tri;
+    }
+    pointer operator->() const { return &**this; }
+    const_iterator &operator++() {
+      ++face;
+      cached = false;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator old(*this);
+      ++*this;
+      return old;
+    }
+    bool operator==(const const_iterator &o) const { return face == o.face; }
+    bool operator!=(const const_iterator &o) const { return face != o.face; }
+
+  private:
+    const Mesh *mesh;
+    std::size_t face;
+    mutable bool cached;
+    mutable Triangle tri;
+  };
+  typedef const_iterator iterator;
+  typedef Triangle value_type;
+  typedef std::size_t size_type;
+
+  explicit TriangleView(Mesh &m) : mesh(&m) {}
+  const_iterator begin() const { return const_iterator(mesh, 0); }
+  const_iterator end() const { return const_iterator(mesh, mesh->size()); }
+  std::size_t size() const { return mesh->size(); }
+  bool empty() const { return mesh->empty(); }
+  /// remove all faces and vertices of the mesh
+  void clear() { mesh->clear(); }
+
+private:
+  Mesh *mesh;
+};
+
+} // namespace ocl
+#endif
+// end file indexedmesh.hpp
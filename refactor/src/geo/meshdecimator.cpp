@@ -0,0 +1,638 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "common/numeric.hpp"
+#include "meshdecimator.hpp"
+#include "meshtopology.hpp"
+#include "point.hpp"
+#include "stlsurf.hpp"
+
+namespace ocl
+{
+
+namespace
+{
+
+typedef std::array<std::uint32_t, 3> Face;
+
+// quadric error of a point: sum of squared distances to planes, stored as
+// the upper triangle of a symmetric 4x4 matrix
+struct Quadric {
+    double q[10] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+    // add the plane n.x + d = 0 with weight w
+    void addPlane(const Point& n, double d, double w)
+    {
+        const double a = n.x, b = n.y, c = n.z;
+        q[0] += w * a * a;
+        q[1] += w * a * b;
+        q[2] += w * a * c;
+        q[3] += w * a * d;
+        q[4] += w * b * b;
+        q[5] += w * b * c;
+        q[6] += w * b * d;
+        q[7] += w * c * c;
+        q[8] += w * c * d;
+        q[9] += w * d * d;
+    }
+    Quadric& operator+=(const Quadric& o)
+    {
+        for (int k = 0; k < 10; ++k)
+            q[k] += o.q[k];
+        return *this;
+    }
+    double error(const Point& p) const
+    {
+        const double x = p.x, y = p.y, z = p.z;
+        return q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x + q[4] * y * y +
+               2 * q[5] * y * z + 2 * q[6] * y + q[7] * z * z + 2 * q[8] * z + q[9];
+    }
+    // the point of least error, false if the quadric is (nearly) singular
+    bool minimum(Point& p) const
+    {
+        const double a = q[0], b = q[1], c = q[2], d = q[4], e = q[5], f = q[7];
+        const double det = a * (d * f - e * e) - b * (b * f - c * e) + c * (b * e - c * d);
+        const double trace = a + d + f;
+        if (!(std::fabs(det) > 1e-9 * trace * trace * trace))
+            return false;
+        const double r0 = -q[3], r1 = -q[6], r2 = -q[8];
+        p.x = (r0 * (d * f - e * e) - b * (r1 * f - e * r2) + c * (r1 * e - d * r2)) / det;
+        p.y = (a * (r1 * f - e * r2) - r0 * (b * f - c * e) + c * (b * r2 - r1 * c)) / det;
+        p.z = (a * (d * r2 - r1 * e) - b * (b * r2 - r1 * c) + r0 * (b * e - c * d)) / det;
+        return true;
+    }
+};
+
+// a point of the projection plane
+struct Point2 {
+    double x, y;
+};
+
+double cross2(const Point2& o, const Point2& a, const Point2& b)
+{
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+// a face projected onto the plane, with the heights of its corners
+struct Projected {
+    Point2 p[3];
+    double h[3];
+    // twice the signed area
+    double area2;
+    // height of the face above the point q of the plane
+    double height(const Point2& q) const
+    {
+        const double w0 = cross2(q, p[1], p[2]) / area2;
+        const double w1 = cross2(q, p[2], p[0]) / area2;
+        return w0 * h[0] + w1 * h[1] + (1.0 - w0 - w1) * h[2];
+    }
+};
+
+// clip the convex polygon poly to the counter-clockwise triangle t
+void clip(std::vector<Point2>& poly, const Projected& t)
+{
+    std::vector<Point2> in;
+    for (int k = 0; k < 3 && !poly.empty(); ++k) {
+        const Point2& a = t.p[k];
+        const Point2& b = t.p[(k + 1) % 3];
+        in.swap(poly);
+        poly.clear();
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            const Point2& s = in[i];
+            const Point2& e = in[(i + 1) % in.size()];
+            const double ds = cross2(a, b, s);
+            const double de = cross2(a, b, e);
+            if (ds >= 0)
+                poly.push_back(s);
+            if ((ds >= 0) != (de >= 0)) {
+                const double u = ds / (ds - de);
+                poly.push_back({s.x + u * (e.x - s.x), s.y + u * (e.y - s.y)});
+            }
+        }
+    }
+}
+
+double polygonArea2(const std::vector<Point2>& poly)
+{
+    double a = 0;
+    for (std::size_t i = 2; i < poly.size(); ++i)
+        a += cross2(poly[0], poly[i - 1], poly[i]);
+    return a;
+}
+
+// 1 for an equilateral triangle, 0 for a degenerate one
+double quality(const Point c[3])
+{
+    const double area2 = (c[1] - c[0]).cross(c[2] - c[0]).norm();
+    const double edges = (c[1] - c[0]).dot(c[1] - c[0]) + (c[2] - c[1]).dot(c[2] - c[1]) +
+                         (c[0] - c[2]).dot(c[0] - c[2]);
+    return edges > 0 ? 2.0 * std::sqrt(3.0) * area2 / edges : 0.0;
+}
+
+// collapses may not make a face worse than this, unless it was already
+const double minQuality = 0.2;
+
+// the mesh being simplified, shared by the tiles. A tile only changes the
+// faces it owns and the vertices that only those faces use.
+struct Work {
+    std::vector<Point> pos;
+    std::vector<Quadric> quadric;
+    std::vector<char> locked;
+    std::vector<Face> faces;
+    std::vector<char> alive;
+    // bound on the distance from each face to the input
+    std::vector<double> error;
+    double tolerance;
+};
+
+// unit normal of face f, zero for a degenerate face
+Point unitNormal(const Work& w, std::uint32_t f)
+{
+    const Face& t = w.faces[f];
+    const Point cr = (w.pos[t[1]] - w.pos[t[0]]).cross(w.pos[t[2]] - w.pos[t[0]]);
+    const double len = cr.norm();
+    return len > 0 ? cr * (1.0 / len) : Point(0, 0, 0);
+}
+
+// one tile: collapses edges between its unlocked vertices
+class TileDecimator
+{
+public:
+    TileDecimator(Work& w, const std::vector<std::uint32_t>& tileFaces) : work(w)
+    {
+        for (std::uint32_t f : tileFaces) {
+            for (std::uint32_t v : work.faces[f]) {
+                if (!work.locked[v])
+                    adjacency[v].push_back(f);
+            }
+        }
+    }
+
+    void run()
+    {
+        for (auto& a : adjacency) {
+            for (std::uint32_t f : a.second) {
+                for (std::uint32_t w : work.faces[f]) {
+                    if (a.first < w && !work.locked[w])
+                        push(a.first, w);
+                }
+            }
+        }
+        while (!heap.empty()) {
+            const Entry e = heap.top();
+            heap.pop();
+            auto iu = adjacency.find(e.u);
+            auto iv = adjacency.find(e.v);
+            if (iu == adjacency.end() || iv == adjacency.end() ||
+                version[e.u] != e.versionU || version[e.v] != e.versionV)
+                continue;
+            collapse(e.u, e.v);
+        }
+    }
+
+private:
+    struct Entry {
+        double cost;
+        std::uint32_t u, v;
+        unsigned int versionU, versionV;
+        bool operator<(const Entry& o) const
+        {
+            return cost > o.cost;
+        }
+    };
+
+    // positions to try for the merged vertex, least error first
+    std::vector<Point> placements(std::uint32_t u, std::uint32_t v) const
+    {
+        Quadric q = work.quadric[u];
+        q += work.quadric[v];
+        std::vector<Point> c;
+        Point best;
+        if (q.minimum(best))
+            c.push_back(best);
+        c.push_back(0.5 * (work.pos[u] + work.pos[v]));
+        c.push_back(work.pos[u]);
+        c.push_back(work.pos[v]);
+        std::stable_sort(c.begin(), c.end(), [&q](const Point& a, const Point& b) {
+            return q.error(a) < q.error(b);
+        });
+        return c;
+    }
+
+    void push(std::uint32_t u, std::uint32_t v)
+    {
+        Quadric q = work.quadric[u];
+        q += work.quadric[v];
+        heap.push({q.error(placements(u, v).front()), u, v, version[u], version[v]});
+    }
+
+    // the live faces of vertex v
+    std::vector<std::uint32_t>& facesOf(std::uint32_t v)
+    {
+        std::vector<std::uint32_t>& a = adjacency[v];
+        a.erase(std::remove_if(a.begin(), a.end(),
+                               [this](std::uint32_t f) { return !work.alive[f]; }),
+                a.end());
+        return a;
+    }
+
+    std::vector<std::uint32_t> neighbours(std::uint32_t v, const std::vector<std::uint32_t>& fs) const
+    {
+        std::vector<std::uint32_t> n;
+        for (std::uint32_t f : fs) {
+            for (std::uint32_t w : work.faces[f]) {
+                if (w != v)
+                    n.push_back(w);
+            }
+        }
+        std::sort(n.begin(), n.end());
+        n.erase(std::unique(n.begin(), n.end()), n.end());
+        return n;
+    }
+
+    // collapse edge u-v into u, at the first placement that keeps the bound
+    void collapse(std::uint32_t u, std::uint32_t v)
+    {
+        std::vector<std::uint32_t> fu = facesOf(u);
+        const std::vector<std::uint32_t>& fv = facesOf(v);
+        std::vector<std::uint32_t> shared, changed, all;
+        for (std::uint32_t f : fv) {
+            const Face& t = work.faces[f];
+            if (t[0] == u || t[1] == u || t[2] == u)
+                shared.push_back(f);
+            else
+                changed.push_back(f);
+        }
+        if (shared.size() != 2)
+            return;
+        for (std::uint32_t f : fu) {
+            if (std::find(shared.begin(), shared.end(), f) == shared.end())
+                changed.push_back(f);
+        }
+        // link condition: u and v share exactly the neighbours of the two
+        // faces on the edge, otherwise the collapse makes the mesh non-manifold
+        std::vector<std::uint32_t> nu = neighbours(u, fu);
+        std::vector<std::uint32_t> nv = neighbours(v, fv);
+        std::vector<std::uint32_t> common;
+        std::set_intersection(nu.begin(), nu.end(), nv.begin(), nv.end(),
+                              std::back_inserter(common));
+        if (common.size() != 2)
+            return;
+        all = changed;
+        all.insert(all.end(), shared.begin(), shared.end());
+
+        for (const Point& p : placements(u, v)) {
+            std::vector<double> errors;
+            if (!check(u, v, p, all, changed, errors))
+                continue;
+            work.pos[u] = p;
+            work.quadric[u] += work.quadric[v];
+            for (std::uint32_t f : shared)
+                work.alive[f] = 0;
+            std::vector<std::uint32_t>& a = adjacency[u];
+            a.clear();
+            for (std::size_t k = 0; k < changed.size(); ++k) {
+                Face& t = work.faces[changed[k]];
+                for (std::uint32_t& w : t) {
+                    if (w == v)
+                        w = u;
+                }
+                work.error[changed[k]] = errors[k];
+                a.push_back(changed[k]);
+            }
+            adjacency.erase(v);
+            ++version[u];
+            for (std::uint32_t w : neighbours(u, a)) {
+                if (!work.locked[w])
+                    push(std::min(u, w), std::max(u, w));
+            }
+            return;
+        }
+    }
+
+    // corners of face f after moving u and v to p
+    void corners(const Face& t, std::uint32_t u, std::uint32_t v, const Point& p, Point c[3]) const
+    {
+        for (int k = 0; k < 3; ++k)
+            c[k] = (t[k] == u || t[k] == v) ? p : work.pos[t[k]];
+    }
+
+    // \brief true if collapsing u-v to p keeps every new face within the
+    // tolerance of the input. errors gets the new bound of each changed face.
+    bool check(std::uint32_t u, std::uint32_t v, const Point& p,
+               const std::vector<std::uint32_t>& oldFaces, const std::vector<std::uint32_t>& newFaces,
+               std::vector<double>& errors) const
+    {
+        // project along z, so that the bound is on the vertical distance that a
+        // drop-cutter sees. The faces are oriented up or down, as their mean normal.
+        double nz = 0;
+        for (std::uint32_t f : oldFaces) {
+            const Face& t = work.faces[f];
+            nz += (work.pos[t[1]] - work.pos[t[0]]).cross(work.pos[t[2]] - work.pos[t[0]]).z;
+        }
+        if (nz == 0)
+            return false;
+        const double up = nz > 0 ? 1.0 : -1.0;
+        // every face must face along z, so that both sides project one-to-one
+        // over XY. Steep faces cannot move far without leaving the tolerance.
+        auto project = [&](const Point c[3], Projected& t) {
+            const Point cr = (c[1] - c[0]).cross(c[2] - c[0]);
+            const double len = cr.norm();
+            if (!(up * cr.z > 1e-3 * len) || !(len > 0))
+                return false;
+            for (int k = 0; k < 3; ++k) {
+                t.p[k] = {c[k].x, up * c[k].y};
+                t.h[k] = c[k].z;
+            }
+            t.area2 = cross2(t.p[0], t.p[1], t.p[2]);
+            return t.area2 > 0;
+        };
+        std::vector<Projected> before(oldFaces.size());
+        double oldArea = 0;
+        for (std::size_t k = 0; k < oldFaces.size(); ++k) {
+            Point c[3];
+            for (int i = 0; i < 3; ++i)
+                c[i] = work.pos[work.faces[oldFaces[k]][i]];
+            if (!project(c, before[k]))
+                return false;
+            oldArea += before[k].area2;
+        }
+        std::vector<Projected> after(newFaces.size());
+        double newArea = 0;
+        for (std::size_t k = 0; k < newFaces.size(); ++k) {
+            Point c[3];
+            corners(work.faces[newFaces[k]], u, v, p, c);
+            if (!project(c, after[k]))
+                return false;
+            newArea += after[k].area2;
+            // no new slivers, they are candidates of many drops
+            Point o[3];
+            for (int i = 0; i < 3; ++i)
+                o[i] = work.pos[work.faces[newFaces[k]][i]];
+            if (quality(c) < std::min(minQuality, quality(o)))
+                return false;
+        }
+        // both sides cover the same polygon once
+        if (std::fabs(oldArea - newArea) > 1e-9 * oldArea)
+            return false;
+
+        errors.assign(newFaces.size(), 0.0);
+        std::vector<Point2> poly;
+        for (std::size_t k = 0; k < newFaces.size(); ++k) {
+            const Projected& t = after[k];
+            double covered = 0;
+            for (std::size_t i = 0; i < oldFaces.size(); ++i) {
+                poly.assign(t.p, t.p + 3);
+                clip(poly, before[i]);
+                if (poly.size() < 3)
+                    continue;
+                covered += polygonArea2(poly);
+                // the heights differ linearly over the overlap, so the largest
+                // difference is at one of its corners
+                double d = 0;
+                for (const Point2& q : poly)
+                    d = std::max(d, std::fabs(t.height(q) - before[i].height(q)));
+                errors[k] = std::max(errors[k], d + work.error[oldFaces[i]]);
+                if (errors[k] > work.tolerance)
+                    return false;
+            }
+            if (std::fabs(covered - t.area2) > 1e-6 * t.area2)
+                return false;
+        }
+        return true;
+    }
+
+    Work& work;
+    /// faces of each unlocked vertex of the tile
+    std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> adjacency;
+    std::unordered_map<std::uint32_t, unsigned int> version;
+    std::priority_queue<Entry> heap;
+};
+
+}  // namespace
+
+MeshDecimator::MeshDecimator()
+{
+    tolerance = 0.01;
+    featureAngle = 30.0;
+    tileSize = 0.0;
+    diameter = 0.0;
+}
+
+double MeshDecimator::getReduction() const
+{
+    if (input.faces == 0)
+        return 0.0;
+    return 1.0 - static_cast<double>(output.faces) / input.faces;
+}
+
+double MeshDecimator::getExpectedSpeedup() const
+{
+    if (output.faces == 0)
+        return 1.0;
+    return input.dropCost(diameter) / output.dropCost(diameter);
+}
+
+MeshDecimator::FaceStats::FaceStats(const STLSurf& s) : FaceStats()
+{
+    faces = s.size();
+    if (faces == 0)
+        return;
+    for (std::size_t f = 0; f < faces; ++f) {
+        const double w = s.mesh.bound(f, 1) - s.mesh.bound(f, 0);
+        const double h = s.mesh.bound(f, 3) - s.mesh.bound(f, 2);
+        width += w;
+        height += h;
+        boxArea += w * h;
+    }
+    width /= faces;
+    height /= faces;
+    boxArea /= faces;
+    area = (s.bb.maxpt.x - s.bb.minpt.x) * (s.bb.maxpt.y - s.bb.minpt.y);
+}
+
+double MeshDecimator::FaceStats::dropCost(double d) const
+{
+    const double candidates =
+        area > 0 ? faces * (boxArea + d * (width + height) + d * d) / area : double(faces);
+    return std::log2(std::max<double>(faces, 2)) + std::min<double>(candidates, faces);
+}
+
+std::size_t MeshDecimator::run(STLSurf& s)
+{
+    assert(tolerance > 0.0);
+    input = FaceStats(s);
+    output = input;
+    if (s.size() == 0)
+        return 0;
+
+    // welding moves vertices by up to weldTol, which the bound must include
+    const double weldTol = 1e-3 * tolerance;
+    IndexedMesh mesh = s.mesh;
+    mesh.weld(weldTol);
+
+    Work work;
+    work.tolerance = tolerance - weldTol;
+    const std::size_t nv = mesh.vertexCount();
+    const std::size_t nf = mesh.size();
+    work.pos.resize(nv);
+    for (std::uint32_t v = 0; v < nv; ++v)
+        work.pos[v] = mesh.vertex(v);
+    work.quadric.resize(nv);
+    work.faces.resize(nf);
+    work.alive.assign(nf, 1);
+    work.error.assign(nf, 0.0);
+    for (std::size_t f = 0; f < nf; ++f) {
+        Face& t = work.faces[f];
+        for (int k = 0; k < 3; ++k)
+            t[k] = mesh.index(f, k);
+        const Point cr = (work.pos[t[1]] - work.pos[t[0]]).cross(work.pos[t[2]] - work.pos[t[0]]);
+        const double len = cr.norm();
+        if (!(len > 0))
+            continue;
+        const Point n = cr * (1.0 / len);
+        // weighted by area, so that large faces hold their plane
+        for (std::uint32_t v : t)
+            work.quadric[v].addPlane(n, -n.dot(work.pos[t[0]]), 0.5 * len);
+    }
+
+    const Bbox& bb = s.bb;
+    double side = tileSize;
+    if (!(side > 0)) {
+        const double k = std::ceil(std::sqrt(2.0 * executor.getThreads()));
+        side = std::max(bb.maxpt.x - bb.minpt.x, bb.maxpt.y - bb.minpt.y) / std::max(k, 1.0);
+        if (!(side > 0))
+            side = 1.0;
+    }
+
+    const double sharp = std::cos(featureAngle * PI / 180.0);
+    for (int pass = 0; pass < 2; ++pass) {
+        // keep vertices on open boundaries, non-manifold edges and vertices,
+        // and on edges sharper than the feature angle
+        std::vector<std::uint32_t> indices;
+        indices.reserve(3 * work.faces.size());
+        for (const Face& t : work.faces)
+            indices.insert(indices.end(), t.begin(), t.end());
+        MeshTopology topo;
+        topo.build(indices, nv);
+        work.locked.assign(nv, 0);
+        std::vector<std::uint32_t> vertexEdges(nv, 0);
+        for (std::size_t e = 0; e < topo.edgeCount(); ++e) {
+            ++vertexEdges[topo.edgeVertex(e, 0)];
+            ++vertexEdges[topo.edgeVertex(e, 1)];
+            if (topo.edgeFaceCount(e) != 2 ||
+                unitNormal(work, topo.edgeFace(e, 0)).dot(unitNormal(work, topo.edgeFace(e, 1))) < sharp) {
+                work.locked[topo.edgeVertex(e, 0)] = 1;
+                work.locked[topo.edgeVertex(e, 1)] = 1;
+            }
+        }
+        for (std::uint32_t v = 0; v < nv; ++v) {
+            if (vertexEdges[v] != topo.vertexFaceCount(v))
+                work.locked[v] = 1;
+        }
+
+        // faces go to the tile of their centroid, the second pass shifted by
+        // half a tile; vertices used by several tiles are kept
+        const double offset = pass ? 0.5 * side : 0.0;
+        const double x0 = bb.minpt.x - offset;
+        const double y0 = bb.minpt.y - offset;
+        const int nx = static_cast<int>(std::floor((bb.maxpt.x - x0) / side)) + 1;
+        const int ny = static_cast<int>(std::floor((bb.maxpt.y - y0) / side)) + 1;
+        std::vector<std::vector<std::uint32_t>> tiles(static_cast<std::size_t>(nx) * ny);
+        const std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+        std::vector<std::uint32_t> tileOf(nv, none);
+        for (std::uint32_t f = 0; f < work.faces.size(); ++f) {
+            const Face& t = work.faces[f];
+            const Point c = (work.pos[t[0]] + work.pos[t[1]] + work.pos[t[2]]) * (1.0 / 3.0);
+            const int i = std::min(nx - 1, std::max(0, static_cast<int>((c.x - x0) / side)));
+            const int j = std::min(ny - 1, std::max(0, static_cast<int>((c.y - y0) / side)));
+            const std::uint32_t k = static_cast<std::uint32_t>(j * nx + i);
+            tiles[k].push_back(f);
+            for (std::uint32_t v : t) {
+                if (tileOf[v] == none)
+                    tileOf[v] = k;
+                else if (tileOf[v] != k)
+                    work.locked[v] = 1;
+            }
+        }
+
+        Executor e = executor;
+        e.setGrainSize(1);
+        e.setPartitioner(Executor::SIMPLE);
+        e.parallel_for(tiles.size(), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t k = begin; k != end; ++k) {
+                if (!tiles[k].empty())
+                    TileDecimator(work, tiles[k]).run();
+            }
+        });
+
+        // drop the collapsed faces
+        std::size_t kept = 0;
+        for (std::size_t f = 0; f < work.faces.size(); ++f) {
+            if (work.alive[f]) {
+                work.faces[kept] = work.faces[f];
+                work.error[kept] = work.error[f];
+                ++kept;
+            }
+        }
+        work.faces.resize(kept);
+        work.error.resize(kept);
+        work.alive.assign(kept, 1);
+    }
+
+    // the vertices still in use, in their old order
+    std::vector<std::uint32_t> remap(nv, 0);
+    for (const Face& t : work.faces) {
+        for (std::uint32_t v : t)
+            remap[v] = 1;
+    }
+    IndexedMesh result;
+    for (std::uint32_t v = 0; v < nv; ++v) {
+        if (remap[v])
+            remap[v] = result.addVertex(work.pos[v]);
+    }
+    result.reserve(result.vertexCount(), work.faces.size());
+    for (const Face& t : work.faces)
+        result.addFace(remap[t[0]], remap[t[1]], remap[t[2]]);
+    s = STLSurf(result);
+    output = FaceStats(s);
+
+    spdlog::info("MeshDecimator: {} -> {} triangles ({:.1f}% fewer) within {}, "
+                 "expected drop-cutter speedup {:.2f}x",
+                 input.faces, output.faces, 100.0 * getReduction(), tolerance,
+                 getExpectedSpeedup());
+    return input.faces - output.faces;
+}
+
+}  // namespace ocl
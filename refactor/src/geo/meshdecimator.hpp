@@ -0,0 +1,120 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MESHDECIMATOR_H
+#define MESHDECIMATOR_H
+
+#include <cstddef>
+
+#include "common/executor.hpp"
+#include "ocl_export.hpp"
+
+namespace ocl {
+
+class STLSurf;
+
+/// \brief simplifies an STLSurf by quadric-error edge collapse, within a
+/// distance bound of the input.
+///
+/// Edges are collapsed cheapest first by the quadric error of their merged
+/// vertex (Garland-Heckbert). A collapse is only made if the vertical
+/// distance between the input and the result stays within the tolerance:
+/// the faces around a collapse are projected, before and after, onto the XY
+/// plane, and all of them must face up (or all down) so that both sides are
+/// one-to-one over it (successive mapping, Cohen et al. 1997). This maps
+/// every point of the old faces to the point of the new ones with the same
+/// x and y, and the difference in z between them is largest at a vertex of
+/// the overlay of the two projections. Each face keeps a bound on the
+/// vertical distance from its points to the input, which a collapse adds to.
+/// The height of the surface under any XY point therefore moves by at most
+/// the tolerance, and so do the CL-points of a drop-cutter. Vertical and
+/// overhanging faces are never changed.
+///
+/// The surface is welded first and split into square XY tiles, which are
+/// simplified in parallel on the Executor. Vertices on tile borders, on open
+/// boundaries, on non-manifold edges and on edges sharper than the feature
+/// angle are kept. A second pass with the tiles shifted by half a tile
+/// simplifies the old borders.
+class OCL_API MeshDecimator {
+public:
+  MeshDecimator();
+  /// \brief largest distance allowed between the input and the result,
+  /// typically the toolpath tolerance
+  void setTolerance(double t) { tolerance = t; }
+  double getTolerance() const { return tolerance; }
+  /// vertices on edges where the face normals turn by more than this angle,
+  /// in degrees, are kept
+  void setFeatureAngle(double degrees) { featureAngle = degrees; }
+  double getFeatureAngle() const { return featureAngle; }
+  /// side of the tiles simplified in parallel, 0 to choose it from the
+  /// number of threads
+  void setTileSize(double s) { tileSize = s; }
+  /// set the Executor that simplifies the tiles
+  void setExecutor(const Executor &e) { executor = e; }
+  /// diameter of the cutter the speedup is estimated for
+  void setCutterDiameter(double d) { diameter = d; }
+  /// simplify s in place, return the number of triangles removed
+  std::size_t run(STLSurf &s);
+
+  /// number of triangles before and after the last run()
+  std::size_t getInputFaces() const { return input.faces; }
+  std::size_t getOutputFaces() const { return output.faces; }
+  /// fraction of the triangles removed by the last run()
+  double getReduction() const;
+  /// \brief expected drop-cutter speedup of the last run(). A drop costs a
+  /// kd-tree descent, about log2 of the triangle count, plus one call per
+  /// candidate triangle; the candidates are estimated as the triangles whose
+  /// XY bounding-box, grown by the cutter, covers a point, from the mean
+  /// bounding-box size and the XY area of the surface.
+  double getExpectedSpeedup() const;
+
+protected:
+  /// triangle count and XY bounding-box sizes of a surface
+  struct FaceStats {
+    FaceStats() : faces(0), width(0), height(0), boxArea(0), area(0) {}
+    explicit FaceStats(const STLSurf &s);
+    /// estimated cost of one drop with a cutter of diameter d
+    double dropCost(double d) const;
+    std::size_t faces;
+    /// mean width, height and area of the face bounding-boxes
+    double width;
+    double height;
+    double boxArea;
+    /// area of the XY bounding-box of the surface
+    double area;
+  };
+  /// the distance bound
+  double tolerance;
+  /// sharp edge limit in degrees
+  double featureAngle;
+  /// side of the tiles, 0 for automatic
+  double tileSize;
+  /// cutter diameter for getExpectedSpeedup()
+  double diameter;
+  /// runs the tiles
+  Executor executor;
+  /// statistics of the last run()
+  FaceStats input;
+  FaceStats output;
+};
+
+} // namespace ocl
+#endif
+// end file meshdecimator.hpp
@@ -0,0 +1,215 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+
+#include <spdlog/spdlog.h>
+#include <spdlog/stopwatch.h>
+
+#include "common/kdtree.hpp"
+#include "meshindex.hpp"
+#include "stlsurf.hpp"
+
+namespace ocl
+{
+
+namespace
+{
+
+void setPlane(KDTree<IndexedMesh>& tree, MeshIndex::Plane p)
+{
+    if (p == MeshIndex::YZ)
+        tree.setYZDimensions();
+    else if (p == MeshIndex::XZ)
+        tree.setXZDimensions();
+    else
+        tree.setXYDimensions();
+}
+
+// append node n and its children to index in pre-order, return its position
+std::uint32_t flatten(const KDNode* n, MeshIndex& index)
+{
+    if (!n)
+        return MeshIndex::none;
+    const std::uint32_t at = static_cast<std::uint32_t>(index.nodes.size());
+    MeshIndex::Node node = {n->cutval, n->dim, n->isLeaf ? 1u : 0u, MeshIndex::none,
+                            MeshIndex::none, static_cast<std::uint32_t>(index.faces.size()), 0};
+    index.nodes.push_back(node);
+    if (n->isLeaf) {
+        index.faces.insert(index.faces.end(), n->faces.begin(), n->faces.end());
+        index.nodes[at].count = static_cast<std::uint32_t>(index.faces.size()) - index.nodes[at].first;
+    }
+    else {
+        const std::uint32_t hi = flatten(n->hi, index);
+        const std::uint32_t lo = flatten(n->lo, index);
+        index.nodes[at].hi = hi;
+        index.nodes[at].lo = lo;
+    }
+    return at;
+}
+
+KDNode* restoreNode(const MeshIndex& index, std::uint32_t i, KDNode* parent, int depth)
+{
+    const MeshIndex::Node& n = index.nodes[i];
+    KDNode* node = new KDNode(n.dim, n.cutval, parent, NULL, NULL, n.leaf != 0, depth);
+    if (n.leaf) {
+        node->faces.assign(index.faces.begin() + n.first, index.faces.begin() + n.first + n.count);
+    }
+    else {
+        if (n.hi != MeshIndex::none)
+            node->hi = restoreNode(index, n.hi, node, depth + 1);
+        if (n.lo != MeshIndex::none)
+            node->lo = restoreNode(index, n.lo, node, depth + 1);
+    }
+    return node;
+}
+
+// sum of count * probability over the leaves below node i. lo and hi bound
+// the search centres that reach the node along x, y and z, area the centres.
+double reachedFaces(const MeshIndex& index, std::uint32_t i, double lo[3], double hi[3],
+                    const Bbox& area, const int axes[2], double r)
+{
+    const MeshIndex::Node& n = index.nodes[i];
+    if (n.leaf) {
+        double p = n.count;
+        for (int k = 0; k < 2; ++k) {
+            const int a = axes[k];
+            const double side = area[2 * a + 1] - area[2 * a];
+            if (hi[a] < lo[a])
+                return 0.0;
+            if (side > 0)
+                p *= (hi[a] - lo[a]) / side;
+        }
+        return p;
+    }
+    // a search goes to hi unless the box is below a min-cut, and to lo
+    // unless it is above a max-cut
+    const int a = n.dim / 2;
+    double sum = 0.0;
+    if (n.hi != MeshIndex::none) {
+        const double old = lo[a];
+        if (n.dim % 2 == 0)
+            lo[a] = std::max(lo[a], n.cutval - r);
+        sum += reachedFaces(index, n.hi, lo, hi, area, axes, r);
+        lo[a] = old;
+    }
+    if (n.lo != MeshIndex::none) {
+        const double old = hi[a];
+        if (n.dim % 2 == 1)
+            hi[a] = std::min(hi[a], n.cutval + r);
+        sum += reachedFaces(index, n.lo, lo, hi, area, axes, r);
+        hi[a] = old;
+    }
+    return sum;
+}
+
+}  // namespace
+
+const std::uint32_t MeshIndex::none;
+
+void MeshIndex::build(const IndexedMesh& m, Plane p, unsigned int bucket)
+{
+    plane = p;
+    bucketSize = bucket;
+    faceCount = m.size();
+    nodes.clear();
+    faces.clear();
+    if (m.empty())
+        return;
+    KDTree<IndexedMesh> tree;
+    setPlane(tree, p);
+    tree.setBucketSize(bucket);
+    tree.build(m);
+    faces.reserve(m.size());
+    flatten(tree.getRoot(), *this);
+}
+
+bool MeshIndex::isValid() const
+{
+    // children come after their parent in pre-order, so there are no cycles
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        const Node& n = nodes[i];
+        if (n.leaf) {
+            if (std::size_t(n.first) + n.count > faces.size())
+                return false;
+        }
+        else {
+            for (std::uint32_t c : {n.hi, n.lo}) {
+                if (c != none && (c <= i || c >= nodes.size()))
+                    return false;
+            }
+        }
+    }
+    for (std::uint32_t f : faces) {
+        if (f >= faceCount)
+            return false;
+    }
+    return plane >= XY && plane <= XZ;
+}
+
+void MeshIndex::restore(const IndexedMesh& m, KDTree<IndexedMesh>& tree) const
+{
+    assert(m.size() == faceCount);
+    setPlane(tree, plane);
+    tree.setBucketSize(bucketSize);
+    tree.adopt(m, nodes.empty() ? NULL : restoreNode(*this, 0, NULL, 0));
+}
+
+void MeshIndex::buildTree(KDTree<IndexedMesh>& tree, const STLSurf& s)
+{
+    const Plane p = planeOf(tree.getDimensions());
+    for (const auto& index : s.indexes) {
+        if (index->plane == p && index->bucketSize == tree.getBucketSize()
+            && index->faceCount == s.mesh.size() && !index->nodes.empty()) {
+            spdlog::stopwatch sw;
+            index->restore(s.mesh, tree);
+            spdlog::info("KDTree restored size:={} time:={} s", s.mesh.size(), sw);
+            return;
+        }
+    }
+    tree.build(s.mesh);
+}
+
+double MeshIndex::meanCandidates(const Bbox& area, double r) const
+{
+    if (nodes.empty())
+        return 0.0;
+    static const int planeAxes[3][2] = {{0, 1}, {1, 2}, {0, 2}};
+    double lo[3], hi[3];
+    for (int a = 0; a < 3; ++a) {
+        lo[a] = area[2 * a];
+        hi[a] = area[2 * a + 1];
+    }
+    return reachedFaces(*this, 0, lo, hi, area, planeAxes[plane], r);
+}
+
+MeshIndex::Plane MeshIndex::planeOf(const std::vector<int>& dimensions)
+{
+    if (!dimensions.empty() && dimensions[0] == 2)
+        return YZ;
+    if (dimensions.size() > 2 && dimensions[2] == 4)
+        return XZ;
+    return XY;
+}
+
+}  // namespace ocl
+// end file meshindex.cpp
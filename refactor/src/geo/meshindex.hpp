@@ -0,0 +1,106 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MESHINDEX_H
+#define MESHINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bbox.hpp"
+#include "indexedmesh.hpp"
+#include "ocl_export.hpp"
+
+namespace ocl {
+
+template <class Mesh> class KDTree;
+class STLSurf;
+
+/// \brief a kd-tree over the faces of an IndexedMesh in flat arrays.
+///
+/// build() makes the same tree as KDTree<IndexedMesh>::build() over the
+/// mesh with the same plane and bucket-size, but stores it in flat arrays,
+/// so the index can be saved with the mesh (MeshSnapshot) and shared between
+/// Operations. restore() turns it back into a KDTree<IndexedMesh> without
+/// computing any spreads or splits.
+class OCL_API MeshIndex {
+public:
+  /// the search plane, as set by KDTree::setXYDimensions() and friends
+  enum Plane { XY = 0, YZ = 1, XZ = 2 };
+  /// \brief a node of the tree, in pre-order. Leaves hold the faces
+  /// faces[first] .. faces[first+count-1]. 32 bytes, written to file as is.
+  struct Node {
+    /// cut value, see KDNode::cutval
+    double cutval;
+    /// dimension of the cut, see KDNode::dim
+    std::int32_t dim;
+    /// 1 for a leaf
+    std::uint32_t leaf;
+    /// index of the hi and lo child nodes, or none
+    std::uint32_t hi;
+    std::uint32_t lo;
+    /// first face and number of faces of a leaf
+    std::uint32_t first;
+    std::uint32_t count;
+  };
+  /// marks a missing child node
+  static const std::uint32_t none = 0xffffffffu;
+
+  MeshIndex() : plane(XY), bucketSize(1) {}
+  /// build the index of mesh m
+  MeshIndex(const IndexedMesh &m, Plane p, unsigned int bucket) {
+    build(m, p, bucket);
+  }
+  /// build the index of mesh m for search plane p and bucket-size bucket
+  void build(const IndexedMesh &m, Plane p, unsigned int bucket);
+  /// check that all node and face references are in range, e.g. after
+  /// reading the index from a file
+  bool isValid() const;
+  /// \brief set the dimensions and bucket-size of tree and make it the
+  /// kd-tree this index was built from, with the faces of m as leaves
+  void restore(const IndexedMesh &m, KDTree<IndexedMesh> &tree) const;
+  /// \brief build tree over the faces of s. If an index with the plane and
+  /// bucket-size of tree is attached to s (STLSurf::indexes) it is restored
+  /// instead. Used by Operation::setSTL().
+  static void buildTree(KDTree<IndexedMesh> &tree, const STLSurf &s);
+  /// search plane of a tree from its dimensions
+  static Plane planeOf(const std::vector<int> &dimensions);
+  /// \brief mean number of faces a search returns, for a square of half-side
+  /// r (the cutter radius) centred on a point spread evenly over area in the
+  /// search plane. Computed exactly from the cuts: each leaf is reached from
+  /// a box of centres.
+  double meanCandidates(const Bbox &area, double r) const;
+
+  /// search plane
+  Plane plane;
+  /// bucket-size the tree was built with
+  unsigned int bucketSize;
+  /// number of faces of the mesh the index was built for
+  std::size_t faceCount {0};
+  /// the nodes, root first
+  std::vector<Node> nodes;
+  /// face indices of the leaves
+  std::vector<std::uint32_t> faces;
+};
+
+} // namespace ocl
+#endif
+// end file meshindex.hpp
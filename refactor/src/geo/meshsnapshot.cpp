@@ -0,0 +1,242 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "common/mappedfile.hpp"
+#include "meshindex.hpp"
+#include "meshsnapshot.hpp"
+#include "stlsurf.hpp"
+
+namespace ocl
+{
+
+namespace
+{
+
+typedef IndexedMesh::real_type Real;
+
+const char magic[8] = {'O', 'C', 'L', 'M', 'E', 'S', 'H', 0};
+const std::uint32_t byteOrder = 0x01020304;
+
+// file layout: FileHeader, vertices, indices, normals x/y/z, bounds
+// [minx maxx miny maxy minz maxz], then per index an IndexHeader, its nodes
+// and its faces. Every section starts at a multiple of 8 bytes.
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t realSize;
+    std::uint32_t indexCount;
+    std::uint64_t vertexCount;
+    std::uint64_t faceCount;
+    double bb[6];
+};
+
+struct IndexHeader {
+    std::uint32_t plane;
+    std::uint32_t bucketSize;
+    std::uint64_t faceCount;
+    std::uint64_t nodeCount;
+    std::uint64_t leafFaceCount;
+};
+
+static_assert(sizeof(FileHeader) == 88, "unexpected FileHeader padding");
+static_assert(sizeof(IndexHeader) == 32, "unexpected IndexHeader padding");
+static_assert(sizeof(MeshIndex::Node) == 32, "unexpected MeshIndex::Node padding");
+
+std::size_t padded(std::size_t bytes)
+{
+    return (bytes + 7) & ~std::size_t(7);
+}
+
+// writes sections padded to 8 bytes
+class Writer
+{
+public:
+    explicit Writer(std::ofstream& o) : out(o) {}
+    void write(const void* p, std::size_t bytes)
+    {
+        static const char zeros[8] = {0};
+        out.write(static_cast<const char*>(p), bytes);
+        out.write(zeros, padded(bytes) - bytes);
+    }
+
+private:
+    std::ofstream& out;
+};
+
+// reads sections of a mapped file, checking that they are in the file
+class Reader
+{
+public:
+    explicit Reader(const MappedFile& f) : file(f) {}
+    /// the next section of the given size, nullptr past the end of file
+    const char* next(std::uint64_t bytes)
+    {
+        if (bytes > file.size() || padded(bytes) > file.size() - pos)
+            return nullptr;
+        const char* p = file.data() + pos;
+        pos += padded(bytes);
+        return p;
+    }
+
+private:
+    const MappedFile& file;
+    std::size_t pos {0};
+};
+
+}  // namespace
+
+const std::uint32_t MeshSnapshot::version;
+
+bool MeshSnapshot::save(const std::wstring& path, const STLSurf& s)
+{
+    std::ofstream out(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+    if (!out) {
+        spdlog::warn("MeshSnapshot: can not write {}", narrowPath(path));
+        return false;
+    }
+    const IndexedMesh& m = s.mesh;
+    const std::size_t nf = m.size();
+    FileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, magic, 8);
+    h.version = version;
+    h.byteOrder = byteOrder;
+    h.realSize = sizeof(Real);
+    h.indexCount = static_cast<std::uint32_t>(s.indexes.size());
+    h.vertexCount = m.vertexCount();
+    h.faceCount = nf;
+    for (unsigned int d = 0; d < 6; ++d)
+        h.bb[d] = s.bb[d];
+
+    Writer w(out);
+    w.write(&h, sizeof(h));
+    w.write(m.vertices().data(), m.vertices().size() * sizeof(Real));
+    w.write(m.indices().data(), m.indices().size() * sizeof(std::uint32_t));
+    for (int k = 0; k < 3; ++k)
+        w.write(m.normalComponent(k).data(), nf * sizeof(Real));
+    for (unsigned int d = 0; d < 6; ++d)
+        w.write(m.boundComponent(d).data(), nf * sizeof(Real));
+    for (const auto& index : s.indexes) {
+        IndexHeader ih = {static_cast<std::uint32_t>(index->plane), index->bucketSize,
+                          index->faceCount, index->nodes.size(), index->faces.size()};
+        w.write(&ih, sizeof(ih));
+        w.write(index->nodes.data(), index->nodes.size() * sizeof(MeshIndex::Node));
+        w.write(index->faces.data(), index->faces.size() * sizeof(std::uint32_t));
+    }
+    out.flush();
+    if (!out) {
+        spdlog::warn("MeshSnapshot: writing {} failed", narrowPath(path));
+        return false;
+    }
+    return true;
+}
+
+bool MeshSnapshot::load(const std::wstring& path, STLSurf& s)
+{
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        spdlog::warn("MeshSnapshot: can not open {}", narrowPath(path));
+        return false;
+    }
+    Reader r(file);
+    const char* p = r.next(sizeof(FileHeader));
+    FileHeader h;
+    if (p)
+        memcpy(&h, p, sizeof(h));
+    if (!p || memcmp(h.magic, magic, 8) != 0) {
+        spdlog::warn("MeshSnapshot: {} is not an .oclmesh file", narrowPath(path));
+        return false;
+    }
+    if (h.version != version || h.byteOrder != byteOrder || h.realSize != sizeof(Real)) {
+        spdlog::warn("MeshSnapshot: {} has version {}, this library reads version {}",
+                     narrowPath(path), h.version, version);
+        return false;
+    }
+
+    const std::uint64_t nv = h.vertexCount;
+    const std::uint64_t nf = h.faceCount;
+    bool ok = nv <= 0xffffffffu && nf <= file.size() / 12;
+    const char* vertices = ok ? r.next(3 * nv * sizeof(Real)) : nullptr;
+    const char* indices = vertices ? r.next(3 * nf * sizeof(std::uint32_t)) : nullptr;
+    const Real* normals[3] = {nullptr, nullptr, nullptr};
+    const Real* bounds[6] = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+    ok = indices != nullptr;
+    for (int k = 0; k < 3 && ok; ++k)
+        ok = (normals[k] = reinterpret_cast<const Real*>(r.next(nf * sizeof(Real)))) != nullptr;
+    for (int k = 0; k < 6 && ok; ++k)
+        ok = (bounds[k] = reinterpret_cast<const Real*>(r.next(nf * sizeof(Real)))) != nullptr;
+
+    std::vector<std::shared_ptr<const MeshIndex>> indexes;
+    for (std::uint32_t n = 0; n < h.indexCount && ok; ++n) {
+        const char* q = r.next(sizeof(IndexHeader));
+        IndexHeader ih;
+        if (q)
+            memcpy(&ih, q, sizeof(ih));
+        const char* nodes = q && ih.nodeCount <= file.size() / sizeof(MeshIndex::Node)
+                                ? r.next(ih.nodeCount * sizeof(MeshIndex::Node))
+                                : nullptr;
+        const char* faces = nodes && ih.leafFaceCount <= file.size() / sizeof(std::uint32_t)
+                                ? r.next(ih.leafFaceCount * sizeof(std::uint32_t))
+                                : nullptr;
+        if (!faces) {
+            ok = false;
+            break;
+        }
+        auto index = std::make_shared<MeshIndex>();
+        index->plane = static_cast<MeshIndex::Plane>(ih.plane);
+        index->bucketSize = ih.bucketSize;
+        index->faceCount = ih.faceCount;
+        index->nodes.resize(ih.nodeCount);
+        memcpy(index->nodes.data(), nodes, ih.nodeCount * sizeof(MeshIndex::Node));
+        index->faces.resize(ih.leafFaceCount);
+        memcpy(index->faces.data(), faces, ih.leafFaceCount * sizeof(std::uint32_t));
+        ok = index->faceCount == nf && index->isValid();
+        indexes.push_back(index);
+    }
+    if (ok) {
+        // the vertex indices of the faces must be in range
+        const std::uint32_t* idx = reinterpret_cast<const std::uint32_t*>(indices);
+        for (std::uint64_t k = 0; k < 3 * nf && ok; ++k)
+            ok = idx[k] < nv;
+    }
+    if (!ok) {
+        spdlog::warn("MeshSnapshot: {} is truncated or corrupt", narrowPath(path));
+        return false;
+    }
+
+    s.mesh.assign(reinterpret_cast<const Real*>(vertices), nv,
+                  reinterpret_cast<const std::uint32_t*>(indices), nf, normals, bounds);
+    s.bb = nf ? Bbox(h.bb[0], h.bb[1], h.bb[2], h.bb[3], h.bb[4], h.bb[5]) : Bbox();
+    s.indexes = std::move(indexes);
+    return true;
+}
+
+}  // namespace ocl
+// end file meshsnapshot.cpp
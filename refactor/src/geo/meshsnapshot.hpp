@@ -0,0 +1,68 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MESHSNAPSHOT_H
+#define MESHSNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+
+#include "ocl_export.hpp"
+
+namespace ocl {
+
+class STLSurf;
+
+/// \brief .oclmesh snapshot: an STLSurf with its face data and kd-tree
+/// indexes in one binary file, for reloading a model without parsing it or
+/// building its kd-trees again.
+///
+/// The file holds a versioned header, the vertex and index buffers, the face
+/// normals and bounds of the IndexedMesh, and every MeshIndex attached to the
+/// surface (STLSurf::addIndex()). All sections are raw arrays at 8-byte
+/// aligned offsets in native byte order; load() maps the file and copies
+/// them as blocks. An Operation whose plane and bucket-size match a loaded
+/// index restores its kd-tree from it in setSTL().
+///
+/// \code
+/// STLSurf s;
+/// STLReader(L"fixture.stl", s);
+/// s.addIndex(MeshIndex::XY, 1);
+/// MeshSnapshot::save(L"fixture.oclmesh", s);
+/// // later, in another process
+/// STLSurf t;
+/// MeshSnapshot::load(L"fixture.oclmesh", t);
+/// bdc.setSTL(t);  // no kd-tree build
+/// \endcode
+class OCL_API MeshSnapshot {
+public:
+  /// current file format version
+  static const std::uint32_t version = 1;
+  /// write s and its attached indexes to path, return false on failure
+  static bool save(const std::wstring &path, const STLSurf &s);
+  /// \brief replace s with the surface and indexes stored at path. Returns
+  /// false and leaves s unchanged if the file is missing, of another version
+  /// or byte order, or inconsistent.
+  static bool load(const std::wstring &path, STLSurf &s);
+};
+
+} // namespace ocl
+#endif
+// end file meshsnapshot.hpp
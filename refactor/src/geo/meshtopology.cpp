@@ -0,0 +1,106 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+
+#include "meshtopology.hpp"
+
+namespace ocl
+{
+
+void MeshTopology::build(const std::vector<std::uint32_t>& indices, std::size_t nverts)
+{
+    assert(indices.size() % 3 == 0);
+    const std::size_t nf = indices.size() / 3;
+
+    // sort the 3*nf half-edges by their (lower, upper) vertex pair, equal
+    // pairs are then adjacent and become one edge
+    std::vector<std::uint64_t> keys(3 * nf);
+    std::vector<std::uint32_t> order(3 * nf);
+    for (std::size_t f = 0; f < nf; ++f) {
+        for (int k = 0; k < 3; ++k) {
+            std::uint64_t a = indices[3 * f + k];
+            std::uint64_t b = indices[3 * f + (k + 1) % 3];
+            if (a > b)
+                std::swap(a, b);
+            keys[3 * f + k] = (a << 32) | b;
+            order[3 * f + k] = static_cast<std::uint32_t>(3 * f + k);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](std::uint32_t i, std::uint32_t j) {
+        return keys[i] < keys[j] || (keys[i] == keys[j] && i < j);
+    });
+
+    edges.clear();
+    faceEdge.assign(3 * nf, 0);
+    edgeStart.assign(1, 0);
+    edgeFaces.clear();
+    edgeFaces.reserve(3 * nf);
+    for (std::size_t n = 0; n < order.size(); ++n) {
+        const std::uint32_t h = order[n];
+        if (n == 0 || keys[h] != keys[order[n - 1]]) {  // a new edge
+            if (n != 0)
+                edgeStart.push_back(static_cast<std::uint32_t>(edgeFaces.size()));
+            edges.push_back(static_cast<std::uint32_t>(keys[h] >> 32));
+            edges.push_back(static_cast<std::uint32_t>(keys[h] & 0xffffffffu));
+        }
+        faceEdge[h] = static_cast<std::uint32_t>(edges.size() / 2 - 1);
+        edgeFaces.push_back(h / 3);
+    }
+    if (!order.empty())
+        edgeStart.push_back(static_cast<std::uint32_t>(edgeFaces.size()));
+
+    // faces of each vertex, by counting sort
+    vertexStart.assign(nverts + 1, 0);
+    for (std::uint32_t v : indices)
+        ++vertexStart[v + 1];
+    for (std::size_t v = 0; v < nverts; ++v)
+        vertexStart[v + 1] += vertexStart[v];
+    vertexFaces.assign(indices.size(), 0);
+    std::vector<std::uint32_t> fill(vertexStart.begin(), vertexStart.end() - 1);
+    for (std::size_t f = 0; f < nf; ++f) {
+        for (int k = 0; k < 3; ++k)
+            vertexFaces[fill[indices[3 * f + k]]++] = static_cast<std::uint32_t>(f);
+    }
+}
+
+std::size_t MeshTopology::boundaryEdgeCount() const
+{
+    std::size_t n = 0;
+    for (std::size_t e = 0; e < edgeCount(); ++e) {
+        if (edgeFaceCount(e) == 1)
+            ++n;
+    }
+    return n;
+}
+
+bool MeshTopology::isClosed() const
+{
+    for (std::size_t e = 0; e < edgeCount(); ++e) {
+        if (edgeFaceCount(e) != 2)
+            return false;
+    }
+    return edgeCount() > 0;
+}
+
+}  // namespace ocl
+// end file meshtopology.cpp
@@ -0,0 +1,94 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MESHTOPOLOGY_H
+#define MESHTOPOLOGY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ocl_export.hpp"
+
+namespace ocl {
+
+/// \brief unique edges and adjacency of an indexed triangle mesh.
+///
+/// Every edge shared by several faces is stored once, so that a drop-cutter
+/// can test each vertex and edge of a neighbourhood once instead of once per
+/// face. Build it on a welded mesh (IndexedMesh::weld()), otherwise no
+/// vertices and edges are shared. Edge k of face f runs from corner k to
+/// corner (k+1)%3, in the same order as MillingCutter::edgeDrop().
+class OCL_API MeshTopology {
+public:
+  MeshTopology() {}
+  /// build the topology of mesh m
+  template <class Mesh> explicit MeshTopology(const Mesh &m) {
+    build(m.indices(), m.vertexCount());
+  }
+  /// build from an index buffer with three vertex indices per face
+  void build(const std::vector<std::uint32_t> &indices, std::size_t nverts);
+
+  std::size_t faceCount() const { return faceEdge.size() / 3; }
+  std::size_t vertexCount() const { return vertexStart.size() - 1; }
+  std::size_t edgeCount() const { return edges.size() / 2; }
+  /// vertex k (0 or 1) of edge e, the lower index first
+  std::uint32_t edgeVertex(std::size_t e, int k) const {
+    return edges[2 * e + k];
+  }
+  /// index of edge k of face f
+  std::uint32_t edge(std::size_t f, int k) const { return faceEdge[3 * f + k]; }
+  /// number of faces sharing edge e
+  std::size_t edgeFaceCount(std::size_t e) const {
+    return edgeStart[e + 1] - edgeStart[e];
+  }
+  /// face i of the faces sharing edge e
+  std::uint32_t edgeFace(std::size_t e, std::size_t i) const {
+    return edgeFaces[edgeStart[e] + i];
+  }
+  /// number of faces sharing vertex v
+  std::size_t vertexFaceCount(std::size_t v) const {
+    return vertexStart[v + 1] - vertexStart[v];
+  }
+  /// face i of the faces sharing vertex v
+  std::uint32_t vertexFace(std::size_t v, std::size_t i) const {
+    return vertexFaces[vertexStart[v] + i];
+  }
+  /// number of edges with only one face
+  std::size_t boundaryEdgeCount() const;
+  /// true if every edge is shared by exactly two faces
+  bool isClosed() const;
+
+private:
+  /// two vertex indices per unique edge
+  std::vector<std::uint32_t> edges;
+  /// three edge indices per face
+  std::vector<std::uint32_t> faceEdge;
+  /// faces of edge e are edgeFaces[edgeStart[e]] .. edgeFaces[edgeStart[e+1]]
+  std::vector<std::uint32_t> edgeStart{0};
+  std::vector<std::uint32_t> edgeFaces;
+  /// faces of vertex v, stored in the same way
+  std::vector<std::uint32_t> vertexStart{0};
+  std::vector<std::uint32_t> vertexFaces;
+};
+
+} // namespace ocl
+#endif
+// end file meshtopology.hpp
@@ -0,0 +1,219 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "indexedmesh.hpp"
+#include "regionofinterest.hpp"
+#include "stlsurf.hpp"
+
+namespace ocl
+{
+
+namespace
+{
+
+// keep the part of poly on one side of the line coordinate[axis] = bound:
+// below it if below is true, above it otherwise (Sutherland-Hodgman)
+void clipPolygon(std::vector<Point>& poly, int axis, double bound, bool below)
+{
+    auto coord = [axis](const Point& p) { return axis ? p.y : p.x; };
+    auto inside = [&](const Point& p) {
+        return below ? coord(p) <= bound : coord(p) >= bound;
+    };
+    std::vector<Point> out;
+    out.reserve(poly.size() + 1);
+    for (std::size_t n = 0; n < poly.size(); ++n) {
+        const Point& a = poly[n];
+        const Point& b = poly[(n + 1) % poly.size()];
+        if (inside(a))
+            out.push_back(a);
+        if (inside(a) != inside(b)) {
+            const double t = (bound - coord(a)) / (coord(b) - coord(a));
+            Point p = a + t * (b - a);
+            // land exactly on the line, whatever the rounding
+            if (axis)
+                p.y = bound;
+            else
+                p.x = bound;
+            out.push_back(p);
+        }
+    }
+    poly.swap(out);
+}
+
+// true if the segment ab meets the rectangle [x0, x1] x [y0, y1] (Liang-Barsky)
+bool segmentMeetsRect(const Point& a, const Point& b, double x0, double x1, double y0,
+                      double y1)
+{
+    double t0 = 0.0;
+    double t1 = 1.0;
+    const double d[2] = {b.x - a.x, b.y - a.y};
+    const double lo[2] = {x0 - a.x, y0 - a.y};
+    const double hi[2] = {x1 - a.x, y1 - a.y};
+    for (int k = 0; k < 2; ++k) {
+        if (d[k] == 0.0) {
+            if (lo[k] > 0.0 || hi[k] < 0.0)
+                return false;
+            continue;
+        }
+        double s0 = lo[k] / d[k];
+        double s1 = hi[k] / d[k];
+        if (s0 > s1)
+            std::swap(s0, s1);
+        t0 = std::max(t0, s0);
+        t1 = std::min(t1, s1);
+        if (t0 > t1)
+            return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+RegionOfInterest::RegionOfInterest(const Bbox& b)
+    : RegionOfInterest(std::vector<Point> {Point(b.minpt.x, b.minpt.y, 0),
+                                           Point(b.maxpt.x, b.minpt.y, 0),
+                                           Point(b.maxpt.x, b.maxpt.y, 0),
+                                           Point(b.minpt.x, b.maxpt.y, 0)})
+{}
+
+RegionOfInterest::RegionOfInterest(const std::vector<Point>& pts)
+    : polygon(pts)
+{
+    assert(polygon.size() >= 3);
+    xmin = ymin = std::numeric_limits<double>::max();
+    xmax = ymax = -std::numeric_limits<double>::max();
+    for (Point& p : polygon) {
+        p.z = 0.0;
+        xmin = std::min(xmin, p.x);
+        xmax = std::max(xmax, p.x);
+        ymin = std::min(ymin, p.y);
+        ymax = std::max(ymax, p.y);
+    }
+}
+
+bool RegionOfInterest::contains(const Point& p) const
+{
+    if (empty() || p.x < xmin || p.x > xmax || p.y < ymin || p.y > ymax)
+        return false;
+    // even-odd rule: count the edges crossed by a ray towards +x. Points on
+    // an edge are inside.
+    bool in = false;
+    for (std::size_t n = 0, m = polygon.size() - 1; n < polygon.size(); m = n++) {
+        const Point& a = polygon[n];
+        const Point& b = polygon[m];
+        const double ex = b.x - a.x;
+        const double ey = b.y - a.y;
+        const double px = p.x - a.x;
+        const double py = p.y - a.y;
+        const double along = ex * px + ey * py;
+        const double len2 = ex * ex + ey * ey;
+        if (std::fabs(ex * py - ey * px) <= 1e-12 * len2 && along >= 0.0 && along <= len2)
+            return true;
+        if ((a.y > p.y) != (b.y > p.y)
+            && p.x < a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y))
+            in = !in;
+    }
+    return in;
+}
+
+bool RegionOfInterest::overlaps(double x0, double x1, double y0, double y1) const
+{
+    if (empty() || x1 < xmin || x0 > xmax || y1 < ymin || y0 > ymax)
+        return false;
+    // the rectangle is inside the polygon, or an edge of the polygon meets it
+    if (contains(Point(x0, y0, 0)))
+        return true;
+    for (std::size_t n = 0, m = polygon.size() - 1; n < polygon.size(); m = n++) {
+        if (segmentMeetsRect(polygon[m], polygon[n], x0, x1, y0, y1))
+            return true;
+    }
+    return false;
+}
+
+Bbox RegionOfInterest::bounds(double r) const
+{
+    return Bbox(xmin - r, xmax + r, ymin - r, ymax + r, 0, 0);
+}
+
+STLSurf RegionOfInterest::cull(const STLSurf& s, double r) const
+{
+    const IndexedMesh& in = s.mesh;
+    const double cx0 = xmin - r;
+    const double cx1 = xmax + r;
+    const double cy0 = ymin - r;
+    const double cy1 = ymax + r;
+
+    IndexedMesh out;
+    const std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+    std::vector<std::uint32_t> map(in.vertexCount(), none);
+    auto keep = [&](std::uint32_t v) {
+        if (map[v] == none)
+            map[v] = out.addVertex(in.vertex(v));
+        return map[v];
+    };
+    std::vector<Point> poly;
+    for (std::size_t f = 0; f < in.size(); ++f) {
+        const std::uint32_t v[3] = {in.index(f, 0), in.index(f, 1), in.index(f, 2)};
+        const Point p[3] = {in.vertex(v[0]), in.vertex(v[1]), in.vertex(v[2])};
+        const double fx0 = std::min({p[0].x, p[1].x, p[2].x});
+        const double fx1 = std::max({p[0].x, p[1].x, p[2].x});
+        const double fy0 = std::min({p[0].y, p[1].y, p[2].y});
+        const double fy1 = std::max({p[0].y, p[1].y, p[2].y});
+        if (!overlaps(fx0 - r, fx1 + r, fy0 - r, fy1 + r))
+            continue;
+        if (fx0 >= cx0 && fx1 <= cx1 && fy0 >= cy0 && fy1 <= cy1) {
+            out.addFace(keep(v[0]), keep(v[1]), keep(v[2]));
+            continue;
+        }
+        // only the part within bounds(r) can touch a cutter inside the region
+        poly.assign(p, p + 3);
+        clipPolygon(poly, 0, cx0, false);
+        clipPolygon(poly, 0, cx1, true);
+        clipPolygon(poly, 1, cy0, false);
+        clipPolygon(poly, 1, cy1, true);
+        if (poly.size() < 3)
+            continue;
+        // the clipped polygon is convex, split it into a fan of triangles
+        const double tiny = 1e-12 * std::max((p[1] - p[0]).cross(p[2] - p[0]).norm(),
+                                             std::numeric_limits<double>::min());
+        const std::uint32_t first = out.addVertex(poly[0]);
+        std::uint32_t prev = none;
+        for (std::size_t k = 1; k + 1 < poly.size(); ++k) {
+            if ((poly[k] - poly[0]).cross(poly[k + 1] - poly[0]).norm() <= tiny) {
+                prev = none;
+                continue;
+            }
+            const std::uint32_t b = prev == none ? out.addVertex(poly[k]) : prev;
+            prev = out.addVertex(poly[k + 1]);
+            out.addFace(first, b, prev);
+        }
+    }
+    return STLSurf(out);
+}
+
+}  // namespace ocl
+// end file regionofinterest.cpp
@@ -0,0 +1,81 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef REGIONOFINTEREST_H
+#define REGIONOFINTEREST_H
+
+#include <vector>
+
+#include "bbox.hpp"
+#include "ocl_export.hpp"
+#include "point.hpp"
+
+namespace ocl {
+
+class STLSurf;
+
+/// \brief a region of interest in the XY plane: a simple polygon, or an
+/// axis-aligned box.
+///
+/// An Operation with a region (Operation::setROI()) indexes only the
+/// triangles that come within the cutter radius of it, clipped to the
+/// bounding-box of the region grown by that radius, see cull(). A cutter at a
+/// CL-point inside the region touches nothing else, so results there are the
+/// same as on the whole surface, while index build time and memory, and the
+/// fibers a Waterline generates over the surface, follow the size of the
+/// region. CL-points outside the region are not generated or not dropped.
+///
+/// The default-constructed region is empty and means the whole surface.
+class OCL_API RegionOfInterest {
+public:
+  /// the empty region, i.e. no restriction
+  RegionOfInterest() {}
+  /// the XY extent of box b
+  explicit RegionOfInterest(const Bbox &b);
+  /// \brief the XY polygon with vertices pts, at least three, closed from the
+  /// last vertex back to the first. z-coordinates are ignored.
+  explicit RegionOfInterest(const std::vector<Point> &pts);
+
+  /// true for the default region, which restricts nothing
+  bool empty() const { return polygon.empty(); }
+  /// true if the XY position of p is inside the region
+  bool contains(const Point &p) const;
+  /// \brief true if the XY rectangle [x0, x1] x [y0, y1] overlaps the
+  /// region, its edges included
+  bool overlaps(double x0, double x1, double y0, double y1) const;
+  /// XY bounding-box of the region grown by r on every side, with z = 0
+  Bbox bounds(double r) const;
+  /// \brief the part of s that may be within r of the region: the triangles
+  /// whose XY bounding-box grown by r overlaps the region, clipped to
+  /// bounds(r). Vertices kept whole stay shared, the clipped triangles get
+  /// vertices of their own.
+  STLSurf cull(const STLSurf &s, double r) const;
+
+  /// vertices of the polygon, empty for the default region
+  std::vector<Point> polygon;
+
+protected:
+  /// XY bounding-box of polygon
+  double xmin {0.0}, xmax {0.0}, ymin {0.0}, ymax {0.0};
+};
+
+} // namespace ocl
+#endif
+// end file regionofinterest.hpp
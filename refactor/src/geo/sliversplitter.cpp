@@ -0,0 +1,188 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+#include <spdlog/spdlog.h>
+
+#include "meshindex.hpp"
+#include "point.hpp"
+#include "sliversplitter.hpp"
+#include "stlsurf.hpp"
+
+namespace ocl
+{
+
+namespace
+{
+
+// XY bounding-box of a triangle grown by d, the area over which it is a
+// candidate of a cutter of diameter d
+double footprint(const Point& a, const Point& b, const Point& c, double d)
+{
+    const double w = std::max({a.x, b.x, c.x}) - std::min({a.x, b.x, c.x});
+    const double h = std::max({a.y, b.y, c.y}) - std::min({a.y, b.y, c.y});
+    return (w + d) * (h + d);
+}
+
+// mean candidates of the XY index of s with the given bucket-size,
+// using an attached index if there is one
+double meanCandidates(const STLSurf& s, unsigned int bucket, double r)
+{
+    for (const auto& index : s.indexes) {
+        if (index->plane == MeshIndex::XY && index->bucketSize == bucket &&
+            index->faceCount == s.mesh.size())
+            return index->meanCandidates(s.bb, r);
+    }
+    return MeshIndex(s.mesh, MeshIndex::XY, bucket).meanCandidates(s.bb, r);
+}
+
+}  // namespace
+
+SliverSplitter::SliverSplitter()
+{
+    boxRatio = 10.0;
+    aspectRatio = 20.0;
+    maxPieces = 64;
+    diameter = 0.0;
+    bucketSize = 1;
+    splitFaces = 0;
+    addedFaces = 0;
+    candidatesBefore = 0.0;
+    candidatesAfter = 0.0;
+}
+
+bool SliverSplitter::isSliver(const Point& a, const Point& b, const Point& c) const
+{
+    const Point n = (b - a).cross(c - a);
+    const double area = 0.5 * n.norm();
+    if (!(area > 0))
+        return false;  // degenerate, splitting does not help
+    const double areaXY = 0.5 * std::fabs(n.z);
+    if (footprint(a, b, c, 0.0) > boxRatio * areaXY)
+        return true;
+    const double longest = std::max({(b - a).norm(), (c - b).norm(), (a - c).norm()});
+    // the height over the longest edge is 2 * area / longest
+    return longest * longest > aspectRatio * 2.0 * area;
+}
+
+std::size_t SliverSplitter::split(IndexedMesh& m, std::uint32_t a, std::uint32_t b, std::uint32_t c,
+                                  unsigned int pieces) const
+{
+    if (pieces < 3 || !isSliver(m.vertex(a), m.vertex(b), m.vertex(c))) {
+        m.addFace(a, b, c);
+        return 1;
+    }
+    // rotate the corners so that b-c is the shortest edge, keeping the winding
+    std::uint32_t v[3] = {a, b, c};
+    double shortest = std::numeric_limits<double>::max();
+    int k0 = 0;
+    for (int k = 0; k < 3; ++k) {
+        const double len = (m.vertex(v[(k + 2) % 3]) - m.vertex(v[(k + 1) % 3])).norm();
+        if (len < shortest) {
+            shortest = len;
+            k0 = k;
+        }
+    }
+    a = v[k0];
+    b = v[(k0 + 1) % 3];
+    c = v[(k0 + 2) % 3];
+    const Point pa = m.vertex(a);
+    const Point ab = m.vertex(b) - pa;
+    const Point ac = m.vertex(c) - pa;
+    // a strip of 2n-1 triangles between points i/n along a-b and a-c
+    auto P = [&](unsigned int i, unsigned int n) { return pa + ab * (double(i) / n); };
+    auto Q = [&](unsigned int i, unsigned int n) { return pa + ac * (double(i) / n); };
+    auto cost = [&](unsigned int n) {
+        double sum = footprint(pa, P(1, n), Q(1, n), diameter);
+        for (unsigned int i = 1; i < n; ++i) {
+            sum += footprint(P(i, n), P(i + 1, n), Q(i + 1, n), diameter);
+            sum += footprint(P(i, n), Q(i + 1, n), Q(i, n), diameter);
+        }
+        return sum;
+    };
+    unsigned int best = 1;
+    double bestCost = cost(1);
+    for (unsigned int n = 2; 2 * n - 1 <= pieces; ++n) {
+        const double cn = cost(n);
+        if (cn < bestCost) {
+            best = n;
+            bestCost = cn;
+        }
+    }
+    if (best == 1) {
+        m.addFace(a, b, c);
+        return 1;
+    }
+    std::uint32_t p0 = a, q0 = a;
+    for (unsigned int i = 1; i <= best; ++i) {
+        const std::uint32_t p1 = i == best ? b : m.addVertex(P(i, best));
+        const std::uint32_t q1 = i == best ? c : m.addVertex(Q(i, best));
+        if (i == 1) {
+            m.addFace(a, p1, q1);
+        }
+        else {
+            m.addFace(p0, p1, q1);
+            m.addFace(p0, q1, q0);
+        }
+        p0 = p1;
+        q0 = q1;
+    }
+    return 2 * best - 1;
+}
+
+std::size_t SliverSplitter::run(STLSurf& s)
+{
+    splitFaces = 0;
+    addedFaces = 0;
+    const double r = 0.5 * diameter;
+    candidatesBefore = s.size() ? meanCandidates(s, bucketSize, r) : 0.0;
+    candidatesAfter = candidatesBefore;
+
+    IndexedMesh result;
+    const IndexedMesh& m = s.mesh;
+    result.reserve(m.vertexCount(), m.size());
+    for (std::uint32_t v = 0; v < m.vertexCount(); ++v)
+        result.addVertex(m.vertex(v));
+    for (std::size_t f = 0; f < m.size(); ++f) {
+        const std::uint32_t a = m.index(f, 0), b = m.index(f, 1), c = m.index(f, 2);
+        const std::size_t n = split(result, a, b, c, maxPieces);
+        if (n > 1) {
+            ++splitFaces;
+            addedFaces += n - 1;
+        }
+    }
+    if (splitFaces == 0)
+        return 0;
+
+    s = STLSurf(result);
+    candidatesAfter = s.addIndex(MeshIndex::XY, bucketSize).meanCandidates(s.bb, r);
+    spdlog::info("SliverSplitter: {} slivers split into {} more triangles, "
+                 "candidates per search {:.1f} -> {:.1f}",
+                 splitFaces, addedFaces, candidatesBefore, candidatesAfter);
+    return splitFaces;
+}
+
+}  // namespace ocl
@@ -0,0 +1,100 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SLIVERSPLITTER_H
+#define SLIVERSPLITTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "indexedmesh.hpp"
+#include "ocl_export.hpp"
+
+namespace ocl {
+
+class Point;
+class STLSurf;
+
+/// \brief splits long thin triangles into smaller ones on the same surface,
+/// so that the kd-tree bounding-boxes fit them better.
+///
+/// A kd-tree search returns every triangle whose bounding-box overlaps the
+/// cutter, so a long diagonal triangle is a candidate of every CL-point along
+/// it. A triangle is a sliver if its XY bounding-box is more than
+/// setBoxRatio() times its XY area, or its longest edge is more than
+/// setAspectRatio() times its height over that edge. A sliver is cut across
+/// its two long edges into a strip of 2n-1 triangles, the points i/n along
+/// both edges joined, with n chosen to give the least sum of (w + d)(h + d)
+/// over the XY boxes of the pieces, their share of the candidates of a
+/// cutter of diameter d, and at most setMaxPieces() pieces.
+///
+/// The new vertices lie on the old edges, so the surface is unchanged, but a
+/// neighbour across a split edge gets a T-junction: vertices and edges there
+/// are no longer shared (MeshTopology, BatchDropCutter::setUniqueElements()).
+///
+/// run() reports the mean number of candidates per drop-cutter search before
+/// and after from the XY kd-tree indexes (MeshIndex::meanCandidates()), and
+/// attaches the index of the result to the surface.
+class OCL_API SliverSplitter {
+public:
+  SliverSplitter();
+  /// largest ratio of XY bounding-box area to XY area of a triangle
+  void setBoxRatio(double r) { boxRatio = r; }
+  /// largest ratio of longest edge to height of a triangle
+  void setAspectRatio(double r) { aspectRatio = r; }
+  /// most pieces a triangle is split into
+  void setMaxPieces(unsigned int n) { maxPieces = n; }
+  /// diameter of the cutter the candidates are counted for
+  void setCutterDiameter(double d) { diameter = d; }
+  /// bucket-size of the kd-tree indexes
+  void setBucketSize(unsigned int b) { bucketSize = b; }
+  /// split the slivers of s, return the number of triangles split
+  std::size_t run(STLSurf &s);
+
+  /// number of triangles split and triangles added by the last run()
+  std::size_t getSplitFaces() const { return splitFaces; }
+  std::size_t getAddedFaces() const { return addedFaces; }
+  /// mean candidates per search before and after the last run()
+  double getCandidatesBefore() const { return candidatesBefore; }
+  double getCandidatesAfter() const { return candidatesAfter; }
+
+protected:
+  /// true if the triangle a, b, c is a sliver
+  bool isSliver(const Point &a, const Point &b, const Point &c) const;
+  /// add the face a, b, c to m, split into at most pieces triangles if it is
+  /// a sliver. Returns the number of faces added.
+  std::size_t split(IndexedMesh &m, std::uint32_t a, std::uint32_t b,
+                    std::uint32_t c, unsigned int pieces) const;
+
+  double boxRatio;
+  double aspectRatio;
+  unsigned int maxPieces;
+  double diameter;
+  unsigned int bucketSize;
+  // results of the last run()
+  std::size_t splitFaces;
+  std::size_t addedFaces;
+  double candidatesBefore;
+  double candidatesAfter;
+};
+
+} // namespace ocl
+#endif
+// end file sliversplitter.hpp
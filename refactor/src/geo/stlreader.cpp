@@ -21,11 +21,17 @@
  *  You should have received a copy of the GNU Lesser General Public License
  *  along with this program. If not, see <http://www.gnu.org/licenses/>.
 */
-#include <fstream>  // required by read_from_file()
-#include <sstream>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
 #include <cstring>
-#include <list>
+#include <functional>
+#include <mutex>
 
+#include <spdlog/spdlog.h>
+
+#include "common/executor.hpp"
+#include "common/mappedfile.hpp"
 #include "stlreader.hpp"
 #include "stlsurf.hpp"
 
@@ -42,111 +48,262 @@ namespace ocl
 
     using namespace std;
 
-    static std::string str_for_Ttc;
+    // binary STL: 80 byte header, uint32 facet count, then 50 bytes per facet
+    // (float normal[3], float vertex[3][3], uint16 attribute)
+    static const std::size_t binary_header = 84;
+    static const std::size_t binary_facet = 50;
 
-    /// consider renaming?
-    const char* Ttc(const wchar_t* str)
+    // a file is binary if its size matches the facet count in the header,
+    // even if the header starts with "solid" as some exporters write it,
+    // or if it does not start with "solid"
+    static bool is_binary(const MappedFile& file)
     {
-        // convert a wchar_t* string into a char* string
-        str_for_Ttc.clear();
-        while (*str)
-            str_for_Ttc.push_back((char) *str++);
-        return str_for_Ttc.c_str();
+        if (file.size() >= binary_header) {
+            std::uint32_t num_facets;
+            memcpy(&num_facets, file.data() + 80, 4);
+            if (binary_header + binary_facet * std::uint64_t(num_facets) == file.size())
+                return true;
+        }
+        return file.size() < 5 || strncmp(file.data(), "solid", 5) != 0;
     }
 
     void STLReader::read_from_file(const wchar_t* filepath, STLSurf& surface) {
-        // read the stl file
-        std::ifstream ifs(Ttc(filepath), ios::binary);
-        if(!ifs)return;
-
-        char solid_string[6] = "aaaaa";
-        ifs.read(solid_string, 5);
-        if(ifs.eof())return;
-        if(strcmp(solid_string, "solid"))
-        {
-            // try binary file read
-
-            // read the header
-            char header[81];
-            header[80] = 0;
-            memcpy(header, solid_string, 5);
-            ifs.read(&header[5], 75);
-
-            unsigned int num_facets = 0;
-            ifs.read((char*)(&num_facets), 4);
-
-            for(unsigned int i = 0; i<num_facets; i++)
-            {
-                float n[3];
-                float x[3][3];
-                ifs.read((char*)(n), 12);
-                ifs.read((char*)(x[0]), 36);
-                short attr;
-                ifs.read((char*)(&attr), 2);
-                surface.addTriangle(Triangle(Point(x[0][0], x[0][1], x[0][2]), 
-                    Point(x[1][0], x[1][1], x[1][2]), 
-                    Point(x[2][0], x[2][1], x[2][2])));
+        MappedFile file(filepath);
+        if (!file.isOpen() || file.size() < 5)
+            return;
+        surface.indexes.clear();  // the indexes do not cover the new faces
+        if (is_binary(file))
+            read_binary(file, surface);
+        else
+            read_ascii(file, surface);
+    }
+
+    // number of complete facets in a binary file, checked against its size
+    static std::size_t binary_facets(const MappedFile& file) {
+        if (file.size() < binary_header)
+            return 0;
+        std::uint32_t num_facets = 0;
+        memcpy(&num_facets, file.data() + 80, 4);
+        const std::size_t available = (file.size() - binary_header) / binary_facet;
+        if (num_facets > available) {
+            spdlog::warn("STLReader: header claims {} facets but the file holds {}, "
+                         "reading {}", num_facets, available, available);
+            return available;
+        } else if (num_facets < available) {
+            spdlog::warn("STLReader: {} bytes after the {} facets of the header are ignored",
+                         file.size() - binary_header - binary_facet * num_facets, num_facets);
+        }
+        return num_facets;
+    }
+
+    // decode facets [first, first + count) of a binary file and append them
+    static void decode_binary(const MappedFile& file, std::size_t first, std::size_t count,
+                              STLSurf& surface) {
+        // decode each facet into its own three vertices and its face, in
+        // parallel; facet i only writes vertices 3i..3i+2 and face i
+        IndexedMesh& mesh = surface.mesh;
+        const std::size_t v0 = mesh.vertexCount();
+        const std::size_t f0 = mesh.size();
+        mesh.resize(v0 + 3 * count, f0 + count);
+        const char* facets = file.data() + binary_header + binary_facet * first;
+        std::mutex bb_mutex;
+        Executor executor;
+        executor.parallel_for(count, [&](std::size_t begin, std::size_t end) {
+            Bbox bb;
+            for (std::size_t i = begin; i != end; ++i) {
+                float x[9];
+                memcpy(x, facets + binary_facet * i + 12, 36);  // skip the normal
+                const std::uint32_t v = static_cast<std::uint32_t>(v0 + 3 * i);
+                for (int k = 0; k < 3; ++k) {
+                    Point p(x[3 * k], x[3 * k + 1], x[3 * k + 2]);
+                    mesh.setVertex(v + k, p);
+                    bb.addPoint(p);
+                }
+                mesh.setFace(f0 + i, v, v + 1, v + 2);
             }
+            std::lock_guard<std::mutex> lock(bb_mutex);
+            surface.bb.addPoint(bb.minpt);
+            surface.bb.addPoint(bb.maxpt);
+        });
+    }
+
+    void STLReader::read_binary(const MappedFile& file, STLSurf& surface) {
+        decode_binary(file, 0, binary_facets(file), surface);
+    }
+
+    // ASCII STL: "solid name", then per facet
+    //   facet normal nx ny nz / outer loop / vertex x y z (3x) / endloop / endfacet
+    // and "endsolid name". Only the vertices are used, keywords are matched as
+    // whitespace separated tokens so any indentation and CRLF line ends work.
+    static const std::size_t ascii_chunk = std::size_t(1) << 20;
+
+    static inline bool is_space(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+    }
+
+    static inline bool is_token(const char* p, const char* end, const char* word, std::size_t len) {
+        return std::size_t(end - p) >= len && memcmp(p, word, len) == 0
+            && (std::size_t(end - p) == len || is_space(p[len]));
+    }
+
+    // first "facet" token at or after p, so that chunks start on a facet
+    static const char* next_facet(const char* p, const char* begin, const char* end) {
+        while (end - p >= 5) {
+            p = static_cast<const char*>(memchr(p, 'f', end - p));
+            if (!p)
+                return end;
+            if ((p == begin || is_space(p[-1])) && is_token(p, end, "facet", 5))
+                return p;
+            ++p;
         }
-        else
-        {
-            // "solid" already found
-            char str[1024] = "solid";
-            ifs.getline(&str[5], 1024);
-            //char title[1024];
-            //if(sscanf(str, "solid %s", title) == 1)
-            //m_title.assign(Ctt(title));
-
-            float n[3];
-            float x[3][3];
-            char five_chars[6] = "aaaaa";
-
-            int vertex = 0;
-
-            while(!ifs.eof())
-            {
-                ifs.getline(str, 1024);
-
-                int i = 0, j = 0;
-                for(; i<5; i++, j++)
-                {
-                    if(str[j] == 0)break;
-                    while(str[j] == ' ' || str[j] == '\t')j++;
-                    five_chars[i] = str[j];
+        return end;
+    }
+
+    static inline bool parse_float(const char*& p, const char* end, float& v) {
+        while (p != end && is_space(*p))
+            ++p;
+        if (p != end && *p == '+')  // from_chars does not accept a leading '+'
+            ++p;
+        std::from_chars_result r = std::from_chars(p, end, v);
+        if (r.ec != std::errc())
+            return false;
+        p = r.ptr;
+        return true;
+    }
+
+    // parse the facets in [p, end) into xyz (9 floats per facet)
+    static void parse_ascii(const char* p, const char* end, std::vector<float>& xyz, Bbox& bb) {
+        float x[9];
+        int vertex = 0;
+        while (p != end) {
+            while (p != end && is_space(*p))
+                ++p;
+            const char* token = p;
+            while (p != end && !is_space(*p))
+                ++p;
+            const std::size_t len = p - token;
+            if (len == 6 && memcmp(token, "vertex", 6) == 0) {
+                float* v = x + 3 * std::min(vertex, 2);
+                if (parse_float(p, end, v[0]) && parse_float(p, end, v[1]) && parse_float(p, end, v[2]))
+                    ++vertex;
+            } else if (len == 5 && memcmp(token, "facet", 5) == 0) {
+                vertex = 0;
+            } else if (len == 8 && memcmp(token, "endfacet", 8) == 0) {
+                if (vertex == 3) {
+                    xyz.insert(xyz.end(), x, x + 9);
+                    for (int k = 0; k < 3; ++k)
+                        bb.addPoint(Point(x[3 * k], x[3 * k + 1], x[3 * k + 2]));
                 }
-                if(i == 5)
-                {
-                    if(!strcmp(five_chars, "verte"))
-                    {
-#ifdef WIN32
-                        sscanf_s(str, " vertex %f %f %f", &(x[vertex][0]), &(x[vertex][1]), &(x[vertex][2]));
-#else
-                        sscanf(str, " vertex %f %f %f", &(x[vertex][0]), &(x[vertex][1]), &(x[vertex][2]));
-#endif
-                        vertex++;
-                        if(vertex > 2)vertex = 2;
-                    }
-                    else if(!strcmp(five_chars, "facet"))
-                    {
-#ifdef WIN32
-                        sscanf_s(str, " facet normal %f %f %f", &(n[0]), &(n[1]), &(n[2]));
-#else
-                        sscanf(str, " facet normal %f %f %f", &(n[0]), &(n[1]), &(n[2]));
-#endif
-                        vertex = 0;
-                    }
-                    else if(!strcmp(five_chars, "endfa"))
-                    {
-                        if(vertex == 2)
-                        {
-                            surface.addTriangle(Triangle(Point(x[0][0], x[0][1], x[0][2]), 
-                                Point(x[1][0], x[1][1], x[1][2]), 
-                                Point(x[2][0], x[2][1], x[2][2])));
-                        }
-                    }
+                vertex = 0;
+            } else if ((len == 5 && memcmp(token, "solid", 5) == 0)
+                       || (len == 8 && memcmp(token, "endsolid", 8) == 0)) {
+                // the name runs to the end of the line
+                const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+                p = eol ? eol : end;
+            }
+        }
+    }
+
+    // split the file into chunks of about ascii_chunk bytes, each starting
+    // on a "facet" token; chunk c is [cuts[c], cuts[c + 1])
+    static std::vector<const char*> ascii_cuts(const MappedFile& file) {
+        const char* text = file.data();
+        const char* text_end = text + file.size();
+        std::vector<const char*> cuts(1, text);
+        while (cuts.back() != text_end) {
+            const char* p = cuts.back();
+            cuts.push_back(std::size_t(text_end - p) > ascii_chunk
+                           ? next_facet(p + ascii_chunk, text, text_end) : text_end);
+        }
+        return cuts;
+    }
+
+    // parse chunks [c0, c1) in parallel and append their facets in file order
+    static void parse_ascii_chunks(const std::vector<const char*>& cuts, std::size_t c0,
+                                   std::size_t c1, STLSurf& surface) {
+        const std::size_t chunks = c1 - c0;
+        std::vector<std::vector<float>> xyz(chunks);
+        std::vector<Bbox> bbs(chunks);
+        Executor executor;
+        executor.setGrainSize(1);
+        executor.setPartitioner(Executor::SIMPLE);
+        executor.parallel_for(chunks, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t c = begin; c != end; ++c) {
+                xyz[c].reserve((cuts[c0 + c + 1] - cuts[c0 + c]) / 24);
+                parse_ascii(cuts[c0 + c], cuts[c0 + c + 1], xyz[c], bbs[c]);
+            }
+        });
+
+        std::vector<std::size_t> first(chunks + 1, 0);
+        for (std::size_t c = 0; c < chunks; ++c)
+            first[c + 1] = first[c] + xyz[c].size() / 9;
+        IndexedMesh& mesh = surface.mesh;
+        const std::size_t v0 = mesh.vertexCount();
+        const std::size_t f0 = mesh.size();
+        mesh.resize(v0 + 3 * first[chunks], f0 + first[chunks]);
+        executor.parallel_for(chunks, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t c = begin; c != end; ++c) {
+                const float* x = xyz[c].data();
+                for (std::size_t i = first[c]; i != first[c + 1]; ++i, x += 9) {
+                    const std::uint32_t v = static_cast<std::uint32_t>(v0 + 3 * i);
+                    for (int k = 0; k < 3; ++k)
+                        mesh.setVertex(v + k, Point(x[3 * k], x[3 * k + 1], x[3 * k + 2]));
+                    mesh.setFace(f0 + i, v, v + 1, v + 2);
                 }
+                std::vector<float>().swap(xyz[c]);
+            }
+        });
+        for (std::size_t c = 0; c < chunks; ++c) {
+            if (first[c + 1] != first[c]) {
+                surface.bb.addPoint(bbs[c].minpt);
+                surface.bb.addPoint(bbs[c].maxpt);
+            }
+        }
+    }
+
+    void STLReader::read_ascii(const MappedFile& file, STLSurf& surface) {
+        std::vector<const char*> cuts = ascii_cuts(file);
+        parse_ascii_chunks(cuts, 0, cuts.size() - 1, surface);
+    }
+
+    bool STLReader::read_blocks(const std::wstring& filepath, std::size_t blockFaces,
+                                const std::function<void(STLSurf&)>& sink) {
+        MappedFile file(filepath);
+        if (!file.isOpen() || file.size() < 5)
+            return false;
+        blockFaces = std::max<std::size_t>(blockFaces, 1);
+        if (is_binary(file)) {
+            const std::size_t n = binary_facets(file);
+            for (std::size_t first = 0; first < n; first += blockFaces) {
+                STLSurf block;
+                decode_binary(file, first, std::min(blockFaces, n - first), block);
+                sink(block);
+            }
+        } else {
+            // about 250 bytes of text per facet
+            const std::vector<const char*> cuts = ascii_cuts(file);
+            const std::size_t step = std::max<std::size_t>(1, blockFaces * 250 / ascii_chunk);
+            for (std::size_t c = 0; c + 1 < cuts.size(); c += step) {
+                STLSurf block;
+                parse_ascii_chunks(cuts, c, std::min(c + step, cuts.size() - 1), block);
+                if (block.size())
+                    sink(block);
             }
         }
+        return true;
+    }
+
+    void STLReader::read_files(const std::vector<std::wstring>& paths,
+                               std::vector<STLSurf>& surfaces) {
+        surfaces.resize(paths.size());
+        // one file per task, each file is decoded in parallel as well
+        Executor executor;
+        executor.setGrainSize(1);
+        executor.setPartitioner(Executor::SIMPLE);
+        executor.parallel_for(paths.size(), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t k = begin; k != end; ++k)
+                STLReader(paths[k], surfaces[k]);
+        });
     }
 
 }
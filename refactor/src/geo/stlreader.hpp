@@ -22,18 +22,26 @@
 #ifndef STLREADER_H
 #define STLREADER_H
 
+#include <cstddef>
+#include <functional>
 #include <string>
+#include <vector>
 
 #include "ocl_export.hpp"
 
 namespace ocl {
 
+class MappedFile;
 class STLSurf;
 
-/// \brief STL file reader, reads an STL file and calls addTriangle on the
+/// \brief STL file reader, reads an STL file and adds its triangles to an
 /// STLSurf
 ///
-
+/// The file is memory-mapped. Binary files are decoded in parallel straight
+/// into STLSurf::mesh, the facet count in the header is checked against the
+/// file size. ASCII files are split into chunks at facet boundaries and the
+/// chunks are parsed in parallel into the same mesh. Readers keep no shared state, so several files can be read at
+/// the same time, see read_files().
 class OCL_API STLReader {
 public:
   STLReader(){};
@@ -41,10 +49,22 @@ public:
   STLReader(const std::wstring &filepath, STLSurf &surface);
   /// destructor
   virtual ~STLReader();
+  /// read paths[k] into surfaces[k], the files concurrently
+  static void read_files(const std::vector<std::wstring> &paths,
+                         std::vector<STLSurf> &surfaces);
+  /// \brief read the file in blocks of about blockFaces triangles and pass
+  /// each block to sink, in file order, so that files larger than memory can
+  /// be processed. Returns false if the file can not be opened.
+  static bool read_blocks(const std::wstring &filepath, std::size_t blockFaces,
+                          const std::function<void(STLSurf &)> &sink);
 
 private:
   /// read STL-surface from file
   void read_from_file(const wchar_t *filepath, STLSurf &surface);
+  /// decode the facets of a binary STL file
+  void read_binary(const MappedFile &file, STLSurf &surface);
+  /// parse the facets of an ASCII STL file
+  void read_ascii(const MappedFile &file, STLSurf &surface);
 };
 
 } // namespace ocl
@@ -20,24 +20,28 @@
  */
 
 #include <cassert>
-#include <list>
-
-
-#include <boost/foreach.hpp>
 
 #include "stlsurf.hpp"
 
 namespace ocl
 {
 
+STLSurf::STLSurf(const IndexedMesh& m) : mesh(m), tris(mesh)
+{
+    calcBB();
+}
+
 void STLSurf::addTriangle(const Point& p1, const Point& p2, const Point& p3)
 {
     // some sanity-checking:
     assert((p1 - p2).norm() > 0.0);
     assert((p2 - p3).norm() > 0.0);
     assert((p3 - p1).norm() > 0.0);
-    tris.emplace_back(p1, p2, p3);
-    bb.addTriangle(tris.back());
+    mesh.addTriangle(p1, p2, p3);
+    indexes.clear();
+    bb.addPoint(p1);
+    bb.addPoint(p2);
+    bb.addPoint(p3);
 }
 
 void STLSurf::addTriangle(const Triangle& t)
@@ -48,33 +52,67 @@ void STLSurf::addTriangle(const Triangle& t)
     assert((t.p[1] - t.p[2]).norm() > 0.0);
     assert((t.p[2] - t.p[0]).norm() > 0.0);
 
-    tris.push_back(t);
+    mesh.addTriangle(t.p[0], t.p[1], t.p[2]);
+    indexes.clear();
     bb.addTriangle(t);
-    return;
+}
+
+void STLSurf::append(const STLSurf& s)
+{
+    mesh.append(s.mesh);
+    indexes.clear();
+    if (s.size()) {
+        bb.addPoint(s.bb.minpt);
+        bb.addPoint(s.bb.maxpt);
+    }
 }
 
 void STLSurf::rotate(double xr, double yr, double zr)
 {
-    // std::cout << " before " << t << "\n";
+    mesh.rotate(xr, yr, zr);
+    indexes.clear();
+    calcBB();
+}
+
+std::size_t STLSurf::weld(double tol)
+{
+    std::size_t removed = mesh.weld(tol);
+    indexes.clear();
+    calcBB();
+    return removed;
+}
+
+const MeshIndex& STLSurf::addIndex(MeshIndex::Plane p, unsigned int bucket)
+{
+    auto index = std::make_shared<const MeshIndex>(mesh, p, bucket);
+    for (auto& old : indexes) {
+        if (old->plane == p && old->bucketSize == bucket) {
+            old = index;
+            return *index;
+        }
+    }
+    indexes.push_back(index);
+    return *index;
+}
+
+void STLSurf::calcBB()
+{
     bb.clear();
-    BOOST_FOREACH (Triangle& t, tris) {
-        // std::cout << " before " << t << "\n";
-        t.rotate(xr, yr, zr);
-        // std::cout << " after " << t << "\n";
-        // char c;
-        // std::cin >> c;
-        bb.addTriangle(t);
+    for (std::size_t f = 0; f < mesh.size(); ++f) {
+        Bbox fb = mesh.bounds(f);
+        bb.addPoint(fb.minpt);
+        bb.addPoint(fb.maxpt);
     }
 }
 
 unsigned int STLSurf::size() const
 {
-    return static_cast<unsigned int>(tris.size());
+    return static_cast<unsigned int>(mesh.size());
 }
 
 std::ostream& operator<<(std::ostream& stream, const STLSurf s)
 {
-    stream << "STLSurf(N=" << s.tris.size() << ")";
+    stream << "STLSurf(N=" << s.mesh.size() << ")";
     return stream;
 }
 
@@ -21,9 +21,13 @@
 #ifndef STLSURF_H
 #define STLSURF_H
 
-#include <list>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include "bbox.hpp"
+#include "indexedmesh.hpp"
+#include "meshindex.hpp"
 #include "triangle.hpp"
 
 
@@ -36,26 +40,73 @@ class Point;
 /// STL surfaces consist of triangles. There is by definition no structure
 /// or order among the triangles, i.e. they can be positioned or connected in
 /// arbitrary ways.
+///
+/// The triangles are stored in an IndexedMesh. tris is a view over the mesh
+/// that yields each face as a Triangle, so the surface can still be used as a
+/// list of triangles.
+///
+/// Prebuilt kd-tree indexes can be attached with addIndex() or loaded with
+/// MeshSnapshot; Operation::setSTL() then restores its kd-tree from a
+/// matching index instead of building it.
 class OCL_API STLSurf {
 public:
   /// Create an empty STL-surface
-  STLSurf(){};
+  STLSurf() : tris(mesh){};
+  /// Create a surface over the faces of mesh m
+  explicit STLSurf(const IndexedMesh &m);
+  STLSurf(const STLSurf &s)
+      : mesh(s.mesh), tris(mesh), bb(s.bb), indexes(s.indexes) {}
+  STLSurf(STLSurf &&s)
+      : mesh(std::move(s.mesh)), tris(mesh), bb(s.bb),
+        indexes(std::move(s.indexes)) {}
+  STLSurf &operator=(const STLSurf &s) {
+    mesh = s.mesh;
+    bb = s.bb;
+    indexes = s.indexes;
+    return *this;
+  }
+  STLSurf &operator=(STLSurf &&s) {
+    mesh = std::move(s.mesh);
+    bb = s.bb;
+    indexes = std::move(s.indexes);
+    return *this;
+  }
   /// destructor
   virtual ~STLSurf(){};
   /// add Triangle with 3 points
   void addTriangle(const Point &p1, const Point &p2, const Point &p3);
   /// add Triangle t to this surface
   void addTriangle(const Triangle &t);
+  /// append the triangles of s to this surface
+  void append(const STLSurf &s);
   /// return number of triangles in surface
   unsigned int size() const;
   /// call Triangle::rotate on all triangles
   void rotate(double xr, double yr, double zr);
-  /// list of Triangles in this surface
-  std::list<Triangle> tris;
+  /// \brief share vertices closer than tol between triangles, see
+  /// IndexedMesh::weld(). Call after loading, before building an Operation.
+  /// Returns the number of vertices removed.
+  std::size_t weld(double tol);
+  /// \brief build a kd-tree index of the faces for search plane p and
+  /// bucket-size bucket and attach it, replacing an index with the same
+  /// plane and bucket-size. Returns the index.
+  const MeshIndex &addIndex(MeshIndex::Plane p, unsigned int bucket);
+  /// vertices and faces of this surface
+  IndexedMesh mesh;
+  /// the faces of mesh as a read-only sequence of Triangles
+  TriangleView<IndexedMesh> tris;
   /// bounding-box
   Bbox bb;
+  /// \brief kd-tree indexes of the faces, see addIndex(). Cleared by
+  /// addTriangle(), rotate() and weld(); clear them after changing mesh
+  /// directly.
+  std::vector<std::shared_ptr<const MeshIndex>> indexes;
   /// STLSurf string repr
   friend std::ostream &operator<<(std::ostream &stream, const STLSurf s);
+
+protected:
+  /// recompute bb from the bounds of all faces
+  void calcBB();
 };
 
 } // namespace ocl
@@ -0,0 +1,304 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <spdlog/spdlog.h>
+
+#include "common/mappedfile.hpp"
+#include "meshindex.hpp"
+#include "meshsnapshot.hpp"
+#include "stlreader.hpp"
+#include "stlsurf.hpp"
+#include "tiledmesh.hpp"
+
+namespace ocl
+{
+
+namespace
+{
+
+namespace fs = std::filesystem;
+
+const char magic[8] = {'O', 'C', 'L', 'T', 'I', 'L', 'E', 'S'};
+const std::uint32_t version = 1;
+const char* headerName = "tiledmesh.hdr";
+
+// the header file: this, then one uint64 face count per tile
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t bucketSize;
+    std::int32_t nx;
+    std::int32_t ny;
+    double x0;
+    double y0;
+    double tileSize;
+    double bb[6];
+    std::uint64_t faces;
+};
+
+// triangles of a tile waiting to be written, 9 coordinates each
+fs::path spillPath(const fs::path& dir, std::size_t k)
+{
+    return dir / ("tile_" + std::to_string(k) + ".spill");
+}
+
+}  // namespace
+
+int TiledMesh::column(double x) const
+{
+    const double c = std::floor((x - x0) / tileSize);
+    if (!(c > 0))
+        return 0;
+    return c < nx ? static_cast<int>(c) : nx - 1;
+}
+
+int TiledMesh::row(double y) const
+{
+    const double r = std::floor((y - y0) / tileSize);
+    if (!(r > 0))
+        return 0;
+    return r < ny ? static_cast<int>(r) : ny - 1;
+}
+
+std::wstring TiledMesh::tilePath(std::size_t k) const
+{
+    return (fs::path(directory) / ("tile_" + std::to_string(k) + ".oclmesh")).wstring();
+}
+
+bool TiledMesh::build(const std::wstring& stl, const std::wstring& dir, double tileSize,
+                      std::size_t budget, unsigned int bucket)
+{
+    // a block costs about 160 bytes per triangle, use a quarter of the budget
+    const std::size_t blockFaces = std::max<std::size_t>(1024, budget / 4 / 160);
+    return build(
+        [&](const std::function<void(const STLSurf&)>& sink) {
+            return STLReader::read_blocks(stl, blockFaces, sink);
+        },
+        dir, tileSize, budget, bucket);
+}
+
+bool TiledMesh::build(const STLSurf& s, const std::wstring& dir, double tileSize,
+                      std::size_t budget, unsigned int bucket)
+{
+    return build(
+        [&](const std::function<void(const STLSurf&)>& sink) {
+            sink(s);
+            return true;
+        },
+        dir, tileSize, budget, bucket);
+}
+
+bool TiledMesh::build(const std::function<bool(const std::function<void(const STLSurf&)>&)>& source,
+                      const std::wstring& dir, double tileSize, std::size_t budget,
+                      unsigned int bucket)
+{
+    assert(tileSize > 0.0);
+    const fs::path root(dir);
+    std::error_code ec;
+    fs::create_directories(root, ec);
+    if (ec) {
+        spdlog::warn("TiledMesh: can not create {}", narrowPath(dir));
+        return false;
+    }
+    // remove the tiles of an earlier build
+    for (const fs::directory_entry& e : fs::directory_iterator(root, ec)) {
+        if (e.path().filename().string().rfind("tile_", 0) == 0)
+            fs::remove(e.path(), ec);
+    }
+
+    // pass 1: bounds of the mesh, which fix the tile grid
+    TiledMesh t;
+    t.directory = dir;
+    t.tileSize = tileSize;
+    t.bucketSize = bucket;
+    bool ok = source([&](const STLSurf& block) {
+        if (block.size() == 0)
+            return;
+        t.bb.addPoint(block.bb.minpt);
+        t.bb.addPoint(block.bb.maxpt);
+        t.faces += block.size();
+    });
+    if (!ok)
+        return false;
+    t.x0 = t.faces ? t.bb.minpt.x : 0.0;
+    t.y0 = t.faces ? t.bb.minpt.y : 0.0;
+    const double nx = t.faces ? std::ceil((t.bb.maxpt.x - t.x0) / tileSize) : 1.0;
+    const double ny = t.faces ? std::ceil((t.bb.maxpt.y - t.y0) / tileSize) : 1.0;
+    if (nx * ny > double(1 << 22)) {
+        spdlog::warn("TiledMesh: {} x {} tiles of size {} is too many", nx, ny, tileSize);
+        return false;
+    }
+    t.nx = std::max(1, static_cast<int>(nx));
+    t.ny = std::max(1, static_cast<int>(ny));
+    const std::size_t ntiles = std::size_t(t.nx) * t.ny;
+    t.tileFaces.assign(ntiles, 0);
+
+    // pass 2: append each triangle to every tile its bounding-box overlaps,
+    // writing the buffered triangles to the spill files of the tiles when
+    // they take more than half the budget
+    std::vector<std::vector<double>> pending(ntiles);
+    std::size_t pendingBytes = 0;
+    auto flush = [&]() {
+        for (std::size_t k = 0; k < ntiles; ++k) {
+            if (pending[k].empty())
+                continue;
+            std::ofstream out(spillPath(root, k), std::ios::binary | std::ios::app);
+            out.write(reinterpret_cast<const char*>(pending[k].data()),
+                      pending[k].size() * sizeof(double));
+            ok = ok && bool(out);
+            std::vector<double>().swap(pending[k]);
+        }
+        pendingBytes = 0;
+    };
+    ok = source([&](const STLSurf& block) {
+        const IndexedMesh& m = block.mesh;
+        for (std::size_t f = 0; f < m.size(); ++f) {
+            double x[9];
+            for (int c = 0; c < 3; ++c) {
+                const Point p = m.vertex(m.index(f, c));
+                x[3 * c] = p.x;
+                x[3 * c + 1] = p.y;
+                x[3 * c + 2] = p.z;
+            }
+            const int i0 = t.column(m.bound(f, 0));
+            const int i1 = t.column(m.bound(f, 1));
+            const int j0 = t.row(m.bound(f, 2));
+            const int j1 = t.row(m.bound(f, 3));
+            for (int j = j0; j <= j1; ++j) {
+                for (int i = i0; i <= i1; ++i) {
+                    const std::size_t k = t.tile(i, j);
+                    pending[k].insert(pending[k].end(), x, x + 9);
+                    ++t.tileFaces[k];
+                    pendingBytes += sizeof(x);
+                }
+            }
+            if (pendingBytes > budget / 2)
+                flush();
+        }
+    }) && ok;
+    flush();
+    if (!ok) {
+        spdlog::warn("TiledMesh: writing the tiles to {} failed", narrowPath(dir));
+        return false;
+    }
+
+    // pass 3: turn each spill file into a snapshot with an XY index, one
+    // tile in memory at a time
+    for (std::size_t k = 0; k < ntiles && ok; ++k) {
+        const std::size_t n = t.tileFaces[k];
+        if (n == 0)
+            continue;
+        if (n * 400 > budget)
+            spdlog::warn("TiledMesh: tile {} holds {} triangles, more than the budget of {} bytes",
+                         k, n, budget);
+        std::vector<double> x(9 * n);
+        {
+            std::ifstream in(spillPath(root, k), std::ios::binary);
+            in.read(reinterpret_cast<char*>(x.data()), x.size() * sizeof(double));
+            ok = bool(in);
+        }
+        fs::remove(spillPath(root, k), ec);
+        IndexedMesh m;
+        m.resize(3 * n, n);
+        for (std::size_t f = 0; f < n; ++f) {
+            const std::uint32_t v = static_cast<std::uint32_t>(3 * f);
+            for (int c = 0; c < 3; ++c)
+                m.setVertex(v + c, Point(x[9 * f + 3 * c], x[9 * f + 3 * c + 1], x[9 * f + 3 * c + 2]));
+            m.setFace(f, v, v + 1, v + 2);
+        }
+        std::vector<double>().swap(x);
+        STLSurf s(m);
+        s.addIndex(MeshIndex::XY, bucket);
+        ok = ok && MeshSnapshot::save(t.tilePath(k), s);
+    }
+
+    Header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, magic, 8);
+    h.version = version;
+    h.bucketSize = bucket;
+    h.nx = t.nx;
+    h.ny = t.ny;
+    h.x0 = t.x0;
+    h.y0 = t.y0;
+    h.tileSize = tileSize;
+    for (unsigned int d = 0; d < 6; ++d)
+        h.bb[d] = t.faces ? t.bb[d] : 0.0;
+    h.faces = t.faces;
+    std::ofstream out(root / headerName, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char*>(t.tileFaces.data()),
+              t.tileFaces.size() * sizeof(std::uint64_t));
+    ok = ok && bool(out);
+    if (!ok)
+        spdlog::warn("TiledMesh: writing the tiles to {} failed", narrowPath(dir));
+    return ok;
+}
+
+bool TiledMesh::open(const std::wstring& dir)
+{
+    std::ifstream in(fs::path(dir) / headerName, std::ios::binary);
+    Header h;
+    in.read(reinterpret_cast<char*>(&h), sizeof(h));
+    if (!in || memcmp(h.magic, magic, 8) != 0 || h.version != version || h.nx < 1 || h.ny < 1
+        || !(h.tileSize > 0.0)) {
+        spdlog::warn("TiledMesh: {} holds no tiled mesh of version {}", narrowPath(dir), version);
+        return false;
+    }
+    std::vector<std::uint64_t> counts(std::size_t(h.nx) * h.ny);
+    in.read(reinterpret_cast<char*>(counts.data()), counts.size() * sizeof(std::uint64_t));
+    if (!in) {
+        spdlog::warn("TiledMesh: the header in {} is truncated", narrowPath(dir));
+        return false;
+    }
+    directory = dir;
+    nx = h.nx;
+    ny = h.ny;
+    x0 = h.x0;
+    y0 = h.y0;
+    tileSize = h.tileSize;
+    bucketSize = h.bucketSize;
+    faces = h.faces;
+    tileFaces.swap(counts);
+    bb = faces ? Bbox(h.bb[0], h.bb[1], h.bb[2], h.bb[3], h.bb[4], h.bb[5]) : Bbox();
+    return true;
+}
+
+bool TiledMesh::loadTile(std::size_t k, STLSurf& s) const
+{
+    assert(k < tileFaces.size());
+    if (tileFaces[k] == 0) {
+        s = STLSurf();
+        return true;
+    }
+    return MeshSnapshot::load(tilePath(k), s) && s.size() == tileFaces[k];
+}
+
+}  // namespace ocl
+// end file tiledmesh.cpp
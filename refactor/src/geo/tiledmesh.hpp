@@ -0,0 +1,124 @@
+/*  $Id$
+ *
+ *  Copyright (c) 2010 Anders Wallin (anders.e.e.wallin "at" gmail.com).
+ *
+ *  This file is part of OpenCAMlib
+ *  (see https://github.com/aewallin/opencamlib).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TILEDMESH_H
+#define TILEDMESH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "bbox.hpp"
+#include "ocl_export.hpp"
+
+namespace ocl {
+
+class STLSurf;
+
+/// \brief a triangle mesh split into square XY tiles stored on disk, for
+/// meshes that do not fit in memory.
+///
+/// The mesh lives in a directory: a header with the tile grid and one
+/// MeshSnapshot (.oclmesh) per non-empty tile, holding the triangles whose
+/// bounding-box overlaps the tile and an XY kd-tree index over them. A
+/// triangle crossing tile borders is stored in every tile it overlaps, so a
+/// tile can be searched on its own. Tiles are loaded one at a time with
+/// loadTile(), see TiledDropCutter.
+///
+/// build() streams the input through STLReader::read_blocks() twice (bounds,
+/// then tiling) and spills the tiles to disk when the buffered triangles
+/// exceed the memory budget, so the whole mesh is never in memory.
+class OCL_API TiledMesh {
+public:
+  TiledMesh() {}
+  /// \brief tile the STL file stl into square tiles of side tileSize and
+  /// write them to directory dir, which is created if needed. budget is the
+  /// memory, in bytes, the build may use; bucket is the bucket-size of the
+  /// kd-tree index of each tile. Returns false if a file can not be read or
+  /// written.
+  static bool build(const std::wstring &stl, const std::wstring &dir,
+                    double tileSize, std::size_t budget,
+                    unsigned int bucket = 1);
+  /// tile the surface s in the same way
+  static bool build(const STLSurf &s, const std::wstring &dir, double tileSize,
+                    std::size_t budget, unsigned int bucket = 1);
+  /// read the header of a tiled mesh in dir, return false on failure
+  bool open(const std::wstring &dir);
+  /// \brief load the triangles and the kd-tree index of tile k into s. An
+  /// empty tile gives an empty surface. Returns false on a read error.
+  bool loadTile(std::size_t k, STLSurf &s) const;
+
+  /// number of tiles along x and y
+  int tilesX() const { return nx; }
+  int tilesY() const { return ny; }
+  std::size_t tileCount() const { return tileFaces.size(); }
+  /// index of the tile in column i and row j
+  std::size_t tile(int i, int j) const {
+    return static_cast<std::size_t>(j) * nx + i;
+  }
+  /// column of the tiles containing x, clamped to the grid
+  int column(double x) const;
+  /// row of the tiles containing y, clamped to the grid
+  int row(double y) const;
+  /// number of triangles stored in tile k, counting shared triangles in
+  /// every tile
+  std::size_t faceCount(std::size_t k) const { return tileFaces[k]; }
+  /// number of triangles of the whole mesh
+  std::size_t faceCount() const { return faces; }
+  /// side length of a tile
+  double getTileSize() const { return tileSize; }
+  /// bucket-size of the kd-tree index of each tile
+  unsigned int getBucketSize() const { return bucketSize; }
+  /// bounding-box of the whole mesh
+  const Bbox &bounds() const { return bb; }
+
+protected:
+  /// \brief tile the triangles delivered by source, which calls its
+  /// argument once per block of triangles, twice in the same order
+  static bool
+  build(const std::function<bool(const std::function<void(const STLSurf &)> &)>
+            &source,
+        const std::wstring &dir, double tileSize, std::size_t budget,
+        unsigned int bucket);
+  /// file of tile k
+  std::wstring tilePath(std::size_t k) const;
+
+  /// the directory of the tiled mesh
+  std::wstring directory;
+  /// tile grid: nx * ny tiles of side tileSize from (x0, y0)
+  int nx{0};
+  int ny{0};
+  double x0{0};
+  double y0{0};
+  double tileSize{1};
+  unsigned int bucketSize{1};
+  /// triangles of the whole mesh
+  std::size_t faces{0};
+  /// triangles of each tile
+  std::vector<std::uint64_t> tileFaces;
+  /// bounding-box of the whole mesh
+  Bbox bb;
+};
+
+} // namespace ocl
+#endif
+// end file tiledmesh.hpp
@@ -47,13 +47,31 @@ Triangle::Triangle(Point p1, Point p2, Point p3)
     calcBB();
 }
 
+Triangle::Triangle(const Point& p1, const Point& p2, const Point& p3, const Point& normal,
+                   const Bbox& bbox)
+    : n(normal), bb(bbox)
+{
+    p[0] = p1;
+    p[1] = p2;
+    p[2] = p3;
+}
+
 Triangle::Triangle(const Triangle& t)
+    : n(t.n), bb(t.bb)
 {
     p[0] = t.p[0];
     p[1] = t.p[1];
     p[2] = t.p[2];
-    calcNormal();
-    calcBB();
+}
+
+Triangle& Triangle::operator=(const Triangle& t)
+{
+    p[0] = t.p[0];
+    p[1] = t.p[1];
+    p[2] = t.p[2];
+    n = t.n;
+    bb = t.bb;
+    return *this;
 }
 
 /// calculate bounding box values
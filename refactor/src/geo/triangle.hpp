@@ -39,12 +39,18 @@ public:
     Triangle();
     /// copy constructor
     Triangle(const Triangle& t);
+    /// copy assignment, takes the normal and bounding-box of t as they are
+    Triangle& operator=(const Triangle& t);
 
     /// destructor
     virtual ~Triangle()
     {}
     /// Create a triangle with the vertices p1, p2, and p3.
     Triangle(Point p1, Point p2, Point p3);
+    /// \brief Create a triangle with the vertices p1, p2, p3 and the given
+    /// normal and bounding-box, e.g. precomputed by an IndexedMesh.
+    Triangle(const Point& p1, const Point& p2, const Point& p3, const Point& normal,
+             const Bbox& bbox);
 
     /// return true if Triangle is sliced by a z-plane at z=zcut
     /// modify p1 and p2 so that they are intersections of the triangle edges
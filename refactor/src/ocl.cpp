@@ -20,19 +20,24 @@
  */
 
 #include "ocl.hpp"
-#ifdef _OPENMP
-#include <omp.h>
-#endif
+#include "common/threadbudget.hpp"
 #include "version_string.hpp"
 
 namespace ocl
 {
   int max_threads()
   {
-#ifdef _OPENMP
-    return omp_get_max_threads();
-#endif
-    return 1;
+    return static_cast<int>(ThreadBudget::getMaxThreads());
+  }
+
+  void set_max_threads(int n)
+  {
+    ThreadBudget::setMaxThreads(n > 0 ? static_cast<unsigned int>(n) : 0);
+  }
+
+  void set_openmp_enabled(bool enabled)
+  {
+    ThreadBudget::setOpenMPEnabled(enabled);
   }
 
   std::string version()
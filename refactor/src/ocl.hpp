@@ -26,7 +26,12 @@
 #include "ocl_export.hpp"
 
 namespace ocl {
+/// the number of threads all Operations together may use
 OCL_API int max_threads();
+/// limit all Operations together to n threads, 0 for all hardware threads
+OCL_API void set_max_threads(int n);
+/// allow or forbid OpenMP; when forbidden all parallel work runs on TBB
+OCL_API void set_openmp_enabled(bool enabled);
 OCL_API std::string version();
 } // namespace ocl
 
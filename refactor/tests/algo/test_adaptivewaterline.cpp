@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include "../utils/triangles_utils.h"
+
+#include <cmath>
+#include <vector>
+
+#include "algo/adaptivewaterline.hpp"
+#include "algo/fiberpushcutter.hpp"
+#include "common/executor.hpp"
+#include "cutters/ballcutter.hpp"
+#include "geo/stlsurf.hpp"
+
+using namespace ocl;
+
+namespace
+{
+// 用于读取纤维
+class FiberAdaptiveWaterline: public AdaptiveWaterline
+{
+public:
+    const std::vector<Fiber>& getXFibers() const
+    {
+        return xfibers;
+    }
+    const std::vector<Fiber>& getYFibers() const
+    {
+        return yfibers;
+    }
+};
+
+// 用于调用不使用kd-tree的pushCutter1()
+class BruteFiberPushCutter: public FiberPushCutter
+{
+public:
+    using FiberPushCutter::pushCutter1;
+};
+
+struct Result {
+    std::vector<Fiber> x;
+    std::vector<Fiber> y;
+    std::vector<std::vector<Point>> loops;
+};
+
+Result runWaterline(const STLSurf& s, const Executor& e, int depth)
+{
+    BallCutter cutter(2.0, 10.0);
+    FiberAdaptiveWaterline awl;
+    awl.setExecutor(e);
+    awl.setSTL(s);
+    awl.setCutter(&cutter);
+    awl.setSampling(0.4);
+    awl.setZ(0.2);
+    awl.setTaskDepth(depth);
+    awl.run();
+    return {awl.getXFibers(), awl.getYFibers(), awl.getLoops()};
+}
+
+void expectSameFibers(const std::vector<Fiber>& a, const std::vector<Fiber>& b)
+{
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t n = 0; n < a.size(); ++n) {
+        EXPECT_EQ(a[n].p1, b[n].p1) << n;
+        EXPECT_EQ(a[n].p2, b[n].p2) << n;
+        ASSERT_EQ(a[n].ints.size(), b[n].ints.size()) << n;
+        for (size_t k = 0; k < a[n].ints.size(); ++k) {
+            EXPECT_EQ(a[n].ints[k].lower, b[n].ints[k].lower);
+            EXPECT_EQ(a[n].ints[k].upper, b[n].ints[k].upper);
+        }
+    }
+}
+}  // namespace
+
+TEST(AdaptiveWaterlineTests, SameFibersAndLoopsForAnyThreadsAndTaskDepth)
+{
+    STLSurf s = gridSurface(24, 0.5, [](double x, double y) {
+        return std::sin(0.8 * x) * std::cos(0.6 * y);
+    });
+    Result reference = runWaterline(s, Executor(Executor::SERIAL), 0);
+    EXPECT_GT(reference.x.size(), 10u);
+    EXPECT_GT(reference.loops.size(), 0u);
+
+    for (Executor::Backend b : {Executor::SERIAL, Executor::OPENMP, Executor::TBB}) {
+        for (int depth : {0, 2, 10}) {
+            Result r = runWaterline(s, Executor(b, 4), depth);
+            expectSameFibers(r.x, reference.x);
+            expectSameFibers(r.y, reference.y);
+            ASSERT_EQ(r.loops.size(), reference.loops.size()) << b << " " << depth;
+            for (size_t n = 0; n < r.loops.size(); ++n)
+                EXPECT_EQ(r.loops[n], reference.loops[n]) << b << " " << depth;
+        }
+    }
+}
+
+TEST(AdaptiveWaterlineTests, PushCutterCallsAreSummedOverFibers)
+{
+    STLSurf s = gridSurface(6, 1.0, [](double x, double) { return 0.1 * x; });
+    BallCutter cutter(1.0, 10.0);
+    BruteFiberPushCutter fpc;
+    fpc.setXDirection();
+    fpc.setSTL(s);
+    fpc.setCutter(&cutter);
+    Fiber a(Point(-2, 1.5, 0.2), Point(8, 1.5, 0.2));
+    Fiber b(Point(-2, 3.5, 0.2), Point(8, 3.5, 0.2));
+    fpc.pushCutter1(a);
+    fpc.pushCutter1(b);
+    EXPECT_EQ(fpc.getCalls(), 2 * static_cast<int>(s.size()));
+}
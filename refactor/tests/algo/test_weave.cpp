@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "algo/fiber.hpp"
+#include "algo/grid_contour.hpp"
+#include "algo/interval.hpp"
+#include "algo/simple_weave.hpp"
+#include "algo/smart_weave.hpp"
+#include "algo/sparse_weave.hpp"
+
+using namespace ocl;
+
+namespace {
+
+// 与顺序无关的环表示: 每个环旋转到最小点开始, 然后整体排序
+// reversed为true时先把每个环反向
+typedef std::vector<std::vector<std::pair<double, double>>> CanonicalLoops;
+
+CanonicalLoops canonical(const std::vector<std::vector<Point>>& loops, bool reversed = false)
+{
+    CanonicalLoops out;
+    for (const auto& loop : loops) {
+        std::vector<std::pair<double, double>> l;
+        for (const Point& p : loop) {
+            l.emplace_back(p.x, p.y);
+        }
+        if (reversed) {
+            std::reverse(l.begin(), l.end());
+        }
+        std::rotate(l.begin(), std::min_element(l.begin(), l.end()), l.end());
+        out.push_back(l);
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+// 暴露顶点数, 用于比较图的大小
+template<class W>
+class CountingWeave: public W
+{
+public:
+    unsigned int vertexCount() const
+    {
+        return this->g.num_vertices();
+    }
+};
+
+}  // namespace
+
+// 圆环区域 (r_in < r < r_out) 的纤维, 不需要STL模型
+class WeaveRingTest: public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        const int n = 81;
+        for (int i = 0; i < n; ++i) {
+            double c = -ext + 2 * ext * (i + 0.5) / n;
+            xfibers.push_back(ringFiber(Point(-ext, c, 0), Point(ext, c, 0), c));
+            yfibers.push_back(ringFiber(Point(c, -ext, 0), Point(c, ext, 0), c));
+        }
+    }
+
+    // 沿纤维 (另一坐标为c) 落在圆环内的区间
+    Fiber ringFiber(const Point& p1, const Point& p2, double c) const
+    {
+        Fiber f(p1, p2);
+        auto tval = [this](double s) { return (s + ext) / (2 * ext); };
+        if (std::fabs(c) >= r_out) {
+            return f;
+        }
+        double ro = std::sqrt(r_out * r_out - c * c);
+        if (std::fabs(c) >= r_in) {
+            Interval i(tval(-ro), tval(ro));
+            f.addInterval(i);
+        }
+        else {
+            double ri = std::sqrt(r_in * r_in - c * c);
+            Interval lo(tval(-ro), tval(-ri));
+            Interval hi(tval(ri), tval(ro));
+            f.addInterval(lo);
+            f.addInterval(hi);
+        }
+        return f;
+    }
+
+    template<class W>
+    CanonicalLoops loops(unsigned int& nv, int threads = 1, bool reversed = false)
+    {
+        CountingWeave<W> w;
+        w.setThreads(threads);
+        for (Fiber f : xfibers) {
+            w.addFiber(f);
+        }
+        for (Fiber f : yfibers) {
+            w.addFiber(f);
+        }
+        w.build();
+        nv = w.vertexCount();
+        w.face_traverse();
+        return canonical(w.getLoops(), reversed);
+    }
+
+    const double ext = 10.0;
+    const double r_in = 4.0;
+    const double r_out = 8.0;
+    std::vector<Fiber> xfibers;
+    std::vector<Fiber> yfibers;
+};
+
+// SparseWeave必须得到与SimpleWeave完全相同的环
+TEST_F(WeaveRingTest, SparseWeaveSameLoopsAsSimpleWeave)
+{
+    unsigned int nv_simple = 0;
+    unsigned int nv_sparse = 0;
+    CanonicalLoops simple = loops<weave::SimpleWeave>(nv_simple);
+    CanonicalLoops sparse = loops<weave::SparseWeave>(nv_sparse);
+
+    ASSERT_EQ(simple.size(), 2u);  // 外环和内环
+    EXPECT_EQ(simple, sparse);
+    // 内部交点不再创建, 图的大小应明显变小
+    EXPECT_LT(nv_sparse, nv_simple / 2);
+}
+
+// SmartWeave按tile并行建图, 在1个和多个线程下都与SimpleWeave得到相同的环
+// (SmartWeave的环方向一直与SimpleWeave相反)
+TEST_F(WeaveRingTest, SmartWeaveSameLoopsAsSimpleWeave)
+{
+    unsigned int nv_simple = 0;
+    CanonicalLoops simple = loops<weave::SimpleWeave>(nv_simple, 1, true);
+    for (int threads : {1, 4}) {
+        unsigned int nv_smart = 0;
+        EXPECT_EQ(loops<weave::SmartWeave>(nv_smart, threads), simple) << threads << " threads";
+        EXPECT_LT(nv_smart, nv_simple / 2);
+    }
+}
+
+// GridContour不建图, 直接从区间追踪, 结果应与SimpleWeave相同
+TEST_F(WeaveRingTest, GridContourSameLoopsAsSimpleWeave)
+{
+    unsigned int nv_simple = 0;
+    CanonicalLoops simple = loops<weave::SimpleWeave>(nv_simple);
+
+    weave::GridContour contour;
+    for (Fiber f : xfibers) {
+        contour.addFiber(f);
+    }
+    for (Fiber f : yfibers) {
+        contour.addFiber(f);
+    }
+    contour.build();
+    contour.face_traverse();
+
+    EXPECT_EQ(canonical(contour.getLoops()), simple);
+}
+
+#ifdef _OPENMP
+// Weave用num_threads子句指定线程数，不改变调用线程的OpenMP设置
+TEST_F(WeaveRingTest, KeepsOpenMPThreadSetting)
+{
+    const int before = omp_get_max_threads();
+    omp_set_num_threads(3);
+    unsigned int nv = 0;
+    loops<weave::SimpleWeave>(nv);
+    EXPECT_EQ(omp_get_max_threads(), 3);
+    omp_set_num_threads(before);
+}
+#endif
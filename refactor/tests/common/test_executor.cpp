@@ -0,0 +1,305 @@
+#include <gtest/gtest.h>
+
+#include "../utils/triangles_utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "common/executor.hpp"
+#include "common/threadbudget.hpp"
+#include "cutters/ballcutter.hpp"
+#include "dropcutter/batchdropcutter.hpp"
+#include "dropcutter/pathdropcutter.hpp"
+#include "geo/clpoint.hpp"
+#include "geo/stlsurf.hpp"
+#include "geo/triangle.hpp"
+#include "ocl.hpp"
+
+using namespace ocl;
+
+namespace {
+
+// 测试期间设置全局线程预算，结束后恢复默认值
+class ScopedBudget
+{
+public:
+    explicit ScopedBudget(unsigned int n) { ThreadBudget::setMaxThreads(n); }
+    ~ScopedBudget()
+    {
+        ThreadBudget::setMaxThreads(0);
+        ThreadBudget::setOpenMPEnabled(true);
+    }
+};
+
+std::vector<Executor> allExecutors()
+{
+    std::vector<Executor> v;
+    for (Executor::Backend b : {Executor::SERIAL, Executor::OPENMP, Executor::TBB}) {
+        for (Executor::Partitioner p : {Executor::AUTO, Executor::SIMPLE, Executor::STATIC}) {
+            Executor e(b, 4);
+            e.setPartitioner(p);
+            if (p == Executor::SIMPLE)
+                e.setGrainSize(7);
+            v.push_back(e);
+        }
+    }
+    return v;
+}
+
+// 斜面上的一排小三角形
+STLSurf rampSurface()
+{
+    return gridSurface(20, 1.0, [](double x, double) { return 0.3 * x; });
+}
+
+}  // namespace
+
+TEST(ExecutorTests, ParallelForCoversRangeOnce)
+{
+    ScopedBudget budget(4);
+    for (const Executor& e : allExecutors()) {
+        const size_t n = 1000;
+        std::vector<std::atomic<int>> hits(n);
+        for (auto& h : hits)
+            h = 0;
+        e.parallel_for(n, [&](size_t begin, size_t end) {
+            ASSERT_LT(begin, end);
+            for (size_t k = begin; k != end; ++k)
+                ++hits[k];
+        });
+        for (size_t k = 0; k < n; ++k)
+            EXPECT_EQ(hits[k], 1) << "backend " << e.getBackend() << " partitioner "
+                                  << e.getPartitioner();
+        // 空区间不调用body
+        e.parallel_for(0, [&](size_t, size_t) {
+            FAIL();
+        });
+    }
+}
+
+TEST(ExecutorTests, InvokeRunsBothInsideExecute)
+{
+    ScopedBudget budget(4);
+    for (const Executor& e : allExecutors()) {
+        // 递归二分求和，检验fork-join在各后端下都正确
+        std::function<long(long, long)> sum = [&](long lo, long hi) -> long {
+            if (hi - lo < 16) {
+                long s = 0;
+                for (long k = lo; k < hi; ++k)
+                    s += k;
+                return s;
+            }
+            long mid = (lo + hi) / 2;
+            long a = 0;
+            long b = 0;
+            e.invoke([&] { a = sum(lo, mid); }, [&] { b = sum(mid, hi); });
+            return a + b;
+        };
+        long total = 0;
+        e.execute([&] { total = sum(0, 5000); });
+        EXPECT_EQ(total, 5000L * 4999L / 2);
+    }
+}
+
+TEST(ExecutorTests, SerialRunsOnOneThread)
+{
+    ScopedBudget budget(4);
+    Executor e(Executor::SERIAL, 8);
+    EXPECT_EQ(e.getThreads(), 1u);
+    EXPECT_EQ(Executor(Executor::TBB, 3).getThreads(), 3u);
+    EXPECT_GE(Executor().getThreads(), 1u);
+}
+
+TEST(ExecutorTests, OperationsGiveSameResultOnEveryBackend)
+{
+    ScopedBudget budget(4);
+    STLSurf surf = rampSurface();
+    BallCutter cutter(2.0, 10.0);
+
+    std::vector<CLPoint> reference;
+    for (const Executor& e : allExecutors()) {
+        BatchDropCutter bdc;
+        bdc.setExecutor(e);
+        bdc.setSTL(surf);
+        bdc.setCutter(&cutter);
+        for (double x = 0.5; x < 20; x += 0.7) {
+            for (double y = 0.5; y < 20; y += 0.9) {
+                CLPoint cl(x, y, -5);
+                bdc.appendPoint(cl);
+            }
+        }
+        bdc.run();
+        EXPECT_EQ(bdc.getExecutor().getBackend(), e.getBackend());
+        std::vector<CLPoint> result = bdc.getCLPoints();
+        if (reference.empty()) {
+            reference = result;
+            continue;
+        }
+        ASSERT_EQ(result.size(), reference.size());
+        for (size_t n = 0; n < result.size(); ++n)
+            EXPECT_EQ(result[n].z, reference[n].z);
+    }
+}
+
+TEST(ExecutorTests, SetThreadsAndExecutorOnOperation)
+{
+    ScopedBudget budget(4);
+    PathDropCutter pdc;
+    pdc.setThreads(3);
+    EXPECT_EQ(pdc.getThreads(), 3);
+    pdc.setExecutor(Executor(Executor::SERIAL));
+    EXPECT_EQ(pdc.getThreads(), 1);
+}
+
+TEST(ThreadBudgetTests, BudgetCapsEveryExecutor)
+{
+    ScopedBudget budget(2);
+    EXPECT_EQ(max_threads(), 2);
+    EXPECT_EQ(Executor(Executor::TBB, 8).getThreads(), 2u);
+    EXPECT_EQ(Executor(Executor::OPENMP).getThreads(), 2u);
+    EXPECT_EQ(Executor(Executor::TBB, 1).getThreads(), 1u);
+    set_max_threads(0);
+    EXPECT_GE(max_threads(), 1);
+}
+
+TEST(ThreadBudgetTests, TeamsLeaseWorkersFromOnePool)
+{
+    ScopedBudget budget(4);
+    // 预算4个线程：调用线程之外共3个工作线程
+    unsigned int a = ThreadBudget::acquire(3);
+    EXPECT_EQ(a, 3u);
+    unsigned int b = ThreadBudget::acquire(8);
+    EXPECT_EQ(b, 2u);
+    // 工作线程用完，只剩调用线程自己
+    unsigned int c = ThreadBudget::acquire(8);
+    EXPECT_EQ(c, 1u);
+    EXPECT_EQ(ThreadBudget::leasedWorkers(), 3u);
+    ThreadBudget::release(c);
+    ThreadBudget::release(b);
+    ThreadBudget::release(a);
+    EXPECT_EQ(ThreadBudget::leasedWorkers(), 0u);
+    {
+        ThreadLease lease(2);
+        EXPECT_EQ(lease.threads(), 2u);
+        EXPECT_EQ(ThreadBudget::leasedWorkers(), 1u);
+    }
+    EXPECT_EQ(ThreadBudget::leasedWorkers(), 0u);
+}
+
+TEST(ThreadBudgetTests, DisabledOpenMPRunsOnTBB)
+{
+    ScopedBudget budget(4);
+    ThreadBudget::setOpenMPEnabled(false);
+    EXPECT_EQ(Executor::defaultBackend(), Executor::TBB);
+
+    Executor e(Executor::OPENMP, 4);
+    const size_t n = 500;
+    std::vector<std::atomic<int>> hits(n);
+    for (auto& h : hits)
+        h = 0;
+    std::atomic<bool> inOpenMP {false};
+    e.parallel_for(n, [&](size_t begin, size_t end) {
+#ifdef _OPENMP
+        if (omp_in_parallel())
+            inOpenMP = true;
+#endif
+        for (size_t k = begin; k != end; ++k)
+            ++hits[k];
+    });
+    EXPECT_FALSE(inOpenMP);
+    for (size_t k = 0; k < n; ++k)
+        EXPECT_EQ(hits[k], 1);
+}
+
+TEST(ThreadBudgetTests, ConcurrentCallersShareTheBudget)
+{
+    ScopedBudget budget(2);
+    for (Executor::Backend b : {Executor::OPENMP, Executor::TBB}) {
+        // 两个调用线程同时各要4个线程，忙碌的线程数不超过 2 + 预算 - 1
+        std::atomic<int> busy {0};
+        std::atomic<int> peak {0};
+        auto job = [&] {
+            Executor e(b, 4);
+            e.setGrainSize(1);
+            e.parallel_for(16, [&](size_t, size_t) {
+                int now = ++busy;
+                int p = peak;
+                while (now > p && !peak.compare_exchange_weak(p, now)) {
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                --busy;
+            });
+        };
+        std::thread t1(job);
+        std::thread t2(job);
+        t1.join();
+        t2.join();
+        EXPECT_LE(peak, 3) << "backend " << b;
+        EXPECT_EQ(ThreadBudget::leasedWorkers(), 0u);
+    }
+}
+
+TEST(ThreadBudgetTests, MixedBackendsShareOnePool)
+{
+    ScopedBudget budget(2);
+    // 一个OpenMP任务和一个TBB任务同时各要4个线程，两者共用一个工作线程池，
+    // 忙碌的线程数不超过 2 + 预算 - 1
+    std::atomic<int> busy {0};
+    std::atomic<int> peak {0};
+    auto job = [&](Executor::Backend b) {
+        Executor e(b, 4);
+        e.setGrainSize(1);
+        for (int round = 0; round < 4; ++round) {
+            e.parallel_for(16, [&](size_t, size_t) {
+                int now = ++busy;
+                int p = peak;
+                while (now > p && !peak.compare_exchange_weak(p, now)) {
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                --busy;
+            });
+        }
+    };
+    std::thread t1(job, Executor::OPENMP);
+    std::thread t2(job, Executor::TBB);
+    t1.join();
+    t2.join();
+    EXPECT_LE(peak, 3);
+    EXPECT_EQ(ThreadBudget::leasedWorkers(), 0u);
+}
+
+TEST(ThreadBudgetTests, NestedTBBWorkStaysInItsArena)
+{
+    ScopedBudget budget(4);
+    Executor e(Executor::TBB, 4);
+    e.setGrainSize(1);
+    // arena中的嵌套并行不再另租工作线程
+    std::atomic<unsigned int> most {0};
+    e.execute([&] {
+        e.invoke(
+            [&] {
+                e.parallel_for(32, [&](size_t, size_t) {
+                    unsigned int now = ThreadBudget::leasedWorkers();
+                    unsigned int m = most;
+                    while (now > m && !most.compare_exchange_weak(m, now)) {
+                    }
+                });
+            },
+            [&] {
+                e.parallel_for(32, [&](size_t, size_t) {
+                    EXPECT_TRUE(ThreadBudget::inArena());
+                });
+            });
+    });
+    EXPECT_EQ(most, 3u);
+    EXPECT_EQ(ThreadBudget::leasedWorkers(), 0u);
+    EXPECT_FALSE(ThreadBudget::inArena());
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include "common/halfedgediagram.hpp"
+#include "geo/point.hpp"
+
+using namespace ocl;
+
+namespace {
+
+struct TestEdgeProps;
+typedef hedi::EdgeHandle TestEdge;
+
+struct TestVertexProps
+{
+    Point position;
+};
+
+struct TestEdgeProps
+{
+    TestEdge next;
+    TestEdge twin;
+    unsigned int face = 0;
+};
+
+struct TestFaceProps
+{
+    unsigned int idx = 0;
+    TestEdge edge;
+};
+
+typedef hedi::HEDIGraph<TestVertexProps, TestEdgeProps, TestFaceProps> TestGraph;
+
+}  // namespace
+
+// 删除的顶点/边的位置会被重用, 其它句柄保持有效
+TEST(HEDIGraphTest, RemovedSlotsAreReused)
+{
+    TestGraph g;
+    TestGraph::Vertex a = g.add_vertex();
+    TestGraph::Vertex b = g.add_vertex();
+    TestGraph::Vertex c = g.add_vertex();
+    g[c].position = Point(1, 2, 3);
+    g.add_edge(a, b);
+    g.add_edge(b, a);
+    TestGraph::Edge bc = g.add_edge(b, c);
+    EXPECT_EQ(g.num_vertices(), 3u);
+    EXPECT_EQ(g.num_edges(), 3u);
+    EXPECT_EQ(g.out_degree(b), 2u);
+    EXPECT_EQ(g.degree(b), 3u);
+    EXPECT_TRUE(g.has_edge(a, b));
+    EXPECT_FALSE(g.has_edge(a, c));
+
+    g.delete_vertex(a);
+    EXPECT_EQ(g.num_vertices(), 2u);
+    EXPECT_EQ(g.num_edges(), 1u);
+    EXPECT_EQ(g.out_edge(b), bc);
+    EXPECT_EQ(g.target(bc), c);
+    EXPECT_EQ(g[c].position, Point(1, 2, 3));
+
+    TestGraph::Vertex d = g.add_vertex();
+    EXPECT_EQ(d, a);  // 重用a的位置
+    EXPECT_EQ(g.out_degree(d), 0u);
+    EXPECT_EQ(g.vertices().size(), 3u);
+}
+
+// 在正方形的一条边上插入顶点, 两个面都应得到新的顶点
+TEST(HEDIGraphTest, InsertVertexInEdge)
+{
+    TestGraph g;
+    TestGraph::Vertex v[4];
+    for (int i = 0; i < 4; ++i) {
+        v[i] = g.add_vertex();
+    }
+    unsigned int inner = g.add_face();
+    unsigned int outer = g.add_face();
+    TestGraph::Edge e[4], t[4];
+    for (int i = 0; i < 4; ++i) {
+        e[i] = g.add_edge(v[i], v[(i + 1) % 4]);
+        t[i] = g.add_edge(v[(i + 1) % 4], v[i]);
+        g.twin_edges(e[i], t[i]);
+        g[e[i]].face = inner;
+        g[t[i]].face = outer;
+    }
+    for (int i = 0; i < 4; ++i) {
+        g[e[i]].next = e[(i + 1) % 4];
+        g[t[i]].next = t[(i + 3) % 4];
+    }
+    g[inner].edge = e[0];
+    g[outer].edge = t[0];
+
+    TestGraph::Vertex m = g.add_vertex();
+    g.insert_vertex_in_edge(m, e[0]);
+    EXPECT_EQ(g.num_edges(), 10u);
+    EXPECT_EQ(g.face_edges(inner).size(), 5u);
+    EXPECT_EQ(g.face_edges(outer).size(), 5u);
+    EXPECT_FALSE(g.has_edge(v[0], v[1]));
+    EXPECT_TRUE(g.has_edge(v[0], m));
+    EXPECT_TRUE(g.has_edge(m, v[1]));
+    EXPECT_EQ(g.adjacent_faces(m).size(), 2u);
+}
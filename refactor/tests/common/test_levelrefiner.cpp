@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "common/levelrefiner.hpp"
+
+using namespace ocl;
+
+namespace {
+
+// 测试样本: 参数t和函数值sin(8t)
+struct Sample
+{
+    double t = 0.0;
+    double v = 0.0;
+};
+
+typedef LevelRefiner<Sample> Refiner;
+
+double f(double t)
+{
+    return std::sin(8.0 * t);
+}
+
+// 中点偏离弦的距离小于tol时接受, 区间小于min_step时放弃
+Refiner::Decision decide(const Sample& start, const Sample& mid, const Sample& stop)
+{
+    const double tol = 1e-3;
+    const double min_step = 1e-2;
+    if (std::fabs(mid.v - 0.5 * (start.v + stop.v)) < tol)
+        return Refiner::ACCEPT;
+    if (stop.t - start.t > min_step)
+        return Refiner::SUBDIVIDE;
+    return Refiner::DISCARD;
+}
+
+// 对照: 深度优先递归
+void recurse(const Sample& start, const Sample& stop, std::vector<Sample>& out)
+{
+    Sample mid;
+    mid.t = start.t + (stop.t - start.t) / 2.0;
+    mid.v = f(mid.t);
+    switch (decide(start, mid, stop)) {
+        case Refiner::SUBDIVIDE:
+            recurse(start, mid, out);
+            recurse(mid, stop, out);
+            break;
+        case Refiner::ACCEPT:
+            out.push_back(stop);
+            break;
+        case Refiner::DISCARD:
+            break;
+    }
+}
+
+Sample sample(double t)
+{
+    Sample s;
+    s.t = t;
+    s.v = f(t);
+    return s;
+}
+
+}  // namespace
+
+// 按层细分的结果与深度优先递归相同, 每个根区间的输出按t递增排列
+TEST(LevelRefinerTest, MatchesDepthFirstOrder)
+{
+    Refiner refiner;
+    refiner.addRoot(0.0, 1.0, sample(0.0), sample(1.0));
+    refiner.addRoot(-1.0, 0.0, sample(-1.0), sample(0.0));
+    int batches = 0;
+    std::vector<std::vector<Sample>> out = refiner.run(
+        [](int, double t) {
+            Sample s;
+            s.t = t;
+            return s;
+        },
+        [&batches](std::vector<Sample>& samples) {
+            ++batches;
+            for (Sample& s : samples)
+                s.v = f(s.t);
+        },
+        [](int, const Sample& start, const Sample& mid, const Sample& stop) {
+            return decide(start, mid, stop);
+        });
+    EXPECT_EQ(batches, refiner.getLevels());
+    EXPECT_GT(batches, 3);
+
+    std::vector<Sample> expect[2];
+    recurse(sample(0.0), sample(1.0), expect[0]);
+    recurse(sample(-1.0), sample(0.0), expect[1]);
+    ASSERT_EQ(out.size(), 2u);
+    for (int r = 0; r < 2; ++r) {
+        ASSERT_EQ(out[r].size(), expect[r].size());
+        for (unsigned int n = 0; n < out[r].size(); ++n) {
+            EXPECT_EQ(out[r][n].t, expect[r][n].t);
+            EXPECT_EQ(out[r][n].v, expect[r][n].v);
+        }
+    }
+}
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <vector>
+
 #include "../utils/triangles_utils.h"
 #include "cutters/bullcutter.hpp"
 #include "geo/clpoint.hpp"
@@ -218,4 +221,34 @@ TEST(CuttersTests, BullCutterRandomPoints)
         EXPECT_NE(cl.getCC().type, NONE) << "Point (" << point.x << ", " << point.y << ", "
                                          << point.z << ") contact type is NONE";
     }
-}
\ No newline at end of file
+}
+TEST(CuttersTests, BullCutterWarmEdgeDrops)
+{
+    // 沿一排相邻的刀位点对几条斜边批量落刀：每条边从前一个刀位点的解热启动，
+    // 与每次都用默认初值的结果相同，椭圆求解的迭代次数更少
+    BullCutter cutter(6.0, 1.0, 20.0);
+    std::vector<DropEdge> edges(3);
+    edges[0].p1 = Point(-5, 1, 0);
+    edges[0].p2 = Point(5, 2, 4);
+    edges[1].p1 = Point(-4, -2, 3);
+    edges[1].p2 = Point(6, -1, -1);
+    edges[2].p1 = Point(2, -5, 1);
+    edges[2].p2 = Point(3, 5, 6);
+    for (DropEdge& e : edges)
+        e.t = NAN;
+
+    int warm_iters = 0;
+    int cold_iters = 0;
+    for (int n = 0; n <= 100; ++n) {
+        CLPoint warm(-1.0 + 0.02 * n, 0.1, -20);
+        CLPoint cold(warm);
+        EXPECT_EQ(cutter.edgeDrops(warm, edges, warm_iters), 3);
+        std::vector<DropEdge> fresh(edges);
+        for (DropEdge& e : fresh)
+            e.t = NAN;
+        cutter.edgeDrops(cold, fresh, cold_iters);
+        EXPECT_NEAR(warm.z, cold.z, 1e-12) << warm;
+        EXPECT_GT(warm.z, -20.0);
+    }
+    EXPECT_LT(warm_iters, cold_iters);
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "algo/fiber.hpp"
+#include "cutters/ellipse.hpp"
+#include "geo/point.hpp"
+
+using namespace ocl;
+
+namespace {
+
+// 暴露求解结果的测试类
+class TestEllipse : public Ellipse
+{
+public:
+    TestEllipse(Point& c, double a, double b, double offset) : Ellipse(c, a, b, offset) {}
+    Point oe1() const { return oePoint1(); }
+    Point oe2() const { return oePoint2(); }
+};
+
+}  // namespace
+
+// 标准落刀问题: 两个解的偏移椭圆点都在y=0上且关于y轴对称, 迭代次数在预算之内
+TEST(EllipseSolverTest, CanonicalDrop)
+{
+    const double a = 3.7, b = 1.0, offset = 2.0;
+    for (double y = -2.95; y <= 2.95; y += 0.25) {
+        Point center(0, y, 0);
+        TestEllipse e(center, a, b, offset);
+        int iters = e.solver();
+        EXPECT_LT(iters, 64);
+        EXPECT_NEAR(e.oe1().y, 0.0, 1e-9);
+        EXPECT_NEAR(e.oe2().y, 0.0, 1e-9);
+        EXPECT_NEAR(e.oe1().x, -e.oe2().x, 1e-9);
+    }
+    // 刀具边缘正好接触时, 解在区间端点 t=±1
+    Point center(0, b + offset, 0);
+    TestEllipse e(center, a, b, offset);
+    e.solver();
+    EXPECT_NEAR(e.oe1().y, 0.0, 1e-9);
+}
+
+// 批量求解: 刀位点移动一小步后, 从上一步的解热启动与用默认初值的结果相同, 迭代次数更少
+TEST(EllipseSolverTest, WarmStartedDrops)
+{
+    std::vector<EllipseDrop> drops;
+    for (int n = 0; n < 50; ++n) {
+        EllipseDrop d;
+        d.y = -1.9 + 0.07 * n;
+        d.a = 1.5 + 0.01 * n;
+        d.b = 0.5;
+        d.offset = 1.5;
+        d.t = NAN;
+        drops.push_back(d);
+    }
+    Ellipse::solve_drops(drops);
+    std::vector<EllipseDrop> warm(drops);
+    std::vector<EllipseDrop> cold(drops);
+    for (std::size_t n = 0; n < drops.size(); ++n) {
+        warm[n].y += 0.01;
+        cold[n].y += 0.01;
+        cold[n].t = NAN;
+    }
+    const int warm_iters = Ellipse::solve_drops(warm);
+    const int cold_iters = Ellipse::solve_drops(cold);
+    EXPECT_LT(warm_iters, cold_iters);
+    for (std::size_t n = 0; n < drops.size(); ++n) {
+        EXPECT_NEAR(warm[n].t, cold[n].t, 1e-12);
+        EXPECT_LT(warm[n].iters, 64);
+    }
+}
+
+// 推刀问题: 两个解的偏移椭圆点都在纤维上; 纤维不与偏移椭圆相交时无解
+TEST(EllipseSolverTest, AlignedPush)
+{
+    Point major(1, 1, 0);
+    major.xyNormalize();
+    Point minor = major.xyPerp();
+    Point center(0.3, -0.2, 1.0);
+    AlignedEllipse e(center, 2.5, 1.0, 1.5, major, minor);
+    for (double y = -3.5; y <= 3.1; y += 0.3) {  // 偏移椭圆的y范围约为[-3.60, 3.20]
+        Fiber f(Point(-10, y, 1.0), Point(10, y, 1.0));
+        ASSERT_TRUE(e.aligned_solver(f));
+        EXPECT_NEAR(e.oePoint1().y, y, 1e-9);
+        EXPECT_NEAR(e.oePoint2().y, y, 1e-9);
+        EXPECT_GT(std::fabs(e.oePoint1().x - e.oePoint2().x), 1e-6);
+    }
+    Fiber far(Point(-10, 8.0, 1.0), Point(10, 8.0, 1.0));
+    EXPECT_FALSE(e.aligned_solver(far));
+}
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "algo/batchpushcutter.hpp"
+#include "algo/fiber.hpp"
+#include "algo/interval.hpp"
+#include "cutters/ballcutter.hpp"
+#include "cutters/bullcutter.hpp"
+#include "cutters/cylcutter.hpp"
+#include "dropcutter/batchdropcutter.hpp"
+#include "geo/clpoint.hpp"
+#include "geo/stlsurf.hpp"
+#include "geo/triangle.hpp"
+
+using namespace ocl;
+
+namespace
+{
+// 随机三角形，包括细长的斜三角形（包围盒大、实际面积小）
+std::vector<Triangle> randomTriangles(int count, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> pos(-10.0, 10.0);
+    std::uniform_real_distribution<double> height(-3.0, 3.0);
+    std::vector<Triangle> tris;
+    for (int n = 0; n < count; ++n) {
+        Point a(pos(gen), pos(gen), height(gen));
+        Point b(pos(gen), pos(gen), height(gen));
+        Point c = a + 0.05 * (b - a) + Point(0.3, -0.2, height(gen));
+        tris.push_back(Triangle(a, b, c));
+    }
+    return tris;
+}
+
+// 沿对角线排列的细长三角形，组成一个斜坡
+STLSurf diagonalStrips()
+{
+    STLSurf s;
+    for (int k = -10; k <= 10; ++k) {
+        double o = 0.7 * k;
+        s.addTriangle(Triangle(Point(-10 + o, -10 - o, 0),
+                               Point(10 + o, 10 - o, 0.5 * k),
+                               Point(10 + o + 0.3, 10 - o - 0.3, 0.5 * k)));
+    }
+    return s;
+}
+}  // namespace
+
+TEST(OverlapTests, DiscNeverRejectsContact)
+{
+    BallCutter ball(4.0, 20.0);
+    CylCutter cyl(4.0, 20.0);
+    BullCutter bull(4.0, 0.5, 20.0);
+    const MillingCutter* cutters[] = {&ball, &cyl, &bull};
+    std::vector<Triangle> tris = randomTriangles(300, 1);
+
+    int rejected = 0;
+    for (const MillingCutter* cutter : cutters) {
+        for (const Triangle& t : tris) {
+            for (double x = -8; x <= 8; x += 1.7) {
+                for (double y = -8; y <= 8; y += 1.9) {
+                    CLPoint cl(x, y, -100);
+                    if (cutter->overlapsDisc(cl, t))
+                        continue;
+                    ++rejected;
+                    // 精确测试拒绝的三角形，降刀不会改变刀位点
+                    EXPECT_FALSE(cutter->dropCutter(cl, t));
+                    EXPECT_DOUBLE_EQ(cl.z, -100);
+                }
+            }
+        }
+    }
+    EXPECT_GT(rejected, 0);
+}
+
+TEST(OverlapTests, DiscRejectsDiagonalTriangle)
+{
+    CylCutter cutter(2.0, 10.0);
+    // 细长斜三角形：包围盒覆盖刀具，但三角形本身离刀具很远
+    Triangle t(Point(0, 0, 0), Point(10, 10, 0), Point(10.2, 9.8, 0));
+    CLPoint cl(8, 2, 0);
+    EXPECT_TRUE(cutter.overlaps(cl, t));
+    EXPECT_FALSE(cutter.overlapsDisc(cl, t));
+    // 刀具中心在三角形内部
+    CLPoint inside(9.9, 9.85, 0);
+    EXPECT_TRUE(cutter.overlapsDisc(inside, t));
+    // 刀具边缘刚好碰到顶点
+    CLPoint rim(11.2, 9.8, 0);
+    EXPECT_TRUE(cutter.overlapsDisc(rim, t));
+}
+
+TEST(OverlapTests, FiberNeverRejectsContact)
+{
+    // 推刀核心函数不检查刀具长度（由kd-tree搜索负责），所以刀具要足够长
+    BallCutter ball(4.0, 20.0);
+    CylCutter cyl(4.0, 20.0);
+    BullCutter bull(4.0, 0.5, 20.0);
+    const MillingCutter* cutters[] = {&ball, &cyl, &bull};
+    std::vector<Triangle> tris = randomTriangles(300, 2);
+
+    int rejected = 0;
+    for (const MillingCutter* cutter : cutters) {
+        for (const Triangle& t : tris) {
+            for (double z = -8; z <= 3; z += 1.3) {
+                for (double c = -8; c <= 8; c += 1.7) {
+                    Fiber fibers[] = {Fiber(Point(-15, c, z), Point(15, c, z)),
+                                      Fiber(Point(c, -15, z), Point(c, 15, z))};
+                    for (const Fiber& f : fibers) {
+                        if (cutter->overlapsFiber(f, t))
+                            continue;
+                        ++rejected;
+                        // 精确测试拒绝的三角形，推刀不会产生区间
+                        Interval i;
+                        EXPECT_FALSE(cutter->pushCutter(f, i, t));
+                        EXPECT_TRUE(i.empty());
+                    }
+                }
+            }
+        }
+    }
+    EXPECT_GT(rejected, 0);
+}
+
+TEST(OverlapTests, BatchDropCutterCountsSkippedCalls)
+{
+    STLSurf surf = diagonalStrips();
+    BallCutter cutter(2.0, 10.0);
+
+    for (bool tbb : {false, true}) {
+        BatchDropCutter bdc;
+        bdc.setForceUseTBB(tbb);
+        bdc.setSTL(surf);
+        bdc.setCutter(&cutter);
+        for (double x = -9; x <= 9; x += 0.9) {
+            for (double y = -9; y <= 9; y += 0.8) {
+                CLPoint cl(x, y, -20);
+                bdc.appendPoint(cl);
+            }
+        }
+        bdc.run();
+        EXPECT_GT(bdc.getSkippedCalls(), 0);
+
+        // 结果与不做任何剔除的逐三角形降刀一致
+        for (const CLPoint& cl : bdc.getCLPoints()) {
+            CLPoint ref(cl.x, cl.y, -20);
+            cutter.dropCutterSTL(ref, surf);
+            EXPECT_NEAR(cl.z, ref.z, 1e-12);
+        }
+    }
+}
+
+TEST(OverlapTests, BatchPushCutterCountsSkippedCalls)
+{
+    STLSurf surf = diagonalStrips();
+    CylCutter cutter(2.0, 20.0);
+
+    BatchPushCutter bpc;
+    bpc.setXDirection();
+    bpc.setSTL(surf);
+    bpc.setCutter(&cutter);
+    std::vector<Fiber> reference;
+    for (double z = -4; z <= 4; z += 0.7) {
+        for (double y = -12; y <= 12; y += 0.9) {
+            Fiber f(Point(-20, y, z), Point(20, y, z));
+            bpc.appendFiber(f);
+            reference.push_back(f);
+        }
+    }
+    bpc.run();
+    EXPECT_GT(bpc.getSkippedCalls(), 0);
+
+    // 结果与逐三角形推刀一致
+    std::vector<Fiber>& fibers = *bpc.getFibers();
+    ASSERT_EQ(fibers.size(), reference.size());
+    for (size_t n = 0; n < fibers.size(); ++n) {
+        for (const Triangle& t : surf.tris) {
+            Interval i;
+            cutter.pushCutter(reference[n], i, t);
+            reference[n].addInterval(i);
+        }
+        ASSERT_EQ(fibers[n].ints.size(), reference[n].ints.size());
+        for (size_t k = 0; k < fibers[n].ints.size(); ++k) {
+            EXPECT_DOUBLE_EQ(fibers[n].ints[k].lower, reference[n].ints[k].lower);
+            EXPECT_DOUBLE_EQ(fibers[n].ints[k].upper, reference[n].ints[k].upper);
+        }
+    }
+}
@@ -0,0 +1,336 @@
+#include <cmath>
+#include <vector>
+
+#include <boost/math/constants/constants.hpp>
+#include <gtest/gtest.h>
+
+#include "algo/fiber.hpp"
+#include "algo/interval.hpp"
+#include "cutters/ballcutter.hpp"
+#include "cutters/cylcutter.hpp"
+#include "cutters/profilecutter.hpp"
+#include "geo/clpoint.hpp"
+#include "geo/triangle.hpp"
+
+using namespace ocl;
+
+namespace {
+
+// 暴露受保护的查表函数和精确轮廓函数
+class ProfileProbe : public ProfileCutter
+{
+public:
+    using ProfileCutter::ProfileCutter;
+    using ProfileCutter::height;
+    using ProfileCutter::profile_height;
+    using ProfileCutter::profile_width;
+    using ProfileCutter::width;
+};
+
+// 球头轮廓的采样，角度均匀分布
+std::vector<DoublePair> ballProfile(double r, int n)
+{
+    std::vector<DoublePair> profile;
+    const double pi = boost::math::constants::pi<double>();
+    for (int k = 0; k <= n; ++k) {
+        double a = 0.5 * pi * k / n;
+        profile.push_back(DoublePair(r * sin(a), r - r * cos(a)));
+    }
+    return profile;
+}
+
+std::vector<Triangle> testTriangles()
+{
+    std::vector<Triangle> tris;
+    tris.push_back(Triangle(Point(0, 0, 0), Point(10, 0, 0), Point(0, 10, 0)));
+    tris.push_back(Triangle(Point(0, 0, 0), Point(10, 0, 5), Point(0, 10, 8)));
+    tris.push_back(Triangle(Point(-3, -2, 1), Point(7, 1, -2), Point(2, 9, 4)));
+    tris.push_back(Triangle(Point(1, 1, 0), Point(8, 2, 9), Point(3, 8, 1)));
+    tris.push_back(Triangle(Point(0, 0, 0), Point(10, 0, 0), Point(5, 0.5, 3)));
+    return tris;
+}
+
+// 在网格上比较两把刀具的drop cutter结果
+void compareDrop(const MillingCutter& ref, const MillingCutter& cutter, double tol)
+{
+    for (const Triangle& t : testTriangles()) {
+        for (double x = -4; x <= 12; x += 0.37) {
+            for (double y = -4; y <= 12; y += 0.41) {
+                CLPoint cl1(x, y, -100);
+                CLPoint cl2(x, y, -100);
+                bool hit1 = ref.dropCutter(cl1, t);
+                bool hit2 = cutter.dropCutter(cl2, t);
+                EXPECT_EQ(hit1, hit2) << "at (" << x << ", " << y << ") " << t;
+                EXPECT_NEAR(cl1.z, cl2.z, tol) << "at (" << x << ", " << y << ") " << t;
+            }
+        }
+    }
+}
+
+// 沿x和y方向的纤维比较push cutter区间
+void comparePush(const MillingCutter& ref, const MillingCutter& cutter, double tol)
+{
+    for (const Triangle& t : testTriangles()) {
+        for (double z = -3; z <= 9; z += 0.7) {
+            for (double c = -4; c <= 12; c += 0.43) {
+                Fiber fibers[2] = {Fiber(Point(-50, c, z), Point(50, c, z)),
+                                   Fiber(Point(c, -50, z), Point(c, 50, z))};
+                for (const Fiber& f : fibers) {
+                    Interval i1, i2;
+                    bool hit1 = ref.pushCutter(f, i1, t);
+                    bool hit2 = cutter.pushCutter(f, i2, t);
+                    if (hit1 != hit2) {
+                        // 相切附近, 半径差tol可以导致只有一把刀具接触到, 此时区间很短
+                        const Interval& i = hit1 ? i1 : i2;
+                        EXPECT_LE(100 * (i.upper - i.lower), 4 * sqrt(tol)) << f.str() << " " << t;
+                    }
+                    else if (hit1) {
+                        // 区间参数乘以纤维长度得到距离
+                        EXPECT_NEAR(100 * i1.lower, 100 * i2.lower, tol) << f.str() << " " << t;
+                        EXPECT_NEAR(100 * i1.upper, 100 * i2.upper, tol) << f.str() << " " << t;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// 几种非标准轮廓: 锥形, 燕尾(带台阶), 棒棒糖, 凹形
+std::vector<std::vector<DoublePair>> formProfiles()
+{
+    std::vector<std::vector<DoublePair>> profiles;
+    profiles.push_back({{0, 0}, {2, 2}});
+    profiles.push_back({{0, 0}, {3, 0}, {2, 1.5}, {1.2, 1.5}, {1.2, 4}});
+    std::vector<DoublePair> lollipop = ballProfile(2, 16);
+    for (int k = 15; k >= 0; --k) {
+        if (lollipop[k].first < 0.5)
+            break;
+        lollipop.push_back(DoublePair(lollipop[k].first, 4 - lollipop[k].second));
+    }
+    profiles.push_back(lollipop);
+    profiles.push_back({{0, 0}, {1, 1}, {2, 1.3}, {2.5, 1.4}});
+    return profiles;
+}
+
+// 竖直三角形上的最高点都在边上, 对三条边密集采样, 再在最佳采样附近三分搜索,
+// 得到参考的drop结果
+double sampledEdgeDrop(const ProfileProbe& cutter, const CLPoint& cl, const Triangle& t)
+{
+    double z = -1e9;
+    const int n = 2000;
+    for (int e = 0; e < 3; ++e) {
+        const Point& p1 = t.p[e];
+        const Point& p2 = t.p[(e + 1) % 3];
+        auto clz = [&](double u) {
+            Point p = p1 + u * (p2 - p1);
+            double r = cl.xyDistance(p);
+            return (r <= cutter.getRadius()) ? p.z - cutter.profile_height(r) : -1e9;
+        };
+        int best = 0;
+        double best_z = clz(0.0);
+        for (int k = 1; k <= n; ++k) {
+            double zk = clz(double(k) / n);
+            if (zk > best_z) {
+                best = k;
+                best_z = zk;
+            }
+        }
+        double lo = std::max(best - 1, 0) / double(n);
+        double hi = std::min(best + 1, n) / double(n);
+        for (int it = 0; it < 60; ++it) {
+            double m1 = lo + (hi - lo) / 3;
+            double m2 = hi - (hi - lo) / 3;
+            if (clz(m1) < clz(m2))
+                lo = m1;
+            else
+                hi = m2;
+        }
+        z = std::max(z, std::max(best_z, std::max(clz(lo), clz(hi))));
+    }
+    return z;
+}
+
+// 对三角形按重心坐标采样, 得到参考的push区间(以沿纤维的距离表示)
+bool sampledPush(const ProfileProbe& cutter, const Fiber& f, const Triangle& t,
+                 double& lower, double& upper)
+{
+    const int n = 90;
+    const Point perp = f.dir.xyPerp();
+    bool hit = false;
+    for (int a = 0; a <= n; ++a) {
+        for (int b = 0; a + b <= n; ++b) {
+            Point p = t.p[0] + (double(a) / n) * (t.p[1] - t.p[0])
+                + (double(b) / n) * (t.p[2] - t.p[0]);
+            double h = p.z - f.p1.z;
+            if (h < 0 || h > cutter.getLength())
+                continue;
+            double w = cutter.profile_width(h);
+            Point d = p - f.p1;
+            double e = d.x * perp.x + d.y * perp.y;
+            if (fabs(e) > w)
+                continue;
+            double x = d.x * f.dir.x + d.y * f.dir.y;
+            double ofs = sqrt(w * w - e * e);
+            lower = hit ? std::min(lower, x - ofs) : x - ofs;
+            upper = hit ? std::max(upper, x + ofs) : x + ofs;
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+}  // namespace
+
+TEST(ProfileCutterTests, Properties)
+{
+    std::vector<DoublePair> profile = {{0, 0}, {1.5, 0}, {2, 0.5}, {2, 3}};
+    ProfileCutter cutter(profile, 20);
+    EXPECT_DOUBLE_EQ(cutter.getDiameter(), 4.0);
+    EXPECT_DOUBLE_EQ(cutter.getRadius(), 2.0);
+    EXPECT_DOUBLE_EQ(cutter.getLength(), 20.0);
+    // 轮廓之上补上刀柄
+    EXPECT_EQ(cutter.getProfile().size(), 5u);
+}
+
+TEST(ProfileCutterTests, TableErrorBound)
+{
+    // 燕尾刀: 底部最宽, 向上收窄, 其中有一个水平台阶
+    std::vector<DoublePair> profile = {{0, 0}, {3, 0}, {2, 1.5}, {1.2, 1.5}, {1.2, 4}};
+    for (int cells : {8, 64, 1024}) {
+        ProfileProbe cutter(profile, 10, cells);
+        for (double r = 0; r <= cutter.getRadius(); r += 1e-3)
+            EXPECT_LE(fabs(cutter.height(r) - cutter.profile_height(r)),
+                      cutter.getHeightError() + 1e-12);
+        for (double h = 0; h <= 10; h += 1e-3)
+            EXPECT_LE(fabs(cutter.width(h) - cutter.profile_width(h)),
+                      cutter.getWidthError() + 1e-12);
+    }
+    // 光滑轮廓的误差随表格加密而减小
+    ProfileProbe coarse(ballProfile(2, 50), 10, 16);
+    ProfileProbe fine(ballProfile(2, 50), 10, 4096);
+    EXPECT_LT(fine.getHeightError(), coarse.getHeightError());
+    EXPECT_LT(fine.getHeightError(), 1e-3);
+    // 台阶处的宽度无法插值, 误差界必须如实反映
+    ProfileProbe dovetail(profile, 10, 4096);
+    EXPECT_GE(dovetail.getWidthError(), 0.3);
+}
+
+TEST(ProfileCutterTests, LollipopWidth)
+{
+    // 棒棒糖刀: 球心以上宽度回落到刀颈
+    std::vector<DoublePair> profile = ballProfile(2, 32);
+    for (int k = 31; k >= 0; --k) {
+        double r = profile[k].first;
+        double h = 4 - profile[k].second;
+        if (r < 0.5)
+            break;
+        profile.push_back(DoublePair(r, h));
+    }
+    ProfileProbe cutter(profile, 15);
+    EXPECT_DOUBLE_EQ(cutter.getRadius(), 2.0);
+    EXPECT_NEAR(cutter.profile_width(2), 2.0, 1e-12);
+    EXPECT_LT(cutter.profile_width(3.5), 1.5);
+    EXPECT_DOUBLE_EQ(cutter.profile_width(10), cutter.getProfile().back().first);
+    // 下落只看下包络
+    EXPECT_NEAR(cutter.profile_height(2), 2.0, 1e-12);
+
+    // 刀颈高度上的水平边: 只有刀颈半径起作用
+    Triangle t(Point(-10, 3, 3.9), Point(10, 3, 3.9), Point(0, 20, 3.9));
+    Fiber f(Point(0, -10, 0), Point(0, 10, 0));
+    Interval i;
+    EXPECT_TRUE(cutter.pushCutter(f, i, t));
+    double neck = cutter.profile_width(3.9);
+    EXPECT_NEAR(f.point(i.lower).y, 3 - neck, 1e-9);
+}
+
+TEST(ProfileCutterTests, PushMatchesSampledTriangle)
+{
+    std::vector<Triangle> tris = testTriangles();
+    tris.push_back(Triangle(Point(0, 0, 0), Point(10, 0, 5), Point(10, 0, -5)));
+    tris.push_back(Triangle(Point(1, 1, 1), Point(4, 9, 2.5), Point(4, 9, 6)));
+    for (const std::vector<DoublePair>& profile : formProfiles()) {
+        // 和其它刀具一样, 面推刀不考虑刀柄顶端, 因此刀具要高过所有三角形
+        ProfileProbe cutter(profile, 30);
+        for (const Triangle& t : tris) {
+            for (double z = -3; z <= 6; z += 1.1) {
+                for (double c = -2.9; c <= 11; c += 1.3) {
+                    Fiber fibers[2] = {Fiber(Point(-50, c, z), Point(50, c, z)),
+                                       Fiber(Point(c, -50, z), Point(c, 50, z))};
+                    for (const Fiber& f : fibers) {
+                        Interval i;
+                        bool hit = cutter.pushCutter(f, i, t);
+                        double lower = 0.0, upper = 0.0;
+                        if (!sampledPush(cutter, f, t, lower, upper))
+                            continue;
+                        // 采样区间必须被包含(不过切), 且与之相差不超过采样间距
+                        ASSERT_TRUE(hit) << cutter << " " << f.str() << " " << t;
+                        const double tol = cutter.getWidthError() + 1e-9;
+                        EXPECT_LE(100 * i.lower, lower + tol) << cutter << " " << f.str() << " " << t;
+                        EXPECT_GE(100 * i.upper, upper - tol) << cutter << " " << f.str() << " " << t;
+                        EXPECT_GE(100 * i.lower, lower - 0.7) << cutter << " " << f.str() << " " << t;
+                        EXPECT_LE(100 * i.upper, upper + 0.7) << cutter << " " << f.str() << " " << t;
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(ProfileCutterTests, MatchesCylCutter)
+{
+    std::vector<DoublePair> profile = {{0, 0}, {1.5, 0}};
+    ProfileCutter cutter(profile, 20);
+    CylCutter cyl(3, 20);
+    compareDrop(cyl, cutter, 1e-9);
+    comparePush(cyl, cutter, 1e-9);
+}
+
+TEST(ProfileCutterTests, FacetDropSupport)
+{
+    // 45度锥: 平面比锥面平缓时刀尖接触, 更陡时刀缘接触
+    std::vector<DoublePair> profile = {{0, 0}, {2, 2}};
+    ProfileCutter cutter(profile, 10);
+    for (double s : {0.0, 0.5, 0.99, 1.01, 2.0, 5.0}) {
+        Triangle t(Point(-20, -20, -20 * s), Point(20, -20, 20 * s), Point(0, 20, 0));
+        CLPoint cl(1, 0, -100);
+        EXPECT_TRUE(cutter.dropCutter(cl, t));
+        double expected = (s <= 1.0) ? s * 1 : s * 3 - 2;
+        EXPECT_NEAR(cl.z, expected, 1e-9) << "slope " << s;
+    }
+}
+
+TEST(ProfileCutterTests, EdgeDropMatchesSampledEdge)
+{
+    std::vector<Triangle> tris;
+    tris.push_back(Triangle(Point(0, 0, 0), Point(10, 0, 5), Point(10, 0, -5)));
+    tris.push_back(Triangle(Point(-3, -2, 1), Point(7, 3, 1), Point(-3, -2, -4)));
+    tris.push_back(Triangle(Point(1, 1, 0), Point(4, 9, 9), Point(4, 9, -3)));
+    for (const std::vector<DoublePair>& profile : formProfiles()) {
+        ProfileProbe cutter(profile, 10);
+        for (const Triangle& t : tris) {
+            for (double x = -3; x <= 11; x += 0.83) {
+                for (double y = -4; y <= 11; y += 0.77) {
+                    CLPoint cl(x, y, -100);
+                    cutter.dropCutter(cl, t);
+                    double ref = sampledEdgeDrop(cutter, cl, t);
+                    if (ref < -1e8) {
+                        EXPECT_DOUBLE_EQ(cl.z, -100);
+                        continue;
+                    }
+                    // 不能低于参考值(过切), 也不能明显高于参考值
+                    EXPECT_GE(cl.z, ref - cutter.getHeightError() - 1e-9) << cutter << " " << t;
+                    EXPECT_LE(cl.z, ref + cutter.getHeightError() + 1e-6) << cutter << " " << t;
+                }
+            }
+        }
+    }
+}
+
+TEST(ProfileCutterTests, MatchesBallCutter)
+{
+    // 采样球头的弦高误差约为 r*(pi/4n)^2/2
+    BallCutter ball(4, 20);
+    ProfileCutter cutter(ballProfile(2, 200), 20);
+    compareDrop(ball, cutter, 1e-4 + cutter.getHeightError());
+    comparePush(ball, cutter, 1e-3 + cutter.getWidthError());
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+#include "../utils/triangles_utils.h"
+
+#include <cmath>
+#include <vector>
+
+#include "cutters/ballcutter.hpp"
+#include "dropcutter/adaptivepathdropcutter.hpp"
+#include "dropcutter/pointdropcutter.hpp"
+#include "geo/clpoint.hpp"
+#include "geo/line.hpp"
+#include "geo/path.hpp"
+#include "geo/regionofinterest.hpp"
+#include "geo/stlsurf.hpp"
+
+using namespace ocl;
+
+namespace
+{
+// 20x20的起伏地形，网格间距0.5
+STLSurf wavySurface()
+{
+    return gridSurface(40, 0.5, [](double x, double y) { return std::sin(0.7 * x) * std::cos(0.5 * y); });
+}
+
+// 斜穿地形的几条直线
+Path crossingPath()
+{
+    Path path;
+    path.append(Line(Point(0.5, 1, 0), Point(19, 7.5, 0)));
+    path.append(Line(Point(19, 7.5, 0), Point(3, 18, 0)));
+    path.append(Line(Point(3, 18, 0), Point(3, 2, 0)));
+    return path;
+}
+
+// 原来的深度优先细分，每个点单独用PointDropCutter落刀
+class DepthFirstReference
+{
+public:
+    DepthFirstReference(PointDropCutter& p, double s, double mins, double cosl)
+        : pdc(p), sampling(s), min_sampling(mins), cosLimit(cosl)
+    {}
+    std::vector<CLPoint> run(const Path& path)
+    {
+        points.clear();
+        for (const Span* span : path.span_list) {
+            CLPoint start = span->getPoint(0.0);
+            CLPoint stop = span->getPoint(1.0);
+            pdc.run(start);
+            pdc.run(stop);
+            points.push_back(start);
+            sample(span, 0.0, 1.0, start, stop);
+        }
+        return points;
+    }
+
+private:
+    void sample(const Span* span, double start_t, double stop_t, const CLPoint& start_cl,
+                const CLPoint& stop_cl)
+    {
+        const double mid_t = start_t + (stop_t - start_t) / 2.0;
+        CLPoint mid_cl = span->getPoint(mid_t);
+        pdc.run(mid_cl);
+        const double fw_step = (stop_cl - start_cl).xyNorm();
+        if (fw_step > sampling || (!flat(start_cl, mid_cl, stop_cl) && fw_step > min_sampling)) {
+            sample(span, start_t, mid_t, start_cl, mid_cl);
+            sample(span, mid_t, stop_t, mid_cl, stop_cl);
+        }
+        else {
+            points.push_back(stop_cl);
+        }
+    }
+    bool flat(const CLPoint& a, const CLPoint& b, const CLPoint& c) const
+    {
+        CLPoint v1 = b - a;
+        CLPoint v2 = c - b;
+        v1.normalize();
+        v2.normalize();
+        return v1.dot(v2) > cosLimit;
+    }
+
+    PointDropCutter& pdc;
+    double sampling;
+    double min_sampling;
+    double cosLimit;
+    std::vector<CLPoint> points;
+};
+}  // namespace
+
+TEST(AdaptivePathDropCutterTests, SameAsDepthFirstPointDrops)
+{
+    STLSurf s = wavySurface();
+    BallCutter cutter(1.0, 10.0);
+    Path path = crossingPath();
+
+    AdaptivePathDropCutter apdc;
+    apdc.setSTL(s);
+    apdc.setCutter(&cutter);
+    apdc.setPath(&path);
+    apdc.setSampling(0.4);
+    apdc.setMinSampling(0.02);
+    apdc.run();
+    std::vector<CLPoint> pts = apdc.getPoints();
+
+    PointDropCutter pdc;
+    pdc.setSTL(s);
+    pdc.setCutter(&cutter);
+    std::vector<CLPoint> ref = DepthFirstReference(pdc, 0.4, 0.02, 0.999).run(path);
+
+    // 逐层批量落刀得到的点和顺序都与深度优先的结果相同
+    ASSERT_EQ(pts.size(), ref.size());
+    for (std::size_t n = 0; n < ref.size(); ++n) {
+        EXPECT_DOUBLE_EQ(pts[n].x, ref[n].x) << n;
+        EXPECT_DOUBLE_EQ(pts[n].y, ref[n].y) << n;
+        EXPECT_DOUBLE_EQ(pts[n].z, ref[n].z) << n;
+    }
+    // 起伏处比按最大步长均匀采样加密了
+    double length = 0;
+    for (const Span* span : path.span_list)
+        length += (span->getPoint(1.0) - span->getPoint(0.0)).xyNorm();
+    EXPECT_GT(pts.size(), 2 * static_cast<std::size_t>(length / 0.4));
+}
+
+TEST(AdaptivePathDropCutterTests, RegionAddsNoPoints)
+{
+    STLSurf s = wavySurface();
+    BallCutter cutter(1.0, 10.0);
+    Path path = crossingPath();
+
+    AdaptivePathDropCutter whole;
+    whole.setSTL(s);
+    whole.setCutter(&cutter);
+    whole.setPath(&path);
+    whole.setSampling(0.4);
+    whole.setMinSampling(0.02);
+    whole.run();
+    std::vector<CLPoint> all = whole.getPoints();
+
+    RegionOfInterest roi(Bbox(4, 14, 2, 12, 0, 0));
+    AdaptivePathDropCutter part;
+    part.setCutter(&cutter);
+    part.setROI(roi);
+    part.setSTL(s);
+    part.setPath(&path);
+    part.setSampling(0.4);
+    part.setMinSampling(0.02);
+    part.run();
+    std::vector<CLPoint> pts = part.getPoints();
+
+    // 跨过区域边界的线段不再加密到最小步长：区域内的每个点都是整个曲面上也有的点，高度相同
+    ASSERT_GT(pts.size(), 20u);
+    std::size_t inside = 0;
+    for (const CLPoint& a : all)
+        inside += roi.contains(a);
+    EXPECT_LE(pts.size(), inside);
+    std::size_t k = 0;
+    for (const CLPoint& p : pts) {
+        EXPECT_TRUE(roi.contains(p)) << p;
+        while (k < all.size() && (all[k].x != p.x || all[k].y != p.y))
+            ++k;
+        ASSERT_LT(k, all.size()) << p;
+        EXPECT_NEAR(all[k].z, p.z, 1e-9) << p;
+    }
+}
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#include "../utils/triangles_utils.h"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "cutters/ballcutter.hpp"
+#include "cutters/bullcutter.hpp"
+#include "cutters/conecutter.hpp"
+#include "cutters/cylcutter.hpp"
+#include "dropcutter/batchdropcutter.hpp"
+#include "geo/clpoint.hpp"
+#include "geo/stlsurf.hpp"
+#include "geo/triangle.hpp"
+
+using namespace ocl;
+
+namespace
+{
+// 起伏的网格曲面 z = sin(x/2) * cos(y/3)
+STLSurf wavySurface()
+{
+    return gridSurface(20, 1.0,
+                       [](double x, double y) { return 2.0 * std::sin(0.5 * x) * std::cos(y / 3.0); },
+                       -10.0, -10.0);
+}
+
+void appendGrid(BatchDropCutter& bdc)
+{
+    for (double x = -8; x <= 8; x += 0.45) {
+        for (double y = -8; y <= 8; y += 0.55) {
+            CLPoint cl(x, y, -10);
+            bdc.appendPoint(cl);
+        }
+    }
+}
+}  // namespace
+
+TEST(BatchDropCutterTests, RunCuttersMatchesSeparateRuns)
+{
+    STLSurf surf = wavySurface();
+    CylCutter cyl(2.0, 10.0);
+    BallCutter ball(3.0, 10.0);
+    BullCutter bull(4.0, 0.5, 10.0);
+    ConeCutter cone(2.0, 45.0 * M_PI / 180.0, 10.0);
+    // 留余量的刀具
+    std::unique_ptr<MillingCutter> offset(ball.offsetCutter(0.25));
+    std::vector<const MillingCutter*> cutters = {&cyl, &ball, &bull, &cone, offset.get()};
+
+    BatchDropCutter multi;
+    multi.setSTL(surf);
+    appendGrid(multi);
+    multi.runCutters(cutters);
+    // 输入点不变
+    for (const CLPoint& cl : multi.getCLPoints())
+        EXPECT_DOUBLE_EQ(cl.z, -10);
+
+    int separateCalls = 0;
+    for (size_t k = 0; k < cutters.size(); ++k) {
+        BatchDropCutter single;
+        single.setSTL(surf);
+        single.setCutter(cutters[k]);
+        appendGrid(single);
+        single.run();
+        separateCalls += single.getCalls();
+
+        std::vector<CLPoint> expected = single.getCLPoints();
+        std::vector<CLPoint> column = multi.getCLPoints(k);
+        ASSERT_EQ(column.size(), expected.size());
+        for (size_t n = 0; n < column.size(); ++n) {
+            EXPECT_DOUBLE_EQ(column[n].x, expected[n].x);
+            EXPECT_DOUBLE_EQ(column[n].y, expected[n].y);
+            EXPECT_DOUBLE_EQ(column[n].z, expected[n].z);
+        }
+    }
+    // 每把刀具的降刀调用次数和单独运行时相同
+    EXPECT_EQ(multi.getCalls(), separateCalls);
+}
+
+TEST(BatchDropCutterTests, SplitPointsMatchSequentialDrop)
+{
+    STLSurf surf = wavySurface();
+    // 大直径刀具，每个点有几百个候选三角形
+    BullCutter cutter(12.0, 2.0, 10.0);
+
+    BatchDropCutter whole;
+    whole.setForceUseTBB(true);
+    whole.setSTL(surf);
+    whole.setCutter(&cutter);
+    appendGrid(whole);
+    whole.run();
+
+    BatchDropCutter split;
+    split.setForceUseTBB(true);
+    split.setSplitThreshold(16);
+    split.setSTL(surf);
+    split.setCutter(&cutter);
+    appendGrid(split);
+    split.run();
+
+    std::vector<CLPoint> expected = whole.getCLPoints();
+    std::vector<CLPoint> result = split.getCLPoints();
+    ASSERT_EQ(result.size(), expected.size());
+    for (size_t n = 0; n < result.size(); ++n) {
+        // 拆分后的结果与逐个三角形顺序降刀完全相同，包括CC点
+        EXPECT_EQ(result[n].z, expected[n].z);
+        EXPECT_EQ(result[n].cc->x, expected[n].cc->x);
+        EXPECT_EQ(result[n].cc->y, expected[n].cc->y);
+        EXPECT_EQ(result[n].cc->z, expected[n].cc->z);
+        EXPECT_EQ(result[n].cc->type, expected[n].cc->type);
+    }
+}
+
+TEST(BatchDropCutterTests, SortByMaxZSavesCalls)
+{
+    STLSurf surf = wavySurface();
+    BallCutter cutter(6.0, 10.0);
+
+    for (bool tbb : {false, true}) {
+        BatchDropCutter treeOrder;
+        treeOrder.setForceUseTBB(tbb);
+        treeOrder.setSTL(surf);
+        treeOrder.setCutter(&cutter);
+        appendGrid(treeOrder);
+        treeOrder.run();
+
+        BatchDropCutter sorted;
+        sorted.setForceUseTBB(tbb);
+        sorted.setSTL(surf);
+        sorted.setSortByMaxZ(true);
+        sorted.setCutter(&cutter);
+        appendGrid(sorted);
+        sorted.run();
+
+        // 先碰到高处的三角形，below()剔除了更多候选
+        RecordProperty(tbb ? "tbb_calls_tree_order" : "calls_tree_order", treeOrder.getCalls());
+        RecordProperty(tbb ? "tbb_calls_sorted" : "calls_sorted", sorted.getCalls());
+        EXPECT_LT(sorted.getCalls(), treeOrder.getCalls());
+
+        std::vector<CLPoint> expected = treeOrder.getCLPoints();
+        std::vector<CLPoint> result = sorted.getCLPoints();
+        ASSERT_EQ(result.size(), expected.size());
+        for (size_t n = 0; n < result.size(); ++n)
+            EXPECT_EQ(result[n].z, expected[n].z);
+    }
+}
+
+TEST(BatchDropCutterTests, UniqueElementsMatchPerTriangleDrop)
+{
+    STLSurf surf = wavySurface();
+    // 800个三角形的2400个顶点焊接成21x21个，内部顶点被6个三角形共用
+    EXPECT_EQ(surf.weld(1e-9), 2400u - 441u);
+    EXPECT_EQ(surf.mesh.vertexCount(), 21u * 21u);
+
+    CylCutter cyl(2.0, 10.0);
+    BallCutter ball(3.0, 10.0);
+    BullCutter bull(4.0, 0.5, 10.0);
+    ConeCutter cone(2.0, 45.0 * M_PI / 180.0, 10.0);
+    const MillingCutter* cutters[] = {&cyl, &ball, &bull, &cone};
+    for (const MillingCutter* cutter : cutters) {
+        BatchDropCutter ref;
+        ref.setSTL(surf);
+        ref.setCutter(cutter);
+        appendGrid(ref);
+        ref.run();
+
+        BatchDropCutter unique;
+        unique.setSTL(surf);
+        unique.setCutter(cutter);
+        unique.setUniqueElements(true);
+        appendGrid(unique);
+        unique.run();
+
+        std::vector<CLPoint> expected = ref.getCLPoints();
+        std::vector<CLPoint> result = unique.getCLPoints();
+        ASSERT_EQ(result.size(), expected.size());
+        for (size_t n = 0; n < result.size(); ++n)
+            EXPECT_NEAR(result[n].z, expected[n].z, 1e-9) << cutter->str();
+        // 每个顶点和边每个刀位点只测试一次：顶点约为三角形的一半，边约为1.5倍
+        EXPECT_LT(unique.getVertexCalls(), unique.getCalls());
+        EXPECT_LT(unique.getEdgeCalls(), 2 * unique.getCalls());
+        EXPECT_GT(unique.getVertexCalls(), 0);
+        EXPECT_GT(unique.getEdgeCalls(), 0);
+    }
+}
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "cutters/ballcutter.hpp"
+#include "dropcutter/batchdropcutter.hpp"
+#include "dropcutter/dropcutterpipeline.hpp"
+#include "dropcutter/pathdropcutter.hpp"
+#include "geo/clpoint.hpp"
+#include "geo/line.hpp"
+#include "geo/path.hpp"
+#include "geo/stlreader.hpp"
+#include "geo/stlsurf.hpp"
+#include "geo/triangle.hpp"
+
+using namespace ocl;
+
+namespace
+{
+std::wstring tempPath(const std::string& name)
+{
+    return (std::filesystem::temp_directory_path() / name).wstring();
+}
+
+// 把n*n格的起伏曲面写成二进制STL
+void writeWavy(const std::wstring& path, int n)
+{
+    auto z = [](double x, double y) { return std::sin(0.3 * x) * std::cos(0.2 * y); };
+    std::ofstream out(std::filesystem::path(path), std::ios::binary);
+    char head[80] = {0};
+    out.write(head, 80);
+    uint32_t facets = 2 * n * n;
+    out.write(reinterpret_cast<const char*>(&facets), 4);
+    auto facet = [&](const Point& a, const Point& b, const Point& c) {
+        float f[12] = {0, 0, 1};
+        const Point* p[3] = {&a, &b, &c};
+        for (int k = 0; k < 3; ++k) {
+            f[3 + 3 * k] = static_cast<float>(p[k]->x);
+            f[4 + 3 * k] = static_cast<float>(p[k]->y);
+            f[5 + 3 * k] = static_cast<float>(p[k]->z);
+        }
+        out.write(reinterpret_cast<const char*>(f), 48);
+        uint16_t attr = 0;
+        out.write(reinterpret_cast<const char*>(&attr), 2);
+    };
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            Point a(i, j, z(i, j));
+            Point b(i + 1, j, z(i + 1, j));
+            Point c(i + 1, j + 1, z(i + 1, j + 1));
+            Point d(i, j + 1, z(i, j + 1));
+            facet(a, b, c);
+            facet(a, c, d);
+        }
+    }
+}
+
+void expectSamePoints(const std::vector<CLPoint>& a, const std::vector<CLPoint>& b)
+{
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t k = 0; k < a.size(); ++k) {
+        EXPECT_EQ(a[k].x, b[k].x);
+        EXPECT_EQ(a[k].y, b[k].y);
+        EXPECT_EQ(a[k].z, b[k].z) << "point " << k;
+    }
+}
+}  // namespace
+
+TEST(DropCutterPipelineTests, RasterEqualsBatchDropCutter)
+{
+    std::wstring path = tempPath("ocl_test_pipeline.stl");
+    writeWavy(path, 30);
+    STLSurf surf;
+    STLReader(path, surf);
+    BallCutter cutter(3.0, 10.0);
+
+    DropCutterPipeline pipe;
+    pipe.setSTLFile(path);
+    pipe.setBlockFaces(100);  // 分成多个块读入
+    pipe.setCutter(&cutter);
+    pipe.setRaster(-1.0, 31.0, -1.0, 31.0, 0.5, -5.0);
+    pipe.start();
+    const STLSurf& loaded = pipe.getSurface();
+    EXPECT_TRUE(pipe.isLoaded());
+    EXPECT_EQ(loaded.size(), surf.size());
+    EXPECT_EQ(pipe.getLoadedFaces(), surf.size());
+    for (unsigned int d = 0; d < 6; ++d)
+        EXPECT_EQ(pipe.getBounds()[d], surf.bb[d]);
+    pipe.wait();
+    EXPECT_LE(pipe.getLoadTime(), pipe.getIndexTime());
+    EXPECT_LE(pipe.getIndexTime(), pipe.getTotalTime());
+    EXPECT_LE(pipe.getPointTime(), pipe.getTotalTime());
+
+    // 同一栅格：65行，每行65点，逐行换向
+    BatchDropCutter bdc;
+    bdc.setSTL(surf);
+    bdc.setCutter(&cutter);
+    for (int j = 0; j <= 64; ++j) {
+        for (int i = 0; i <= 64; ++i) {
+            int k = (j % 2) ? 64 - i : i;
+            CLPoint cl(-1.0 + 0.5 * k, -1.0 + 0.5 * j, -5.0);
+            bdc.appendPoint(cl);
+        }
+    }
+    bdc.run();
+    expectSamePoints(pipe.getCLPoints(), bdc.getCLPoints());
+    EXPECT_EQ(pipe.getCalls(), bdc.getCalls());
+
+    // 再次运行时生成的点被替换而不是追加
+    pipe.run();
+    expectSamePoints(pipe.getCLPoints(), bdc.getCLPoints());
+    std::filesystem::remove(std::filesystem::path(path));
+}
+
+TEST(DropCutterPipelineTests, PathEqualsPathDropCutter)
+{
+    std::wstring path = tempPath("ocl_test_pipeline_path.stl");
+    writeWavy(path, 20);
+    STLSurf surf;
+    STLReader(path, surf);
+    BallCutter cutter(2.0, 10.0);
+
+    Path p;
+    p.append(Line(Point(0, 0, 0), Point(20, 20, 0)));
+    p.append(Line(Point(20, 20, 0), Point(20, 3, 0)));
+    p.append(Line(Point(20, 3, 0), Point(1, 17, 0)));
+
+    PathDropCutter pdc;
+    pdc.setSTL(surf);
+    pdc.setCutter(&cutter);
+    pdc.setPath(&p);
+    pdc.setSampling(0.2);
+    pdc.setZ(-3.0);
+    pdc.run();
+
+    DropCutterPipeline pipe;
+    pipe.setSTLFile(path);
+    pipe.setCutter(&cutter);
+    // 先加入的点排在生成的点之前
+    CLPoint first(5.0, 5.0, -3.0);
+    pipe.appendPoint(first);
+    pipe.setPath(&p, 0.2, -3.0);
+    pipe.run();
+    std::vector<CLPoint> result = pipe.getCLPoints();
+    ASSERT_FALSE(result.empty());
+    EXPECT_EQ(result[0].x, 5.0);
+    EXPECT_GT(result[0].z, -3.0);
+    result.erase(result.begin());
+    expectSamePoints(result, pdc.getPoints());
+    std::filesystem::remove(std::filesystem::path(path));
+}
+
+TEST(DropCutterPipelineTests, MissingFileLeavesPointsUndropped)
+{
+    BallCutter cutter(2.0, 10.0);
+    DropCutterPipeline pipe;
+    pipe.setSTLFile(tempPath("ocl_test_pipeline_missing.stl"));
+    pipe.setCutter(&cutter);
+    pipe.setRaster(0.0, 2.0, 0.0, 1.0, 1.0, -1.0);
+    pipe.run();
+    EXPECT_EQ(pipe.getSurface().size(), 0u);
+    std::vector<CLPoint> result = pipe.getCLPoints();
+    ASSERT_EQ(result.size(), 6u);
+    for (const CLPoint& cl : result)
+        EXPECT_EQ(cl.z, -1.0);
+}
@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+
+#include "../utils/triangles_utils.h"
+
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cutters/ballcutter.hpp"
+#include "cutters/cylcutter.hpp"
+#include "dropcutter/batchdropcutter.hpp"
+#include "dropcutter/tileddropcutter.hpp"
+#include "geo/clpoint.hpp"
+#include "geo/regionofinterest.hpp"
+#include "geo/stlreader.hpp"
+#include "geo/stlsurf.hpp"
+#include "geo/tiledmesh.hpp"
+#include "geo/triangle.hpp"
+
+#ifndef STL_MODELS_DIR
+#define STL_MODELS_DIR "../../../stl"
+#endif
+
+using namespace ocl;
+
+namespace
+{
+// 起伏曲面，另加一些跨越多个tile的长三角形
+STLSurf wavySurface(int n)
+{
+    STLSurf s = gridSurface(n, 1.0, [](double x, double y) {
+        return std::sin(0.3 * x) * std::cos(0.2 * y);
+    });
+    s.addTriangle(Triangle(Point(0, 3, 1.2), Point(n, 5, 1.4), Point(n, 6, 1.1)));
+    s.addTriangle(Triangle(Point(2, 0, 1.5), Point(4, n, 0.9), Point(5, n, 1.3)));
+    return s;
+}
+
+std::wstring tempDir(const std::string& name)
+{
+    return (std::filesystem::temp_directory_path() / name).wstring();
+}
+
+std::vector<CLPoint> grid(double size, double step)
+{
+    std::vector<CLPoint> points;
+    for (double x = -1.3; x < size + 1; x += step) {
+        for (double y = -0.7; y < size + 1; y += step * 1.1) {
+            points.push_back(CLPoint(x, y, -5));
+        }
+    }
+    return points;
+}
+
+std::vector<CLPoint> dropAll(BatchDropCutter& bdc, const MillingCutter& cutter,
+                             std::vector<CLPoint> points)
+{
+    bdc.setCutter(&cutter);
+    for (CLPoint& cl : points)
+        bdc.appendPoint(cl);
+    bdc.run();
+    return bdc.getCLPoints();
+}
+}  // namespace
+
+TEST(TiledDropCutterTests, TilesHoldOverlappingTriangles)
+{
+    STLSurf s = wavySurface(20);
+    std::wstring dir = tempDir("ocl_test_tiles_a");
+    ASSERT_TRUE(TiledMesh::build(s, dir, 6.0, 1 << 20));
+    TiledMesh tiles;
+    ASSERT_TRUE(tiles.open(dir));
+    EXPECT_EQ(tiles.tilesX(), 4);
+    EXPECT_EQ(tiles.tilesY(), 4);
+    EXPECT_EQ(tiles.faceCount(), s.size());
+    for (unsigned int d = 0; d < 6; ++d)
+        EXPECT_EQ(tiles.bounds()[d], s.bb[d]);
+
+    // 每个tile中的三角形都与tile相交；跨tile的三角形被重复存放
+    size_t stored = 0;
+    for (size_t k = 0; k < tiles.tileCount(); ++k) {
+        STLSurf tile;
+        ASSERT_TRUE(tiles.loadTile(k, tile));
+        EXPECT_EQ(tile.size(), tiles.faceCount(k));
+        EXPECT_EQ(tile.indexes.size(), 1u);
+        for (const Triangle& t : tile.tris) {
+            EXPECT_LE(tiles.column(t.bb.minpt.x), int(k % 4));
+            EXPECT_GE(tiles.column(t.bb.maxpt.x), int(k % 4));
+            EXPECT_LE(tiles.row(t.bb.minpt.y), int(k / 4));
+            EXPECT_GE(tiles.row(t.bb.maxpt.y), int(k / 4));
+        }
+        stored += tile.size();
+    }
+    EXPECT_GT(stored, s.size());
+    std::filesystem::remove_all(std::filesystem::path(dir));
+}
+
+TEST(TiledDropCutterTests, SameResultAsBatchDropCutter)
+{
+    STLSurf s = wavySurface(30);
+    std::wstring dir = tempDir("ocl_test_tiles_b");
+    // 很小的预算：构建时多次写出暂存文件
+    ASSERT_TRUE(TiledMesh::build(s, dir, 4.0, 64 * 1024));
+    TiledMesh tiles;
+    ASSERT_TRUE(tiles.open(dir));
+
+    BallCutter ball(3.0, 10.0);
+    CylCutter cyl(1.0, 10.0);
+    for (const MillingCutter* cutter : {static_cast<const MillingCutter*>(&ball),
+                                        static_cast<const MillingCutter*>(&cyl)}) {
+        BatchDropCutter bdc;
+        bdc.setSTL(s);
+        std::vector<CLPoint> expected = dropAll(bdc, *cutter, grid(30, 0.6));
+
+        // 预算只够同时驻留少量tile，驻留的tile被换出后重新读取
+        TiledDropCutter tdc;
+        tdc.setTiles(tiles);
+        tdc.setMemoryBudget(600 * 1024);
+        std::vector<CLPoint> result = dropAll(tdc, *cutter, grid(30, 0.6));
+        ASSERT_EQ(result.size(), expected.size());
+        for (size_t n = 0; n < result.size(); ++n)
+            EXPECT_EQ(result[n].z, expected[n].z) << n;
+        EXPECT_GT(tdc.getTileLoads(), 0u);
+        EXPECT_LE(tdc.getPeakResidentBytes(), 600u * 1024u);
+        EXPECT_GT(tdc.getCalls(), 0);
+    }
+    std::filesystem::remove_all(std::filesystem::path(dir));
+}
+
+TEST(TiledDropCutterTests, RegionOfInterestLeavesOutsidePoints)
+{
+    STLSurf s = wavySurface(30);
+    std::wstring dir = tempDir("ocl_test_tiles_roi");
+    ASSERT_TRUE(TiledMesh::build(s, dir, 4.0, 1 << 20));
+    TiledMesh tiles;
+    ASSERT_TRUE(tiles.open(dir));
+
+    BallCutter ball(2.0, 10.0);
+    BatchDropCutter bdc;
+    bdc.setSTL(s);
+    std::vector<CLPoint> expected = dropAll(bdc, ball, grid(30, 0.6));
+
+    TiledDropCutter whole;
+    whole.setTiles(tiles);
+    dropAll(whole, ball, grid(30, 0.6));
+
+    // 区域外的点保持原样，只读入区域附近的tile
+    RegionOfInterest roi(Bbox(5, 11, 6, 13, 0, 0));
+    TiledDropCutter tdc;
+    tdc.setTiles(tiles);
+    tdc.setROI(roi);
+    std::vector<CLPoint> result = dropAll(tdc, ball, grid(30, 0.6));
+    ASSERT_EQ(result.size(), expected.size());
+    int inside = 0;
+    for (size_t n = 0; n < result.size(); ++n) {
+        if (roi.contains(expected[n])) {
+            EXPECT_EQ(result[n].z, expected[n].z) << n;
+            ++inside;
+        } else {
+            EXPECT_EQ(result[n].z, -5.0) << n;
+        }
+    }
+    EXPECT_GT(inside, 50);
+    EXPECT_LT(tdc.getTileLoads() * 2, whole.getTileLoads());
+    std::filesystem::remove_all(std::filesystem::path(dir));
+}
+
+TEST(TiledDropCutterTests, EvictsLeastRecentlyUsedTiles)
+{
+    STLSurf s = wavySurface(40);
+    std::wstring dir = tempDir("ocl_test_tiles_c");
+    ASSERT_TRUE(TiledMesh::build(s, dir, 5.0, 1 << 20));
+    TiledMesh tiles;
+    ASSERT_TRUE(tiles.open(dir));
+    size_t nonEmpty = 0;
+    for (size_t k = 0; k < tiles.tileCount(); ++k)
+        nonEmpty += tiles.faceCount(k) ? 1 : 0;
+
+    BallCutter cutter(1.0, 10.0);
+    TiledDropCutter unlimited;
+    unlimited.setTiles(tiles);
+    dropAll(unlimited, cutter, grid(40, 0.5));
+    // 预算足够时每个tile只读取一次
+    EXPECT_EQ(unlimited.getTileLoads(), nonEmpty);
+
+    TiledDropCutter small;
+    small.setTiles(tiles);
+    small.setMemoryBudget(unlimited.getPeakResidentBytes() / 2);
+    dropAll(small, cutter, grid(40, 0.5));
+    // 按蛇形顺序逐行处理，换出的tile不再需要
+    EXPECT_GE(small.getTileLoads(), nonEmpty);
+    EXPECT_LE(small.getPeakResidentBytes(), unlimited.getPeakResidentBytes() / 2);
+    std::filesystem::remove_all(std::filesystem::path(dir));
+}
+
+TEST(TiledDropCutterTests, TileModelFile)
+{
+    // 从STL文件分块读取并分tile，结果与整体读入相同
+    std::wstring stl = std::filesystem::path(std::string(STL_MODELS_DIR) + "/mount_rush.stl").wstring();
+    STLSurf s;
+    STLReader(stl, s);
+    ASSERT_GT(s.size(), 0u);
+    std::wstring dir = tempDir("ocl_test_tiles_d");
+    const double size = std::max(s.bb.maxpt.x - s.bb.minpt.x, s.bb.maxpt.y - s.bb.minpt.y);
+    ASSERT_TRUE(TiledMesh::build(stl, dir, size / 5, 2 << 20));
+    TiledMesh tiles;
+    ASSERT_TRUE(tiles.open(dir));
+    EXPECT_EQ(tiles.faceCount(), s.size());
+
+    BallCutter cutter(size / 20, size);
+    std::vector<CLPoint> points;
+    for (double x = s.bb.minpt.x; x <= s.bb.maxpt.x; x += size / 37) {
+        for (double y = s.bb.minpt.y; y <= s.bb.maxpt.y; y += size / 41)
+            points.push_back(CLPoint(x, y, s.bb.minpt.z - 1));
+    }
+    BatchDropCutter bdc;
+    bdc.setSTL(s);
+    std::vector<CLPoint> expected = dropAll(bdc, cutter, points);
+    TiledDropCutter tdc;
+    tdc.setTiles(tiles);
+    tdc.setMemoryBudget(8 << 20);
+    std::vector<CLPoint> result = dropAll(tdc, cutter, points);
+    ASSERT_EQ(result.size(), expected.size());
+    for (size_t n = 0; n < result.size(); ++n)
+        EXPECT_EQ(result[n].z, expected[n].z);
+    std::filesystem::remove_all(std::filesystem::path(dir));
+}
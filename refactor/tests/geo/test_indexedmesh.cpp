@@ -0,0 +1,265 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "common/kdtree.hpp"
+#include "geo/indexedmesh.hpp"
+#include "geo/meshtopology.hpp"
+#include "geo/stlsurf.hpp"
+#include "geo/triangle.hpp"
+
+using namespace ocl;
+
+namespace
+{
+std::vector<Triangle> randomTriangles(int count, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> pos(-10.0, 10.0);
+    std::vector<Triangle> tris;
+    for (int n = 0; n < count; ++n) {
+        tris.push_back(Triangle(Point(pos(gen), pos(gen), pos(gen)),
+                                Point(pos(gen), pos(gen), pos(gen)),
+                                Point(pos(gen), pos(gen), pos(gen))));
+    }
+    return tris;
+}
+
+void expectSameTriangle(const Triangle& a, const Triangle& b)
+{
+    for (int k = 0; k < 3; ++k) {
+        EXPECT_EQ(a.p[k].x, b.p[k].x);
+        EXPECT_EQ(a.p[k].y, b.p[k].y);
+        EXPECT_EQ(a.p[k].z, b.p[k].z);
+    }
+    EXPECT_EQ(a.n.x, b.n.x);
+    EXPECT_EQ(a.n.y, b.n.y);
+    EXPECT_EQ(a.n.z, b.n.z);
+    for (unsigned int d = 0; d < 6; ++d)
+        EXPECT_EQ(a.bb[d], b.bb[d]);
+}
+}  // namespace
+
+TEST(IndexedMeshTests, FacesMatchTriangles)
+{
+    std::vector<Triangle> tris = randomTriangles(200, 1);
+    IndexedMesh mesh;
+    for (const Triangle& t : tris)
+        mesh.addTriangle(t.p[0], t.p[1], t.p[2]);
+    ASSERT_EQ(mesh.size(), tris.size());
+    EXPECT_EQ(mesh.vertexCount(), 3 * tris.size());
+
+    for (size_t f = 0; f < tris.size(); ++f) {
+        // 预先计算的法向量和包围盒与Triangle完全一致
+        expectSameTriangle(mesh.triangle(f), tris[f]);
+        EXPECT_EQ(mesh.normal(f).z, tris[f].n.z);
+        for (unsigned int d = 0; d < 6; ++d) {
+            EXPECT_EQ(mesh.bound(f, d), tris[f].bb[d]);
+            EXPECT_EQ(mesh.bounds(f)[d], tris[f].bb[d]);
+        }
+    }
+    // 复用同一个Triangle逐个读取面
+    Triangle t;
+    for (size_t f = 0; f < tris.size(); ++f) {
+        mesh.triangle(f, t);
+        expectSameTriangle(t, tris[f]);
+    }
+}
+
+TEST(IndexedMeshTests, KDTreeFindsOverlappingFaces)
+{
+    std::vector<Triangle> tris = randomTriangles(300, 3);
+    IndexedMesh mesh;
+    for (const Triangle& t : tris)
+        mesh.addTriangle(t.p[0], t.p[1], t.p[2]);
+    KDTree<IndexedMesh> tree;
+    tree.setXYDimensions();
+    tree.setBucketSize(4);
+    tree.build(mesh);
+    EXPECT_EQ(tree.getMesh(), &mesh);
+
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<double> pos(-10.0, 10.0);
+    std::vector<std::uint32_t> faces;
+    for (int q = 0; q < 50; ++q) {
+        const double x = pos(gen), y = pos(gen);
+        const Bbox bb(x - 1, x + 1, y - 1, y + 1, -20, 20);
+        tree.search(bb, faces);
+        // 结果中每个面只出现一次，包围盒与查询框重叠的面都被找到
+        std::vector<std::uint32_t> sorted(faces);
+        std::sort(sorted.begin(), sorted.end());
+        EXPECT_TRUE(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+        for (std::uint32_t f = 0; f < mesh.size(); ++f) {
+            if (mesh.bounds(f).overlaps(bb)) {
+                EXPECT_TRUE(std::binary_search(sorted.begin(), sorted.end(), f)) << f;
+            }
+        }
+        // 按最高点排序时，面的集合不变
+        tree.setSortByMaxZ(true);
+        tree.search(bb, faces);
+        tree.setSortByMaxZ(false);
+        for (std::size_t k = 1; k < faces.size(); ++k)
+            EXPECT_GE(mesh.bound(faces[k - 1], 5), mesh.bound(faces[k], 5));
+        std::sort(faces.begin(), faces.end());
+        EXPECT_EQ(faces, sorted);
+    }
+
+    // 空网格没有根节点，查询结果为空
+    IndexedMesh empty;
+    tree.build(empty);
+    EXPECT_EQ(tree.getRoot(), nullptr);
+    tree.search(Bbox(-1, 1, -1, 1, -1, 1), faces);
+    EXPECT_TRUE(faces.empty());
+}
+
+TEST(IndexedMeshTests, SharedVertices)
+{
+    // 两个三角形组成的正方形，共用对角线上的两个顶点
+    IndexedMesh mesh;
+    uint32_t a = mesh.addVertex(Point(0, 0, 0));
+    uint32_t b = mesh.addVertex(Point(1, 0, 0));
+    uint32_t c = mesh.addVertex(Point(1, 1, 1));
+    uint32_t d = mesh.addVertex(Point(0, 1, 1));
+    mesh.addFace(a, b, c);
+    mesh.addFace(a, c, d);
+    EXPECT_EQ(mesh.vertexCount(), 4u);
+    EXPECT_EQ(mesh.size(), 2u);
+    EXPECT_EQ(mesh.index(1, 1), c);
+    expectSameTriangle(mesh.triangle(1), Triangle(Point(0, 0, 0), Point(1, 1, 1), Point(0, 1, 1)));
+    EXPECT_EQ(mesh.indices().size(), 6u);
+    EXPECT_EQ(mesh.vertices().size(), 12u);
+}
+
+TEST(IndexedMeshTests, FloatMeshAndMemory)
+{
+    std::vector<Triangle> tris = randomTriangles(1000, 2);
+    IndexedMesh mesh;
+    IndexedMeshF meshf;
+    mesh.reserve(3 * tris.size(), tris.size());
+    meshf.reserve(3 * tris.size(), tris.size());
+    for (const Triangle& t : tris) {
+        mesh.addTriangle(t.p[0], t.p[1], t.p[2]);
+        meshf.addTriangle(t.p[0], t.p[1], t.p[2]);
+    }
+    for (size_t f = 0; f < tris.size(); ++f) {
+        Triangle t = meshf.triangle(f);
+        for (int k = 0; k < 3; ++k)
+            EXPECT_NEAR((t.p[k] - tris[f].p[k]).norm(), 0, 1e-5);
+    }
+    // 即使顶点不共用，每个三角形的内存也小于std::list<Triangle>的一个节点
+    const size_t listNode = sizeof(Triangle) + 2 * sizeof(void*);
+    EXPECT_LT(mesh.memoryUsage(), tris.size() * listNode * 3 / 4);
+    EXPECT_LT(meshf.memoryUsage(), tris.size() * listNode / 2);
+    EXPECT_EQ(2 * meshf.memoryUsage(), mesh.memoryUsage() + 3 * tris.size() * sizeof(uint32_t));
+}
+
+TEST(IndexedMeshTests, STLSurfIsAViewOverTheMesh)
+{
+    std::vector<Triangle> tris = randomTriangles(50, 3);
+    STLSurf surf;
+    for (const Triangle& t : tris)
+        surf.addTriangle(t);
+    EXPECT_EQ(surf.size(), tris.size());
+    EXPECT_EQ(surf.tris.size(), tris.size());
+    EXPECT_EQ(surf.mesh.size(), tris.size());
+
+    size_t n = 0;
+    for (const Triangle& t : surf.tris)
+        expectSameTriangle(t, tris[n++]);
+    EXPECT_EQ(n, tris.size());
+
+    // 复制后的曲面有自己的网格
+    STLSurf copy = surf;
+    copy.rotate(0.1, 0.2, 0.3);
+    n = 0;
+    for (const Triangle& t : surf.tris)
+        expectSameTriangle(t, tris[n++]);
+    n = 0;
+    Bbox bb;
+    for (const Triangle& t : copy.tris) {
+        Triangle r = tris[n++];
+        r.rotate(0.1, 0.2, 0.3);
+        expectSameTriangle(t, r);
+        bb.addTriangle(r);
+    }
+    for (unsigned int d = 0; d < 6; ++d)
+        EXPECT_EQ(copy.bb[d], bb[d]);
+
+    STLSurf fromMesh(surf.mesh);
+    EXPECT_EQ(fromMesh.size(), surf.size());
+    for (unsigned int d = 0; d < 6; ++d)
+        EXPECT_EQ(fromMesh.bb[d], surf.bb[d]);
+
+    copy.tris.clear();
+    EXPECT_TRUE(copy.tris.empty());
+    EXPECT_EQ(surf.size(), tris.size());
+}
+
+TEST(IndexedMeshTests, WeldWithTolerance)
+{
+    // 两个三角形的共用边有微小误差
+    IndexedMesh mesh;
+    mesh.addTriangle(Point(0, 0, 0), Point(1, 0, 0), Point(1, 1, 0));
+    mesh.addTriangle(Point(1e-7, -1e-7, 0), Point(1, 1 + 1e-7, 0), Point(0, 1, 0));
+    // 容差内的顶点合并成第一个顶点
+    EXPECT_EQ(mesh.weld(1e-6), 2u);
+    EXPECT_EQ(mesh.vertexCount(), 4u);
+    EXPECT_EQ(mesh.size(), 2u);
+    EXPECT_EQ(mesh.index(1, 0), mesh.index(0, 0));
+    EXPECT_EQ(mesh.index(1, 1), mesh.index(0, 2));
+    EXPECT_EQ(mesh.vertex(mesh.index(1, 0)).x, 0.0);
+
+    // 容差过大时退化的三角形被删除
+    IndexedMesh tiny;
+    tiny.addTriangle(Point(0, 0, 0), Point(1e-3, 0, 0), Point(0, 1, 0));
+    tiny.addTriangle(Point(0, 0, 0), Point(1, 0, 0), Point(0, 1, 0));
+    EXPECT_EQ(tiny.weld(1e-2), 3u);
+    EXPECT_EQ(tiny.size(), 1u);
+    EXPECT_EQ(tiny.triangle(0).p[1].x, 1.0);
+}
+
+TEST(IndexedMeshTests, TopologyOfClosedMesh)
+{
+    // 八面体：6个顶点，12条边，8个面，每个顶点被4个面共用
+    Point v[6] = {Point(1, 0, 0), Point(-1, 0, 0), Point(0, 1, 0),
+                  Point(0, -1, 0), Point(0, 0, 1), Point(0, 0, -1)};
+    int faces[8][3] = {{0, 2, 4}, {2, 1, 4}, {1, 3, 4}, {3, 0, 4},
+                       {2, 0, 5}, {1, 2, 5}, {3, 1, 5}, {0, 3, 5}};
+    STLSurf surf;
+    for (auto& f : faces)
+        surf.addTriangle(v[f[0]], v[f[1]], v[f[2]]);
+    EXPECT_EQ(surf.weld(1e-9), 24u - 6u);
+
+    MeshTopology topo(surf.mesh);
+    EXPECT_EQ(topo.faceCount(), 8u);
+    EXPECT_EQ(topo.vertexCount(), 6u);
+    EXPECT_EQ(topo.edgeCount(), 12u);
+    EXPECT_TRUE(topo.isClosed());
+    EXPECT_EQ(topo.boundaryEdgeCount(), 0u);
+    for (size_t u = 0; u < topo.vertexCount(); ++u)
+        EXPECT_EQ(topo.vertexFaceCount(u), 4u);
+    for (size_t f = 0; f < topo.faceCount(); ++f) {
+        for (int k = 0; k < 3; ++k) {
+            // 面的第k条边从第k个角点到第k+1个角点
+            uint32_t e = topo.edge(f, k);
+            uint32_t a = surf.mesh.index(f, k);
+            uint32_t b = surf.mesh.index(f, (k + 1) % 3);
+            EXPECT_EQ(topo.edgeVertex(e, 0), std::min(a, b));
+            EXPECT_EQ(topo.edgeVertex(e, 1), std::max(a, b));
+            ASSERT_EQ(topo.edgeFaceCount(e), 2u);
+            EXPECT_TRUE(topo.edgeFace(e, 0) == f || topo.edgeFace(e, 1) == f);
+        }
+    }
+
+    // 去掉一个面后有3条边界边
+    IndexedMesh open;
+    for (size_t u = 0; u < surf.mesh.vertexCount(); ++u)
+        open.addVertex(surf.mesh.vertex(u));
+    for (size_t f = 1; f < surf.mesh.size(); ++f)
+        open.addFace(surf.mesh.index(f, 0), surf.mesh.index(f, 1), surf.mesh.index(f, 2));
+    MeshTopology openTopo(open);
+    EXPECT_FALSE(openTopo.isClosed());
+    EXPECT_EQ(openTopo.boundaryEdgeCount(), 3u);
+}
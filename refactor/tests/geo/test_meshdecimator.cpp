@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include "../utils/triangles_utils.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "common/executor.hpp"
+#include "cutters/ballcutter.hpp"
+#include "dropcutter/batchdropcutter.hpp"
+#include "geo/clpoint.hpp"
+#include "geo/meshdecimator.hpp"
+#include "geo/stlsurf.hpp"
+#include "geo/triangle.hpp"
+
+using namespace ocl;
+
+namespace
+{
+std::vector<CLPoint> dropRaster(const STLSurf& s, const MillingCutter& cutter, double size)
+{
+    BatchDropCutter bdc;
+    bdc.setSTL(s);
+    bdc.setCutter(&cutter);
+    for (double x = 0.13; x < size; x += 0.37) {
+        for (double y = 0.21; y < size; y += 0.41) {
+            CLPoint cl(x, y, -10);
+            bdc.appendPoint(cl);
+        }
+    }
+    bdc.run();
+    return bdc.getCLPoints();
+}
+
+// x<5处z=0, x>5处z=2的台阶, 中间是x=5处分成4层的竖直墙
+STLSurf stepSurface()
+{
+    const double h = 0.5;
+    STLSurf s;
+    for (int i = 0; i < 20; ++i) {
+        for (int j = 0; j < 20; ++j) {
+            const double z = i < 10 ? 0.0 : 2.0;
+            Point a(i * h, j * h, z);
+            Point b((i + 1) * h, j * h, z);
+            Point c((i + 1) * h, (j + 1) * h, z);
+            Point d(i * h, (j + 1) * h, z);
+            s.addTriangle(Triangle(a, b, c));
+            s.addTriangle(Triangle(a, c, d));
+        }
+    }
+    for (int j = 0; j < 20; ++j) {
+        for (int k = 0; k < 4; ++k) {
+            Point a(5.0, j * h, k * h);
+            Point b(5.0, (j + 1) * h, k * h);
+            Point c(5.0, (j + 1) * h, (k + 1) * h);
+            Point d(5.0, j * h, (k + 1) * h);
+            s.addTriangle(Triangle(a, b, c));
+            s.addTriangle(Triangle(a, c, d));
+        }
+    }
+    return s;
+}
+}  // namespace
+
+TEST(MeshDecimatorTests, FlatGridCollapses)
+{
+    STLSurf s = gridSurface(40, 0.5, [](double, double) { return 1.5; });
+    Bbox bb = s.bb;
+    MeshDecimator d;
+    d.setTolerance(0.01);
+    std::size_t removed = d.run(s);
+    EXPECT_EQ(d.getInputFaces(), 3200u);
+    EXPECT_EQ(removed, 3200u - s.size());
+    EXPECT_EQ(d.getOutputFaces(), s.size());
+    // 平面上只剩下边界顶点附近的三角形
+    EXPECT_LT(s.size(), 3200u / 5);
+    EXPECT_GT(d.getReduction(), 0.8);
+    // 边界顶点保持不动，包围盒不变
+    for (unsigned int k = 0; k < 6; ++k)
+        EXPECT_NEAR(s.bb[k], bb[k], 1e-12);
+    for (size_t f = 0; f < s.mesh.size(); ++f) {
+        for (int k = 0; k < 3; ++k)
+            EXPECT_NEAR(s.mesh.vertex(s.mesh.index(f, k)).z, 1.5, 1e-9);
+    }
+}
+
+TEST(MeshDecimatorTests, DropCutterStaysWithinTolerance)
+{
+    const double size = 20.0;
+    auto z = [](double x, double y) { return std::sin(0.3 * x) * std::cos(0.2 * y); };
+    STLSurf original = gridSurface(50, size / 50, z);
+    BallCutter cutter(2.0, 10.0);
+    std::vector<CLPoint> reference = dropRaster(original, cutter, size);
+
+    for (double tol : {0.002, 0.02}) {
+        STLSurf s = original;
+        MeshDecimator d;
+        d.setTolerance(tol);
+        d.setCutterDiameter(2.0);
+        d.setTileSize(4.0);
+        d.run(s);
+        EXPECT_LT(s.size(), original.size());
+        EXPECT_GE(d.getExpectedSpeedup(), 1.0);
+        std::vector<CLPoint> result = dropRaster(s, cutter, size);
+        ASSERT_EQ(result.size(), reference.size());
+        for (size_t k = 0; k < result.size(); ++k)
+            EXPECT_NEAR(result[k].z, reference[k].z, tol) << "tolerance " << tol;
+    }
+}
+
+// 竖直墙两侧的平面可以简化, 但墙和它的上下棱边不能动, 落刀结果仍在公差之内
+TEST(MeshDecimatorTests, VerticalWallStaysWithinTolerance)
+{
+    STLSurf original = stepSurface();
+    BallCutter cutter(2.0, 10.0);
+    std::vector<CLPoint> reference = dropRaster(original, cutter, 10.0);
+
+    const double tol = 0.01;
+    STLSurf s = original;
+    MeshDecimator d;
+    d.setTolerance(tol);
+    d.run(s);
+    EXPECT_LT(s.size(), original.size() / 2);
+    std::vector<CLPoint> result = dropRaster(s, cutter, 10.0);
+    ASSERT_EQ(result.size(), reference.size());
+    for (size_t k = 0; k < result.size(); ++k)
+        EXPECT_NEAR(result[k].z, reference[k].z, tol) << result[k].x << " " << result[k].y;
+
+    // 墙上的顶点都还在原处
+    unsigned int wall = 0;
+    for (std::uint32_t v = 0; v < s.mesh.vertexCount(); ++v) {
+        const Point p = s.mesh.vertex(v);
+        if (std::fabs(p.x - 5.0) < 1e-9)
+            ++wall;
+    }
+    EXPECT_EQ(wall, 21u * 5u);
+}
+
+TEST(MeshDecimatorTests, LargerToleranceRemovesMore)
+{
+    auto z = [](double x, double y) { return 0.05 * x * x - 0.03 * y * y; };
+    STLSurf a = gridSurface(30, 0.2, z);
+    STLSurf b = a;
+    MeshDecimator fine;
+    fine.setTolerance(0.001);
+    fine.run(a);
+    MeshDecimator coarse;
+    coarse.setTolerance(0.05);
+    coarse.setExecutor(Executor(Executor::SERIAL));
+    coarse.run(b);
+    EXPECT_LT(b.size(), a.size());
+    EXPECT_GT(coarse.getReduction(), fine.getReduction());
+}
+
+TEST(MeshDecimatorTests, EmptySurface)
+{
+    STLSurf s;
+    MeshDecimator d;
+    EXPECT_EQ(d.run(s), 0u);
+    EXPECT_EQ(d.getReduction(), 0.0);
+    EXPECT_EQ(d.getExpectedSpeedup(), 1.0);
+}
@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include "../utils/triangles_utils.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/kdtree.hpp"
+#include "cutters/ballcutter.hpp"
+#include "dropcutter/batchdropcutter.hpp"
+#include "geo/clpoint.hpp"
+#include "geo/meshindex.hpp"
+#include "geo/meshsnapshot.hpp"
+#include "geo/stlsurf.hpp"
+#include "geo/triangle.hpp"
+
+using namespace ocl;
+
+namespace
+{
+// 起伏的随机网格面，三角形大小不一
+STLSurf bumpySurface(int n, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> dz(-0.5, 0.5);
+    return gridSurface(n, 1.0, [&](double, double) { return dz(gen); });
+}
+
+std::wstring tempPath(const std::string& name)
+{
+    return (std::filesystem::temp_directory_path() / name).wstring();
+}
+
+// 两棵kd-tree的结构和叶子中的面完全相同
+void expectSameNode(const KDNode* a, const KDNode* b)
+{
+    ASSERT_EQ(a == nullptr, b == nullptr);
+    if (!a)
+        return;
+    EXPECT_EQ(a->dim, b->dim);
+    EXPECT_EQ(a->cutval, b->cutval);
+    EXPECT_EQ(a->depth, b->depth);
+    ASSERT_EQ(a->isLeaf, b->isLeaf);
+    EXPECT_EQ(a->faces, b->faces);
+    expectSameNode(a->hi, b->hi);
+    expectSameNode(a->lo, b->lo);
+}
+
+void setPlane(KDTree<IndexedMesh>& tree, MeshIndex::Plane p)
+{
+    if (p == MeshIndex::XY)
+        tree.setXYDimensions();
+    else if (p == MeshIndex::YZ)
+        tree.setYZDimensions();
+    else
+        tree.setXZDimensions();
+}
+
+std::vector<CLPoint> dropGrid(const STLSurf& s, unsigned int bucket)
+{
+    BallCutter cutter(1.5, 10.0);
+    BatchDropCutter bdc;
+    bdc.setBucketSize(bucket);
+    bdc.setSTL(s);
+    bdc.setCutter(&cutter);
+    for (double x = 0.3; x < 12; x += 0.45) {
+        for (double y = 0.2; y < 12; y += 0.55) {
+            CLPoint cl(x, y, -5);
+            bdc.appendPoint(cl);
+        }
+    }
+    bdc.run();
+    return bdc.getCLPoints();
+}
+}  // namespace
+
+TEST(MeshSnapshotTests, RestoredTreeEqualsBuiltTree)
+{
+    STLSurf s = bumpySurface(15, 1);
+    for (MeshIndex::Plane p : {MeshIndex::XY, MeshIndex::YZ, MeshIndex::XZ}) {
+        for (unsigned int bucket : {1u, 6u}) {
+            KDTree<IndexedMesh> built;
+            setPlane(built, p);
+            built.setBucketSize(bucket);
+            built.build(s.mesh);
+
+            MeshIndex index(s.mesh, p, bucket);
+            EXPECT_TRUE(index.isValid());
+            EXPECT_EQ(index.faces.size(), s.size());
+            KDTree<IndexedMesh> restored;
+            index.restore(s.mesh, restored);
+            EXPECT_EQ(restored.getDimensions(), built.getDimensions());
+            EXPECT_EQ(restored.getBucketSize(), bucket);
+            expectSameNode(restored.getRoot(), built.getRoot());
+        }
+    }
+}
+
+TEST(MeshSnapshotTests, SaveAndLoad)
+{
+    STLSurf s = bumpySurface(12, 2);
+    s.addIndex(MeshIndex::XY, 1);
+    s.addIndex(MeshIndex::YZ, 4);
+    // 相同平面和bucket大小的索引被替换
+    s.addIndex(MeshIndex::XY, 1);
+    ASSERT_EQ(s.indexes.size(), 2u);
+
+    std::wstring path = tempPath("ocl_test_snapshot.oclmesh");
+    ASSERT_TRUE(MeshSnapshot::save(path, s));
+    STLSurf t;
+    ASSERT_TRUE(MeshSnapshot::load(path, t));
+    std::filesystem::remove(std::filesystem::path(path));
+
+    EXPECT_EQ(t.mesh.vertices(), s.mesh.vertices());
+    EXPECT_EQ(t.mesh.indices(), s.mesh.indices());
+    for (int k = 0; k < 3; ++k)
+        EXPECT_EQ(t.mesh.normalComponent(k), s.mesh.normalComponent(k));
+    for (unsigned int d = 0; d < 6; ++d) {
+        EXPECT_EQ(t.mesh.boundComponent(d), s.mesh.boundComponent(d));
+        EXPECT_EQ(t.bb[d], s.bb[d]);
+    }
+    ASSERT_EQ(t.indexes.size(), 2u);
+    for (size_t n = 0; n < 2; ++n) {
+        EXPECT_EQ(t.indexes[n]->plane, s.indexes[n]->plane);
+        EXPECT_EQ(t.indexes[n]->bucketSize, s.indexes[n]->bucketSize);
+        EXPECT_EQ(t.indexes[n]->faces, s.indexes[n]->faces);
+        ASSERT_EQ(t.indexes[n]->nodes.size(), s.indexes[n]->nodes.size());
+    }
+
+    // 从快照恢复kd-tree的降刀结果与重新建树相同
+    STLSurf plain = bumpySurface(12, 2);
+    std::vector<CLPoint> expected = dropGrid(plain, 1);
+    std::vector<CLPoint> result = dropGrid(t, 1);
+    ASSERT_EQ(result.size(), expected.size());
+    for (size_t n = 0; n < result.size(); ++n)
+        EXPECT_EQ(result[n].z, expected[n].z);
+    // bucket大小不同时照常建树
+    result = dropGrid(t, 3);
+    for (size_t n = 0; n < result.size(); ++n)
+        EXPECT_EQ(result[n].z, expected[n].z);
+}
+
+TEST(MeshSnapshotTests, RejectsBadFiles)
+{
+    STLSurf s = bumpySurface(4, 3);
+    s.addIndex(MeshIndex::XY, 1);
+    std::wstring path = tempPath("ocl_test_bad.oclmesh");
+    ASSERT_TRUE(MeshSnapshot::save(path, s));
+    std::vector<char> bytes(std::filesystem::file_size(std::filesystem::path(path)));
+    {
+        std::ifstream in(std::filesystem::path(path), std::ios::binary);
+        in.read(bytes.data(), bytes.size());
+    }
+    auto rewrite = [&](const std::vector<char>& b) {
+        std::ofstream out(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+        out.write(b.data(), b.size());
+    };
+
+    STLSurf t = bumpySurface(2, 4);
+    const size_t before = t.size();
+    // 截断
+    rewrite(std::vector<char>(bytes.begin(), bytes.end() - 16));
+    EXPECT_FALSE(MeshSnapshot::load(path, t));
+    // 版本不同
+    std::vector<char> other = bytes;
+    other[8] = 99;
+    rewrite(other);
+    EXPECT_FALSE(MeshSnapshot::load(path, t));
+    // 不是快照文件
+    other = bytes;
+    other[0] = 'X';
+    rewrite(other);
+    EXPECT_FALSE(MeshSnapshot::load(path, t));
+    // 顶点索引越界
+    other = bytes;
+    const size_t indices = 88 + ((s.mesh.vertices().size() * 8 + 7) & ~size_t(7));
+    other[indices + 3] = 0x7f;
+    rewrite(other);
+    EXPECT_FALSE(MeshSnapshot::load(path, t));
+    EXPECT_EQ(t.size(), before);
+    EXPECT_FALSE(MeshSnapshot::load(tempPath("ocl_test_missing.oclmesh"), t));
+    std::filesystem::remove(std::filesystem::path(path));
+}
+
+TEST(MeshSnapshotTests, ChangesDropIndexes)
+{
+    STLSurf s = bumpySurface(3, 5);
+    s.addIndex(MeshIndex::XY, 1);
+    STLSurf copy = s;
+    EXPECT_EQ(copy.indexes.size(), 1u);
+    s.addTriangle(Triangle(Point(0, 0, 5), Point(1, 0, 5), Point(0, 1, 5)));
+    EXPECT_TRUE(s.indexes.empty());
+    copy.rotate(0.1, 0, 0);
+    EXPECT_TRUE(copy.indexes.empty());
+}
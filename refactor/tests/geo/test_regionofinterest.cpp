@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+
+#include "../utils/triangles_utils.h"
+
+#include <cmath>
+#include <vector>
+
+#include "algo/waterline.hpp"
+#include "cutters/ballcutter.hpp"
+#include "dropcutter/batchdropcutter.hpp"
+#include "dropcutter/pathdropcutter.hpp"
+#include "dropcutter/pointdropcutter.hpp"
+#include "geo/clpoint.hpp"
+#include "geo/line.hpp"
+#include "geo/path.hpp"
+#include "geo/regionofinterest.hpp"
+#include "geo/stlsurf.hpp"
+#include "geo/triangle.hpp"
+
+using namespace ocl;
+
+namespace
+{
+// 20x20的起伏地形，网格间距0.5
+STLSurf wavySurface()
+{
+    return gridSurface(40, 0.5, [](double x, double y) { return std::sin(0.7 * x) * std::cos(0.5 * y); });
+}
+
+// 三角形区域
+RegionOfInterest triangleRegion()
+{
+    return RegionOfInterest(std::vector<Point> {Point(4, 4, 0), Point(14, 5, 0), Point(8, 13, 0)});
+}
+
+// 用于读取纤维数量
+class FiberCountingWaterline: public Waterline
+{
+public:
+    std::size_t fibers() const
+    {
+        return xfibers.size() + yfibers.size();
+    }
+};
+
+}  // namespace
+
+TEST(RegionOfInterestTests, ContainsAndOverlaps)
+{
+    RegionOfInterest all;
+    EXPECT_TRUE(all.empty());
+    EXPECT_FALSE(all.contains(Point(0, 0, 0)));
+
+    RegionOfInterest tri = triangleRegion();
+    EXPECT_FALSE(tri.empty());
+    EXPECT_TRUE(tri.contains(Point(8, 7, 100)));
+    EXPECT_FALSE(tri.contains(Point(4, 12, 0)));
+    EXPECT_FALSE(tri.contains(Point(20, 5, 0)));
+    // 顶点和边上的点算在区域内
+    EXPECT_TRUE(tri.contains(Point(4, 4, 0)));
+    EXPECT_TRUE(tri.contains(Point(9, 4.5, 0)));
+
+    // 矩形在区域内、跨过边界、包住区域、在外面
+    EXPECT_TRUE(tri.overlaps(7.5, 8.5, 6.5, 7.5));
+    EXPECT_TRUE(tri.overlaps(3, 5, 3, 5));
+    EXPECT_TRUE(tri.overlaps(0, 20, 0, 20));
+    EXPECT_FALSE(tri.overlaps(3, 5, 9, 12));
+    EXPECT_FALSE(tri.overlaps(15, 16, 0, 20));
+
+    RegionOfInterest box(Bbox(2, 6, 3, 7, -1, 1));
+    EXPECT_TRUE(box.contains(Point(6, 7, 0)));
+    EXPECT_FALSE(box.contains(Point(6.01, 5, 0)));
+    Bbox b = box.bounds(1.0);
+    EXPECT_DOUBLE_EQ(b.minpt.x, 1.0);
+    EXPECT_DOUBLE_EQ(b.maxpt.x, 7.0);
+    EXPECT_DOUBLE_EQ(b.minpt.y, 2.0);
+    EXPECT_DOUBLE_EQ(b.maxpt.y, 8.0);
+}
+
+TEST(RegionOfInterestTests, CullClipsToGrownBounds)
+{
+    STLSurf s = wavySurface();
+    RegionOfInterest roi(Bbox(5.2, 9.2, 6.1, 10.1, 0, 0));
+    STLSurf t = roi.cull(s, 1.0);
+    EXPECT_GT(t.size(), 0u);
+    EXPECT_LT(t.size(), s.size() / 5);
+
+    // 裁剪后的三角形都在外扩的包围盒内，投影面积正好是外扩包围盒的面积
+    double area = 0.0;
+    for (const Triangle& tr : t.tris) {
+        for (int k = 0; k < 3; ++k) {
+            EXPECT_GE(tr.p[k].x, 4.2 - 1e-12);
+            EXPECT_LE(tr.p[k].x, 10.2 + 1e-12);
+            EXPECT_GE(tr.p[k].y, 5.1 - 1e-12);
+            EXPECT_LE(tr.p[k].y, 11.1 + 1e-12);
+        }
+        area += 0.5 * std::fabs((tr.p[1] - tr.p[0]).cross(tr.p[2] - tr.p[0]).z);
+    }
+    EXPECT_NEAR(area, 6.0 * 6.0, 1e-9);
+    EXPECT_NEAR(t.bb.minpt.x, 4.2, 1e-12);
+    EXPECT_NEAR(t.bb.maxpt.y, 11.1, 1e-12);
+}
+
+TEST(RegionOfInterestTests, DropCutterMatchesWholeSurfaceInside)
+{
+    STLSurf s = wavySurface();
+    BallCutter cutter(2.0, 10.0);
+    RegionOfInterest roi = triangleRegion();
+
+    BatchDropCutter whole;
+    whole.setCutter(&cutter);
+    whole.setSTL(s);
+    // 先设区域和曲面再设刀具：换刀时按刀具半径重新裁剪
+    BatchDropCutter part;
+    part.setROI(roi);
+    part.setSTL(s);
+    std::size_t bare = part.getROIFaces();
+    part.setCutter(&cutter);
+    EXPECT_GT(part.getROIFaces(), bare);
+    EXPECT_LT(part.getROIFaces(), s.size() / 3);
+    EXPECT_EQ(whole.getROIFaces(), s.size());
+
+    int inside = 0;
+    for (double x = 0.1; x < 20; x += 0.37) {
+        for (double y = 0.2; y < 20; y += 0.41) {
+            CLPoint cl(x, y, -5);
+            whole.appendPoint(cl);
+            part.appendPoint(cl);
+            inside += roi.contains(cl);
+        }
+    }
+    whole.run();
+    part.run();
+    std::vector<CLPoint> a = whole.getCLPoints();
+    std::vector<CLPoint> b = part.getCLPoints();
+    ASSERT_EQ(a.size(), b.size());
+    EXPECT_GT(inside, 100);
+    for (std::size_t n = 0; n < a.size(); ++n) {
+        if (roi.contains(a[n]))
+            EXPECT_NEAR(b[n].z, a[n].z, 1e-9) << a[n];
+        else
+            EXPECT_EQ(b[n].z, -5.0) << a[n];
+    }
+
+    // 多把刀具一起落刀时区域外的点也保持原样
+    BallCutter small(1.0, 10.0);
+    part.runCutters({&small, &cutter});
+    std::vector<CLPoint> c = part.getCLPoints(1);
+    ASSERT_EQ(c.size(), a.size());
+    for (std::size_t n = 0; n < a.size(); ++n)
+        EXPECT_NEAR(c[n].z, roi.contains(a[n]) ? a[n].z : -5.0, 1e-9) << a[n];
+
+    // 路径落刀只生成区域内的点
+    Path path;
+    path.append(Line(Point(0, 6, 0), Point(20, 9, 0)));
+    PathDropCutter pdc;
+    pdc.setSTL(s);
+    pdc.setPath(&path);
+    pdc.setCutter(&cutter);
+    pdc.setROI(roi);
+    pdc.setSampling(0.1);
+    pdc.setZ(-5);
+    pdc.run();
+    std::vector<CLPoint> path_pts = pdc.getPoints();
+    EXPECT_GT(path_pts.size(), 50u);
+    PointDropCutter pt;
+    pt.setSTL(s);
+    pt.setCutter(&cutter);
+    for (const CLPoint& p : path_pts) {
+        EXPECT_TRUE(roi.contains(p)) << p;
+        CLPoint q(p.x, p.y, -5);
+        pt.run(q);
+        EXPECT_NEAR(p.z, q.z, 1e-9) << p;
+    }
+
+    // 去掉区域后恢复整个曲面
+    part.clearROI();
+    EXPECT_EQ(part.getROIFaces(), s.size());
+}
+
+TEST(RegionOfInterestTests, WaterlineFibersFollowRegion)
+{
+    STLSurf s = wavySurface();
+    BallCutter cutter(1.0, 10.0);
+    const double zh = 0.3;
+
+    FiberCountingWaterline whole;
+    whole.setSTL(s);
+    whole.setCutter(&cutter);
+    whole.setSampling(0.1);
+    whole.setZ(zh);
+    whole.run();
+
+    FiberCountingWaterline part;
+    part.setCutter(&cutter);
+    part.setROI(RegionOfInterest(Bbox(6, 11, 6, 11, 0, 0)));
+    part.setSTL(s);
+    part.setSampling(0.1);
+    part.setZ(zh);
+    part.run();
+    EXPECT_LT(part.fibers() * 2, whole.fibers());
+
+    // 区域内的刀位点都和整个曲面接触在zh高度
+    PointDropCutter pt;
+    pt.setSTL(s);
+    pt.setCutter(&cutter);
+    RegionOfInterest inner(Bbox(6.001, 10.999, 6.001, 10.999, 0, 0));
+    int checked = 0;
+    for (const std::vector<Point>& loop : part.getLoops()) {
+        for (const Point& p : loop) {
+            if (!inner.contains(p))
+                continue;
+            CLPoint q(p.x, p.y, -5);
+            pt.run(q);
+            EXPECT_NEAR(q.z, zh, 1e-6) << p;
+            ++checked;
+        }
+    }
+    EXPECT_GT(checked, 50);
+    int wholeInside = 0;
+    for (const std::vector<Point>& loop : whole.getLoops())
+        for (const Point& p : loop)
+            wholeInside += inner.contains(p);
+    EXPECT_NEAR(checked, wholeInside, 0.2 * wholeInside);
+}
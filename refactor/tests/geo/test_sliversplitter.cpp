@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include "../utils/triangles_utils.h"
+
+#include <cmath>
+#include <list>
+#include <random>
+#include <vector>
+
+#include "common/kdtree.hpp"
+#include "cutters/cylcutter.hpp"
+#include "dropcutter/batchdropcutter.hpp"
+#include "geo/clpoint.hpp"
+#include "geo/meshindex.hpp"
+#include "geo/sliversplitter.hpp"
+#include "geo/stlsurf.hpp"
+#include "geo/triangle.hpp"
+
+using namespace ocl;
+
+namespace
+{
+// 斜坡网格，加上几条斜向的细长三角形和一条沿x轴的细长三角形
+STLSurf sliverSurface()
+{
+    STLSurf s = gridSurface(20, 1.0, [](double x, double) { return 0.1 * x; });
+    for (int k = 0; k < 5; ++k) {
+        double o = 3.0 * k;
+        s.addTriangle(Triangle(Point(o, 0, 3), Point(o + 5, 20, 3.5), Point(o + 5.1, 20, 3.5)));
+    }
+    s.addTriangle(Triangle(Point(0, 10.5, 4), Point(20, 10.5, 4), Point(20, 10.6, 4)));
+    return s;
+}
+
+double totalArea(const STLSurf& s)
+{
+    double a = 0;
+    for (const Triangle& t : s.tris)
+        a += 0.5 * (t.p[1] - t.p[0]).cross(t.p[2] - t.p[0]).norm();
+    return a;
+}
+
+std::vector<CLPoint> drop(const STLSurf& s, const MillingCutter& cutter)
+{
+    BatchDropCutter bdc;
+    bdc.setSTL(s);
+    bdc.setCutter(&cutter);
+    for (double x = 0.1; x < 20; x += 0.53) {
+        for (double y = 0.2; y < 20; y += 0.47) {
+            CLPoint cl(x, y, -5);
+            bdc.appendPoint(cl);
+        }
+    }
+    bdc.run();
+    return bdc.getCLPoints();
+}
+}  // namespace
+
+TEST(SliverSplitterTests, SplitsDiagonalSliversOnly)
+{
+    STLSurf s = sliverSurface();
+    const double area = totalArea(s);
+    const unsigned int n = s.size();
+    CylCutter cutter(1.0, 10.0);
+    std::vector<CLPoint> before = drop(s, cutter);
+
+    SliverSplitter sp;
+    sp.setCutterDiameter(1.0);
+    EXPECT_EQ(sp.run(s), 5u);  // 沿x轴的细长三角形的包围盒已经很紧，不拆
+    EXPECT_EQ(sp.getSplitFaces(), 5u);
+    EXPECT_EQ(s.size(), n + sp.getAddedFaces());
+    EXPECT_LE(sp.getAddedFaces(), 5u * 63u);
+    EXPECT_LT(sp.getCandidatesAfter(), sp.getCandidatesBefore());
+    EXPECT_NEAR(totalArea(s), area, 1e-9 * area);
+    // 结果的XY索引已附加在曲面上
+    ASSERT_EQ(s.indexes.size(), 1u);
+    EXPECT_EQ(s.indexes[0]->plane, MeshIndex::XY);
+    EXPECT_EQ(s.indexes[0]->faceCount, s.mesh.size());
+
+    // 曲面几何不变，降刀结果相同
+    std::vector<CLPoint> after = drop(s, cutter);
+    ASSERT_EQ(after.size(), before.size());
+    for (size_t k = 0; k < after.size(); ++k)
+        EXPECT_NEAR(after[k].z, before[k].z, 1e-9);
+}
+
+TEST(SliverSplitterTests, WellShapedSurfaceUnchanged)
+{
+    STLSurf s;
+    s.addTriangle(Triangle(Point(0, 0, 0), Point(1, 0, 0), Point(0, 1, 0)));
+    s.addTriangle(Triangle(Point(1, 0, 0), Point(1, 1, 0), Point(0, 1, 0)));
+    SliverSplitter sp;
+    EXPECT_EQ(sp.run(s), 0u);
+    EXPECT_EQ(s.size(), 2u);
+    EXPECT_EQ(sp.getCandidatesAfter(), sp.getCandidatesBefore());
+}
+
+TEST(SliverSplitterTests, MeanCandidatesMatchesSearches)
+{
+    STLSurf s = sliverSurface();
+    const double r = 0.8;
+    for (unsigned int bucket : {1u, 4u}) {
+        MeshIndex index(s.mesh, MeshIndex::XY, bucket);
+        double expected = index.meanCandidates(s.bb, r);
+
+        KDTree<IndexedMesh> tree;
+        tree.setXYDimensions();
+        tree.setBucketSize(bucket);
+        tree.build(s.mesh);
+        std::mt19937 gen(7);
+        std::uniform_real_distribution<double> x(s.bb.minpt.x, s.bb.maxpt.x);
+        std::uniform_real_distribution<double> y(s.bb.minpt.y, s.bb.maxpt.y);
+        const int queries = 8000;
+        double found = 0;
+        std::vector<std::uint32_t> faces;
+        for (int q = 0; q < queries; ++q) {
+            double cx = x(gen), cy = y(gen);
+            tree.search(Bbox(cx - r, cx + r, cy - r, cy + r, -10, 10), faces);
+            found += faces.size();
+        }
+        EXPECT_NEAR(found / queries, expected, 0.03 * expected) << "bucket " << bucket;
+    }
+    EXPECT_EQ(MeshIndex().meanCandidates(s.bb, r), 0.0);
+}
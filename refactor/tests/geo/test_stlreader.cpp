@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "geo/stlreader.hpp"
+#include "geo/stlsurf.hpp"
+#include "geo/triangle.hpp"
+
+#ifndef STL_MODELS_DIR
+#define STL_MODELS_DIR "../../../stl"
+#endif
+
+using namespace ocl;
+
+namespace
+{
+// 随机三角形，坐标取float精度，与STL文件中保存的一致
+std::vector<Triangle> randomTriangles(int count, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> pos(-50.0f, 50.0f);
+    std::vector<Triangle> tris;
+    for (int n = 0; n < count; ++n) {
+        Point p[3];
+        for (auto& q : p)
+            q = Point(pos(gen), pos(gen), pos(gen));
+        tris.push_back(Triangle(p[0], p[1], p[2]));
+    }
+    return tris;
+}
+
+std::wstring tempPath(const std::string& name)
+{
+    return (std::filesystem::temp_directory_path() / name).wstring();
+}
+
+// 写二进制STL，facets为头部记录的三角形数量
+void writeBinary(const std::wstring& path, const std::vector<Triangle>& tris,
+                 const char* header, uint32_t facets)
+{
+    std::ofstream out(std::filesystem::path(path), std::ios::binary);
+    char head[80] = {0};
+    std::strncpy(head, header, 79);
+    out.write(head, 80);
+    out.write(reinterpret_cast<const char*>(&facets), 4);
+    for (const Triangle& t : tris) {
+        float f[12] = {0, 0, 1};
+        for (int k = 0; k < 3; ++k) {
+            f[3 + 3 * k] = static_cast<float>(t.p[k].x);
+            f[4 + 3 * k] = static_cast<float>(t.p[k].y);
+            f[5 + 3 * k] = static_cast<float>(t.p[k].z);
+        }
+        out.write(reinterpret_cast<const char*>(f), 48);
+        uint16_t attr = 0;
+        out.write(reinterpret_cast<const char*>(&attr), 2);
+    }
+}
+
+// 写ASCII STL，eol为行尾
+void writeAscii(const std::wstring& path, const std::vector<Triangle>& tris,
+                const char* eol = "\n")
+{
+    std::ofstream out(std::filesystem::path(path), std::ios::binary);
+    out.precision(9);
+    out << "solid test" << eol;
+    for (const Triangle& t : tris) {
+        out << "  facet normal 0 0 1" << eol << "    outer loop" << eol;
+        for (const Point& p : t.p)
+            out << "      vertex " << p.x << " " << p.y << " " << p.z << eol;
+        out << "    endloop" << eol << "  endfacet" << eol;
+    }
+    out << "endsolid test" << eol;
+}
+
+void expectSurface(const STLSurf& s, const std::vector<Triangle>& tris)
+{
+    ASSERT_EQ(s.size(), tris.size());
+    size_t n = 0;
+    Bbox bb;
+    for (const Triangle& t : s.tris) {
+        for (int k = 0; k < 3; ++k) {
+            EXPECT_EQ(t.p[k].x, tris[n].p[k].x);
+            EXPECT_EQ(t.p[k].y, tris[n].p[k].y);
+            EXPECT_EQ(t.p[k].z, tris[n].p[k].z);
+        }
+        bb.addTriangle(tris[n++]);
+    }
+    for (unsigned int d = 0; d < 6; ++d)
+        EXPECT_EQ(s.bb[d], bb[d]);
+}
+}  // namespace
+
+TEST(STLReaderTests, BinaryFileStartingWithSolid)
+{
+    // 有些导出程序在二进制文件头部写"solid"，按文件大小判断为二进制
+    std::vector<Triangle> tris = randomTriangles(5000, 1);
+    std::wstring path = tempPath("ocl_test_solid_binary.stl");
+    writeBinary(path, tris, "solid exported by a CAD system", 5000);
+    STLSurf s;
+    STLReader(path, s);
+    expectSurface(s, tris);
+    std::filesystem::remove(std::filesystem::path(path));
+}
+
+TEST(STLReaderTests, FacetCountCheckedAgainstFileSize)
+{
+    std::vector<Triangle> tris = randomTriangles(100, 2);
+    std::wstring path = tempPath("ocl_test_truncated.stl");
+    // 头部声称的三角形数量多于文件内容：只读取完整的三角形
+    writeBinary(path, tris, "binary", 250);
+    STLSurf s;
+    STLReader(path, s);
+    expectSurface(s, tris);
+
+    // 头部数量少于文件内容：忽略多余的数据
+    writeBinary(path, tris, "binary", 40);
+    STLSurf t;
+    STLReader(path, t);
+    expectSurface(t, std::vector<Triangle>(tris.begin(), tris.begin() + 40));
+    std::filesystem::remove(std::filesystem::path(path));
+}
+
+TEST(STLReaderTests, AppendsToSurface)
+{
+    std::vector<Triangle> tris = randomTriangles(30, 3);
+    std::wstring path = tempPath("ocl_test_append.stl");
+    writeBinary(path, std::vector<Triangle>(tris.begin() + 10, tris.end()), "binary", 20);
+    STLSurf s;
+    for (int n = 0; n < 10; ++n)
+        s.addTriangle(tris[n]);
+    STLReader(path, s);
+    expectSurface(s, tris);
+    std::filesystem::remove(std::filesystem::path(path));
+}
+
+TEST(STLReaderTests, AsciiChunksAndCRLF)
+{
+    // 超过1MB的文件分成多块并行解析，结果按文件顺序排列
+    std::vector<Triangle> tris = randomTriangles(12000, 4);
+    std::wstring path = tempPath("ocl_test_crlf.stl");
+    writeAscii(path, tris, "\r\n");
+    ASSERT_GT(std::filesystem::file_size(std::filesystem::path(path)), 2u << 20);
+    STLSurf s;
+    STLReader(path, s);
+    expectSurface(s, tris);
+    std::filesystem::remove(std::filesystem::path(path));
+}
+
+TEST(STLReaderTests, AsciiFormatting)
+{
+    // 制表符缩进、带符号的指数、名字中含关键字、缺顶点的面、文件末尾没有换行
+    const char* text =
+        "solid facet vertex name\n"
+        "facet normal 0 0 1\n"
+        "\touter loop\n"
+        "\t\tvertex +1.5e+00 -2 3\n"
+        "\t\tvertex 4 5.25 6\n"
+        "\t\tvertex 7 8 -9.5E-1\n"
+        "\tendloop\n"
+        "endfacet\n"
+        "facet normal 0 0 1 outer loop vertex 1 1 1 vertex 2 2 2 endloop endfacet\n"
+        "facet normal 0 0 1 outer loop vertex 0 0 0 vertex 1 0 0 vertex 0 1 0 endloop endfacet\n"
+        "endsolid facet vertex name";
+    std::wstring path = tempPath("ocl_test_format.stl");
+    {
+        std::ofstream out(std::filesystem::path(path), std::ios::binary);
+        out << text;
+    }
+    STLSurf s;
+    STLReader(path, s);
+    std::vector<Triangle> expected = {
+        Triangle(Point(1.5, -2, 3), Point(4, 5.25, 6), Point(7, 8, -0.95f)),
+        Triangle(Point(0, 0, 0), Point(1, 0, 0), Point(0, 1, 0))};
+    expectSurface(s, expected);
+    std::filesystem::remove(std::filesystem::path(path));
+}
+
+TEST(STLReaderTests, ReadFilesConcurrently)
+{
+    std::vector<std::wstring> paths;
+    std::vector<std::vector<Triangle>> expected;
+    for (int k = 0; k < 6; ++k) {
+        expected.push_back(randomTriangles(200 + 100 * k, 10 + k));
+        paths.push_back(tempPath("ocl_test_many_" + std::to_string(k) + ".stl"));
+        if (k % 2)
+            writeAscii(paths[k], expected[k]);
+        else
+            writeBinary(paths[k], expected[k], "binary", static_cast<uint32_t>(expected[k].size()));
+    }
+    std::vector<STLSurf> surfaces;
+    STLReader::read_files(paths, surfaces);
+    ASSERT_EQ(surfaces.size(), paths.size());
+    for (size_t k = 0; k < paths.size(); ++k) {
+        expectSurface(surfaces[k], expected[k]);
+        std::filesystem::remove(std::filesystem::path(paths[k]));
+    }
+}
+
+TEST(STLReaderTests, ModelFiles)
+{
+    // 二进制和ASCII模型
+    STLSurf binary;
+    STLReader(std::filesystem::path(std::string(STL_MODELS_DIR) + "/mount_rush.stl").wstring(), binary);
+    EXPECT_EQ(binary.size(), (779684u - 84u) / 50u);
+    STLSurf ascii;
+    STLReader(std::filesystem::path(std::string(STL_MODELS_DIR) + "/sphere.stl").wstring(), ascii);
+    EXPECT_GT(ascii.size(), 0u);
+
+    // 不存在的文件不添加三角形
+    STLSurf none;
+    STLReader(tempPath("ocl_test_does_not_exist.stl"), none);
+    EXPECT_EQ(none.size(), 0u);
+}
@@ -88,4 +88,25 @@ double squaredArea(const Triangle& triangle)
     return tri.squared_area();
 }
 
+STLSurf gridSurface(int n, double h, const std::function<double(double, double)>& z, double x0,
+                    double y0)
+{
+    STLSurf s;
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            const double xa = x0 + i * h;
+            const double xb = x0 + (i + 1) * h;
+            const double ya = y0 + j * h;
+            const double yb = y0 + (j + 1) * h;
+            Point a(xa, ya, z(xa, ya));
+            Point b(xb, ya, z(xb, ya));
+            Point c(xb, yb, z(xb, yb));
+            Point d(xa, yb, z(xa, yb));
+            s.addTriangle(Triangle(a, b, c));
+            s.addTriangle(Triangle(a, c, d));
+        }
+    }
+    return s;
+}
+
 }  // namespace ocl
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <functional>
+
 #include "algo/fiber.hpp"
+#include "geo/stlsurf.hpp"
 #include "geo/triangle.hpp"
 
 namespace ocl
@@ -14,4 +17,9 @@ std::vector<Point> createRandomPointsInTriangle(const Triangle& triangle,
 bool doIntersect(const Triangle& triangle, const Fiber& fiber);
 
 double squaredArea(const Triangle& triangle);
+
+// n*n格、格宽h的高度场曲面，从(x0, y0)开始，每格两个三角形，三角形互不共享顶点。
+// 每格按 (x,y)、(x+h,y)、(x+h,y+h)、(x,y+h) 的顺序各调用一次z
+STLSurf gridSurface(int n, double h, const std::function<double(double, double)>& z,
+                    double x0 = 0.0, double y0 = 0.0);
 }  // namespace ocl